@@ -1,10 +1,38 @@
 #include "stm32f10x.h"                  // Device header
 #include "Delay.h"
+#include "PT.h"
+#include "Latency.h"
+#include "Scheduler.h"
 
 /*引脚配置*/
 #define BUZZER_PORT GPIOA
 #define BUZZER_PIN GPIO_Pin_8
 
+/*鸣叫节奏：第一次打开由调用者直接完成，之后的开关由buzzer协程（sensor线程）按节奏进行，不阻塞调用者*/
+static PT_Task_t buzzer_task;
+static volatile uint16_t buzzer_on_ms;
+static volatile uint16_t buzzer_off_ms;
+static volatile uint8_t buzzer_repeat;
+static volatile uint32_t buzzer_start;      //第一次打开的时刻（ms）
+
+/*buzzer协程：从第一次打开起响on_ms、停off_ms，重复repeat次*/
+static PT_THREAD(Buzzer_Thread(PT_t *pt))
+{
+    static uint8_t i;
+    
+    PT_BEGIN(pt);
+    PT_DELAY_UNTIL(pt, buzzer_start + buzzer_on_ms);
+    GPIO_SetBits(BUZZER_PORT, BUZZER_PIN); //设置高电平关闭
+    for (i = 1; i < buzzer_repeat; i++)
+    {
+        PT_DELAY(pt, buzzer_off_ms);
+        GPIO_ResetBits(BUZZER_PORT, BUZZER_PIN); //低电平触发，设置低电平打开
+        PT_DELAY(pt, buzzer_on_ms);
+        GPIO_SetBits(BUZZER_PORT, BUZZER_PIN); //设置高电平关闭
+    }
+    PT_END(pt);
+}
+
 /*蜂鸣器初始化*/
 void Buzzer_Init(void)
 {
@@ -17,11 +45,15 @@ void Buzzer_Init(void)
     GPIO_Init(BUZZER_PORT, &GPIO_InitStructure);
     
     GPIO_SetBits(BUZZER_PORT, BUZZER_PIN); //低电平触发，初始高电平关闭
+    
+    PT_TaskInit(&buzzer_task, "buzzer", Buzzer_Thread);
 }
 
-/*蜂鸣器控制*/
+/*蜂鸣器控制，同时停止正在进行的鸣叫节奏*/
 void Buzzer_Control(uint8_t status)
 {
+    PT_TaskStop(&buzzer_task);
+    
     if (status)
     {
         GPIO_ResetBits(BUZZER_PORT, BUZZER_PIN); //低电平触发，设置低电平打开
@@ -32,10 +64,26 @@ void Buzzer_Control(uint8_t status)
     }
 }
 
-/*蜂鸣器鸣叫一次*/
-void Buzzer_Beep(uint16_t duration)
+/*蜂鸣器按节奏鸣叫：响on_ms、停off_ms，重复repeat次；返回前已打开蜂鸣器，之后的开关由协程完成*/
+void Buzzer_Pattern(uint16_t on_ms, uint16_t off_ms, uint8_t repeat)
 {
+    if (repeat == 0)
+    {
+        Buzzer_Control(0);
+        return;
+    }
+    
+    buzzer_on_ms = on_ms;
+    buzzer_off_ms = off_ms;
+    buzzer_repeat = repeat;
+    buzzer_start = Scheduler_GetTick();
     GPIO_ResetBits(BUZZER_PORT, BUZZER_PIN); //低电平触发，设置低电平打开
-    Delay_ms(duration);
-    GPIO_SetBits(BUZZER_PORT, BUZZER_PIN); //设置高电平关闭
+    Latency_Mark(LATENCY_BUZZER);
+    PT_TaskStart(&buzzer_task);
+}
+
+/*蜂鸣器鸣叫一次，立即返回*/
+void Buzzer_Beep(uint16_t duration)
+{
+    Buzzer_Pattern(duration, 0, 1);
 }
\ No newline at end of file
@@ -4,5 +4,6 @@
 void Buzzer_Init(void);
 void Buzzer_Control(uint8_t status);
 void Buzzer_Beep(uint16_t duration);
+void Buzzer_Pattern(uint16_t on_ms, uint16_t off_ms, uint8_t repeat);
 
 #endif
\ No newline at end of file
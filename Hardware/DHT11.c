@@ -1,150 +1,216 @@
-#include "dht11.h" 
-#include "delay.h" 
-#include "stdio.h" 
-#include "Serial.h" 
-		 
-void DHT11_Rst(void)	   //复位DHT11 
-{ 
-	//SET OUTPUT 
-	DHT11_Mode(OUT); 
-	//拉低DQ 
-	DHT11_Low; 
-	//主机拉低18~30ms 
-	Delay_ms(20); 
-	//拉高DQ 
-	DHT11_High; 
-	//主机拉高10~35us 
-	Delay_us(13);      	 
-} 
-  
-
-uint8_t DHT11_Check(void) 	   
-{   
-	uint8_t retry=0; 
-	DHT11_Mode(IN);//SET INPUT	 
-    while (GPIO_ReadInputDataBit(DHT11_GPIO_PORT,DHT11_GPIO_PIN)&&retry<100)//DHT11会拉低40~80us 
-	{ 
-		retry++; 
-		Delay_us(1); 
-	};    
-	if(retry>=100)return 1; 
-	else retry=0; 
-    while (!GPIO_ReadInputDataBit(DHT11_GPIO_PORT,DHT11_GPIO_PIN)&&retry<100)//DHT11拉低后会再次拉高40~80us 
-	{ 
-		retry++; 
-		Delay_us(1); 
-	}; 
-	if(retry>=100)return 1;    
-	return 0; 
-} 
-
-uint8_t DHT11_ReadBit(void) 			 
-{ 
-  uint8_t retry=0; 
-  while(GPIO_ReadInputDataBit(DHT11_GPIO_PORT,DHT11_GPIO_PIN)&&retry<100)//等待变为低电平 
-  { retry++; Delay_us(1); } 
-  retry=0; 
-  while(!GPIO_ReadInputDataBit(DHT11_GPIO_PORT,DHT11_GPIO_PIN)&&retry<100)//等待变高电平 
-  { retry++; Delay_us(1); } 
-  Delay_us(30);//30us延时区分0/1位，DHT11 0位约26-28us，1位约70us 
-  if(GPIO_ReadInputDataBit(DHT11_GPIO_PORT,DHT11_GPIO_PIN))return 1; 
-  else return 0;		   
-} 
-  
-
-/*========================================================== 
-Name：	DHT11_ReadByte 
-Function：	读取DHT11一个字节 
-pars:		无 
-return：	读到的数据 
-notes：		无 
-==========================================================*/ 
-uint8_t DHT11_ReadByte(void)    
-{        
-	uint8_t i,dat; 
-	dat=0; 
-	for (i=0;i<8;i++) 
-	{ 
-		dat<<=1; 
-		dat|=DHT11_ReadBit(); 
-	}						    
-	return dat; 
-} 
-
-uint8_t DHT11_ReadData(uint8_t *humi, uint8_t *temp, uint8_t mode)    // 添加mode参数用于调试控制
-{
-  uint8_t buff[5]; 
-  uint8_t i;
-  DHT11_Rst(); //发送起始信号 
-  if(DHT11_Check()==0) //等待响应 
-  {
-    for(i=0;i<5;i++)//读取40位数据 
-    {
-      buff[i]=DHT11_ReadByte(); 
-    }
-    
-    // 计算并验证校验和
-    uint8_t checksum = buff[0] + buff[1] + buff[2] + buff[3];
-    if(checksum == buff[4]) 
-    {
-      *humi=buff[0];		//湿度数据 
-      *temp=buff[2];		//温度数据 
-    }
-    
-    // 仅在调试模式时打印原始数据以便调试
-    if (mode == 2) // MODE_DEBUG 对应的值为2
-    {
-      printf("[DEBUG] DHT11 Raw Data: %02X %02X %02X %02X %02X\n", 
-             buff[0], buff[1], buff[2], buff[3], buff[4]);
-      printf("[DEBUG] DHT11 Checksum: Calculated=%02X, Received=%02X\n", 
-             checksum, buff[4]);
-      printf("[DEBUG] DHT11 Extracted: Temp=%d, Humi=%d\n", 
-             *temp, *humi);
-    }
-  } 
-  else return 1; 
-  return 0;	 
-} 
-  
-/*========================================================== 
-Name：	DHT11_Init 
-Function：	初始化DHT11的IO口，同时检测DHT11的存在 
-pars:		temp:温度 
-		humi:湿度 
-return：	0-存在 
-		1-不存在 
-notes：		无 
-==========================================================*/ 
-uint8_t DHT11_Init(void) 
-{	 
-  GPIO_InitTypeDef  GPIO_InitStructure;	 
-  RCC_APB2PeriphClockCmd(DHT11_GPIO_CLK, ENABLE);	 	//使能PA端口时钟 
-  GPIO_InitStructure.GPIO_Pin = DHT11_GPIO_PIN;		//端口配置 
-  GPIO_InitStructure.GPIO_Mode = GPIO_Mode_Out_PP; 	//推挽输出 
-  GPIO_InitStructure.GPIO_Speed = GPIO_Speed_50MHz; 
-  GPIO_Init(DHT11_GPIO_PORT, &GPIO_InitStructure);	//初始化IO口 
-  GPIO_SetBits(DHT11_GPIO_PORT,DHT11_GPIO_PIN);		//输出高电平 
-		    
-	DHT11_Rst();  //发送起始信号 
-	return DHT11_Check();//等待DHT11的回应 
-} 
-  
-void DHT11_Mode(uint8_t mode) 
-{ 
-	GPIO_InitTypeDef GPIO_InitStructure; 
-	 
-	if(mode) 
-	{ 
-		GPIO_InitStructure.GPIO_Pin = DHT11_GPIO_PIN; 
-		GPIO_InitStructure.GPIO_Speed = GPIO_Speed_50MHz; 
-		GPIO_InitStructure.GPIO_Mode = GPIO_Mode_Out_PP; 
-	} 
-	else 
-	{ 
-		GPIO_InitStructure.GPIO_Pin =  DHT11_GPIO_PIN; 
-		GPIO_InitStructure.GPIO_Mode = GPIO_Mode_IPU; 
-	} 
-	GPIO_Init(DHT11_GPIO_PORT, &GPIO_InitStructure); 
-}
-
-
\ No newline at end of file
+#include "dht11.h" 
+#include "delay.h" 
+#include "stdio.h" 
+#include "Serial.h" 
+#include "Perf.h"
+#include "Trace.h"
+#include "Kernel.h"
+
+/* 读取数据帧（不含20ms起始信号）的耗时 */
+PERF_PROBE(perf_dht11_read, "DHT11_ReadData");
+		 
+void DHT11_Rst(void)	   //复位DHT11 
+{ 
+	//SET OUTPUT 
+	DHT11_Mode(OUT); 
+	//拉低DQ 
+	DHT11_Low; 
+	//主机拉低18~30ms 
+	Delay_ms(20); 
+	//拉高DQ 
+	DHT11_High; 
+	//主机拉高10~35us 
+	Delay_us(13);      	 
+} 
+  
+
+uint8_t DHT11_Check(void) 	   
+{   
+	uint8_t retry=0; 
+	DHT11_Mode(IN);//SET INPUT	 
+    while (GPIO_ReadInputDataBit(DHT11_GPIO_PORT,DHT11_GPIO_PIN)&&retry<100)//DHT11会拉低40~80us 
+	{ 
+		retry++; 
+		Delay_us(1); 
+	};    
+	if(retry>=100)return 1; 
+	else retry=0; 
+    while (!GPIO_ReadInputDataBit(DHT11_GPIO_PORT,DHT11_GPIO_PIN)&&retry<100)//DHT11拉低后会再次拉高40~80us 
+	{ 
+		retry++; 
+		Delay_us(1); 
+	}; 
+	if(retry>=100)return 1;    
+	return 0; 
+} 
+
+uint8_t DHT11_ReadBit(void) 			 
+{ 
+  uint8_t retry=0; 
+  while(GPIO_ReadInputDataBit(DHT11_GPIO_PORT,DHT11_GPIO_PIN)&&retry<100)//等待变为低电平 
+  { retry++; Delay_us(1); } 
+  retry=0; 
+  while(!GPIO_ReadInputDataBit(DHT11_GPIO_PORT,DHT11_GPIO_PIN)&&retry<100)//等待变高电平 
+  { retry++; Delay_us(1); } 
+  Delay_us(30);//30us延时区分0/1位，DHT11 0位约26-28us，1位约70us 
+  if(GPIO_ReadInputDataBit(DHT11_GPIO_PORT,DHT11_GPIO_PIN))return 1; 
+  else return 0;		   
+} 
+  
+
+/*========================================================== 
+Name：	DHT11_ReadByte 
+Function：	读取DHT11一个字节 
+pars:		无 
+return：	读到的数据 
+notes：		无 
+==========================================================*/ 
+uint8_t DHT11_ReadByte(void)    
+{        
+	uint8_t i,dat; 
+	dat=0; 
+	for (i=0;i<8;i++) 
+	{ 
+		dat<<=1; 
+		dat|=DHT11_ReadBit(); 
+	}						    
+	return dat; 
+} 
+
+/*========================================================== 
+Name：	DHT11_ReadFrame 
+Function：	起始信号发出后，等待DHT11响应并读取40位数据 
+pars:		humi:湿度 
+		temp:温度 
+		mode:系统模式，调试模式下打印原始数据 
+return：	0-成功 
+		1-无响应 
+		2-校验错误，humi/temp保持原值 
+notes：		整帧约4ms，位时序依赖微秒级延时，读取期间锁定调度器， 
+		防止被高优先级线程抢占打乱时序（中断仍可响应） 
+==========================================================*/ 
+uint8_t DHT11_ReadFrame(uint8_t *humi, uint8_t *temp, uint8_t mode)
+{
+  uint8_t buff[5]; 
+  uint8_t i;
+  uint8_t ret = 0;
+  PERF_BEGIN(perf_dht11_read);
+  TRACE(TRACE_EV_DHT11_BEGIN, 0);
+  Kernel_SchedLock();
+  if(DHT11_Check()==0) //等待响应 
+  {
+    for(i=0;i<5;i++)//读取40位数据 
+    {
+      buff[i]=DHT11_ReadByte(); 
+    }
+    Kernel_SchedUnlock();
+    
+    // 计算并验证校验和
+    uint8_t checksum = buff[0] + buff[1] + buff[2] + buff[3];
+    if(checksum == buff[4]) 
+    {
+      *humi=buff[0];		//湿度数据 
+      *temp=buff[2];		//温度数据 
+    }
+    else
+    {
+      ret = 2;
+    }
+    
+    // 仅在调试模式时打印原始数据以便调试
+    if (mode == 2) // MODE_DEBUG 对应的值为2
+    {
+      printf("[DEBUG] DHT11 Raw Data: %02X %02X %02X %02X %02X\n", 
+             buff[0], buff[1], buff[2], buff[3], buff[4]);
+      printf("[DEBUG] DHT11 Checksum: Calculated=%02X, Received=%02X\n", 
+             checksum, buff[4]);
+      printf("[DEBUG] DHT11 Extracted: Temp=%d, Humi=%d\n", 
+             *temp, *humi);
+    }
+  } 
+  else
+  {
+    Kernel_SchedUnlock();
+    PERF_END(perf_dht11_read);
+    TRACE(TRACE_EV_DHT11_END, 1);
+    return 1; 
+  }
+  PERF_END(perf_dht11_read);
+  TRACE(TRACE_EV_DHT11_END, ret);
+  return ret;	 
+}
+
+uint8_t DHT11_ReadData(uint8_t *humi, uint8_t *temp, uint8_t mode)    // 添加mode参数用于调试控制
+{
+  DHT11_Rst(); //发送起始信号 
+  return DHT11_ReadFrame(humi, temp, mode);
+} 
+
+/*========================================================== 
+Name：	DHT11_ReadPT 
+Function：	协程版读取，20ms起始信号期间挂起，不占用CPU 
+pars:		pt:协程控制块 
+		humi:湿度 
+		temp:温度 
+		mode:系统模式 
+		result:结果，0-成功，1-无响应，2-校验错误 
+return：	协程状态 
+notes：		参数在协程结束前必须保持有效 
+==========================================================*/ 
+PT_THREAD(DHT11_ReadPT(PT_t *pt, uint8_t *humi, uint8_t *temp, uint8_t mode, uint8_t *result))
+{
+  PT_BEGIN(pt);
+  
+  DHT11_Mode(OUT); 
+  DHT11_Low; 
+  PT_DELAY(pt, 20); //主机拉低18~30ms，期间让出 
+  DHT11_High; 
+  Delay_us(13); //主机拉高10~35us 
+  
+  *result = DHT11_ReadFrame(humi, temp, mode);
+  
+  PT_END(pt);
+}
+  
+/*========================================================== 
+Name：	DHT11_Init 
+Function：	初始化DHT11的IO口，同时检测DHT11的存在 
+pars:		temp:温度 
+		humi:湿度 
+return：	0-存在 
+		1-不存在 
+notes：		无 
+==========================================================*/ 
+uint8_t DHT11_Init(void) 
+{	 
+  GPIO_InitTypeDef  GPIO_InitStructure;	 
+  RCC_APB2PeriphClockCmd(DHT11_GPIO_CLK, ENABLE);	 	//使能PA端口时钟 
+  GPIO_InitStructure.GPIO_Pin = DHT11_GPIO_PIN;		//端口配置 
+  GPIO_InitStructure.GPIO_Mode = GPIO_Mode_Out_PP; 	//推挽输出 
+  GPIO_InitStructure.GPIO_Speed = GPIO_Speed_50MHz; 
+  GPIO_Init(DHT11_GPIO_PORT, &GPIO_InitStructure);	//初始化IO口 
+  GPIO_SetBits(DHT11_GPIO_PORT,DHT11_GPIO_PIN);		//输出高电平 
+		    
+	DHT11_Rst();  //发送起始信号 
+	return DHT11_Check();//等待DHT11的回应 
+} 
+  
+void DHT11_Mode(uint8_t mode) 
+{ 
+	GPIO_InitTypeDef GPIO_InitStructure; 
+	 
+	if(mode) 
+	{ 
+		GPIO_InitStructure.GPIO_Pin = DHT11_GPIO_PIN; 
+		GPIO_InitStructure.GPIO_Speed = GPIO_Speed_50MHz; 
+		GPIO_InitStructure.GPIO_Mode = GPIO_Mode_Out_PP; 
+	} 
+	else 
+	{ 
+		GPIO_InitStructure.GPIO_Pin =  DHT11_GPIO_PIN; 
+		GPIO_InitStructure.GPIO_Mode = GPIO_Mode_IPU; 
+	} 
+	GPIO_Init(DHT11_GPIO_PORT, &GPIO_InitStructure); 
+}
+
+
@@ -3,6 +3,7 @@
 
 #include "stm32f10x.h"                  // Device header
 #include "delay.h"
+#include "PT.h"
 
 //DHT11引脚宏定义
 #define DHT11_GPIO_PORT  GPIOA
@@ -20,6 +21,8 @@
 //函数声明
 uint8_t DHT11_Init(void);
 uint8_t DHT11_ReadData(uint8_t *humi, uint8_t *temp, uint8_t mode); // 添加mode参数用于调试控制
+uint8_t DHT11_ReadFrame(uint8_t *humi, uint8_t *temp, uint8_t mode);
+PT_THREAD(DHT11_ReadPT(PT_t *pt, uint8_t *humi, uint8_t *temp, uint8_t mode, uint8_t *result));
 uint8_t DHT11_ReadByte(void);
 uint8_t DHT11_ReadBit(void);
 void DHT11_Mode(uint8_t mode);
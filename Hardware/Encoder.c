@@ -1,5 +1,8 @@
 #include "stm32f10x.h"                  // Device header
 #include "Delay.h"
+#include "Scheduler.h"
+#include "Event.h"
+#include "Trace.h"
 
 /*引脚配置*/
 #define ENCODER_PORT GPIOB
@@ -9,7 +12,6 @@
 
 /*编码器计数变量*/
 int16_t Encoder_Count = 0;
-uint8_t Encoder_KeyFlag = 0;
 
 /*编码器防抖变量*/
 static int16_t last_valid_diff = 0;
@@ -17,9 +19,8 @@ static uint8_t debounce_counter = 0;
 #define DEBOUNCE_THRESHOLD 1 //只需要检测到一次旋转就有效
 
 /*按键防抖变量*/
-static uint8_t key_debounce_counter = 0;
-static uint8_t key_state = 1; //初始状态为释放（高电平）
-#define KEY_DEBOUNCE_THRESHOLD 5 //按键防抖阈值（5个主循环周期，约2.5秒）
+static uint32_t key_last_tick = 0;
+#define KEY_DEBOUNCE_MS 200 //按键防抖时间，200ms内的重复下降沿视为抖动
 
 /*编码器初始化*/
 void Encoder_Init(void)
@@ -94,17 +95,6 @@ int16_t Encoder_GetCount(void)
     return count;
 }
 
-/*获取编码器按键状态*/
-uint8_t Encoder_GetKeyStatus(void)
-{
-    if (Encoder_KeyFlag)
-    {
-        Encoder_KeyFlag = 0;
-        return 1;
-    }
-    return 0;
-}
-
 /*定时器3中断函数 - 用于编码器计数更新*/
 void TIM3_IRQHandler(void)
 {
@@ -119,8 +109,15 @@ void EXTI15_10_IRQHandler(void)
 {
     if (EXTI_GetITStatus(EXTI_Line10) == SET)
     {
-        //按键按下时产生中断，只设置标志位，防抖在主循环中处理
-        Encoder_KeyFlag = 1;
+        TRACE(TRACE_EV_KEY_ISR, 0);
+        
+        //按键按下时产生中断，按时间窗口防抖后投递按键事件
+        uint32_t now = Scheduler_GetTick();
+        if (now - key_last_tick >= KEY_DEBOUNCE_MS)
+        {
+            key_last_tick = now;
+            Event_Post(EVENT_KEY_PRESS, 0);
+        }
         EXTI_ClearITPendingBit(EXTI_Line10);
     }
 }
@@ -189,31 +186,4 @@ void Encoder_Update(void)
         //差值太小，重置防抖计数器
         debounce_counter = 0;
     }
-    
-    //按键防抖处理
-    uint8_t current_key_state = GPIO_ReadInputDataBit(ENCODER_PORT, ENCODER_KEY_PIN);
-    
-    if (current_key_state != key_state)
-    {
-        //按键状态变化，增加防抖计数器
-        key_debounce_counter++;
-        
-        if (key_debounce_counter >= KEY_DEBOUNCE_THRESHOLD)
-        {
-            //状态稳定，更新按键状态
-            key_state = current_key_state;
-            key_debounce_counter = 0;
-            
-            //如果是按下状态（低电平），设置按键标志
-            if (key_state == 0)
-            {
-                Encoder_KeyFlag = 1;
-            }
-        }
-    }
-    else
-    {
-        //状态未变化，重置防抖计数器
-        key_debounce_counter = 0;
-    }
 }
\ No newline at end of file
@@ -7,6 +7,7 @@
   * 函    数：编码器初始化
   * 参    数：无
   * 返 回 值：无
+  * 说    明：编码器按键由外部中断检测，防抖后以EVENT_KEY_PRESS事件投递到事件队列
   */
 void Encoder_Init(void);
 
@@ -17,13 +18,6 @@ void Encoder_Init(void);
   */
 int16_t Encoder_GetCount(void);
 
-/**
-  * 函    数：获取编码器按键状态
-  * 参    数：无
-  * 返 回 值：按键状态，1表示按键按下，0表示未按下
-  */
-uint8_t Encoder_GetKeyStatus(void);
-
 /**
   * 函    数：更新编码器计数值
   * 参    数：无
@@ -1,4 +1,7 @@
 #include "stm32f10x.h"                  // Device header
+#include "Event.h"
+#include "Latency.h"
+#include "Trace.h"
 
 /*引脚配置*/
 #define IR_PORT GPIOA
@@ -14,6 +17,27 @@ void IR_Init(void)
     GPIO_InitStructure.GPIO_Pin = IR_PIN;
     GPIO_InitStructure.GPIO_Speed = GPIO_Speed_50MHz;
     GPIO_Init(IR_PORT, &GPIO_InitStructure);
+    
+    /*外部中断配置 - 上升沿和下降沿均触发，红外状态变化立即上报*/
+    RCC_APB2PeriphClockCmd(RCC_APB2Periph_AFIO, ENABLE);
+    GPIO_EXTILineConfig(GPIO_PortSourceGPIOA, GPIO_PinSource1);
+    
+    EXTI_InitTypeDef EXTI_InitStructure;
+    EXTI_InitStructure.EXTI_Line = EXTI_Line1;
+    EXTI_InitStructure.EXTI_LineCmd = ENABLE;
+    EXTI_InitStructure.EXTI_Mode = EXTI_Mode_Interrupt;
+    EXTI_InitStructure.EXTI_Trigger = EXTI_Trigger_Rising_Falling;
+    EXTI_Init(&EXTI_InitStructure);
+    
+    /*NVIC配置，与其他投递事件的中断使用相同的抢占优先级*/
+    NVIC_PriorityGroupConfig(NVIC_PriorityGroup_2);
+    
+    NVIC_InitTypeDef NVIC_InitStructure;
+    NVIC_InitStructure.NVIC_IRQChannel = EXTI1_IRQn;
+    NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+    NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = 1;
+    NVIC_InitStructure.NVIC_IRQChannelSubPriority = 0;
+    NVIC_Init(&NVIC_InitStructure);
 }
 
 /*获取红外传感器状态*/
@@ -21,4 +45,25 @@ uint8_t IR_GetStatus(void)
 {
     //返回0表示检测到物体，返回1表示未检测到物体
     return GPIO_ReadInputDataBit(IR_PORT, IR_PIN);
+}
+
+/*外部中断1中断函数 - 红外传感器电平变化*/
+void EXTI1_IRQHandler(void)
+{
+    if (EXTI_GetITStatus(EXTI_Line1) == SET)
+    {
+        uint8_t level = GPIO_ReadInputDataBit(IR_PORT, IR_PIN);
+        
+        TRACE(TRACE_EV_IR_ISR, level);
+        
+        //检测到物体时开始报警延迟跟踪
+        if (level == 0)
+        {
+            Latency_Edge();
+        }
+        
+        //上报变化后的电平，由主循环处理报警逻辑
+        Event_Post(EVENT_IR_EDGE, level);
+        EXTI_ClearITPendingBit(EXTI_Line1);
+    }
 }
\ No newline at end of file
@@ -1,5 +1,9 @@
 #include "stm32f10x.h"
 #include "OLED_Font.h"
+#include "Perf.h"
+
+/*清屏耗时探针*/
+PERF_PROBE(perf_oled_clear, "OLED_Clear");
 
 /*引脚配置*/
 #define OLED_W_SCL(x)		GPIO_WriteBit(GPIOB, GPIO_Pin_8, (BitAction)(x))
@@ -114,6 +118,7 @@ void OLED_SetCursor(uint8_t Y, uint8_t X)
 void OLED_Clear(void)
 {  
 	uint8_t i, j;
+	PERF_BEGIN(perf_oled_clear);
 	for (j = 0; j < 8; j++)
 	{
 		OLED_SetCursor(j, 0);
@@ -122,6 +127,7 @@ void OLED_Clear(void)
 			OLED_WriteData(0x00);
 		}
 	}
+	PERF_END(perf_oled_clear);
 }
 
 /**
@@ -1,9 +1,18 @@
 #include "stm32f10x.h"                  // Device header
 #include <stdio.h>
 #include <stdarg.h>
+#include "Event.h"
+#include "Kernel.h"
+#include "Scheduler.h"
+#include "Perf.h"
+#include "Trace.h"
 
 uint8_t Serial_RxData;		//定义串口接收的数据变量
 uint8_t Serial_RxFlag;		//定义串口接收的标志位变量
+static volatile uint32_t Serial_LastRxTick;	//最近一次接收数据的时刻（ms），低功耗处理据此判断串口是否空闲
+
+static Kernel_Mutex_t Serial_Mutex;	//多线程输出互斥锁，保证每次Serial_Printf输出的内容不被打断
+PERF_PROBE(perf_serial_printf, "Serial_Printf");	//格式化和发送耗时探针，包含等待互斥锁的时间
 
 // 从main.c中导入变量
 extern char serial_command_buffer[64];
@@ -150,12 +159,28 @@ int fputc(int ch, FILE *f)
   */
 void Serial_Printf(char *format, ...)
 {
-	char String[128];				// 增大缓冲区到128字节，减少溢出风险
+	char String[128];				//每次输出最多127个字符，更长的行应拆成多次输出
 	va_list arg;					//定义可变参数列表数据类型的变量arg
+	int length;
+	PERF_BEGIN(perf_serial_printf);
 	va_start(arg, format);			//从format开始，接收参数列表到arg变量
-	vsprintf(String, format, arg);	//使用vsprintf打印格式化字符串和参数列表到字符数组中
+	length = vsnprintf(String, sizeof(String), format, arg);	//使用vsnprintf打印到字符数组中，超长时截断，不越界
 	va_end(arg);					//结束变量arg
+	if (length < 0)					//格式错误时不输出
+	{
+		length = 0;
+		String[0] = '\0';
+	}
+	else if (length >= (int)sizeof(String))	//被截断时按实际发送的长度记录
+	{
+		length = sizeof(String) - 1;
+	}
+	Kernel_MutexLock(&Serial_Mutex);	//获取输出互斥锁
+	TRACE(TRACE_EV_UART_TX_BEGIN, length);
 	Serial_SendString(String);		//串口发送字符数组（字符串）
+	TRACE(TRACE_EV_UART_TX_END, length);
+	Kernel_MutexUnlock(&Serial_Mutex);	//释放输出互斥锁
+	PERF_END(perf_serial_printf);
 }
 
 /**
@@ -183,6 +208,26 @@ uint8_t Serial_GetRxData(void)
 	return Serial_RxData;			//返回接收的数据变量
 }
 
+/**
+  * 函    数：获取最近一次接收数据的时刻
+  * 参    数：无
+  * 返 回 值：接收时刻（ms），上电后未接收过数据时为0
+  */
+uint32_t Serial_GetLastRxTick(void)
+{
+	return Serial_LastRxTick;
+}
+
+/**
+  * 函    数：查询发送是否全部完成（移位寄存器已空）
+  * 参    数：无
+  * 返 回 值：1：发送完成，0：仍在发送
+  */
+uint8_t Serial_IsTxIdle(void)
+{
+	return USART_GetFlagStatus(USART1, USART_FLAG_TC) == SET;
+}
+
 /**
   * 函    数：USART1中断函数
   * 参    数：无
@@ -199,15 +244,22 @@ void USART1_IRQHandler(void)
 	{
 		Serial_RxData = USART_ReceiveData(USART1);				//读取数据寄存器，存放在接收的数据变量
 		Serial_RxFlag = 1;										//置接收标志位变量为1
+		Serial_LastRxTick = Scheduler_GetTick();				//记录接收时刻
+		TRACE(TRACE_EV_UART_RX_ISR, Serial_RxData);
 		
 		// 处理命令接收
-		if (Serial_RxData == '\n') // 换行符表示命令结束
+		if (serial_command_received) // 上一条命令尚未处理完，丢弃新数据，避免改写缓冲区
+		{
+			// 不处理
+		}
+		else if (Serial_RxData == '\n') // 换行符表示命令结束
 		{
 			if (serial_command_length > 0) // 如果有有效命令
 			{
 				serial_command_buffer[serial_command_length] = '\0'; // 添加字符串结束符
-				serial_command_received = 1; // 置命令接收完成标志
+				serial_command_received = 1; // 置命令接收完成标志，处理完成后由主循环清除
 				serial_command_length = 0; // 重置命令长度
+				Event_Post(EVENT_COMMAND, 0); // 通知主循环处理命令
 			}
 		}
 		else if (Serial_RxData == '\r') // 忽略回车符
@@ -12,5 +12,7 @@ void Serial_Printf(char *format, ...);
 
 uint8_t Serial_GetRxFlag(void);
 uint8_t Serial_GetRxData(void);
+uint32_t Serial_GetLastRxTick(void);
+uint8_t Serial_IsTxIdle(void);
 
 #endif
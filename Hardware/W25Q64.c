@@ -12,9 +12,79 @@
 #include "stm32f10x_spi.h"
 #include "stm32f10x_gpio.h"
 #include "stm32f10x_rcc.h"
+#include "stm32f10x_dma.h"
+#include "misc.h"
 #include "Serial.h"
+#include "Trace.h"
+#include "Kernel.h"
+#include "Timer.h"
+#include "PT.h"
 #include <stddef.h>
 
+/* DMA memory address of a buffer (host builds keep 64-bit pointers and override this, see host_cm3.h) */
+#ifndef DMA_MEMORY_ADDR
+#define DMA_MEMORY_ADDR(p)              ((uint32_t)(p))
+#endif
+
+/* SPI link state */
+static uint16_t w25q64_prescaler = W25Q64_SPI_DEFAULT_PRESCALER;
+static uint8_t w25q64_read_cmd = W25Q64_CMD_READ_DATA;  /* Fast Read above W25Q64_READ_DATA_MAX_HZ */
+static uint8_t w25q64_test_pattern = 0;                 /* 1: the self-test page holds the pattern */
+static uint8_t w25q64_test_failures = 0;                /* Candidate speeds rejected by the last self-test */
+
+/* Self-test candidates, fastest first */
+static const uint16_t w25q64_prescalers[] = {
+    SPI_BaudRatePrescaler_2, SPI_BaudRatePrescaler_4, SPI_BaudRatePrescaler_8, SPI_BaudRatePrescaler_16
+};
+
+/* DMA transfer completion callback, called from the DMA interrupt; status 0: done, 1: DMA transfer error */
+typedef void (*W25Q64_Callback_t)(uint8_t status);
+
+/* DMA transfer state */
+static volatile uint8_t w25q64_dma_busy = 0;        /* Set from start until the completion interrupt */
+static W25Q64_Callback_t w25q64_dma_callback = NULL;
+static uint8_t w25q64_dma_enabled = 1;
+static const uint8_t w25q64_dma_tx_dummy = 0xFF;    /* TX source for reads */
+static uint8_t w25q64_dma_rx_dummy;                 /* RX sink for page programs */
+static Kernel_Sem_t w25q64_dma_sem;                 /* Posted on completion for the blocking wrappers */
+
+/* Transfer statistics (data bytes only, command and address bytes are always polled) */
+static uint32_t w25q64_dma_transfers = 0;
+static uint32_t w25q64_dma_bytes = 0;
+static uint32_t w25q64_dma_errors = 0;
+static uint32_t w25q64_polled_bytes = 0;
+
+/* Queued flash operation */
+typedef struct {
+    uint8_t cmd;                /* W25Q64_CMD_SECTOR_ERASE_4KB or W25Q64_CMD_PAGE_PROGRAM */
+    uint16_t length;            /* Program length, inside one page */
+    uint32_t addr;
+    const uint8_t* buffer;      /* Program data, owned by the caller until the program completes */
+    W25Q64_OpCallback_t done;   /* Called when the program completes, may be NULL */
+    uint32_t tag;               /* Argument of done */
+} W25Q64_Op_t;
+
+/* Operation engine state. Any thread may queue or poll (bulk, the timer service thread, and the
+   alarm thread when the supply drops), so the queue and the bus are only used with w25q64_mutex
+   held: foreground calls wait for it and hold it for a whole transaction, W25Q64_Poll only tries
+   it and skips a round while another thread holds it */
+static W25Q64_Op_t w25q64_ops[W25Q64_OP_QUEUE_SIZE];
+static volatile uint8_t w25q64_op_head = 0;     /* Operation in progress or next to start */
+static volatile uint8_t w25q64_op_count = 0;
+static uint8_t w25q64_op_started = 0;           /* The head operation has been sent to the chip */
+static Kernel_Mutex_t w25q64_mutex;             /* Bus and queue owner, with priority inheritance */
+static Timer_t w25q64_op_timer;
+
+/* Operation engine statistics */
+static uint8_t w25q64_op_max_depth = 0;
+static uint32_t w25q64_op_erases = 0;
+static uint32_t w25q64_op_programs = 0;
+static uint32_t w25q64_op_suspends = 0;         /* Erases suspended to serve a read */
+static uint32_t w25q64_op_read_waits = 0;       /* Reads that waited for a program or an erase of the same sector */
+static uint32_t w25q64_op_full_waits = 0;       /* Operations that waited for a free queue slot */
+
+static void W25Q64_PollTimer(void *arg);
+
 /**
   * @brief  Initializes the W25Q64 SPI communication
   * @param  None
@@ -22,11 +92,12 @@
   */
 void W25Q64_Init(void)
 {
-    SPI_InitTypeDef SPI_InitStructure;
     GPIO_InitTypeDef GPIO_InitStructure;
+    NVIC_InitTypeDef NVIC_InitStructure;
 
-    /* Enable SPI and GPIO clocks */
+    /* Enable SPI, GPIO and DMA clocks */
     RCC_APB2PeriphClockCmd(W25Q64_SPI_CLK | W25Q64_SPI_GPIO_CLK | W25Q64_CS_GPIO_CLK, ENABLE);
+    RCC_AHBPeriphClockCmd(W25Q64_DMA_CLK, ENABLE);
 
     /* Configure SPI pins: SCK, MISO, MOSI */
     GPIO_InitStructure.GPIO_Pin = W25Q64_SPI_PIN_SCK | W25Q64_SPI_PIN_MOSI;
@@ -46,6 +117,53 @@ void W25Q64_Init(void)
     /* Deselect W25Q64 */
     W25Q64_CS_HIGH();
 
+    /* SPI configuration at the known-good speed, W25Q64_SelfTest selects the fastest reliable one */
+    W25Q64_SetPrescaler(W25Q64_SPI_DEFAULT_PRESCALER);
+
+    /* DMA channels are configured per transfer, only the RX completion interrupt is used */
+    Kernel_SemInit(&w25q64_dma_sem, 0);
+    NVIC_PriorityGroupConfig(NVIC_PriorityGroup_2);
+    NVIC_InitStructure.NVIC_IRQChannel = W25Q64_DMA_RX_IRQn;
+    NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+    NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = 1;
+    NVIC_InitStructure.NVIC_IRQChannelSubPriority = 3;
+    NVIC_Init(&NVIC_InitStructure);
+
+    /* Operation engine poll timer, runs in the timer service thread */
+    Timer_Setup(&w25q64_op_timer, "flash", W25Q64_PollTimer, NULL);
+}
+
+/**
+  * @brief  Starts a foreground transaction, waiting while another thread uses the bus or the queue
+  * @param  None
+  * @retval None
+  * @note   Not recursive: a transaction must not call another locking function or W25Q64_Sync
+  */
+static void W25Q64_Lock(void)
+{
+    Kernel_MutexLock(&w25q64_mutex);
+}
+
+/**
+  * @brief  Ends a foreground transaction
+  * @param  None
+  * @retval None
+  */
+static void W25Q64_Unlock(void)
+{
+    Kernel_MutexUnlock(&w25q64_mutex);
+}
+
+/**
+  * @brief  Configures the SPI link speed and the matching read command
+  * @param  prescaler: SPI_BaudRatePrescaler_x, SCK = 72MHz / x
+  * @retval None
+  * @note   Must not be called while a DMA transfer is running
+  */
+void W25Q64_SetPrescaler(uint16_t prescaler)
+{
+    SPI_InitTypeDef SPI_InitStructure;
+
     /* SPI configuration */
     SPI_InitStructure.SPI_Direction = SPI_Direction_2Lines_FullDuplex;
     SPI_InitStructure.SPI_Mode = SPI_Mode_Master;
@@ -53,15 +171,39 @@ void W25Q64_Init(void)
     SPI_InitStructure.SPI_CPOL = SPI_CPOL_Low;
     SPI_InitStructure.SPI_CPHA = SPI_CPHA_1Edge;
     SPI_InitStructure.SPI_NSS = SPI_NSS_Soft;
-    SPI_InitStructure.SPI_BaudRatePrescaler = SPI_BaudRatePrescaler_16; /* 72MHz/16=4.5MHz */
+    SPI_InitStructure.SPI_BaudRatePrescaler = prescaler;
     SPI_InitStructure.SPI_FirstBit = SPI_FirstBit_MSB;
     SPI_InitStructure.SPI_CRCPolynomial = 7;
 
-    /* Initialize SPI */
+    /* Reinitialize SPI, the baud rate can only change while SPI is disabled */
+    W25Q64_Lock();
+    SPI_Cmd(W25Q64_SPI, DISABLE);
     SPI_Init(W25Q64_SPI, &SPI_InitStructure);
-
-    /* Enable SPI */
     SPI_Cmd(W25Q64_SPI, ENABLE);
+    W25Q64_Unlock();
+
+    w25q64_prescaler = prescaler;
+    w25q64_read_cmd = (W25Q64_SPI_HZ(prescaler) > W25Q64_READ_DATA_MAX_HZ) ? W25Q64_CMD_FAST_READ : W25Q64_CMD_READ_DATA;
+}
+
+/**
+  * @brief  Gets the SPI link speed
+  * @param  None
+  * @retval SCK frequency (Hz)
+  */
+uint32_t W25Q64_GetSpeedHz(void)
+{
+    return W25Q64_SPI_HZ(w25q64_prescaler);
+}
+
+/**
+  * @brief  Checks whether reads use Fast Read (0x0B) with a dummy byte
+  * @param  None
+  * @retval 1: Fast Read, 0: Read Data (0x03)
+  */
+uint8_t W25Q64_IsFastRead(void)
+{
+    return w25q64_read_cmd == W25Q64_CMD_FAST_READ;
 }
 
 /**
@@ -99,41 +241,748 @@ static uint8_t W25Q64_ReadStatusReg1(void)
     /* Send Read Status Register 1 command */
     W25Q64_SPI_SendByte(W25Q64_CMD_READ_STATUS_REG1);
 
-    /* Read status register value */
-    status = W25Q64_SPI_SendByte(0x00);
+    /* Read status register value */
+    status = W25Q64_SPI_SendByte(0x00);
+
+    /* Deselect W25Q64 */
+    W25Q64_CS_HIGH();
+
+    return status;
+}
+
+/**
+  * @brief  Reads the status register 2 of the W25Q64
+  * @param  None
+  * @retval Status register 2 value
+  */
+static uint8_t W25Q64_ReadStatusReg2(void)
+{
+    uint8_t status;
+
+    /* Select W25Q64 */
+    W25Q64_CS_LOW();
+
+    /* Send Read Status Register 2 command */
+    W25Q64_SPI_SendByte(W25Q64_CMD_READ_STATUS_REG2);
+
+    /* Read status register value */
+    status = W25Q64_SPI_SendByte(0x00);
+
+    /* Deselect W25Q64 */
+    W25Q64_CS_HIGH();
+
+    return status;
+}
+
+/**
+  * @brief  Checks whether the W25Q64 is busy with a program or erase operation
+  * @param  None
+  * @retval 1: busy, 0: ready
+  */
+uint8_t W25Q64_IsBusy(void)
+{
+    return (W25Q64_ReadStatusReg1() & W25Q64_SR1_BUSY) == W25Q64_SR1_BUSY;
+}
+
+/**
+  * @brief  Waits until the W25Q64 is ready for a new operation
+  * @param  None
+  * @retval None
+  */
+static void W25Q64_WaitForReady(void)
+{
+    /* Wait until BUSY bit is cleared */
+    while ((W25Q64_ReadStatusReg1() & W25Q64_SR1_BUSY) == W25Q64_SR1_BUSY);
+}
+
+/**
+  * @brief  Reads the JEDEC ID of the W25Q64
+  * @param  None
+  * @retval Manufacturer ID, memory type and capacity, W25Q64_JEDEC_ID for a W25Q64
+  */
+uint32_t W25Q64_ReadJedecId(void)
+{
+    uint32_t id;
+
+    /* Select W25Q64 */
+    W25Q64_Lock();
+    W25Q64_CS_LOW();
+
+    /* Send JEDEC ID command and read 3 bytes */
+    W25Q64_SPI_SendByte(W25Q64_CMD_JEDEC_ID);
+    id = (uint32_t)W25Q64_SPI_SendByte(0x00) << 16;
+    id |= (uint32_t)W25Q64_SPI_SendByte(0x00) << 8;
+    id |= W25Q64_SPI_SendByte(0x00);
+
+    /* Deselect W25Q64 */
+    W25Q64_CS_HIGH();
+    W25Q64_Unlock();
+
+    return id;
+}
+
+/**
+  * @brief  Sends a single-byte instruction to the W25Q64
+  * @param  cmd: instruction
+  * @retval None
+  */
+static void W25Q64_SendInstruction(uint8_t cmd)
+{
+    /* Select W25Q64 */
+    W25Q64_CS_LOW();
+
+    /* Send instruction */
+    W25Q64_SPI_SendByte(cmd);
+
+    /* Deselect W25Q64 */
+    W25Q64_CS_HIGH();
+}
+
+/**
+  * @brief  Sends Write Enable command to the W25Q64
+  * @param  None
+  * @retval None
+  */
+static void W25Q64_WriteEnable(void)
+{
+    W25Q64_SendInstruction(W25Q64_CMD_WRITE_ENABLE);
+}
+
+/**
+  * @brief  Sends a command followed by a 24-bit address, CS must already be low
+  * @param  cmd: command
+  * @param  addr: address
+  * @retval None
+  */
+static void W25Q64_SendCommand(uint8_t cmd, uint32_t addr)
+{
+    W25Q64_SPI_SendByte(cmd);
+    W25Q64_SPI_SendByte((addr >> 16) & 0xFF);
+    W25Q64_SPI_SendByte((addr >> 8) & 0xFF);
+    W25Q64_SPI_SendByte(addr & 0xFF);
+}
+
+/**
+  * @brief  Selects the W25Q64 and starts a read at the current link speed
+  * @param  addr: start address to read from
+  * @retval None
+  * @note   Fast Read needs one dummy byte after the address; CS is left low
+  */
+static void W25Q64_ReadBegin(uint32_t addr)
+{
+    W25Q64_CS_LOW();
+    W25Q64_SendCommand(w25q64_read_cmd, addr);
+    if (w25q64_read_cmd == W25Q64_CMD_FAST_READ)
+    {
+        W25Q64_SPI_SendByte(0xFF);
+    }
+}
+
+/**
+  * @brief  Waits for the previous operation, enables writing and starts a Page Program command
+  * @param  addr: start address inside the page
+  * @retval None
+  * @note   CS is left low, the caller sends the data and raises CS to start programming
+  */
+static void W25Q64_PageProgramBegin(uint32_t addr)
+{
+    /* Wait for W25Q64 to be ready */
+    W25Q64_WaitForReady();
+
+    /* Send Write Enable command */
+    W25Q64_WriteEnable();
+
+    /* Select W25Q64 and send Page Program command with address */
+    W25Q64_CS_LOW();
+    W25Q64_SendCommand(W25Q64_CMD_PAGE_PROGRAM, addr);
+}
+
+/**
+  * @brief  Marks the DMA engine busy if it is free
+  * @param  None
+  * @retval 0: claimed, 1: a transfer is already running
+  */
+static uint8_t W25Q64_DmaClaim(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    uint8_t busy;
+
+    __disable_irq();
+    busy = w25q64_dma_busy;
+    w25q64_dma_busy = 1;
+    __set_PRIMASK(primask);
+
+    return busy;
+}
+
+/**
+  * @brief  Starts a full-duplex DMA transfer on SPI1, CS must already be low
+  * @param  rx: receive buffer, NULL to discard the received bytes
+  * @param  tx: transmit buffer, NULL to send 0xFF
+  * @param  length: number of bytes
+  * @param  callback: completion callback
+  * @retval None
+  * @note   The RX channel receives the last byte after it has been shifted out,
+  *         so its transfer complete interrupt marks the end of the whole transfer
+  */
+static void W25Q64_DmaStart(uint8_t* rx, const uint8_t* tx, uint16_t length, W25Q64_Callback_t callback)
+{
+    DMA_InitTypeDef DMA_InitStructure;
+
+    w25q64_dma_callback = callback;
+    w25q64_dma_transfers++;
+    w25q64_dma_bytes += length;
+
+    DMA_InitStructure.DMA_PeripheralBaseAddr = W25Q64_SPI_DR_ADDR;
+    DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+    DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Byte;
+    DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_Byte;
+    DMA_InitStructure.DMA_BufferSize = length;
+    DMA_InitStructure.DMA_Mode = DMA_Mode_Normal;
+    DMA_InitStructure.DMA_M2M = DMA_M2M_Disable;
+
+    /* RX channel: SPI1->DR to memory, higher priority so DR is read before the next byte arrives */
+    DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralSRC;
+    DMA_InitStructure.DMA_MemoryBaseAddr = DMA_MEMORY_ADDR(rx ? rx : &w25q64_dma_rx_dummy);
+    DMA_InitStructure.DMA_MemoryInc = rx ? DMA_MemoryInc_Enable : DMA_MemoryInc_Disable;
+    DMA_InitStructure.DMA_Priority = DMA_Priority_VeryHigh;
+    DMA_Init(W25Q64_DMA_RX_CHANNEL, &DMA_InitStructure);
+
+    /* TX channel: memory to SPI1->DR */
+    DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralDST;
+    DMA_InitStructure.DMA_MemoryBaseAddr = DMA_MEMORY_ADDR(tx ? tx : &w25q64_dma_tx_dummy);
+    DMA_InitStructure.DMA_MemoryInc = tx ? DMA_MemoryInc_Enable : DMA_MemoryInc_Disable;
+    DMA_InitStructure.DMA_Priority = DMA_Priority_High;
+    DMA_Init(W25Q64_DMA_TX_CHANNEL, &DMA_InitStructure);
+
+    DMA_ITConfig(W25Q64_DMA_RX_CHANNEL, DMA_IT_TC | DMA_IT_TE, ENABLE);
+    TRACE(TRACE_EV_FLASH_DMA_BEGIN, length);
+
+    /* TXE is already set, so the TX request starts the transfer as soon as it is enabled */
+    DMA_Cmd(W25Q64_DMA_RX_CHANNEL, ENABLE);
+    DMA_Cmd(W25Q64_DMA_TX_CHANNEL, ENABLE);
+    SPI_I2S_DMACmd(W25Q64_SPI, SPI_I2S_DMAReq_Rx | SPI_I2S_DMAReq_Tx, ENABLE);
+}
+
+/**
+  * @brief  DMA1 channel 2 (SPI1_RX) interrupt: ends the transfer and calls the completion callback
+  * @param  None
+  * @retval None
+  */
+void DMA1_Channel2_IRQHandler(void)
+{
+    W25Q64_Callback_t callback = w25q64_dma_callback;
+    uint8_t status = (DMA_GetITStatus(W25Q64_DMA_RX_IT_TE) == SET);
+
+    DMA_ClearITPendingBit(W25Q64_DMA_RX_IT_GL | W25Q64_DMA_TX_IT_GL);
+    DMA_Cmd(W25Q64_DMA_RX_CHANNEL, DISABLE);
+    DMA_Cmd(W25Q64_DMA_TX_CHANNEL, DISABLE);
+    SPI_I2S_DMACmd(W25Q64_SPI, SPI_I2S_DMAReq_Rx | SPI_I2S_DMAReq_Tx, DISABLE);
+
+    /* Deselect W25Q64, a page program starts here */
+    W25Q64_CS_HIGH();
+    TRACE(TRACE_EV_FLASH_DMA_END, status);
+
+    if (status)
+    {
+        w25q64_dma_errors++;
+    }
+    w25q64_dma_callback = NULL;
+    w25q64_dma_busy = 0;
+
+    if (callback != NULL)
+    {
+        callback(status);
+    }
+}
+
+/**
+  * @brief  Completion callback of the blocking wrappers, wakes the waiting thread
+  * @param  status: transfer status (unused, the data is checked by the caller's CRC)
+  * @retval None
+  */
+static void W25Q64_DmaWakeup(uint8_t status)
+{
+    (void)status;
+    Kernel_SemPost(&w25q64_dma_sem);
+}
+
+/**
+  * @brief  Decides whether a blocking transfer uses DMA
+  * @param  length: number of data bytes
+  * @retval 1: DMA, 0: polled
+  * @note   Only threads can sleep until the completion interrupt; before the kernel
+  *         starts and in interrupts the polled path is used
+  */
+static uint8_t W25Q64_UseDma(uint32_t length)
+{
+    return w25q64_dma_enabled && length >= W25Q64_DMA_MIN_LENGTH && Kernel_InThread();
+}
+
+/**
+  * @brief  Starts reading bytes from the W25Q64 by DMA
+  * @param  addr: start address to read from
+  * @param  buffer: buffer to store read data, must stay valid until the callback
+  * @param  length: number of bytes to read
+  * @param  callback: called from the DMA interrupt when the data is in the buffer
+  * @retval 0: started, 1: another transfer is running, 2: invalid parameters
+  * @note   Caller holds the bus lock. Waits (polled) for a page program started by
+  *         W25Q64_PageProgramAsync to finish
+  */
+static uint8_t W25Q64_ReadBytesAsync(uint32_t addr, uint8_t* buffer, uint16_t length, W25Q64_Callback_t callback)
+{
+    /* Check parameters */
+    if (buffer == NULL || length == 0) return 2;
+    if (W25Q64_DmaClaim()) return 1;
+
+    /* Wait for W25Q64 to be ready */
+    W25Q64_WaitForReady();
+
+    /* Select W25Q64 and send the read command with address */
+    W25Q64_ReadBegin(addr);
+
+    /* Read data, CS is raised in the completion interrupt */
+    W25Q64_DmaStart(buffer, NULL, length, callback);
+    return 0;
+}
+
+/**
+  * @brief  Starts programming bytes inside one page of the W25Q64 by DMA
+  * @param  addr: start address to write to
+  * @param  buffer: data to write, must stay valid until the callback
+  * @param  length: number of bytes to write, must not cross a page boundary
+  * @param  callback: called from the DMA interrupt when the data has been sent
+  * @retval 0: started, 1: another transfer is running, 2: invalid parameters
+  * @note   The chip is still programming when the callback runs (about 0.7ms);
+  *         the next read or program waits for it. Caller holds the bus lock
+  */
+static uint8_t W25Q64_PageProgramAsync(uint32_t addr, const uint8_t* buffer, uint16_t length, W25Q64_Callback_t callback)
+{
+    /* Check parameters */
+    if (buffer == NULL || length == 0 || (addr % W25Q64_PAGE_SIZE) + length > W25Q64_PAGE_SIZE) return 2;
+    if (W25Q64_DmaClaim()) return 1;
+
+    W25Q64_PageProgramBegin(addr);
+
+    /* Send data, CS is raised in the completion interrupt */
+    W25Q64_DmaStart(NULL, buffer, length, callback);
+    return 0;
+}
+
+/**
+  * @brief  Checks whether a DMA transfer is running
+  * @param  None
+  * @retval 1: busy, 0: idle
+  */
+uint8_t W25Q64_IsTransferBusy(void)
+{
+    return w25q64_dma_busy;
+}
+
+/**
+  * @brief  Enables or disables DMA for the blocking ReadBytes/WriteBytes
+  * @param  enable: 1: DMA for long transfers, 0: always polled
+  * @retval None
+  */
+void W25Q64_SetDmaEnabled(uint8_t enable)
+{
+    w25q64_dma_enabled = enable;
+}
+
+/**
+  * @brief  Checks whether the blocking ReadBytes/WriteBytes use DMA
+  * @param  None
+  * @retval 1: enabled, 0: disabled
+  */
+uint8_t W25Q64_IsDmaEnabled(void)
+{
+    return w25q64_dma_enabled;
+}
+
+/**
+  * @brief  Prints the link, transfer and operation engine statistics
+  * @param  None
+  * @retval None
+  */
+void W25Q64_ReportStats(void)
+{
+    Serial_Printf("[FLASH] SPI link %lu kHz, %s, self-test %s, %u faster speeds rejected\n",
+                  W25Q64_GetSpeedHz() / 1000, W25Q64_IsFastRead() ? "Fast Read 0x0B" : "Read Data 0x03",
+                  w25q64_test_pattern ? "pattern" : "JEDEC ID only", w25q64_test_failures);
+    Serial_Printf("[FLASH] SPI DMA %s: %lu transfers, %lu bytes, %lu errors; polled %lu bytes\n",
+                  w25q64_dma_enabled ? "on" : "off", w25q64_dma_transfers, w25q64_dma_bytes,
+                  w25q64_dma_errors, w25q64_polled_bytes);
+    Serial_Printf("[FLASH] Op queue: %u of %u queued (max %u), %lu erases, %lu programs done\n",
+                  w25q64_op_count, W25Q64_OP_QUEUE_SIZE, w25q64_op_max_depth, w25q64_op_erases,
+                  w25q64_op_programs);
+    Serial_Printf("[FLASH] Op waits: %lu erase suspends for reads, %lu reads waited, %lu full-queue waits\n",
+                  w25q64_op_suspends, w25q64_op_read_waits, w25q64_op_full_waits);
+}
+
+/**
+  * @brief  Clears the transfer and operation engine statistics
+  * @param  None
+  * @retval None
+  */
+void W25Q64_ResetStats(void)
+{
+    w25q64_dma_transfers = 0;
+    w25q64_dma_bytes = 0;
+    w25q64_dma_errors = 0;
+    w25q64_polled_bytes = 0;
+    w25q64_op_max_depth = w25q64_op_count;
+    w25q64_op_erases = 0;
+    w25q64_op_programs = 0;
+    w25q64_op_suspends = 0;
+    w25q64_op_read_waits = 0;
+    w25q64_op_full_waits = 0;
+}
+
+/**
+  * @brief  Sends the head operation of the queue to the chip, CS is raised to start it
+  * @param  op: operation
+  * @retval None
+  */
+static void W25Q64_OpStart(const W25Q64_Op_t* op)
+{
+    uint16_t i;
+
+    /* Send Write Enable command */
+    W25Q64_WriteEnable();
+
+    /* Select W25Q64 and send the command with address */
+    W25Q64_CS_LOW();
+    W25Q64_SendCommand(op->cmd, op->addr);
+
+    /* Send program data, at most one page (70us at 36MHz) */
+    if (op->cmd == W25Q64_CMD_PAGE_PROGRAM)
+    {
+        for (i = 0; i < op->length; i++)
+        {
+            W25Q64_SPI_SendByte(op->buffer[i]);
+        }
+        w25q64_polled_bytes += op->length;
+    }
+
+    /* Deselect W25Q64, the chip starts erasing or programming */
+    W25Q64_CS_HIGH();
+    if (op->cmd == W25Q64_CMD_SECTOR_ERASE_4KB)
+    {
+        TRACE(TRACE_EV_FLASH_ERASE_BEGIN, op->addr / W25Q64_SECTOR_SIZE);
+    }
+    w25q64_op_started = 1;
+}
+
+/**
+  * @brief  Removes the completed head operation from the queue
+  * @param  op: operation
+  * @retval None
+  */
+static void W25Q64_OpComplete(const W25Q64_Op_t* op)
+{
+    W25Q64_OpCallback_t done = op->done;
+    uint32_t tag = op->tag;
+
+    if (op->cmd == W25Q64_CMD_SECTOR_ERASE_4KB)
+    {
+        TRACE(TRACE_EV_FLASH_ERASE_END, op->addr / W25Q64_SECTOR_SIZE);
+        w25q64_op_erases++;
+    }
+    else
+    {
+        w25q64_op_programs++;
+    }
+    w25q64_op_started = 0;
+    w25q64_op_head = (w25q64_op_head + 1) % W25Q64_OP_QUEUE_SIZE;
+    w25q64_op_count--;
+
+    if (done != NULL)
+    {
+        done(tag);
+    }
+}
+
+/**
+  * @brief  Advances the operation engine: completes the running operation once BUSY clears
+  *         and starts the next one; rearms the poll timer while operations are queued
+  * @param  None
+  * @retval None
+  * @note   Called from the poll timer, after queueing and by threads waiting for the queue.
+  *         Skips a round while another thread or a DMA transfer is using the bus
+  */
+void W25Q64_Poll(void)
+{
+    if (Kernel_MutexTryLock(&w25q64_mutex) == 0)
+    {
+        while (w25q64_op_count > 0 && !w25q64_dma_busy)
+        {
+            const W25Q64_Op_t* op = &w25q64_ops[w25q64_op_head];
+
+            if (!w25q64_op_started)
+            {
+                W25Q64_OpStart(op);
+            }
+            else if (W25Q64_ReadStatusReg1() & W25Q64_SR1_BUSY)
+            {
+                break;
+            }
+            else
+            {
+                W25Q64_OpComplete(op);
+            }
+        }
+        W25Q64_Unlock();
+    }
+
+    if (w25q64_op_count > 0)
+    {
+        Timer_Start(&w25q64_op_timer, W25Q64_OP_POLL_MS, 0);
+    }
+}
+
+/**
+  * @brief  Poll timer callback
+  * @param  arg: unused
+  * @retval None
+  */
+static void W25Q64_PollTimer(void *arg)
+{
+    (void)arg;
+    W25Q64_Poll();
+}
+
+/**
+  * @brief  Waits one poll interval for the operation in progress
+  * @param  None
+  * @retval None
+  * @note   Threads sleep; before the kernel starts the caller keeps polling
+  */
+static void W25Q64_OpWait(void)
+{
+    if (Kernel_InThread())
+    {
+        Kernel_Sleep(W25Q64_OP_POLL_MS);
+    }
+}
+
+/**
+  * @brief  Waits until every queued operation has completed
+  * @param  None
+  * @retval None
+  * @note   Must not be called during a foreground transaction (the engine would stay off the bus)
+  */
+void W25Q64_Sync(void)
+{
+    while (w25q64_op_count > 0)
+    {
+        W25Q64_Poll();
+        if (w25q64_op_count > 0)
+        {
+            W25Q64_OpWait();
+        }
+    }
+}
+
+/**
+  * @brief  Appends an operation to the queue, waiting for a free slot when it is full
+  * @param  cmd: W25Q64_CMD_SECTOR_ERASE_4KB or W25Q64_CMD_PAGE_PROGRAM
+  * @param  addr: sector address or program start address
+  * @param  buffer: program data
+  * @param  length: program length
+  * @param  done: completion callback, NULL for none
+  * @param  tag: argument of done
+  * @retval None
+  */
+static void W25Q64_OpQueue(uint8_t cmd, uint32_t addr, const uint8_t* buffer, uint16_t length,
+                           W25Q64_OpCallback_t done, uint32_t tag)
+{
+    W25Q64_Op_t* op;
+
+    W25Q64_Lock();
+    if (w25q64_op_count >= W25Q64_OP_QUEUE_SIZE)
+    {
+        w25q64_op_full_waits++;
+        do
+        {
+            /* Release the queue so the engine (or another thread) can complete operations */
+            W25Q64_Unlock();
+            W25Q64_Poll();
+            if (w25q64_op_count >= W25Q64_OP_QUEUE_SIZE)
+            {
+                W25Q64_OpWait();
+            }
+            W25Q64_Lock();
+        } while (w25q64_op_count >= W25Q64_OP_QUEUE_SIZE);
+    }
+
+    op = &w25q64_ops[(w25q64_op_head + w25q64_op_count) % W25Q64_OP_QUEUE_SIZE];
+    op->cmd = cmd;
+    op->addr = addr;
+    op->buffer = buffer;
+    op->length = length;
+    op->done = done;
+    op->tag = tag;
+    w25q64_op_count++;
+    if (w25q64_op_count > w25q64_op_max_depth)
+    {
+        w25q64_op_max_depth = w25q64_op_count;
+    }
+    W25Q64_Unlock();
+
+    /* Start it right away when the chip is idle */
+    W25Q64_Poll();
+}
+
+/**
+  * @brief  Queues a sector (4KB) erase
+  * @param  sector_addr: sector address to erase
+  * @retval 0: queued
+  * @note   Waits for a free slot when the queue is full; the erase runs in the background
+  */
+uint8_t W25Q64_QueueErase(uint32_t sector_addr)
+{
+    W25Q64_OpQueue(W25Q64_CMD_SECTOR_ERASE_4KB, sector_addr - (sector_addr % W25Q64_SECTOR_SIZE), NULL, 0, NULL, 0);
+    return 0;
+}
+
+/**
+  * @brief  Queues a page program
+  * @param  addr: start address to write to
+  * @param  buffer: data to write, must stay unchanged until the program completes
+  * @param  length: number of bytes to write, must not cross a page boundary
+  * @retval 0: queued, 1: invalid parameters
+  * @note   Waits for a free slot when the queue is full; operations run in queue order
+  */
+uint8_t W25Q64_QueueProgram(uint32_t addr, const uint8_t* buffer, uint16_t length)
+{
+    return W25Q64_QueueProgramNotify(addr, buffer, length, NULL, 0);
+}
+
+/**
+  * @brief  Queues a page program and reports its completion
+  * @param  addr: start address to write to
+  * @param  buffer: data to write, must stay unchanged until the program completes
+  * @param  length: number of bytes to write, must not cross a page boundary
+  * @param  done: called with tag once the chip has finished programming, NULL for none
+  * @param  tag: argument of done
+  * @retval 0: queued, 1: invalid parameters
+  * @note   Programs complete in queue order, so callbacks run in the order the programs were queued
+  */
+uint8_t W25Q64_QueueProgramNotify(uint32_t addr, const uint8_t* buffer, uint16_t length,
+                                  W25Q64_OpCallback_t done, uint32_t tag)
+{
+    /* Check parameters */
+    if (buffer == NULL || length == 0 || (addr % W25Q64_PAGE_SIZE) + length > W25Q64_PAGE_SIZE) return 1;
+
+    W25Q64_OpQueue(W25Q64_CMD_PAGE_PROGRAM, addr, buffer, length, done, tag);
+    return 0;
+}
+
+/**
+  * @brief  Gets the number of queued operations, including the one in progress
+  * @param  None
+  * @retval Queue depth
+  */
+uint8_t W25Q64_GetQueueDepth(void)
+{
+    return w25q64_op_count;
+}
+
+/**
+  * @brief  Gets the number of queued sector erases, including one in progress
+  * @param  None
+  * @retval Number of erases
+  */
+uint8_t W25Q64_GetQueuedErases(void)
+{
+    uint8_t i, erases = 0;
+
+    W25Q64_Lock();
+    for (i = 0; i < w25q64_op_count; i++)
+    {
+        if (w25q64_ops[(w25q64_op_head + i) % W25Q64_OP_QUEUE_SIZE].cmd == W25Q64_CMD_SECTOR_ERASE_4KB)
+        {
+            erases++;
+        }
+    }
+    W25Q64_Unlock();
+    return erases;
+}
+
+/**
+  * @brief  Checks whether a queued program still reads from a buffer
+  * @param  buffer: start of the buffer
+  * @param  length: buffer size in bytes
+  * @retval 1: a queued or running program uses the buffer, 0: the buffer may be reused
+  */
+uint8_t W25Q64_IsQueued(const uint8_t* buffer, uint16_t length)
+{
+    uint8_t i, queued = 0;
 
-    /* Deselect W25Q64 */
-    W25Q64_CS_HIGH();
+    W25Q64_Lock();
+    for (i = 0; i < w25q64_op_count; i++)
+    {
+        const W25Q64_Op_t* op = &w25q64_ops[(w25q64_op_head + i) % W25Q64_OP_QUEUE_SIZE];
 
-    return status;
+        if (op->length > 0 && op->buffer < buffer + length && buffer < op->buffer + op->length)
+        {
+            queued = 1;
+        }
+    }
+    W25Q64_Unlock();
+    return queued;
 }
 
 /**
-  * @brief  Waits until the W25Q64 is ready for a new operation
-  * @param  None
-  * @retval None
+  * @brief  Makes the chip readable for a foreground read, called with w25q64_mutex held
+  * @param  addr: start address of the read
+  * @param  length: number of bytes to read
+  * @retval 1: an erase was suspended and must be resumed after the read, 0: nothing to resume
+  * @note   An erase elsewhere is suspended (tSUS, at most 20us); a page program (about 0.7ms)
+  *         or an erase of the sector being read is waited for
   */
-static void W25Q64_WaitForReady(void)
+static uint8_t W25Q64_ReadSuspend(uint32_t addr, uint32_t length)
 {
-    /* Wait until BUSY bit is cleared */
-    while ((W25Q64_ReadStatusReg1() & W25Q64_SR1_BUSY) == W25Q64_SR1_BUSY);
+    const W25Q64_Op_t* op = &w25q64_ops[w25q64_op_head];
+
+    if (!w25q64_op_started || !(W25Q64_ReadStatusReg1() & W25Q64_SR1_BUSY))
+    {
+        return 0;
+    }
+
+    if (op->cmd != W25Q64_CMD_SECTOR_ERASE_4KB ||
+        (addr < op->addr + W25Q64_SECTOR_SIZE && addr + length > op->addr))
+    {
+        w25q64_op_read_waits++;
+        W25Q64_WaitForReady();
+        return 0;
+    }
+
+    W25Q64_SendInstruction(W25Q64_CMD_ERASE_SUSPEND);
+    W25Q64_WaitForReady();
+
+    /* The erase may have completed just before the suspend, then there is nothing to resume */
+    if (!(W25Q64_ReadStatusReg2() & W25Q64_SR2_SUS))
+    {
+        return 0;
+    }
+    w25q64_op_suspends++;
+    TRACE(TRACE_EV_FLASH_SUSPEND, op->addr / W25Q64_SECTOR_SIZE);
+    return 1;
 }
 
 /**
-  * @brief  Sends Write Enable command to the W25Q64
-  * @param  None
+  * @brief  Resumes the erase suspended by W25Q64_ReadSuspend
+  * @param  suspended: return value of W25Q64_ReadSuspend
   * @retval None
   */
-static void W25Q64_WriteEnable(void)
+static void W25Q64_ReadResume(uint8_t suspended)
 {
-    /* Select W25Q64 */
-    W25Q64_CS_LOW();
-
-    /* Send Write Enable command */
-    W25Q64_SPI_SendByte(W25Q64_CMD_WRITE_ENABLE);
-
-    /* Deselect W25Q64 */
-    W25Q64_CS_HIGH();
+    if (suspended)
+    {
+        W25Q64_SendInstruction(W25Q64_CMD_ERASE_RESUME);
+        TRACE(TRACE_EV_FLASH_RESUME, w25q64_ops[w25q64_op_head].addr / W25Q64_SECTOR_SIZE);
+    }
 }
 
 /**
@@ -143,18 +992,14 @@ static void W25Q64_WriteEnable(void)
   */
 uint8_t W25Q64_ReadByte(uint32_t addr)
 {
-    uint8_t data;
-
-    /* Select W25Q64 */
-    W25Q64_CS_LOW();
+    uint8_t data, suspended;
 
-    /* Send Read Data command */
-    W25Q64_SPI_SendByte(W25Q64_CMD_READ_DATA);
+    /* Suspend a background erase */
+    W25Q64_Lock();
+    suspended = W25Q64_ReadSuspend(addr, 1);
 
-    /* Send address */
-    W25Q64_SPI_SendByte((addr >> 16) & 0xFF);
-    W25Q64_SPI_SendByte((addr >> 8) & 0xFF);
-    W25Q64_SPI_SendByte(addr & 0xFF);
+    /* Select W25Q64 and send the read command with address */
+    W25Q64_ReadBegin(addr);
 
     /* Read data */
     data = W25Q64_SPI_SendByte(0x00);
@@ -162,6 +1007,8 @@ uint8_t W25Q64_ReadByte(uint32_t addr)
     /* Deselect W25Q64 */
     W25Q64_CS_HIGH();
 
+    W25Q64_ReadResume(suspended);
+    W25Q64_Unlock();
     return data;
 }
 
@@ -175,29 +1022,51 @@ uint8_t W25Q64_ReadByte(uint32_t addr)
 void W25Q64_ReadBytes(uint32_t addr, uint8_t* buffer, uint32_t length)
 {
     uint32_t i;
+    uint8_t suspended;
 
     /* Check parameters */
     if (buffer == NULL || length == 0) return;
 
-    /* Select W25Q64 */
-    W25Q64_CS_LOW();
+    /* Suspend a background erase */
+    W25Q64_Lock();
+    suspended = W25Q64_ReadSuspend(addr, length);
 
-    /* Send Read Data command */
-    W25Q64_SPI_SendByte(W25Q64_CMD_READ_DATA);
+    /* Long reads from a thread: DMA, sleep until the completion interrupt */
+    if (W25Q64_UseDma(length))
+    {
+        while (length > 0)
+        {
+            uint16_t chunk = (length > W25Q64_DMA_MAX_LENGTH) ? W25Q64_DMA_MAX_LENGTH : length;
 
-    /* Send address */
-    W25Q64_SPI_SendByte((addr >> 16) & 0xFF);
-    W25Q64_SPI_SendByte((addr >> 8) & 0xFF);
-    W25Q64_SPI_SendByte(addr & 0xFF);
+            /* DMA engine not free: read the rest polled instead of waiting for a wakeup */
+            if (W25Q64_ReadBytesAsync(addr, buffer, chunk, W25Q64_DmaWakeup) != 0) break;
+            Kernel_SemWait(&w25q64_dma_sem, KERNEL_WAIT_FOREVER);
 
-    /* Read data */
-    for (i = 0; i < length; i++)
+            addr += chunk;
+            buffer += chunk;
+            length -= chunk;
+        }
+    }
+
+    if (length > 0)
     {
-        buffer[i] = W25Q64_SPI_SendByte(0x00);
+        w25q64_polled_bytes += length;
+
+        /* Select W25Q64 and send the read command with address */
+        W25Q64_ReadBegin(addr);
+
+        /* Read data */
+        for (i = 0; i < length; i++)
+        {
+            buffer[i] = W25Q64_SPI_SendByte(0x00);
+        }
+
+        /* Deselect W25Q64 */
+        W25Q64_CS_HIGH();
     }
 
-    /* Deselect W25Q64 */
-    W25Q64_CS_HIGH();
+    W25Q64_ReadResume(suspended);
+    W25Q64_Unlock();
 }
 
 /**
@@ -208,6 +1077,10 @@ void W25Q64_ReadBytes(uint32_t addr, uint8_t* buffer, uint32_t length)
   */
 void W25Q64_WriteByte(uint32_t addr, uint8_t data)
 {
+    /* Let queued operations complete first */
+    W25Q64_Sync();
+    W25Q64_Lock();
+
     /* Wait for W25Q64 to be ready */
     W25Q64_WaitForReady();
 
@@ -233,6 +1106,7 @@ void W25Q64_WriteByte(uint32_t addr, uint8_t data)
 
     /* Wait for write to complete */
     W25Q64_WaitForReady();
+    W25Q64_Unlock();
 }
 
 /**
@@ -250,11 +1124,12 @@ void W25Q64_WriteBytes(uint32_t addr, uint8_t* buffer, uint32_t length)
     /* Check parameters */
     if (buffer == NULL || length == 0) return;
 
+    /* Let queued operations complete first */
+    W25Q64_Sync();
+    W25Q64_Lock();
+
     while (length > 0)
     {
-        /* Wait for W25Q64 to be ready */
-        W25Q64_WaitForReady();
-
         /* Calculate current page and next page start address */
         current_page = addr / W25Q64_PAGE_SIZE;
         next_page_start = (current_page + 1) * W25Q64_PAGE_SIZE;
@@ -266,28 +1141,26 @@ void W25Q64_WriteBytes(uint32_t addr, uint8_t* buffer, uint32_t length)
             bytes_to_write = length;
         }
 
-        /* Send Write Enable command */
-        W25Q64_WriteEnable();
-
-        /* Select W25Q64 */
-        W25Q64_CS_LOW();
-
-        /* Send Page Program command */
-        W25Q64_SPI_SendByte(W25Q64_CMD_PAGE_PROGRAM);
-
-        /* Send address */
-        W25Q64_SPI_SendByte((addr >> 16) & 0xFF);
-        W25Q64_SPI_SendByte((addr >> 8) & 0xFF);
-        W25Q64_SPI_SendByte(addr & 0xFF);
-
-        /* Send data */
-        for (i = 0; i < bytes_to_write; i++)
+        if (W25Q64_UseDma(bytes_to_write) &&
+            W25Q64_PageProgramAsync(addr, buffer, (uint16_t)bytes_to_write, W25Q64_DmaWakeup) == 0)
         {
-            W25Q64_SPI_SendByte(buffer[i]);
+            /* Data goes out by DMA, sleep until the completion interrupt raises CS */
+            Kernel_SemWait(&w25q64_dma_sem, KERNEL_WAIT_FOREVER);
         }
+        else
+        {
+            w25q64_polled_bytes += bytes_to_write;
+            W25Q64_PageProgramBegin(addr);
 
-        /* Deselect W25Q64 */
-        W25Q64_CS_HIGH();
+            /* Send data */
+            for (i = 0; i < bytes_to_write; i++)
+            {
+                W25Q64_SPI_SendByte(buffer[i]);
+            }
+
+            /* Deselect W25Q64 */
+            W25Q64_CS_HIGH();
+        }
 
         /* Update address, buffer and remaining length */
         addr += bytes_to_write;
@@ -297,110 +1170,144 @@ void W25Q64_WriteBytes(uint32_t addr, uint8_t* buffer, uint32_t length)
         /* Wait for write to complete */
         W25Q64_WaitForReady();
     }
+    W25Q64_Unlock();
 }
 
 /**
-  * @brief  Erases a sector (4KB) of the W25Q64 at the specified address
-  * @param  sector_addr: sector address to erase
-  * @retval None
+  * @brief  Byte of the self-test pattern: every byte value once, neighbours differ in several bits
+  * @param  offset: offset in the test page
+  * @retval Pattern byte
   */
-void W25Q64_EraseSector(uint32_t sector_addr)
+static uint8_t W25Q64_PatternByte(uint32_t offset)
 {
-    /* Wait for W25Q64 to be ready */
-    W25Q64_WaitForReady();
-
-    /* Send Write Enable command */
-    W25Q64_WriteEnable();
-
-    /* Select W25Q64 */
-    W25Q64_CS_LOW();
-
-    /* Send Sector Erase command */
-    W25Q64_SPI_SendByte(W25Q64_CMD_SECTOR_ERASE_4KB);
-
-    /* Send sector address */
-    W25Q64_SPI_SendByte((sector_addr >> 16) & 0xFF);
-    W25Q64_SPI_SendByte((sector_addr >> 8) & 0xFF);
-    W25Q64_SPI_SendByte(sector_addr & 0xFF);
+    return (uint8_t)(offset ^ (offset << 4) ^ 0x5A);
+}
 
-    /* Deselect W25Q64 */
-    W25Q64_CS_HIGH();
+/**
+  * @brief  Compares the self-test page with the pattern at the current link speed
+  * @param  None
+  * @retval 0: match, 1: page erased, 2: mismatch
+  */
+static uint8_t W25Q64_CheckPattern(void)
+{
+    uint8_t buffer[W25Q64_DMA_MIN_LENGTH];
+    uint8_t erased = 1, match = 1;
+    uint32_t offset, i;
 
-    /* Wait for erase to complete */
-    W25Q64_WaitForReady();
+    for (offset = 0; offset < W25Q64_PAGE_SIZE; offset += sizeof(buffer))
+    {
+        W25Q64_ReadBytes(W25Q64_TEST_ADDR + offset, buffer, sizeof(buffer));
+        for (i = 0; i < sizeof(buffer); i++)
+        {
+            if (buffer[i] != W25Q64_PatternByte(offset + i)) match = 0;
+            if (buffer[i] != 0xFF) erased = 0;
+        }
+    }
+    return match ? 0 : erased ? 1 : 2;
 }
 
 /**
-  * @brief  Erases a 32KB block of the W25Q64 at the specified address
-  * @param  block_addr: block address to erase
+  * @brief  Programs the self-test pattern into the erased test page
+  * @param  None
   * @retval None
   */
-void W25Q64_EraseBlock32K(uint32_t block_addr)
+static void W25Q64_WritePattern(void)
 {
-    /* Wait for W25Q64 to be ready */
-    W25Q64_WaitForReady();
-
-    /* Send Write Enable command */
-    W25Q64_WriteEnable();
-
-    /* Select W25Q64 */
-    W25Q64_CS_LOW();
-
-    /* Send Block Erase 32KB command */
-    W25Q64_SPI_SendByte(W25Q64_CMD_BLOCK_ERASE_32KB);
-
-    /* Send block address */
-    W25Q64_SPI_SendByte((block_addr >> 16) & 0xFF);
-    W25Q64_SPI_SendByte((block_addr >> 8) & 0xFF);
-    W25Q64_SPI_SendByte(block_addr & 0xFF);
-
-    /* Deselect W25Q64 */
-    W25Q64_CS_HIGH();
+    uint8_t buffer[W25Q64_DMA_MIN_LENGTH];
+    uint32_t offset, i;
 
-    /* Wait for erase to complete */
-    W25Q64_WaitForReady();
+    for (offset = 0; offset < W25Q64_PAGE_SIZE; offset += sizeof(buffer))
+    {
+        for (i = 0; i < sizeof(buffer); i++)
+        {
+            buffer[i] = W25Q64_PatternByte(offset + i);
+        }
+        W25Q64_WriteBytes(W25Q64_TEST_ADDR + offset, buffer, sizeof(buffer));
+    }
 }
 
 /**
-  * @brief  Erases a 64KB block of the W25Q64 at the specified address
-  * @param  block_addr: block address to erase
-  * @retval None
+  * @brief  Selects the fastest SPI link speed that reads the JEDEC ID and the test pattern reliably
+  * @param  None
+  * @retval Selected SCK frequency (Hz), 0 if the W25Q64 does not answer at the default speed
+  * @note   The pattern is checked (and programmed on first use) at the known-good default speed.
+  *         If the test page holds other data only the JEDEC ID is checked and the default speed is kept.
+  *         Each candidate, fastest first, must pass W25Q64_TEST_PASSES rounds.
   */
-void W25Q64_EraseBlock64K(uint32_t block_addr)
+uint32_t W25Q64_SelfTest(void)
 {
-    /* Wait for W25Q64 to be ready */
-    W25Q64_WaitForReady();
-
-    /* Send Write Enable command */
-    W25Q64_WriteEnable();
+    uint8_t i, pass;
 
-    /* Select W25Q64 */
-    W25Q64_CS_LOW();
+    /* The chip ignores the JEDEC ID command while erasing or programming */
+    W25Q64_Sync();
 
-    /* Send Block Erase 64KB command */
-    W25Q64_SPI_SendByte(W25Q64_CMD_BLOCK_ERASE_64KB);
+    w25q64_test_failures = 0;
+    W25Q64_SetPrescaler(W25Q64_SPI_DEFAULT_PRESCALER);
+    if (W25Q64_ReadJedecId() != W25Q64_JEDEC_ID)
+    {
+        return 0;
+    }
 
-    /* Send block address */
-    W25Q64_SPI_SendByte((block_addr >> 16) & 0xFF);
-    W25Q64_SPI_SendByte((block_addr >> 8) & 0xFF);
-    W25Q64_SPI_SendByte(block_addr & 0xFF);
+    /* Establish the pattern at the default speed */
+    switch (W25Q64_CheckPattern())
+    {
+        case 1:
+            W25Q64_WritePattern();
+            w25q64_test_pattern = (W25Q64_CheckPattern() == 0);
+            break;
+        case 0:
+            w25q64_test_pattern = 1;
+            break;
+        default:
+            w25q64_test_pattern = 0;
+            break;
+    }
+    if (!w25q64_test_pattern)
+    {
+        return W25Q64_GetSpeedHz();
+    }
 
-    /* Deselect W25Q64 */
-    W25Q64_CS_HIGH();
+    for (i = 0; i < sizeof(w25q64_prescalers) / sizeof(w25q64_prescalers[0]); i++)
+    {
+        if (W25Q64_SPI_HZ(w25q64_prescalers[i]) > W25Q64_SPI_MAX_HZ)
+        {
+            continue;
+        }
+        W25Q64_SetPrescaler(w25q64_prescalers[i]);
+        for (pass = 0; pass < W25Q64_TEST_PASSES; pass++)
+        {
+            if (W25Q64_ReadJedecId() != W25Q64_JEDEC_ID || W25Q64_CheckPattern() != 0)
+            {
+                break;
+            }
+        }
+        if (pass == W25Q64_TEST_PASSES)
+        {
+            return W25Q64_GetSpeedHz();
+        }
+        w25q64_test_failures++;
+    }
 
-    /* Wait for erase to complete */
-    W25Q64_WaitForReady();
+    /* Not even the default speed passed every round, keep it anyway */
+    W25Q64_SetPrescaler(W25Q64_SPI_DEFAULT_PRESCALER);
+    return W25Q64_GetSpeedHz();
 }
 
 /**
-  * @brief  Erases the entire W25Q64 chip
-  * @param  None
-  * @retval None
+  * @brief  Protothread that issues an erase command and waits for it to complete
+  * @param  pt: protothread control block
+  * @param  cmd: erase command (sector, 32KB block, 64KB block or chip erase)
+  * @param  addr: address inside the area to erase (ignored for chip erase)
+  * @param  poll_ms: interval between BUSY polls while the erase is running
+  * @retval Protothread state
+  * @note   The CPU is released between polls instead of spinning on the status register
   */
-void W25Q64_EraseChip(void)
+static PT_THREAD(W25Q64_EraseThread(PT_t *pt, uint8_t cmd, uint32_t addr, uint16_t poll_ms))
 {
+    PT_BEGIN(pt);
+
     /* Wait for W25Q64 to be ready */
-    W25Q64_WaitForReady();
+    PT_WAIT_WHILE(pt, W25Q64_IsBusy());
 
     /* Send Write Enable command */
     W25Q64_WriteEnable();
@@ -408,99 +1315,90 @@ void W25Q64_EraseChip(void)
     /* Select W25Q64 */
     W25Q64_CS_LOW();
 
-    /* Send Chip Erase command */
-    W25Q64_SPI_SendByte(W25Q64_CMD_CHIP_ERASE);
+    /* Send erase command */
+    W25Q64_SPI_SendByte(cmd);
+
+    /* Send address */
+    if (cmd != W25Q64_CMD_CHIP_ERASE)
+    {
+        W25Q64_SPI_SendByte((addr >> 16) & 0xFF);
+        W25Q64_SPI_SendByte((addr >> 8) & 0xFF);
+        W25Q64_SPI_SendByte(addr & 0xFF);
+    }
 
     /* Deselect W25Q64 */
     W25Q64_CS_HIGH();
+    TRACE(TRACE_EV_FLASH_ERASE_BEGIN, addr / W25Q64_SECTOR_SIZE);
 
-    /* Wait for erase to complete (this may take several seconds) */
-    W25Q64_WaitForReady();
+    /* Wait for erase to complete */
+    while (W25Q64_IsBusy())
+    {
+        PT_DELAY(pt, poll_ms);
+    }
+    TRACE(TRACE_EV_FLASH_ERASE_END, addr / W25Q64_SECTOR_SIZE);
+
+    PT_END(pt);
 }
 
 /**
-  * @brief  Writes a data record to the W25Q64 at the specified index
-  * @param  record: pointer to DataRecord_t structure to write
-  * @param  index: index of the record (0-based)
+  * @brief  Erases a sector (4KB) of the W25Q64 at the specified address
+  * @param  sector_addr: sector address to erase
   * @retval None
   */
-void W25Q64_WriteRecord(DataRecord_t* record, uint32_t index)
+void W25Q64_EraseSector(uint32_t sector_addr)
 {
-    uint32_t addr;
-    DataRecord_t temp_record;
-    
-    /* Copy record data */
-    temp_record = *record;
-    
-    /* Calculate CRC for the record data (excluding the CRC field itself) */
-    temp_record.crc = W25Q64_CalculateCRC16((uint8_t*)&temp_record.timestamp, 
-                                          sizeof(temp_record) - sizeof(temp_record.crc));
-    
-    /* Calculate record address */
-    addr = index * sizeof(DataRecord_t);
-    
-    /* Write record to W25Q64 */
-    W25Q64_WriteBytes(addr, (uint8_t*)&temp_record, sizeof(DataRecord_t));
+    PT_t pt;
+
+    W25Q64_Sync();
+    W25Q64_Lock();
+    PT_RUN_BLOCKING(&pt, W25Q64_EraseThread(&pt, W25Q64_CMD_SECTOR_ERASE_4KB, sector_addr, W25Q64_POLL_SECTOR_MS));
+    W25Q64_Unlock();
 }
 
 /**
-  * @brief  Reads a data record from the W25Q64 at the specified index
-  * @param  record: pointer to DataRecord_t structure to store read data
-  * @param  index: index of the record (0-based)
-  * @retval uint8_t: 0 if record is valid (CRC match), 1 if CRC mismatch
+  * @brief  Erases a 32KB block of the W25Q64 at the specified address
+  * @param  block_addr: block address to erase
+  * @retval None
   */
-uint8_t W25Q64_ReadRecord(DataRecord_t* record, uint32_t index)
+void W25Q64_EraseBlock32K(uint32_t block_addr)
 {
-    uint32_t addr;
-    uint16_t calculated_crc;
-    DataRecord_t temp_record;
-
-    /* Calculate record address */
-    addr = index * sizeof(DataRecord_t);
-
-    /* Read record from W25Q64 */
-    W25Q64_ReadBytes(addr, (uint8_t*)&temp_record, sizeof(DataRecord_t));
-    
-    /* Calculate CRC for the received data (excluding the CRC field itself) */
-    calculated_crc = W25Q64_CalculateCRC16((uint8_t*)&temp_record.timestamp, 
-                                          sizeof(DataRecord_t) - sizeof(temp_record.crc));
-    
+    PT_t pt;
 
-    
-    /* Copy to output record */
-    *record = temp_record;
-    
-    /* Compare calculated CRC with the stored CRC */
-    if (calculated_crc != temp_record.crc)
-    {
-        /* CRC mismatch, record is invalid */
-        return 1;
-    }
-    
-    /* CRC match, record is valid */
-    return 0;
+    W25Q64_Sync();
+    W25Q64_Lock();
+    PT_RUN_BLOCKING(&pt, W25Q64_EraseThread(&pt, W25Q64_CMD_BLOCK_ERASE_32KB, block_addr, W25Q64_POLL_BLOCK_MS));
+    W25Q64_Unlock();
 }
 
 /**
-  * @brief  Gets the total number of data records that can be stored in the W25Q64
-  * @param  None
-  * @retval Total number of data records
+  * @brief  Erases a 64KB block of the W25Q64 at the specified address
+  * @param  block_addr: block address to erase
+  * @retval None
   */
-uint32_t W25Q64_GetTotalRecords(void)
+void W25Q64_EraseBlock64K(uint32_t block_addr)
 {
-    /* Calculate total records based on W25Q64 size and record size */
-    return W25Q64_TOTAL_SIZE / sizeof(DataRecord_t);
+    PT_t pt;
+
+    W25Q64_Sync();
+    W25Q64_Lock();
+    PT_RUN_BLOCKING(&pt, W25Q64_EraseThread(&pt, W25Q64_CMD_BLOCK_ERASE_64KB, block_addr, W25Q64_POLL_BLOCK_MS));
+    W25Q64_Unlock();
 }
 
 /**
-  * @brief  Clears all data records by erasing the entire W25Q64 chip
+  * @brief  Erases the entire W25Q64 chip
   * @param  None
   * @retval None
+  * @note   This may take tens of seconds
   */
-void W25Q64_ClearAllRecords(void)
+void W25Q64_EraseChip(void)
 {
-    /* Erase the entire chip */
-    W25Q64_EraseChip();
+    PT_t pt;
+
+    W25Q64_Sync();
+    W25Q64_Lock();
+    PT_RUN_BLOCKING(&pt, W25Q64_EraseThread(&pt, W25Q64_CMD_CHIP_ERASE, 0, W25Q64_POLL_CHIP_MS));
+    W25Q64_Unlock();
 }
 
 /**
@@ -513,52 +1411,6 @@ void W25Q64_Delay(uint32_t nCount)
     while(nCount--);
 }
 
-/**
-  * @brief  Writes the record index to the W25Q64
-  * @param  index: Record index to write
-  * @retval None
-  */
-void W25Q64_WriteRecordIndex(uint32_t index)
-{
-    uint32_t addr = W25Q64_RECORD_INDEX_ADDR;
-    uint8_t data[4];
-    
-    /* Convert index to byte array */
-    data[0] = (index >> 24) & 0xFF;
-    data[1] = (index >> 16) & 0xFF;
-    data[2] = (index >> 8) & 0xFF;
-    data[3] = index & 0xFF;
-    
-    /* Erase the sector containing the index (last sector of the chip) */
-    W25Q64_EraseSector(addr - (addr % W25Q64_SECTOR_SIZE));
-    
-    /* Write the index */
-    W25Q64_WriteBytes(addr, data, sizeof(data));
-}
-
-/**
-  * @brief  Reads the record index from the W25Q64
-  * @param  None
-  * @retval Record index
-  */
-uint32_t W25Q64_ReadRecordIndex(void)
-{
-    uint32_t addr = W25Q64_RECORD_INDEX_ADDR;
-    uint8_t data[4];
-    uint32_t index;
-    
-    /* Read the index bytes */
-    W25Q64_ReadBytes(addr, data, sizeof(data));
-    
-    /* Convert byte array to index */
-    index = ((uint32_t)data[0] << 24) |
-            ((uint32_t)data[1] << 16) |
-            ((uint32_t)data[2] << 8) |
-            data[3];
-    
-    return index;
-}
-
 /**
   * @brief  Calculates CRC16 checksum for data reliability
   * @param  data: Pointer to data buffer
@@ -590,31 +1442,7 @@ uint16_t W25Q64_CalculateCRC16(const uint8_t* data, uint32_t length)
 }
 
 /**
-  * @brief  Writes system configuration to the W25Q64
-  * @param  config: Pointer to SystemConfig_t structure to write
-  * @retval None
-  */
-void W25Q64_WriteConfig(SystemConfig_t* config)
-{
-    uint32_t addr = W25Q64_CONFIG_ADDR;
-    SystemConfig_t temp_config;
-    
-    /* Copy config data */
-    temp_config = *config;
-    
-    /* Calculate CRC for the config data (excluding the CRC field itself) */
-    temp_config.crc = W25Q64_CalculateCRC16((uint8_t*)&temp_config.temp_threshold_low, 
-                                          sizeof(temp_config) - sizeof(temp_config.crc));
-    
-    /* Erase the sector containing the config */
-    W25Q64_EraseSector(addr - (addr % W25Q64_SECTOR_SIZE));
-    
-    /* Write config to W25Q64 */
-    W25Q64_WriteBytes(addr, (uint8_t*)&temp_config, sizeof(SystemConfig_t));
-}
-
-/**
-  * @brief  Reads system configuration from the W25Q64
+  * @brief  Reads the legacy single-slot system configuration from the W25Q64
   * @param  config: Pointer to SystemConfig_t structure to store read data
   * @retval uint8_t: 0 if config is valid (CRC match), 1 if CRC mismatch
   */
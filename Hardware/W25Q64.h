@@ -51,6 +51,15 @@
 #define W25Q64_NUM_PAGES                (W25Q64_TOTAL_SIZE / W25Q64_PAGE_SIZE) /* 32768 pages */
 #define W25Q64_NUM_SECTORS              (W25Q64_TOTAL_SIZE / W25Q64_SECTOR_SIZE) /* 2048 sectors */
 
+/* BUSY poll intervals while an erase is running (typical erase time: sector 45ms, block 150ms, chip 20s) */
+#define W25Q64_POLL_SECTOR_MS           2
+#define W25Q64_POLL_BLOCK_MS            10
+#define W25Q64_POLL_CHIP_MS             100
+
+/* Flash operation engine: queued sector erases and page programs run in the background */
+#define W25Q64_OP_QUEUE_SIZE            4     /* Queued operations, including the one in progress */
+#define W25Q64_OP_POLL_MS               2     /* BUSY poll interval of the operation in progress */
+
 /* W25Q64 Status Register 1 bits */
 #define W25Q64_SR1_BUSY                 ((uint8_t)0x01) /* Busy bit */
 #define W25Q64_SR1_WEL                  ((uint8_t)0x02) /* Write Enable Latch bit */
@@ -73,6 +82,7 @@
 /* W25Q64 JEDEC ID */
 #define W25Q64_JEDEC_MANUFACTURER_ID    0xEF  /* Manufacturer ID */
 #define W25Q64_JEDEC_DEVICE_ID          0x16  /* Device ID for W25Q64 */
+#define W25Q64_JEDEC_ID                 0xEF4017 /* Manufacturer, memory type and capacity (0x9F) */
 
 /* W25Q64 SPI configuration */
 #define W25Q64_SPI                      SPI1
@@ -83,6 +93,36 @@
 #define W25Q64_SPI_PIN_MISO             GPIO_Pin_6
 #define W25Q64_SPI_PIN_MOSI             GPIO_Pin_7
 
+/* SPI link speed: SCK = PCLK2 / prescaler, from PCLK2/2 (36MHz) down to PCLK2/16 (4.5MHz) */
+#define W25Q64_PCLK2_HZ                 72000000
+#define W25Q64_SPI_DEFAULT_PRESCALER    SPI_BaudRatePrescaler_16 /* Known-good speed before the self-test */
+#define W25Q64_SPI_MAX_HZ               36000000 /* Fastest speed tried by the self-test */
+#define W25Q64_SPI_HZ(prescaler)        (W25Q64_PCLK2_HZ / (2U << ((prescaler) >> 3)))
+/* Read Data (0x03) has no dummy cycle and a lower frequency limit than Fast Read (0x0B).
+   W25Q64FV/JV allow 50MHz; 33MHz keeps older parts and clones within spec */
+#define W25Q64_READ_DATA_MAX_HZ         33000000
+
+/* Link self-test page: first page of the config store's sector A, which leaves it unused.
+   It holds a fixed pattern, programmed by the self-test when the page is erased */
+#define W25Q64_TEST_ADDR                ((uint32_t)(W25Q64_NUM_SECTORS - 2) * W25Q64_SECTOR_SIZE)
+#define W25Q64_TEST_PASSES              4     /* JEDEC ID and pattern reads per candidate speed */
+
+/* W25Q64 DMA configuration: SPI1_RX on DMA1 channel 2, SPI1_TX on DMA1 channel 3 */
+#define W25Q64_DMA_CLK                  RCC_AHBPeriph_DMA1
+#define W25Q64_DMA_RX_CHANNEL           DMA1_Channel2
+#define W25Q64_DMA_TX_CHANNEL           DMA1_Channel3
+#define W25Q64_DMA_RX_IRQn              DMA1_Channel2_IRQn
+#define W25Q64_DMA_RX_IT_TC             DMA1_IT_TC2
+#define W25Q64_DMA_RX_IT_TE             DMA1_IT_TE2
+#define W25Q64_DMA_RX_IT_GL             DMA1_IT_GL2
+#define W25Q64_DMA_TX_IT_GL             DMA1_IT_GL3
+#define W25Q64_SPI_DR_ADDR              (SPI1_BASE + 0x0C) /* SPI1->DR */
+
+/* Transfers shorter than this are polled: DMA setup and the completion interrupt cost more than they save */
+#define W25Q64_DMA_MIN_LENGTH           32
+/* DMA counter limit, longer blocking reads are split */
+#define W25Q64_DMA_MAX_LENGTH           0xFFFF
+
 /* W25Q64 CS pin configuration */
 #define W25Q64_CS_GPIO_PORT             GPIOA
 #define W25Q64_CS_GPIO_CLK              RCC_APB2Periph_GPIOA
@@ -113,6 +153,10 @@ typedef struct {
 } SystemConfig_t;
 #pragma pack() /* 恢复默认对齐 */
 
+/* Queued program completion callback, called with the caller's tag from the thread that polls the
+   operation engine while it owns the bus; must not block or call other W25Q64 functions */
+typedef void (*W25Q64_OpCallback_t)(uint32_t tag);
+
 /* W25Q64 function prototypes */
 void W25Q64_Init(void);
 uint8_t W25Q64_ReadByte(uint32_t addr);
@@ -123,20 +167,42 @@ void W25Q64_EraseSector(uint32_t sector_addr);
 void W25Q64_EraseBlock32K(uint32_t block_addr);
 void W25Q64_EraseBlock64K(uint32_t block_addr);
 void W25Q64_EraseChip(void);
-void W25Q64_WriteRecord(DataRecord_t* record, uint32_t index);
-uint8_t W25Q64_ReadRecord(DataRecord_t* record, uint32_t index);
-uint32_t W25Q64_GetTotalRecords(void);
-void W25Q64_ClearAllRecords(void);
+uint8_t W25Q64_IsBusy(void);
 void W25Q64_Delay(uint32_t nCount);
 
-/* Record Index functions */
-#define W25Q64_RECORD_INDEX_ADDR        (W25Q64_TOTAL_SIZE - sizeof(uint32_t)) /* Store index at the end of flash */
-void W25Q64_WriteRecordIndex(uint32_t index);
-uint32_t W25Q64_ReadRecordIndex(void);
-
-/* System Configuration functions */
-#define W25Q64_CONFIG_ADDR              (W25Q64_RECORD_INDEX_ADDR - sizeof(SystemConfig_t)) /* Store config before index */
-void W25Q64_WriteConfig(SystemConfig_t* config);
+/* SPI link speed and boot-time self-test */
+uint32_t W25Q64_ReadJedecId(void);
+void W25Q64_SetPrescaler(uint16_t prescaler);
+uint32_t W25Q64_GetSpeedHz(void);
+uint8_t W25Q64_IsFastRead(void);
+uint32_t W25Q64_SelfTest(void);
+
+/* DMA transfers: the blocking ReadBytes/WriteBytes use DMA from thread context for
+   transfers of at least W25Q64_DMA_MIN_LENGTH bytes and sleep on a semaphore until the
+   completion interrupt raises CS; they fall back to polled I/O if the DMA channel is taken */
+uint8_t W25Q64_IsTransferBusy(void);
+void W25Q64_SetDmaEnabled(uint8_t enable);
+uint8_t W25Q64_IsDmaEnabled(void);
+void W25Q64_ReportStats(void);
+void W25Q64_ResetStats(void);
+
+/* Flash operation engine: sector erases and page programs are queued, started right away when
+   the chip is idle and polled for completion from a one-shot timer in the timer service thread,
+   so no thread spins on BUSY. A read that arrives during a queued erase suspends the erase (0x75),
+   reads and resumes it (0x7A). The blocking write and erase functions drain the queue first */
+uint8_t W25Q64_QueueErase(uint32_t sector_addr);
+uint8_t W25Q64_QueueProgram(uint32_t addr, const uint8_t* buffer, uint16_t length);
+uint8_t W25Q64_QueueProgramNotify(uint32_t addr, const uint8_t* buffer, uint16_t length,
+                                  W25Q64_OpCallback_t done, uint32_t tag);
+void W25Q64_Poll(void);
+void W25Q64_Sync(void);
+uint8_t W25Q64_GetQueueDepth(void);
+uint8_t W25Q64_GetQueuedErases(void);
+uint8_t W25Q64_IsQueued(const uint8_t* buffer, uint16_t length);
+
+/* Legacy system configuration slot, read once to migrate it into the config store (see Config.h).
+   Records are stored by the journal, see Journal.h */
+#define W25Q64_CONFIG_ADDR              (W25Q64_TOTAL_SIZE - sizeof(uint32_t) - sizeof(SystemConfig_t)) /* Last sector, unchanged from the old index layout */
 uint8_t W25Q64_ReadConfig(SystemConfig_t* config);
 
 /* CRC functions for data reliability */
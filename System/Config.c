@@ -0,0 +1,425 @@
+#include "Config.h"
+#include "Kernel.h"
+#include "Scheduler.h"
+#include "Serial.h"
+#include <string.h>
+
+/* 扇区的Flash地址，sector为配置区内的扇区号（0: A，1: B） */
+#define CONFIG_SECTOR_ADDR(sector)  ((uint32_t)(CONFIG_FIRST_SECTOR + (sector)) * W25Q64_SECTOR_SIZE)
+
+/* 扇区头和配置项槽的Flash地址 */
+#define CONFIG_HEADER_ADDR(sector)  (CONFIG_SECTOR_ADDR(sector) + CONFIG_AREA_OFFSET)
+#define CONFIG_SLOT_ADDR(sector, slot) \
+    (CONFIG_HEADER_ADDR(sector) + CONFIG_HEADER_SIZE + (uint32_t)(slot) * CONFIG_ENTRY_SIZE)
+
+/* 内存中的副本，按键索引，0号不使用 */
+static uint32_t config_values[CONFIG_KEY_COUNT];
+static uint32_t config_versions[CONFIG_KEY_COUNT];  /* 已写入Flash的版本号 */
+static uint16_t config_present = 0;             /* 有值的键，按键号置位 */
+static uint16_t config_dirty = 0;               /* 修改后尚未写入的键，按键号置位 */
+static uint32_t config_dirty_tick = 0;          /* 最后一次修改的时刻 */
+
+/* 写入位置 */
+static uint8_t config_sector = 1;               /* 当前扇区 */
+static uint32_t config_seq = 0;                 /* 当前扇区的序号，0表示配置区无效 */
+static uint16_t config_slot = 0;                /* 下一个配置项的槽号 */
+static uint32_t config_version = 0;             /* 最后写入的版本号 */
+
+/* 写入统计 */
+static uint32_t config_set_count = 0;           /* Config_Set修改的次数（值不变的不计） */
+static uint32_t config_entry_count = 0;         /* 写入的配置项数，包括整理 */
+static uint32_t config_program_count = 0;       /* 页编程次数 */
+static uint32_t config_compact_count = 0;       /* 整理（擦除扇区）次数 */
+static uint32_t config_buffer_waits = 0;        /* 写入缓冲区仍在编程的次数 */
+static uint16_t config_invalid = 0;             /* 上电时CRC错误的配置项数（写入时掉电） */
+
+/**
+  * @brief  写入缓冲区：扇区头和每个键一项，数据保留到编程完成；上电时用于批量读取配置项
+  */
+static struct {
+    Config_Header_t header;
+    Config_Entry_t entries[CONFIG_KEY_COUNT - 1];
+} config_buffer;
+
+/* bulk线程修改和写入，alarm线程在电压下降时写入 */
+static Kernel_Mutex_t config_mutex;
+
+/**
+  * @brief  读取并校验扇区头
+  * @param  sector: 配置区内的扇区号
+  * @param  header: 用于存放扇区头的指针
+  * @retval 1: 有效，0: 无效或未写入
+  */
+static uint8_t Config_LoadHeader(uint8_t sector, Config_Header_t *header)
+{
+    W25Q64_ReadBytes(CONFIG_HEADER_ADDR(sector), (uint8_t *)header, sizeof(Config_Header_t));
+
+    return header->magic == CONFIG_MAGIC && header->seq != 0xFFFFFFFF &&
+           header->crc == W25Q64_CalculateCRC16((uint8_t *)header, sizeof(Config_Header_t) - 2);
+}
+
+/**
+  * @brief  判断配置项槽是否未写入
+  * @param  entry: 读出的配置项
+  * @retval 1: 未写入（全为0xFF），0: 已写入
+  */
+static uint8_t Config_EntryErased(const Config_Entry_t *entry)
+{
+    const uint8_t *p = (const uint8_t *)entry;
+    uint8_t i;
+
+    for (i = 0; i < sizeof(Config_Entry_t); i++)
+    {
+        if (p[i] != 0xFF)
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+  * @brief  读取当前扇区的全部配置项，后写入的项覆盖之前的项，第一个空槽为写入位置
+  * @param  None
+  * @retval None
+  */
+static void Config_Scan(void)
+{
+    uint16_t slot, count, i;
+
+    for (slot = 0; slot < CONFIG_ENTRIES_PER_SECTOR; slot += count)
+    {
+        count = CONFIG_ENTRIES_PER_SECTOR - slot;
+        if (count > CONFIG_KEY_COUNT - 1)
+        {
+            count = CONFIG_KEY_COUNT - 1;
+        }
+        W25Q64_ReadBytes(CONFIG_SLOT_ADDR(config_sector, slot), (uint8_t *)config_buffer.entries,
+                         count * CONFIG_ENTRY_SIZE);
+
+        for (i = 0; i < count; i++)
+        {
+            const Config_Entry_t *entry = &config_buffer.entries[i];
+
+            if (Config_EntryErased(entry))
+            {
+                config_slot = slot + i;
+                return;
+            }
+            if (entry->key == 0 || entry->key >= CONFIG_KEY_COUNT ||
+                entry->crc != W25Q64_CalculateCRC16((const uint8_t *)entry, sizeof(Config_Entry_t) - 2))
+            {
+                config_invalid++;
+                continue;
+            }
+            config_values[entry->key] = entry->value;
+            config_versions[entry->key] = entry->version;
+            config_present |= 1 << entry->key;
+            if (entry->version > config_version)
+            {
+                config_version = entry->version;
+            }
+        }
+    }
+    config_slot = CONFIG_ENTRIES_PER_SECTOR;
+}
+
+/**
+  * @brief  等待写入缓冲区之前的编程完成
+  * @param  None
+  * @retval None
+  */
+static void Config_WaitBuffer(void)
+{
+    if (W25Q64_IsQueued((const uint8_t *)&config_buffer, sizeof(config_buffer)))
+    {
+        config_buffer_waits++;
+        W25Q64_Sync();
+    }
+}
+
+/**
+  * @brief  把数据加入编程，跨页时分为两次
+  * @param  addr: Flash地址
+  * @param  data: 数据，保留到编程完成
+  * @param  length: 字节数
+  * @retval None
+  */
+static void Config_Program(uint32_t addr, const uint8_t *data, uint16_t length)
+{
+    while (length > 0)
+    {
+        uint16_t chunk = W25Q64_PAGE_SIZE - addr % W25Q64_PAGE_SIZE;
+
+        if (chunk > length)
+        {
+            chunk = length;
+        }
+        W25Q64_QueueProgram(addr, data, chunk);
+        config_program_count++;
+        addr += chunk;
+        data += chunk;
+        length -= chunk;
+    }
+}
+
+/**
+  * @brief  在写入缓冲区中生成键的配置项
+  * @param  entry: 缓冲区中的配置项
+  * @param  key: 配置键
+  * @retval None
+  */
+static void Config_MakeEntry(Config_Entry_t *entry, uint8_t key)
+{
+    entry->version = config_versions[key];
+    entry->value = config_values[key];
+    entry->key = key;
+    memset(entry->reserved, 0xFF, sizeof(entry->reserved));
+    entry->crc = W25Q64_CalculateCRC16((uint8_t *)entry, sizeof(Config_Entry_t) - 2);
+}
+
+/**
+  * @brief  整理：擦除另一个扇区，写入全部键的当前值，最后写入扇区头
+  * @param  None
+  * @retval None
+  * @note   操作按队列顺序完成，扇区头写入之前掉电时原扇区仍然有效
+  */
+static void Config_Compact(void)
+{
+    uint8_t other = config_sector ^ 1;
+    uint8_t key, count = 0;
+
+    Config_WaitBuffer();
+    W25Q64_QueueErase(CONFIG_SECTOR_ADDR(other));
+
+    for (key = 1; key < CONFIG_KEY_COUNT; key++)
+    {
+        if (config_present & (1 << key))
+        {
+            Config_MakeEntry(&config_buffer.entries[count++], key);
+        }
+    }
+    if (count > 0)
+    {
+        Config_Program(CONFIG_SLOT_ADDR(other, 0), (const uint8_t *)config_buffer.entries,
+                       count * CONFIG_ENTRY_SIZE);
+    }
+
+    config_buffer.header.magic = CONFIG_MAGIC;
+    config_buffer.header.seq = config_seq + 1;
+    memset(config_buffer.header.reserved, 0xFF, sizeof(config_buffer.header.reserved));
+    config_buffer.header.crc = W25Q64_CalculateCRC16((uint8_t *)&config_buffer.header, sizeof(Config_Header_t) - 2);
+    Config_Program(CONFIG_HEADER_ADDR(other), (const uint8_t *)&config_buffer.header, sizeof(Config_Header_t));
+
+    config_sector = other;
+    config_seq++;
+    config_slot = count;
+    config_entry_count += count;
+    config_compact_count++;
+}
+
+/**
+  * @brief  把修改过的键追加到当前扇区，放不下时整理，调用时持有config_mutex
+  * @param  None
+  * @retval None
+  */
+static void Config_WriteDirty(void)
+{
+    uint8_t key, count = 0;
+
+    for (key = 1; key < CONFIG_KEY_COUNT; key++)
+    {
+        if (config_dirty & (1 << key))
+        {
+            config_versions[key] = ++config_version;
+            count++;
+        }
+    }
+    if (count == 0)
+    {
+        return;
+    }
+
+    if (config_seq == 0 || config_slot + count > CONFIG_ENTRIES_PER_SECTOR)
+    {
+        Config_Compact();
+    }
+    else
+    {
+        Config_WaitBuffer();
+        count = 0;
+        for (key = 1; key < CONFIG_KEY_COUNT; key++)
+        {
+            if (config_dirty & (1 << key))
+            {
+                Config_MakeEntry(&config_buffer.entries[count++], key);
+            }
+        }
+        Config_Program(CONFIG_SLOT_ADDR(config_sector, config_slot), (const uint8_t *)config_buffer.entries,
+                       count * CONFIG_ENTRY_SIZE);
+        config_slot += count;
+        config_entry_count += count;
+    }
+    config_dirty = 0;
+}
+
+/**
+  * @brief  读取当前扇区恢复全部配置，两个扇区都无效时迁移旧版配置，在W25Q64_Init之后调用
+  * @param  None
+  * @retval 0: 从配置区读取，1: 从旧版配置迁移，2: 没有保存的配置
+  * @note   迁移时旧版配置所在的B扇区保留，配置先写入A扇区（第0页的自检图案被擦除，
+  *         下次自检时重新写入）
+  */
+uint8_t Config_Init(void)
+{
+    Config_Header_t header;
+    SystemConfig_t legacy;
+    uint8_t sector;
+
+    config_sector = 1;
+    config_seq = 0;
+    config_slot = 0;
+    config_version = 0;
+    config_present = 0;
+    config_dirty = 0;
+
+    for (sector = 0; sector < CONFIG_SECTOR_COUNT; sector++)
+    {
+        if (Config_LoadHeader(sector, &header) && header.seq > config_seq)
+        {
+            config_sector = sector;
+            config_seq = header.seq;
+        }
+    }
+    if (config_seq != 0)
+    {
+        Config_Scan();
+        return 0;
+    }
+
+    if (W25Q64_ReadConfig(&legacy) == 0)
+    {
+        Config_Set(CONFIG_KEY_TEMP_LOW, legacy.temp_threshold_low);
+        Config_Set(CONFIG_KEY_TEMP_HIGH, legacy.temp_threshold_high);
+        Config_Set(CONFIG_KEY_HUMI_LOW, legacy.humi_threshold_low);
+        Config_Set(CONFIG_KEY_HUMI_HIGH, legacy.humi_threshold_high);
+        Config_Flush();
+        W25Q64_Sync();
+        return 1;
+    }
+    return 2;
+}
+
+/**
+  * @brief  读取配置（内存中的副本）
+  * @param  key: 配置键
+  * @param  value: 用于存放值的指针
+  * @retval 0: 成功，1: 键无效或未保存过
+  */
+uint8_t Config_Get(Config_Key_t key, uint32_t *value)
+{
+    if (key == 0 || key >= CONFIG_KEY_COUNT || !(config_present & (1 << key)))
+    {
+        return 1;
+    }
+    *value = config_values[key];
+    return 0;
+}
+
+/**
+  * @brief  修改配置，CONFIG_DEBOUNCE_MS内没有新的修改时才写入Flash
+  * @param  key: 配置键
+  * @param  value: 值
+  * @retval 0: 成功，1: 键无效
+  */
+uint8_t Config_Set(Config_Key_t key, uint32_t value)
+{
+    if (key == 0 || key >= CONFIG_KEY_COUNT)
+    {
+        return 1;
+    }
+
+    Kernel_MutexLock(&config_mutex);
+    if (!(config_present & (1 << key)) || config_values[key] != value)
+    {
+        config_values[key] = value;
+        config_present |= 1 << key;
+        config_dirty |= 1 << key;
+        config_dirty_tick = Scheduler_GetTick();
+        config_set_count++;
+    }
+    Kernel_MutexUnlock(&config_mutex);
+    return 0;
+}
+
+/**
+  * @brief  立即把修改过的配置加入编程，不等待编程完成
+  * @param  None
+  * @retval None
+  */
+void Config_Flush(void)
+{
+    Kernel_MutexLock(&config_mutex);
+    Config_WriteDirty();
+    Kernel_MutexUnlock(&config_mutex);
+}
+
+/**
+  * @brief  最后一次修改超过CONFIG_DEBOUNCE_MS时写入修改过的配置（bulk线程调用）
+  * @param  None
+  * @retval None
+  */
+void Config_Poll(void)
+{
+    Kernel_MutexLock(&config_mutex);
+    if (config_dirty && Scheduler_GetTick() - config_dirty_tick >= CONFIG_DEBOUNCE_MS)
+    {
+        Config_WriteDirty();
+    }
+    Kernel_MutexUnlock(&config_mutex);
+}
+
+/**
+  * @brief  获取到下一次写入修改过的配置的时间
+  * @param  None
+  * @retval 时间（ms），没有未写入的修改时为KERNEL_WAIT_FOREVER
+  */
+uint32_t Config_GetFlushDelay(void)
+{
+    uint32_t elapsed = Scheduler_GetTick() - config_dirty_tick;
+
+    if (!config_dirty)
+    {
+        return KERNEL_WAIT_FOREVER;
+    }
+    return (elapsed < CONFIG_DEBOUNCE_MS) ? CONFIG_DEBOUNCE_MS - elapsed : 1;
+}
+
+/**
+  * @brief  通过串口输出配置区位置和写入统计
+  * @param  None
+  * @retval None
+  */
+void Config_ReportStats(void)
+{
+    Serial_Printf("[FLASH] Config: sector %u seq %lu, %u of %u entries used, version %lu, %u invalid\n",
+                  CONFIG_FIRST_SECTOR + config_sector, config_seq, config_slot, CONFIG_ENTRIES_PER_SECTOR,
+                  config_version, config_invalid);
+    Serial_Printf("[FLASH] Config writes: %lu changes in %lu entries, %lu programs, %lu compactions, %lu buffer waits\n",
+                  config_set_count, config_entry_count, config_program_count, config_compact_count,
+                  config_buffer_waits);
+}
+
+/**
+  * @brief  清除写入统计
+  * @param  None
+  * @retval None
+  */
+void Config_ResetStats(void)
+{
+    config_set_count = 0;
+    config_entry_count = 0;
+    config_program_count = 0;
+    config_compact_count = 0;
+    config_buffer_waits = 0;
+}
@@ -0,0 +1,130 @@
+#ifndef __CONFIG_H
+#define __CONFIG_H
+
+#include "stm32f10x.h"
+#include "W25Q64.h"
+
+/**
+  * W25Q64上的键值配置存储
+  *
+  * 配置保存在两个交替使用的扇区（A/B）中，每个扇区从第1页开始依次为扇区头和
+  * CONFIG_ENTRIES_PER_SECTOR个16字节的配置项槽（第0页为SPI链路自检页，不使用）：
+  *     扇区头：magic、扇区序号（每次整理加1）、CRC
+  *     配置项：版本号（每写一项加1）、键、值、CRC
+  * 修改配置只追加一项，同一个键后写入的项覆盖之前的项；读取配置直接返回内存中的副本。
+  * Config_Set只修改副本，最后一次修改CONFIG_DEBOUNCE_MS后才把修改过的键合并写入，
+  * 连续修改多个阈值只需编程一次。扇区写满时才整理：擦除另一个扇区，写入全部键的
+  * 当前值，最后写入序号更大的扇区头，整理中途掉电时原扇区仍然有效。
+  * 上电时扇区头有效且序号更大的扇区为当前扇区，第一个空槽即为写入位置；
+  * 两个扇区都无效时从旧版配置（W25Q64_ReadConfig）迁移。
+  */
+
+/* 配置区：日志区之后的两个扇区，第一个扇区的第0页为SPI链路自检页（W25Q64_TEST_ADDR） */
+#define CONFIG_FIRST_SECTOR         (W25Q64_NUM_SECTORS - 2)
+#define CONFIG_SECTOR_COUNT         2
+#define CONFIG_AREA_OFFSET          W25Q64_PAGE_SIZE
+
+#define CONFIG_MAGIC                0x53474643      /* "CFGS" */
+
+/* 最后一次修改之后等待的时间（ms），之间的修改合并写入 */
+#define CONFIG_DEBOUNCE_MS          500
+
+#define CONFIG_HEADER_SIZE          16
+#define CONFIG_ENTRY_SIZE           16
+#define CONFIG_ENTRIES_PER_SECTOR   \
+    ((W25Q64_SECTOR_SIZE - CONFIG_AREA_OFFSET - CONFIG_HEADER_SIZE) / CONFIG_ENTRY_SIZE)
+
+/**
+  * @brief  配置键，0和0xFFFF保留（0xFFFF为未写入的槽）
+  */
+typedef enum {
+    CONFIG_KEY_TEMP_LOW = 1,    /* 温度下限阈值（°C） */
+    CONFIG_KEY_TEMP_HIGH,       /* 温度上限阈值（°C） */
+    CONFIG_KEY_HUMI_LOW,        /* 湿度下限阈值（%） */
+    CONFIG_KEY_HUMI_HIGH,       /* 湿度上限阈值（%） */
+    CONFIG_KEY_SERIES,          /* 温湿度连续采样流：1打开，0关闭（Series.h） */
+    CONFIG_KEY_COUNT
+} Config_Key_t;
+
+#pragma pack(1)
+/**
+  * @brief  扇区头
+  */
+typedef struct {
+    uint32_t magic;         /* CONFIG_MAGIC */
+    uint32_t seq;           /* 扇区序号，从1开始 */
+    uint8_t reserved[6];
+    uint16_t crc;           /* 以上字段的CRC16 */
+} Config_Header_t;
+
+/**
+  * @brief  配置项
+  */
+typedef struct {
+    uint32_t version;       /* 配置项版本号，整理时保留 */
+    uint32_t value;         /* 值 */
+    uint16_t key;           /* Config_Key_t */
+    uint8_t reserved[4];
+    uint16_t crc;           /* 以上字段的CRC16 */
+} Config_Entry_t;
+#pragma pack()
+
+/**
+  * @brief  读取当前扇区恢复全部配置，两个扇区都无效时迁移旧版配置，在W25Q64_Init之后调用
+  * @param  None
+  * @retval 0: 从配置区读取，1: 从旧版配置迁移，2: 没有保存的配置
+  */
+uint8_t Config_Init(void);
+
+/**
+  * @brief  读取配置（内存中的副本）
+  * @param  key: 配置键
+  * @param  value: 用于存放值的指针
+  * @retval 0: 成功，1: 键无效或未保存过
+  */
+uint8_t Config_Get(Config_Key_t key, uint32_t *value);
+
+/**
+  * @brief  修改配置，CONFIG_DEBOUNCE_MS内没有新的修改时才写入Flash
+  * @param  key: 配置键
+  * @param  value: 值
+  * @retval 0: 成功，1: 键无效
+  */
+uint8_t Config_Set(Config_Key_t key, uint32_t value);
+
+/**
+  * @brief  立即把修改过的配置加入编程，不等待编程完成
+  * @param  None
+  * @retval None
+  */
+void Config_Flush(void);
+
+/**
+  * @brief  最后一次修改超过CONFIG_DEBOUNCE_MS时写入修改过的配置（bulk线程调用）
+  * @param  None
+  * @retval None
+  */
+void Config_Poll(void);
+
+/**
+  * @brief  获取到下一次写入修改过的配置的时间
+  * @param  None
+  * @retval 时间（ms），没有未写入的修改时为KERNEL_WAIT_FOREVER
+  */
+uint32_t Config_GetFlushDelay(void);
+
+/**
+  * @brief  通过串口输出配置区位置和写入统计
+  * @param  None
+  * @retval None
+  */
+void Config_ReportStats(void);
+
+/**
+  * @brief  清除写入统计
+  * @param  None
+  * @retval None
+  */
+void Config_ResetStats(void);
+
+#endif /* __CONFIG_H */
@@ -1,26 +1,63 @@
 #include "stm32f10x.h"
+#include "Delay.h"
+#include "Kernel.h"
+#include "Trace.h"
+
+/* 64位周期计数的高32位，以及上一次读到的CYCCNT值（用于检测回绕） */
+static volatile uint32_t delay_cycles_high = 0;
+static volatile uint32_t delay_cycles_last = 0;
+
+/* 内核时钟停止期间（睡眠、停机）CYCCNT未计入的周期数 */
+static volatile uint64_t delay_cycles_offset = 0;
+
+/**
+  * @brief  延时初始化，使能DWT周期计数器
+  * @param  无
+  * @retval 无
+  * @note   延时与时间戳全部基于DWT_CYCCNT，不占用也不改动SysTick
+  */
+void Delay_Init(void)
+{
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;	//使能DWT模块
+	DWT_CYCCNT = 0;									//清空周期计数
+	DWT_CTRL |= DWT_CTRL_CYCCNTENA;					//启动周期计数
+	delay_cycles_high = 0;
+	delay_cycles_last = 0;
+	delay_cycles_offset = 0;
+}
 
 /**
   * @brief  微秒级延时
-  * @param  xus 延时时长，范围：0~233015
+  * @param  xus 延时时长，范围：0~59652323（CYCCNT在72MHz下约59.6秒回绕一次）
   * @retval 无
   */
 void Delay_us(uint32_t xus)
 {
-	SysTick->LOAD = 72 * xus;				//设置定时器重装值
-	SysTick->VAL = 0x00;					//清空当前计数值
-	SysTick->CTRL = 0x00000005;				//设置时钟源为HCLK，启动定时器
-	while(!(SysTick->CTRL & 0x00010000));	//等待计数到0
-	SysTick->CTRL = 0x00000004;				//关闭定时器
+	uint32_t start, ticks;
+	
+	if (!(DWT_CTRL & DWT_CTRL_CYCCNTENA))		//尚未初始化时自动初始化
+	{
+		Delay_Init();
+	}
+	
+	start = DWT_CYCCNT;
+	ticks = xus * (SystemCoreClock / 1000000);	//需要经过的HCLK周期数
+	while (DWT_CYCCNT - start < ticks);			//无符号减法自动处理回绕
 }
 
 /**
   * @brief  毫秒级延时
   * @param  xms 延时时长，范围：0~4294967295
   * @retval 无
+  * @note   在内核线程中调用时让出CPU，由其他线程运行
   */
 void Delay_ms(uint32_t xms)
 {
+	if (Kernel_InThread())
+	{
+		Kernel_Sleep(xms);
+		return;
+	}
 	while(xms--)
 	{
 		Delay_us(1000);
@@ -38,4 +75,83 @@ void Delay_s(uint32_t xs)
 	{
 		Delay_ms(1000);
 	}
-} 
+}
+
+/**
+  * @brief  获取64位单调周期计数
+  * @param  无
+  * @retval 自Delay_Init以来的HCLK周期数
+  * @note   两次调用间隔不能超过CYCCNT回绕周期（约59.6秒），由SysTick中断定期调用以保证这一点（低功耗空闲时间隔最长POWER_MAX_IDLE_MS）
+  */
+uint64_t Delay_GetCycles64(void)
+{
+	uint32_t primask = __get_PRIMASK();
+	uint32_t now;
+	uint64_t cycles;
+	
+	__disable_irq();
+	now = DWT_CYCCNT;
+	if (now < delay_cycles_last)				//CYCCNT发生回绕
+	{
+		delay_cycles_high++;
+	}
+	delay_cycles_last = now;
+	cycles = (((uint64_t)delay_cycles_high << 32) | now) + delay_cycles_offset;
+	__set_PRIMASK(primask);
+	
+	return cycles;
+}
+
+/**
+  * @brief  补偿内核时钟停止期间CYCCNT未计入的周期，使时间戳保持与实际时间同步
+  * @param  cycles 按HCLK换算的补偿周期数
+  * @retval 无
+  * @note   由低功耗空闲处理在睡眠或停机唤醒后调用，调用前后应关闭中断
+  */
+void Delay_AddCycles(uint32_t cycles)
+{
+	uint32_t units = cycles / (SystemCoreClock / 1000000) / 16;	//跟踪记录中以16us为单位
+	
+	delay_cycles_offset += cycles;
+	TRACE(TRACE_EV_CLOCK_SKIP, units < 0xFFFF ? units : 0xFFFF);
+}
+
+/**
+  * @brief  获取64位单调微秒时间戳
+  * @param  无
+  * @retval 自Delay_Init以来的微秒数
+  */
+uint64_t Delay_Micros64(void)
+{
+	return Delay_GetCycles64() / (SystemCoreClock / 1000000);
+}
+
+/**
+  * @brief  获取32位单调微秒时间戳
+  * @param  无
+  * @retval 自Delay_Init以来的微秒数，约71.6分钟回绕一次
+  */
+uint32_t Delay_Micros(void)
+{
+	return (uint32_t)Delay_Micros64();
+}
+
+/**
+  * @brief  计算从现在起经过指定微秒数的截止时刻
+  * @param  us 距现在的微秒数，范围：0~2147483647
+  * @retval 截止时刻，配合Delay_DeadlineReached使用
+  */
+uint32_t Delay_Deadline(uint32_t us)
+{
+	return Delay_Micros() + us;
+}
+
+/**
+  * @brief  非阻塞查询截止时刻是否已到，调用者可在未到时先去做其他事情
+  * @param  deadline 由Delay_Deadline得到的截止时刻
+  * @retval 1：已到，0：未到
+  */
+uint8_t Delay_DeadlineReached(uint32_t deadline)
+{
+	return (int32_t)(Delay_Micros() - deadline) >= 0;
+}
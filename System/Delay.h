@@ -1,8 +1,25 @@
 #ifndef __DELAY_H
 #define __DELAY_H
 
+#include "stm32f10x.h"
+
+/* DWT寄存器（CMSIS V1.30的core_cm3.h未提供DWT定义） */
+#ifndef DWT_CYCCNT
+#define DWT_CTRL        (*(volatile uint32_t *)0xE0001000)
+#define DWT_CYCCNT      (*(volatile uint32_t *)0xE0001004)
+#endif
+#define DWT_CTRL_CYCCNTENA      ((uint32_t)0x00000001)
+
+void Delay_Init(void);
 void Delay_us(uint32_t us);
 void Delay_ms(uint32_t ms);
 void Delay_s(uint32_t s);
 
+uint64_t Delay_GetCycles64(void);
+void Delay_AddCycles(uint32_t cycles);
+uint32_t Delay_Micros(void);
+uint64_t Delay_Micros64(void);
+uint32_t Delay_Deadline(uint32_t us);
+uint8_t Delay_DeadlineReached(uint32_t deadline);
+
 #endif
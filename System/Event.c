@@ -0,0 +1,94 @@
+#include "Event.h"
+#include "Scheduler.h"
+#include "Kernel.h"
+
+/* 事件环形缓冲区，head只由生产者写，tail只由消费者写 */
+static volatile Event_t event_queue[EVENT_QUEUE_SIZE];
+static volatile uint8_t event_head = 0;
+static volatile uint8_t event_tail = 0;
+static volatile uint32_t event_drop_count = 0;
+
+/* 每投递一个事件释放一次，消费者线程在此等待 */
+static Kernel_Sem_t event_sem;
+
+/**
+  * @brief  投递事件（生产者端，在中断中调用）
+  * @param  type: 事件类型
+  * @param  arg: 事件参数
+  * @retval 0: 成功，1: 队列已满，事件被丢弃
+  */
+uint8_t Event_Post(uint8_t type, uint8_t arg)
+{
+    uint8_t head = event_head;
+    uint8_t next = (head + 1) & (EVENT_QUEUE_SIZE - 1);
+
+    if (next == event_tail)
+    {
+        event_drop_count++;
+        return 1;
+    }
+
+    event_queue[head].type = type;
+    event_queue[head].arg = arg;
+    event_queue[head].tick = Scheduler_GetTick();
+
+    /* 先写入数据再发布head，消费者看到新head时数据已完整 */
+    event_head = next;
+
+    /* 唤醒消费者线程 */
+    Kernel_SemPost(&event_sem);
+    return 0;
+}
+
+/**
+  * @brief  取出一个事件（消费者端，在主循环中调用）
+  * @param  event: 用于存放事件的指针
+  * @retval 1: 取到事件，0: 队列为空
+  */
+uint8_t Event_Get(Event_t *event)
+{
+    uint8_t tail = event_tail;
+
+    if (tail == event_head)
+    {
+        return 0;
+    }
+
+    event->type = event_queue[tail].type;
+    event->arg = event_queue[tail].arg;
+    event->tick = event_queue[tail].tick;
+
+    /* 数据读取完成后再释放该槽位 */
+    event_tail = (tail + 1) & (EVENT_QUEUE_SIZE - 1);
+    return 1;
+}
+
+/**
+  * @brief  等待事件到达（消费者线程调用）
+  * @param  timeout: 超时（ms），KERNEL_WAIT_FOREVER表示永久等待
+  * @retval 0: 有事件到达，1: 超时
+  */
+uint8_t Event_Wait(uint32_t timeout)
+{
+    return Kernel_SemWait(&event_sem, timeout);
+}
+
+/**
+  * @brief  查询队列是否为空
+  * @param  None
+  * @retval 1: 为空，0: 非空
+  */
+uint8_t Event_IsEmpty(void)
+{
+    return event_head == event_tail;
+}
+
+/**
+  * @brief  获取因队列满而丢弃的事件数
+  * @param  None
+  * @retval 丢弃计数
+  */
+uint32_t Event_GetDropCount(void)
+{
+    return event_drop_count;
+}
@@ -0,0 +1,69 @@
+#ifndef __EVENT_H
+#define __EVENT_H
+
+#include "stm32f10x.h"
+
+/* 事件队列长度，必须为2的幂 */
+#define EVENT_QUEUE_SIZE        16
+
+/**
+  * @brief  事件类型
+  */
+typedef enum {
+    EVENT_NONE = 0,
+    EVENT_IR_EDGE,          /* 红外传感器电平变化，arg为变化后的电平 */
+    EVENT_KEY_PRESS,        /* 编码器按键按下 */
+    EVENT_COMMAND,          /* 串口收到完整的一行命令 */
+    EVENT_RTC_TICK,         /* RTC秒中断 */
+    EVENT_MEM_LOW,          /* 栈剩余空间低于余量，arg为栈号（见Mem.h） */
+    EVENT_POWER_LOW         /* PVD：电源电压低于阈值，arg为1；恢复到阈值以上，arg为0 */
+} Event_Type_t;
+
+/**
+  * @brief  事件结构体
+  */
+typedef struct {
+    uint8_t type;           /* 事件类型，见Event_Type_t */
+    uint8_t arg;            /* 事件参数 */
+    uint32_t tick;          /* 事件产生时刻（ms） */
+} Event_t;
+
+/**
+  * @brief  投递事件（生产者端，在中断中调用）
+  * @param  type: 事件类型
+  * @param  arg: 事件参数
+  * @retval 0: 成功，1: 队列已满，事件被丢弃
+  * @note   队列为单生产者/单消费者无锁结构。所有投递事件的中断必须配置为相同的
+  *         抢占优先级（当前均为1），保证它们之间不会互相嵌套，从而等效于单一生产者
+  */
+uint8_t Event_Post(uint8_t type, uint8_t arg);
+
+/**
+  * @brief  取出一个事件（消费者端，在主循环中调用）
+  * @param  event: 用于存放事件的指针
+  * @retval 1: 取到事件，0: 队列为空
+  */
+uint8_t Event_Get(Event_t *event);
+
+/**
+  * @brief  等待事件到达（消费者线程调用）
+  * @param  timeout: 超时（ms），KERNEL_WAIT_FOREVER表示永久等待
+  * @retval 0: 有事件到达，1: 超时
+  */
+uint8_t Event_Wait(uint32_t timeout);
+
+/**
+  * @brief  查询队列是否为空
+  * @param  None
+  * @retval 1: 为空，0: 非空
+  */
+uint8_t Event_IsEmpty(void);
+
+/**
+  * @brief  获取因队列满而丢弃的事件数
+  * @param  None
+  * @retval 丢弃计数
+  */
+uint32_t Event_GetDropCount(void);
+
+#endif /* __EVENT_H */
@@ -0,0 +1,1264 @@
+#include "Journal.h"
+#include "Kernel.h"
+#include "Scheduler.h"
+#include "Serial.h"
+#include "Perf.h"
+#include "Trace.h"
+#include <string.h>
+
+/* 扇区的Flash地址，sector为日志区内的扇区号 */
+#define JOURNAL_SECTOR_ADDR(sector) ((uint32_t)(JOURNAL_FIRST_SECTOR + (sector)) * W25Q64_SECTOR_SIZE)
+
+/* 记录槽的Flash地址 */
+#define JOURNAL_SLOT_ADDR(sector, slot) \
+    (JOURNAL_SECTOR_ADDR(sector) + JOURNAL_HEADER_SIZE + (uint32_t)(slot) * JOURNAL_ENTRY_SIZE)
+
+/* 扇区摘要的Flash地址 */
+#define JOURNAL_FOOTER_ADDR(sector) (JOURNAL_SECTOR_ADDR(sector) + W25Q64_SECTOR_SIZE - JOURNAL_FOOTER_SIZE)
+
+/* 起始时间未知（索引未建立、扇区摘要无效或扇区中没有有效记录） */
+#define JOURNAL_TIME_UNKNOWN        0xFFFFFFFF
+
+/* 扇区头读取结果 */
+#define JOURNAL_HEADER_VALID        0
+#define JOURNAL_HEADER_ERASED       1
+#define JOURNAL_HEADER_INVALID      2
+
+/* 页编程的SPI字节数：写使能1字节，命令和地址4字节 */
+#define JOURNAL_PROGRAM_OVERHEAD    5
+
+/* 记录追加探针（CRC + 写入页缓冲，写满一页时加入编程） */
+PERF_PROBE(perf_journal_append, "Journal_Append");
+
+/* 写入位置 */
+static uint16_t journal_head_sector = JOURNAL_SECTOR_COUNT - 1;    /* 当前写入扇区 */
+static uint16_t journal_head_slot = JOURNAL_ENTRIES_PER_SECTOR;    /* 下一条记录的槽号 */
+static uint32_t journal_head_seq = 0;           /* 当前写入扇区的序号，0表示日志为空 */
+static uint32_t journal_next_record = 0;        /* 下一条记录的序号 */
+
+/* 最早的记录 */
+static uint16_t journal_tail_sector = 0;
+static uint32_t journal_first_record = 0;
+
+/* 写入统计 */
+static uint32_t journal_append_count = 0;
+static uint32_t journal_erase_count = 0;
+static uint32_t journal_open_count = 0;         /* 启用扇区次数 */
+static uint32_t journal_open_ready = 0;         /* 启用时扇区已预先擦除的次数 */
+static uint32_t journal_erase_waits = 0;        /* 排在擦除之后写入的记录数 */
+static uint32_t journal_program_count = 0;      /* 页编程次数 */
+static uint32_t journal_program_bytes = 0;      /* 页编程的SPI字节数 */
+static uint32_t journal_flush_full = 0;         /* 各原因的编程次数：写满一页 */
+static uint32_t journal_flush_timer = 0;        /* 超过JOURNAL_FLUSH_MS未写入 */
+static uint32_t journal_flush_sync = 0;         /* Journal_Sync和电压下降后的逐条写入 */
+static uint32_t journal_buffer_waits = 0;       /* 换页时另一个缓冲区仍在编程的次数 */
+
+/* 预擦除：写入扇区之后已擦除或擦除已加入队列的扇区数，上电时不确定，置0重新擦除 */
+static uint8_t journal_ahead_target = JOURNAL_ERASE_AHEAD;
+static uint8_t journal_ahead = 0;
+static uint8_t journal_ahead_first = 0;         /* 下一个启用的预擦除扇区在擦除次数环形队列中的位置 */
+static uint32_t journal_ahead_wear[JOURNAL_ERASE_AHEAD_MAX];   /* 预擦除扇区的擦除次数，启用时写入扇区头 */
+
+/* 写入扇区的擦除次数，扇区头可能还在页缓冲中；擦除前读不到扇区头时按此估计 */
+static uint32_t journal_head_wear = 0;
+static uint32_t journal_wear_erases = 0;        /* 上电以来的扇区擦除次数，用于估算寿命，不随统计清除 */
+
+/* 上电恢复读取扇区头、记录槽和扇区摘要的次数 */
+static uint16_t journal_recover_reads = 0;
+
+/* 写入扇区的摘要，写满扇区时写在扇区末尾 */
+static Journal_Footer_t journal_summary;
+
+/* 时间索引：第k项为k * JOURNAL_INDEX_STRIDE号扇区的起始时间，扇区写满时写入，擦除时清除 */
+static uint32_t journal_index[JOURNAL_INDEX_SIZE];
+static uint32_t journal_search_count = 0;       /* 按时间查找的次数 */
+static uint32_t journal_search_reads = 0;       /* 查找时读取扇区摘要和记录槽的次数 */
+
+/**
+  * @brief  页缓冲：扇区头和记录先写入内存中的页缓冲，写满一页、超时或Journal_Sync时
+  *         才把未写入的部分加入W25Q64操作队列，数据保留到编程完成
+  */
+typedef struct {
+    uint32_t addr;                      /* 页的Flash地址 */
+    uint32_t first_record;              /* 缓冲区中第一条记录的序号 */
+    uint16_t first;                     /* 第一条记录的页内偏移 */
+    uint16_t flushed;                   /* 已加入编程的数据末尾（页内偏移） */
+    uint16_t fill;                      /* 已写入缓冲区的数据末尾（页内偏移） */
+    uint8_t data[W25Q64_PAGE_SIZE];
+} Journal_Page_t;
+
+/* 两个页缓冲交替使用，一页在后台编程时记录写入另一页；换页时另一页的编程早已完成 */
+static Journal_Page_t journal_pages[2];
+static uint8_t journal_page = 0;                /* 当前页缓冲 */
+static uint32_t journal_dirty_tick = 0;         /* 当前页缓冲开始有未写入数据的时刻 */
+static volatile uint8_t journal_write_through = 0;  /* 1: 电源电压下降，每条记录立即编程 */
+
+/* 序号小于此值的记录都已编程完成，由操作队列的完成回调推进（可能在任一轮询操作队列的线程中） */
+static volatile uint32_t journal_durable_record = 0;
+static void (*journal_durable_hook)(uint32_t next) = 0;
+
+/* bulk线程追加和读取，alarm线程在电压下降时写入页缓冲 */
+static Kernel_Mutex_t journal_mutex;
+
+static void Journal_BuildIndex(void);
+
+/**
+  * @brief  读取并校验扇区头，不计入上电恢复的读取次数
+  * @param  sector: 日志区内的扇区号
+  * @param  header: 用于存放扇区头的指针
+  * @retval JOURNAL_HEADER_VALID/ERASED/INVALID
+  */
+static uint8_t Journal_LoadHeader(uint16_t sector, Journal_Header_t *header)
+{
+    W25Q64_ReadBytes(JOURNAL_SECTOR_ADDR(sector), (uint8_t *)header, sizeof(Journal_Header_t));
+
+    if (header->magic == 0xFFFFFFFF && header->seq == 0xFFFFFFFF)
+    {
+        return JOURNAL_HEADER_ERASED;
+    }
+    if (header->magic != JOURNAL_MAGIC || header->version != JOURNAL_VERSION ||
+        header->crc != W25Q64_CalculateCRC16((uint8_t *)header, sizeof(Journal_Header_t) - 2))
+    {
+        return JOURNAL_HEADER_INVALID;
+    }
+    return JOURNAL_HEADER_VALID;
+}
+
+/**
+  * @brief  上电恢复时读取并校验扇区头
+  * @param  sector: 日志区内的扇区号
+  * @param  header: 用于存放扇区头的指针
+  * @retval JOURNAL_HEADER_VALID/ERASED/INVALID
+  */
+static uint8_t Journal_ReadHeader(uint16_t sector, Journal_Header_t *header)
+{
+    journal_recover_reads++;
+    return Journal_LoadHeader(sector, header);
+}
+
+/**
+  * @brief  判断记录槽是否未写入
+  * @param  sector: 日志区内的扇区号
+  * @param  slot: 槽号
+  * @retval 1: 未写入（全为0xFF），0: 已写入
+  */
+static uint8_t Journal_SlotErased(uint16_t sector, uint16_t slot)
+{
+    uint32_t words[JOURNAL_ENTRY_SIZE / 4];
+    uint8_t i;
+
+    W25Q64_ReadBytes(JOURNAL_SLOT_ADDR(sector, slot), (uint8_t *)words, JOURNAL_ENTRY_SIZE);
+    journal_recover_reads++;
+    for (i = 0; i < JOURNAL_ENTRY_SIZE / 4; i++)
+    {
+        if (words[i] != 0xFFFFFFFF)
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+  * @brief  清空扇区摘要
+  * @param  summary: 摘要
+  * @retval None
+  */
+static void Journal_SummaryReset(Journal_Footer_t *summary)
+{
+    memset(summary, 0, sizeof(Journal_Footer_t));
+    summary->first_time = JOURNAL_TIME_UNKNOWN;
+    summary->temp_min = 0xFF;
+    summary->humi_min = 0xFF;
+}
+
+/**
+  * @brief  把一条记录计入扇区摘要
+  * @param  summary: 摘要
+  * @param  record: 记录
+  * @retval None
+  */
+static void Journal_SummaryAdd(Journal_Footer_t *summary, const DataRecord_t *record)
+{
+    if (summary->count == 0)
+    {
+        summary->first_time = record->timestamp;
+    }
+    summary->last_time = record->timestamp;
+    summary->count++;
+    if (record->temperature < summary->temp_min) summary->temp_min = record->temperature;
+    if (record->temperature > summary->temp_max) summary->temp_max = record->temperature;
+    if (record->humidity < summary->humi_min) summary->humi_min = record->humidity;
+    if (record->humidity > summary->humi_max) summary->humi_max = record->humidity;
+    if (record->ir_status == 0)     /* 红外传感器低电平表示检测到人体 */
+    {
+        summary->motion++;
+    }
+}
+
+/**
+  * @brief  读取并校验扇区摘要
+  * @param  sector: 日志区内的扇区号
+  * @param  footer: 用于存放摘要的指针
+  * @retval 1: 有效，0: 未写入或CRC错误
+  */
+static uint8_t Journal_LoadFooter(uint16_t sector, Journal_Footer_t *footer)
+{
+    W25Q64_ReadBytes(JOURNAL_FOOTER_ADDR(sector), (uint8_t *)footer, sizeof(Journal_Footer_t));
+
+    return footer->count != 0xFF &&
+           footer->crc == W25Q64_CalculateCRC16((uint8_t *)footer, sizeof(Journal_Footer_t) - 2);
+}
+
+/**
+  * @brief  校验记录槽
+  * @param  entry: 读出的记录槽
+  * @param  seq: 期望的记录序号
+  * @retval 1: 有效，0: 序号不符或CRC错误
+  */
+static uint8_t Journal_EntryValid(const Journal_Entry_t *entry, uint32_t seq)
+{
+    return entry->seq == seq &&
+           entry->crc == W25Q64_CalculateCRC16((const uint8_t *)entry, sizeof(Journal_Entry_t) - 2) &&
+           entry->record.crc == W25Q64_CalculateCRC16((const uint8_t *)&entry->record, sizeof(DataRecord_t) - 2);
+}
+
+/**
+  * @brief  判断扇区是否属于从0号扇区开始的本轮写入（有效且序号不小于0号扇区）
+  * @param  sector: 日志区内的扇区号
+  * @param  seq0: 0号扇区的序号
+  * @retval 1: 属于本轮写入，0: 更早的扇区、无效或未写入
+  */
+static uint8_t Journal_InLap(uint16_t sector, uint32_t seq0)
+{
+    Journal_Header_t header;
+
+    return Journal_ReadHeader(sector, &header) == JOURNAL_HEADER_VALID && header.seq >= seq0;
+}
+
+/**
+  * @brief  从Flash内容恢复写入位置和最早的记录，在W25Q64_Init之后调用
+  * @param  None
+  * @retval 0: 日志为空或最后一条记录有效，1: 最后一条记录CRC错误（写入时掉电）
+  * @note   扇区按物理顺序循环启用，从0号扇区到写入扇区的序号连续递增，之后是上一轮
+  *         的旧扇区或未写入的扇区，二分查找写入扇区只需读取约log2(扇区数)个扇区头；
+  *         扇区内的记录槽也按顺序写入，同样二分查找第一个空槽
+  */
+uint8_t Journal_Init(void)
+{
+    Journal_Header_t header;
+    Journal_Entry_t entry;
+    uint16_t sector, lo, hi, mid;
+    uint8_t i;
+
+    journal_head_sector = JOURNAL_SECTOR_COUNT - 1;
+    journal_head_slot = JOURNAL_ENTRIES_PER_SECTOR;
+    journal_head_seq = 0;
+    journal_next_record = 0;
+    journal_tail_sector = 0;
+    journal_first_record = 0;
+    journal_durable_record = 0;
+    journal_recover_reads = 0;
+    for (i = 0; i < 2; i++)
+    {
+        /*页缓冲不对应任何页，第一次追加时换页*/
+        journal_pages[i].addr = 0xFFFFFFFF;
+        journal_pages[i].first = 0;
+        journal_pages[i].flushed = 0;
+        journal_pages[i].fill = 0;
+    }
+    journal_ahead = 0;
+    journal_ahead_first = 0;
+    Journal_SummaryReset(&journal_summary);
+    for (i = 0; i < JOURNAL_INDEX_SIZE; i++)
+    {
+        journal_index[i] = JOURNAL_TIME_UNKNOWN;
+    }
+
+    /*二分查找写入扇区：本轮写入的最后一个扇区*/
+    if (Journal_ReadHeader(0, &header) == JOURNAL_HEADER_VALID)
+    {
+        uint32_t seq0 = header.seq;
+
+        lo = 0;
+        hi = JOURNAL_SECTOR_COUNT;
+        while (hi - lo > 1)
+        {
+            mid = (lo + hi) / 2;
+            if (Journal_InLap(mid, seq0))
+            {
+                lo = mid;
+            }
+            else
+            {
+                hi = mid;
+            }
+        }
+        journal_head_sector = lo;
+    }
+    else
+    {
+        /*0号扇区是预擦除的扇区，或启用0号扇区时掉电，写入扇区在最后几个扇区中*/
+        sector = JOURNAL_SECTOR_COUNT;
+        for (i = 0; i < JOURNAL_ERASE_AHEAD_MAX + 1; i++)
+        {
+            sector--;
+            if (Journal_ReadHeader(sector, &header) == JOURNAL_HEADER_VALID)
+            {
+                break;
+            }
+        }
+        if (i == JOURNAL_ERASE_AHEAD_MAX + 1)
+        {
+            /*日志为空，第一次追加时启用0号扇区*/
+            return 0;
+        }
+        journal_head_sector = sector;
+    }
+
+    Journal_ReadHeader(journal_head_sector, &header);
+    journal_head_seq = header.seq;
+    journal_next_record = header.first_record;
+    journal_head_wear = header.erase_count;
+
+    /*二分查找写入扇区中第一个空槽*/
+    lo = 0;
+    hi = JOURNAL_ENTRIES_PER_SECTOR;
+    while (lo < hi)
+    {
+        mid = (lo + hi) / 2;
+        if (Journal_SlotErased(journal_head_sector, mid))
+        {
+            hi = mid;
+        }
+        else
+        {
+            lo = mid + 1;
+        }
+    }
+    journal_head_slot = lo;
+    journal_next_record += lo;
+
+    /*日志区已循环时，写入扇区之后跳过预擦除的扇区即为最早的扇区；启用扇区时掉电可能留下一个无效扇区*/
+    journal_tail_sector = 0;
+    sector = journal_head_sector;
+    for (i = 0; i < JOURNAL_ERASE_AHEAD_MAX + 2; i++)
+    {
+        sector = (sector + 1) % JOURNAL_SECTOR_COUNT;
+        if (Journal_ReadHeader(sector, &header) == JOURNAL_HEADER_VALID && header.seq < journal_head_seq)
+        {
+            journal_tail_sector = sector;
+            break;
+        }
+    }
+    if (Journal_ReadHeader(journal_tail_sector, &header) == JOURNAL_HEADER_VALID)
+    {
+        journal_first_record = header.first_record;
+    }
+    else
+    {
+        /*最早的扇区头无效，只保留写入扇区*/
+        journal_tail_sector = journal_head_sector;
+        journal_first_record = journal_next_record - journal_head_slot;
+    }
+
+    /*恢复出的记录都已在Flash中*/
+    journal_durable_record = journal_next_record;
+
+    /*重建写入扇区的摘要，读取每JOURNAL_INDEX_STRIDE个扇区的摘要建立时间索引*/
+    Journal_BuildIndex();
+
+    /*校验最后一条记录，写入时掉电会留下CRC错误的记录，其序号不再使用*/
+    if (journal_head_slot > 0)
+    {
+        W25Q64_ReadBytes(JOURNAL_SLOT_ADDR(journal_head_sector, journal_head_slot - 1), (uint8_t *)&entry, sizeof(entry));
+        journal_recover_reads++;
+        if (entry.seq != journal_next_record - 1 ||
+            entry.crc != W25Q64_CalculateCRC16((uint8_t *)&entry, sizeof(entry) - 2))
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+  * @brief  擦除写入扇区之后的扇区，日志区已满时丢弃最早的扇区
+  * @param  sector: 日志区内的扇区号
+  * @retval 包括本次在内的擦除次数，由扇区头中的计数加1；读不到扇区头时按写入扇区的
+  *         次数估计（扇区轮流擦除，本轮尚未擦除的扇区比写入扇区少一次）
+  * @note   擦除只加入操作队列，不等待完成
+  */
+static uint32_t Journal_EraseSector(uint16_t sector)
+{
+    Journal_Header_t header;
+    uint32_t erases;
+
+    if (Journal_LoadHeader(sector, &header) == JOURNAL_HEADER_VALID)
+    {
+        erases = header.erase_count + 1;
+    }
+    else
+    {
+        erases = (journal_head_wear > 0) ? journal_head_wear : 1;
+    }
+
+    if (journal_head_seq != 0 && sector == journal_tail_sector)
+    {
+        /*覆盖最早的扇区，之后的扇区成为最早的扇区*/
+        journal_tail_sector = (sector + 1) % JOURNAL_SECTOR_COUNT;
+        if (Journal_LoadHeader(journal_tail_sector, &header) == JOURNAL_HEADER_VALID)
+        {
+            journal_first_record = header.first_record;
+        }
+        else
+        {
+            journal_first_record += JOURNAL_ENTRIES_PER_SECTOR;
+        }
+    }
+
+    if (sector % JOURNAL_INDEX_STRIDE == 0)
+    {
+        journal_index[sector / JOURNAL_INDEX_STRIDE] = JOURNAL_TIME_UNKNOWN;
+    }
+
+    W25Q64_QueueErase(JOURNAL_SECTOR_ADDR(sector));
+    journal_erase_count++;
+    journal_wear_erases++;
+    return erases;
+}
+
+/**
+  * @brief  计算页缓冲中的记录数
+  * @param  page: 页缓冲
+  * @retval 记录数，不含扇区头和摘要
+  */
+static uint32_t Journal_PageRecords(const Journal_Page_t *page)
+{
+    uint32_t records = (page->fill > page->first) ? (uint32_t)(page->fill - page->first) / JOURNAL_ENTRY_SIZE : 0;
+
+    /*扇区最后一页以摘要结束，摘要不是记录*/
+    if (records > 0 && (page->addr + page->fill) % W25Q64_SECTOR_SIZE == 0)
+    {
+        records--;
+    }
+    return records;
+}
+
+/**
+  * @brief  页编程完成回调，在轮询操作队列的线程中调用
+  * @param  next: 这次编程写入的最后一条记录之后的序号
+  * @retval None
+  * @note   编程按加入顺序完成，next不会减小
+  */
+static void Journal_ProgramDone(uint32_t next)
+{
+    journal_durable_record = next;
+    if (journal_durable_hook)
+    {
+        journal_durable_hook(next);
+    }
+}
+
+/**
+  * @brief  把页缓冲中未写入的部分加入W25Q64操作队列
+  * @param  page: 页缓冲
+  * @retval None
+  * @note   之后追加的数据写在已加入部分之后，不改动正在编程的字节
+  */
+static void Journal_FlushPage(Journal_Page_t *page)
+{
+    uint16_t start = (page->flushed > page->first) ? page->flushed : page->first;
+
+    if (page->fill <= page->flushed)
+    {
+        return;
+    }
+
+    if (W25Q64_GetQueuedErases() > 0)
+    {
+        /*操作队列按顺序执行，这些记录要等擦除完成才能编程*/
+        journal_erase_waits += (page->fill - start) / JOURNAL_ENTRY_SIZE;
+    }
+    W25Q64_QueueProgramNotify(page->addr + page->flushed, page->data + page->flushed, page->fill - page->flushed,
+                              Journal_ProgramDone, page->first_record + Journal_PageRecords(page));
+    journal_program_count++;
+    journal_program_bytes += JOURNAL_PROGRAM_OVERHEAD + page->fill - page->flushed;
+    page->flushed = page->fill;
+}
+
+/**
+  * @brief  写入当前页缓冲，写入位置不在当前页时先换页
+  * @param  addr: Flash地址，与之前写入的数据连续或位于新的一页
+  * @param  data: 数据
+  * @param  length: 字节数，不跨页
+  * @retval None
+  */
+static void Journal_Put(uint32_t addr, const void *data, uint16_t length)
+{
+    Journal_Page_t *page = &journal_pages[journal_page];
+    uint16_t offset = addr % W25Q64_PAGE_SIZE;
+
+    if (page->addr + page->fill != addr || page->fill == W25Q64_PAGE_SIZE)
+    {
+        /*换页：当前页剩余的部分加入编程，另一个页缓冲的编程未完成时等待*/
+        Journal_FlushPage(page);
+        journal_page ^= 1;
+        page = &journal_pages[journal_page];
+        if (W25Q64_IsQueued(page->data, W25Q64_PAGE_SIZE))
+        {
+            journal_buffer_waits++;
+            W25Q64_Sync();
+        }
+        page->addr = addr - offset;
+        page->first_record = journal_next_record;
+        page->first = offset;
+        page->flushed = offset;
+        page->fill = offset;
+    }
+
+    if (page->fill == page->flushed)
+    {
+        journal_dirty_tick = Scheduler_GetTick();
+    }
+    memcpy(page->data + offset, data, length);
+    page->fill = offset + length;
+}
+
+/**
+  * @brief  启用下一个扇区并写入扇区头，未预先擦除时先擦除
+  * @param  None
+  * @retval None
+  * @note   擦除只加入操作队列，扇区头写入页缓冲，和之后的记录一起编程
+  */
+static void Journal_OpenSector(void)
+{
+    Journal_Header_t header;
+    uint16_t sector = (journal_head_sector + 1) % JOURNAL_SECTOR_COUNT;
+
+    journal_open_count++;
+    if (journal_ahead > 0)
+    {
+        header.erase_count = journal_ahead_wear[journal_ahead_first];
+        journal_ahead_first = (journal_ahead_first + 1) % JOURNAL_ERASE_AHEAD_MAX;
+        journal_ahead--;
+        journal_open_ready++;
+    }
+    else
+    {
+        header.erase_count = Journal_EraseSector(sector);
+    }
+
+    header.magic = JOURNAL_MAGIC;
+    header.seq = journal_head_seq + 1;
+    header.first_record = journal_next_record;
+    header.version = JOURNAL_VERSION;
+    memset(header.reserved, 0xFF, sizeof(header.reserved));
+    header.crc = W25Q64_CalculateCRC16((uint8_t *)&header, sizeof(Journal_Header_t) - 2);
+    Journal_Put(JOURNAL_SECTOR_ADDR(sector), &header, sizeof(Journal_Header_t));
+    journal_pages[journal_page].first = JOURNAL_HEADER_SIZE;   /* 扇区头之后才是记录 */
+
+    journal_head_sector = sector;
+    journal_head_seq = header.seq;
+    journal_head_slot = 0;
+    journal_head_wear = header.erase_count;
+    Journal_SummaryReset(&journal_summary);
+}
+
+/**
+  * @brief  由写入扇区中已写入的记录重建摘要，写入扇区已满而摘要未写入时补写，并建立时间索引
+  * @param  None
+  * @retval None
+  * @note   在Journal_Init恢复写入位置之后调用；读取写入扇区的全部记录（最多约4KB）和
+  *         约JOURNAL_INDEX_SIZE个扇区摘要
+  */
+static void Journal_BuildIndex(void)
+{
+    Journal_Entry_t entries[4];
+    Journal_Footer_t footer;
+    uint32_t first = journal_next_record - journal_head_slot;
+    uint16_t slot, count, sector, k, i;
+
+    Journal_SummaryReset(&journal_summary);
+    for (slot = 0; slot < journal_head_slot; slot += count)
+    {
+        count = journal_head_slot - slot;
+        if (count > sizeof(entries) / sizeof(entries[0]))
+        {
+            count = sizeof(entries) / sizeof(entries[0]);
+        }
+        W25Q64_ReadBytes(JOURNAL_SLOT_ADDR(journal_head_sector, slot), (uint8_t *)entries, count * JOURNAL_ENTRY_SIZE);
+        journal_recover_reads++;
+        for (i = 0; i < count; i++)
+        {
+            if (Journal_EntryValid(&entries[i], first + slot + i))
+            {
+                Journal_SummaryAdd(&journal_summary, &entries[i].record);
+            }
+        }
+    }
+
+    /*写满扇区的最后一页编程时掉电，摘要未写入：摘要位置仍为空时补写*/
+    if (journal_head_slot == JOURNAL_ENTRIES_PER_SECTOR && !Journal_LoadFooter(journal_head_sector, &footer))
+    {
+        const uint8_t *p = (const uint8_t *)&footer;
+
+        for (i = 0; i < sizeof(footer) && p[i] == 0xFF; i++);
+        if (i == sizeof(footer))
+        {
+            journal_summary.crc = W25Q64_CalculateCRC16((uint8_t *)&journal_summary, sizeof(Journal_Footer_t) - 2);
+            Journal_Put(JOURNAL_FOOTER_ADDR(journal_head_sector), &journal_summary, sizeof(Journal_Footer_t));
+            Journal_FlushPage(&journal_pages[journal_page]);
+        }
+    }
+
+    /*写入扇区和写入扇区之后的扇区没有可用的摘要*/
+    for (k = 0; k < JOURNAL_INDEX_SIZE; k++)
+    {
+        sector = k * JOURNAL_INDEX_STRIDE;
+        journal_index[k] = JOURNAL_TIME_UNKNOWN;
+        if (journal_head_seq != 0 && sector != journal_head_sector &&
+            (sector + JOURNAL_SECTOR_COUNT - journal_tail_sector) % JOURNAL_SECTOR_COUNT <
+            (journal_head_sector + JOURNAL_SECTOR_COUNT - journal_tail_sector) % JOURNAL_SECTOR_COUNT)
+        {
+            journal_recover_reads++;
+            if (Journal_LoadFooter(sector, &footer))
+            {
+                journal_index[k] = footer.first_time;
+            }
+        }
+    }
+}
+
+/**
+  * @brief  追加一条记录
+  * @param  record: 记录，CRC由日志计算
+  * @retval 追加的记录序号
+  * @note   记录写入页缓冲后即返回，写满一页时整页加入W25Q64操作队列；
+  *         未写满的页由Journal_Poll超时写入，或由Journal_Sync立即写入
+  */
+uint32_t Journal_Append(const DataRecord_t *record)
+{
+    Journal_Entry_t entry;
+    Journal_Page_t *page;
+    uint32_t seq;
+
+    PERF_BEGIN(perf_journal_append);
+    TRACE(TRACE_EV_FLASH_WRITE_BEGIN, journal_next_record);
+    Kernel_MutexLock(&journal_mutex);
+
+    if (journal_head_slot >= JOURNAL_ENTRIES_PER_SECTOR)
+    {
+        Journal_OpenSector();
+    }
+
+    entry.seq = journal_next_record;
+    entry.record = *record;
+    entry.record.crc = W25Q64_CalculateCRC16((uint8_t *)&entry.record, sizeof(DataRecord_t) - 2);
+    entry.crc = W25Q64_CalculateCRC16((uint8_t *)&entry, sizeof(Journal_Entry_t) - 2);
+    Journal_Put(JOURNAL_SLOT_ADDR(journal_head_sector, journal_head_slot), &entry, sizeof(Journal_Entry_t));
+    Journal_SummaryAdd(&journal_summary, &entry.record);
+
+    if (journal_head_slot == JOURNAL_ENTRIES_PER_SECTOR - 1)
+    {
+        /*写满扇区：摘要紧接最后一个记录槽，和最后一页一起编程*/
+        journal_summary.crc = W25Q64_CalculateCRC16((uint8_t *)&journal_summary, sizeof(Journal_Footer_t) - 2);
+        Journal_Put(JOURNAL_FOOTER_ADDR(journal_head_sector), &journal_summary, sizeof(Journal_Footer_t));
+        if (journal_head_sector % JOURNAL_INDEX_STRIDE == 0)
+        {
+            journal_index[journal_head_sector / JOURNAL_INDEX_STRIDE] = journal_summary.first_time;
+        }
+    }
+
+    page = &journal_pages[journal_page];
+    if (page->fill == W25Q64_PAGE_SIZE)
+    {
+        journal_flush_full++;
+        Journal_FlushPage(page);
+    }
+    else if (journal_write_through)
+    {
+        journal_flush_sync++;
+        Journal_FlushPage(page);
+    }
+
+    seq = journal_next_record;
+    journal_head_slot++;
+    journal_next_record++;
+    journal_append_count++;
+
+    Kernel_MutexUnlock(&journal_mutex);
+    TRACE(TRACE_EV_FLASH_WRITE_END, seq);
+    PERF_END(perf_journal_append);
+    return seq;
+}
+
+/**
+  * @brief  把页缓冲中未写入的数据加入编程，不等待编程完成
+  * @param  None
+  * @retval None
+  */
+void Journal_Sync(void)
+{
+    Journal_Page_t *page;
+
+    Kernel_MutexLock(&journal_mutex);
+    page = &journal_pages[journal_page];
+    if (page->fill > page->flushed)
+    {
+        journal_flush_sync++;
+        Journal_FlushPage(page);
+    }
+    Kernel_MutexUnlock(&journal_mutex);
+}
+
+/**
+  * @brief  页缓冲中的数据超过JOURNAL_FLUSH_MS未写入时加入编程（bulk线程调用）
+  * @param  None
+  * @retval None
+  */
+void Journal_Poll(void)
+{
+    Journal_Page_t *page;
+
+    Kernel_MutexLock(&journal_mutex);
+    page = &journal_pages[journal_page];
+    if (page->fill > page->flushed && Scheduler_GetTick() - journal_dirty_tick >= JOURNAL_FLUSH_MS)
+    {
+        journal_flush_timer++;
+        Journal_FlushPage(page);
+    }
+    Kernel_MutexUnlock(&journal_mutex);
+}
+
+/**
+  * @brief  获取到下一次超时写入页缓冲的时间
+  * @param  None
+  * @retval 时间（ms），页缓冲中没有未写入的数据时为KERNEL_WAIT_FOREVER
+  */
+uint32_t Journal_GetFlushDelay(void)
+{
+    Journal_Page_t *page = &journal_pages[journal_page];
+    uint32_t elapsed = Scheduler_GetTick() - journal_dirty_tick;
+
+    if (page->fill <= page->flushed)
+    {
+        return KERNEL_WAIT_FOREVER;
+    }
+    return (elapsed < JOURNAL_FLUSH_MS) ? JOURNAL_FLUSH_MS - elapsed : 1;
+}
+
+/**
+  * @brief  电源电压下降时立即写入页缓冲，之后每条记录追加后立即编程
+  * @param  enable: 1: 电压低于PVD阈值，0: 电压恢复，重新按页合并写入
+  * @retval None
+  */
+void Journal_SetWriteThrough(uint8_t enable)
+{
+    journal_write_through = enable;
+    if (enable)
+    {
+        Journal_Sync();
+    }
+}
+
+/**
+  * @brief  在空闲时预先擦除写入扇区之后的扇区（bulk线程写完记录后调用）
+  * @param  None
+  * @retval None
+  * @note   只在操作队列为空时加入擦除，不推迟已追加记录的编程；
+  *         日志区已循环时每预擦除一个扇区，最早的扇区提前被丢弃
+  */
+void Journal_Prepare(void)
+{
+    uint16_t sector;
+
+    if (W25Q64_GetQueueDepth() > 0)
+    {
+        return;
+    }
+
+    Kernel_MutexLock(&journal_mutex);
+    while (journal_ahead < journal_ahead_target)
+    {
+        sector = (journal_head_sector + 1 + journal_ahead) % JOURNAL_SECTOR_COUNT;
+        if (sector == journal_head_sector)
+        {
+            break;
+        }
+        journal_ahead_wear[(journal_ahead_first + journal_ahead) % JOURNAL_ERASE_AHEAD_MAX] = Journal_EraseSector(sector);
+        journal_ahead++;
+    }
+    Kernel_MutexUnlock(&journal_mutex);
+}
+
+/**
+  * @brief  设置预擦除的扇区数
+  * @param  count: 扇区数，超过JOURNAL_ERASE_AHEAD_MAX时取最大值
+  * @retval None
+  * @note   减少时已擦除的扇区仍然保留，下次启用扇区时使用
+  */
+void Journal_SetEraseAhead(uint8_t count)
+{
+    journal_ahead_target = (count > JOURNAL_ERASE_AHEAD_MAX) ? JOURNAL_ERASE_AHEAD_MAX : count;
+}
+
+/**
+  * @brief  获取预擦除的扇区数
+  * @param  None
+  * @retval 扇区数
+  */
+uint8_t Journal_GetEraseAhead(void)
+{
+    return journal_ahead_target;
+}
+
+/**
+  * @brief  按序号读取记录，调用时持有journal_mutex
+  * @param  seq: 记录序号
+  * @param  record: 用于存放记录的指针
+  * @retval 0: 成功，1: CRC错误或记录无效，2: 序号不在日志中
+  */
+static uint8_t Journal_ReadEntry(uint32_t seq, DataRecord_t *record)
+{
+    Journal_Entry_t entry;
+    uint32_t offset;
+    uint16_t sector;
+    uint8_t i;
+
+    if (seq - journal_first_record >= journal_next_record - journal_first_record)
+    {
+        return 2;
+    }
+
+    /*最近追加的记录可能还在页缓冲或操作队列中，读取内存中的副本*/
+    for (i = 0; i < 2; i++)
+    {
+        const Journal_Page_t *page = &journal_pages[i];
+
+        if (seq - page->first_record < Journal_PageRecords(page))
+        {
+            memcpy(&entry, page->data + page->first + (seq - page->first_record) * JOURNAL_ENTRY_SIZE, sizeof(entry));
+            break;
+        }
+    }
+    if (i == 2)
+    {
+        /*每个扇区的记录序号连续，由最早的扇区按偏移定位*/
+        offset = seq - journal_first_record;
+        sector = (journal_tail_sector + offset / JOURNAL_ENTRIES_PER_SECTOR) % JOURNAL_SECTOR_COUNT;
+        W25Q64_ReadBytes(JOURNAL_SLOT_ADDR(sector, offset % JOURNAL_ENTRIES_PER_SECTOR), (uint8_t *)&entry, sizeof(entry));
+    }
+
+    *record = entry.record;
+    return Journal_EntryValid(&entry, seq) ? 0 : 1;
+}
+
+/**
+  * @brief  按序号读取记录
+  * @param  seq: 记录序号，范围为[Journal_GetFirst(), Journal_GetNext())
+  * @param  record: 用于存放记录的指针
+  * @retval 0: 成功，1: CRC错误或记录无效，2: 序号不在日志中
+  */
+uint8_t Journal_Read(uint32_t seq, DataRecord_t *record)
+{
+    uint8_t result;
+
+    Kernel_MutexLock(&journal_mutex);
+    result = Journal_ReadEntry(seq, record);
+    Kernel_MutexUnlock(&journal_mutex);
+    return result;
+}
+
+/**
+  * @brief  读取写满的扇区的摘要
+  * @param  seq: 扇区第一条记录的序号
+  * @param  summary: 用于存放摘要的指针
+  * @retval 0: 成功，1: seq不是扇区第一条记录、扇区未写满或摘要尚未写入Flash
+  */
+uint8_t Journal_ReadSummary(uint32_t seq, Journal_Footer_t *summary)
+{
+    uint32_t offset;
+    uint16_t sector;
+    uint8_t result = 1;
+
+    Kernel_MutexLock(&journal_mutex);
+    offset = seq - journal_first_record;
+    if (offset < journal_next_record - journal_first_record && offset % JOURNAL_ENTRIES_PER_SECTOR == 0)
+    {
+        sector = (journal_tail_sector + offset / JOURNAL_ENTRIES_PER_SECTOR) % JOURNAL_SECTOR_COUNT;
+        if (sector != journal_head_sector && Journal_LoadFooter(sector, summary))
+        {
+            result = 0;
+        }
+    }
+    Kernel_MutexUnlock(&journal_mutex);
+    return result;
+}
+
+/**
+  * @brief  获取日志区中第pos个扇区（从最早的扇区数起）的起始时间，调用时持有journal_mutex
+  * @param  pos: 扇区位置
+  * @retval 第一条有效记录的时间戳，未知时为JOURNAL_TIME_UNKNOWN
+  * @note   依次使用写入扇区的摘要、时间索引、扇区摘要和第一个记录槽
+  */
+static uint32_t Journal_SectorTime(uint16_t pos)
+{
+    uint16_t sector = (journal_tail_sector + pos) % JOURNAL_SECTOR_COUNT;
+    Journal_Footer_t footer;
+    DataRecord_t record;
+
+    if (sector == journal_head_sector)
+    {
+        return journal_summary.first_time;
+    }
+    if (sector % JOURNAL_INDEX_STRIDE == 0 && journal_index[sector / JOURNAL_INDEX_STRIDE] != JOURNAL_TIME_UNKNOWN)
+    {
+        return journal_index[sector / JOURNAL_INDEX_STRIDE];
+    }
+
+    journal_search_reads++;
+    if (Journal_LoadFooter(sector, &footer))
+    {
+        return footer.first_time;
+    }
+    journal_search_reads++;
+    if (Journal_ReadEntry(journal_first_record + (uint32_t)pos * JOURNAL_ENTRIES_PER_SECTOR, &record) == 0)
+    {
+        return record.timestamp;
+    }
+    return JOURNAL_TIME_UNKNOWN;
+}
+
+/**
+  * @brief  按时间查找记录
+  * @param  timestamp: 时间戳（RTC秒数）
+  * @retval 第一条时间戳不早于timestamp的记录序号，没有时为Journal_GetNext()
+  * @note   先在内存索引中、再按扇区起始时间二分查找第一个起始时间不早于timestamp的扇区，
+  *         之后在前一个扇区中二分查找记录。起始时间未知的扇区和无效记录按不早于timestamp
+  *         处理，结果只会偏早，不会漏掉记录
+  */
+uint32_t Journal_FindTime(uint32_t timestamp)
+{
+    DataRecord_t record;
+    uint32_t lo, hi, mid;
+    uint16_t count, base, k_lo, k_hi, k_mid;
+
+    Kernel_MutexLock(&journal_mutex);
+    journal_search_count++;
+    if (journal_next_record == journal_first_record)
+    {
+        Kernel_MutexUnlock(&journal_mutex);
+        return journal_next_record;
+    }
+
+    /*扇区位置pos = 从最早的扇区数起的序号，查找第一个起始时间不早于timestamp的位置*/
+    count = (journal_head_sector + JOURNAL_SECTOR_COUNT - journal_tail_sector) % JOURNAL_SECTOR_COUNT + 1;
+    lo = 0;
+    hi = count;
+
+    /*内存索引：已索引的扇区位于base + k * JOURNAL_INDEX_STRIDE*/
+    base = (JOURNAL_INDEX_STRIDE - journal_tail_sector % JOURNAL_INDEX_STRIDE) % JOURNAL_INDEX_STRIDE;
+    k_lo = 0;
+    k_hi = (base < count) ? (count - 1 - base) / JOURNAL_INDEX_STRIDE + 1 : 0;
+    while (k_lo < k_hi)
+    {
+        k_mid = (k_lo + k_hi) / 2;
+        if (Journal_SectorTime(base + k_mid * JOURNAL_INDEX_STRIDE) >= timestamp)
+        {
+            k_hi = k_mid;
+        }
+        else
+        {
+            k_lo = k_mid + 1;
+        }
+    }
+    if (k_lo > 0)
+    {
+        lo = base + (k_lo - 1) * JOURNAL_INDEX_STRIDE + 1;
+    }
+    if (base + k_lo * JOURNAL_INDEX_STRIDE < count)
+    {
+        hi = base + k_lo * JOURNAL_INDEX_STRIDE;
+    }
+
+    /*索引之间的扇区读取扇区摘要*/
+    while (lo < hi)
+    {
+        mid = (lo + hi) / 2;
+        if (Journal_SectorTime(mid) >= timestamp)
+        {
+            hi = mid;
+        }
+        else
+        {
+            lo = mid + 1;
+        }
+    }
+
+    /*前一个扇区的起始时间早于timestamp，其中的记录槽二分查找*/
+    if (lo == 0)
+    {
+        hi = journal_first_record;
+    }
+    else
+    {
+        hi = journal_first_record + lo * JOURNAL_ENTRIES_PER_SECTOR;
+        if (hi - journal_first_record > journal_next_record - journal_first_record)
+        {
+            hi = journal_next_record;
+        }
+        lo = journal_first_record + (lo - 1) * JOURNAL_ENTRIES_PER_SECTOR;
+        while (lo < hi)
+        {
+            mid = lo + (hi - lo) / 2;
+            journal_search_reads++;
+            if (Journal_ReadEntry(mid, &record) != 0 || record.timestamp >= timestamp)
+            {
+                hi = mid;
+            }
+            else
+            {
+                lo = mid + 1;
+            }
+        }
+    }
+    Kernel_MutexUnlock(&journal_mutex);
+    return hi;
+}
+
+/**
+  * @brief  获取最早保留的记录序号
+  * @param  None
+  * @retval 记录序号
+  */
+uint32_t Journal_GetFirst(void)
+{
+    return journal_first_record;
+}
+
+/**
+  * @brief  获取下一条追加记录的序号
+  * @param  None
+  * @retval 记录序号
+  */
+uint32_t Journal_GetNext(void)
+{
+    return journal_next_record;
+}
+
+/**
+  * @brief  获取已编程完成的记录末尾
+  * @param  None
+  * @retval 记录序号，小于它的记录都已写入Flash，之后的还在页缓冲或操作队列中
+  */
+uint32_t Journal_GetDurable(void)
+{
+    return journal_durable_record;
+}
+
+/**
+  * @brief  设置记录编程完成的钩子
+  * @param  hook: 钩子函数，参数为Journal_GetDurable()的新值，0表示不调用
+  * @retval None
+  * @note   钩子在轮询W25Q64操作队列的线程中运行（持有Flash总线），不能阻塞或访问W25Q64
+  */
+void Journal_SetDurableHook(void (*hook)(uint32_t next))
+{
+    journal_durable_hook = hook;
+}
+
+/**
+  * @brief  擦除日志区，清空全部记录（系统配置保留）
+  * @param  None
+  * @retval None
+  */
+void Journal_Clear(void)
+{
+    uint16_t sector = 0;
+    uint16_t per_block = W25Q64_BLOCK_64KB_SIZE / W25Q64_SECTOR_SIZE;
+
+    Kernel_MutexLock(&journal_mutex);
+
+    /*整块用64KB块擦除，剩余扇区逐个擦除*/
+    while (sector < JOURNAL_SECTOR_COUNT)
+    {
+        if ((JOURNAL_FIRST_SECTOR + sector) % per_block == 0 && sector + per_block <= JOURNAL_SECTOR_COUNT)
+        {
+            W25Q64_EraseBlock64K(JOURNAL_SECTOR_ADDR(sector));
+            sector += per_block;
+        }
+        else
+        {
+            W25Q64_EraseSector(JOURNAL_SECTOR_ADDR(sector));
+            sector++;
+        }
+    }
+    journal_wear_erases += JOURNAL_SECTOR_COUNT;
+
+    /*擦除次数随扇区头一起清除，之后按清除前写入扇区的次数加1估计*/
+    journal_head_wear++;
+    Journal_Init();
+    Kernel_MutexUnlock(&journal_mutex);
+}
+
+/**
+  * @brief  计算百倍比值，用于输出两位小数
+  * @param  part: 分子
+  * @param  whole: 分母
+  * @retval part * 100 / whole，whole为0时返回0
+  */
+static uint32_t Journal_Ratio100(uint32_t part, uint32_t whole)
+{
+    return whole ? (uint32_t)((uint64_t)part * 100 / whole) : 0;
+}
+
+/**
+  * @brief  统计时间索引中起始时间已知的项数
+  * @param  None
+  * @retval 项数
+  */
+static uint16_t Journal_IndexCount(void)
+{
+    uint16_t k, known = 0;
+
+    for (k = 0; k < JOURNAL_INDEX_SIZE; k++)
+    {
+        if (journal_index[k] != JOURNAL_TIME_UNKNOWN)
+        {
+            known++;
+        }
+    }
+    return known;
+}
+
+/**
+  * @brief  通过串口输出日志位置和写入统计
+  * @param  None
+  * @retval None
+  */
+void Journal_ReportStats(void)
+{
+    Serial_Printf("[FLASH] Journal: %u sectors x %u records, records %lu..%lu (%lu kept)\n",
+                  JOURNAL_SECTOR_COUNT, JOURNAL_ENTRIES_PER_SECTOR,
+                  journal_first_record, journal_next_record, journal_next_record - journal_first_record);
+    Serial_Printf("[FLASH] Head: sector %u seq %lu slot %u, tail: sector %u, recovered with %u reads\n",
+                  journal_head_sector, journal_head_seq, journal_head_slot, journal_tail_sector,
+                  journal_recover_reads);
+    Serial_Printf("[FLASH] Appends: %lu, sector erases: %lu\n", journal_append_count, journal_erase_count);
+    Serial_Printf("[FLASH] Page buffer: %lu programs for %lu appends (%lu.%02lu per record), %lu.%02lu SPI bytes per record\n",
+                  journal_program_count, journal_append_count,
+                  Journal_Ratio100(journal_program_count, journal_append_count) / 100,
+                  Journal_Ratio100(journal_program_count, journal_append_count) % 100,
+                  Journal_Ratio100(journal_program_bytes, journal_append_count) / 100,
+                  Journal_Ratio100(journal_program_bytes, journal_append_count) % 100);
+    Serial_Printf("[FLASH] Page flushes: %lu full pages, %lu timer and %lu sync flushes, %lu buffer waits\n",
+                  journal_flush_full, journal_flush_timer, journal_flush_sync, journal_buffer_waits);
+    Serial_Printf("[FLASH] Erase-ahead: %u of %u sectors ready, %lu appends waited on an erase\n",
+                  journal_ahead, journal_ahead_target, journal_erase_waits);
+    Serial_Printf("[FLASH] Sector opens: %lu of %lu pre-erased\n", journal_open_ready, journal_open_count);
+    Serial_Printf("[FLASH] Time index: %u of %u entries (every %u sectors)\n",
+                  Journal_IndexCount(), JOURNAL_INDEX_SIZE, JOURNAL_INDEX_STRIDE);
+    Serial_Printf("[FLASH] Time searches: %lu, %lu.%02lu flash reads per search\n",
+                  journal_search_count,
+                  Journal_Ratio100(journal_search_reads, journal_search_count) / 100,
+                  Journal_Ratio100(journal_search_reads, journal_search_count) % 100);
+}
+
+/**
+  * @brief  读取全部扇区头，通过串口输出擦除次数的最小/最大/平均值和按当前擦除速率估算的寿命
+  * @param  None
+  * @retval None
+  * @note   扇区按物理顺序循环启用，擦除次数由扇区头保存，启用扇区时写入新的计数；
+  *         未写入扇区头的扇区（从未使用或清除后）不计入
+  */
+void Journal_ReportWear(void)
+{
+    Journal_Header_t header;
+    uint32_t erases, min = 0xFFFFFFFF, max = 0;
+    uint32_t uptime = Scheduler_GetTick();
+    uint64_t total = 0;
+    uint16_t sector, ahead, counted = 0;
+
+    for (sector = 0; sector < JOURNAL_SECTOR_COUNT; sector++)
+    {
+        ahead = (sector + JOURNAL_SECTOR_COUNT - journal_head_sector - 1) % JOURNAL_SECTOR_COUNT;
+        if (sector == journal_head_sector && journal_head_seq != 0)
+        {
+            erases = journal_head_wear;
+        }
+        else if (ahead < journal_ahead)
+        {
+            erases = journal_ahead_wear[(journal_ahead_first + ahead) % JOURNAL_ERASE_AHEAD_MAX];
+        }
+        else if (Journal_LoadHeader(sector, &header) == JOURNAL_HEADER_VALID)
+        {
+            erases = header.erase_count;
+        }
+        else
+        {
+            continue;
+        }
+
+        if (erases < min)
+        {
+            min = erases;
+        }
+        if (erases > max)
+        {
+            max = erases;
+        }
+        total += erases;
+        counted++;
+    }
+
+    if (counted == 0)
+    {
+        Serial_Printf("[FLASH] Wear: no sector headers written yet\n");
+        return;
+    }
+    Serial_Printf("[FLASH] Wear: %u of %u sectors with erase counts, min %lu, max %lu, mean %lu.%02lu\n",
+                  counted, JOURNAL_SECTOR_COUNT, min, max,
+                  (uint32_t)(total / counted), (uint32_t)(total * 100 / counted % 100));
+    Serial_Printf("[FLASH] Endurance: %lu erase cycles per sector\n", (uint32_t)JOURNAL_ENDURANCE);
+
+    if (journal_wear_erases == 0 || uptime == 0 || max >= JOURNAL_ENDURANCE)
+    {
+        Serial_Printf("[FLASH] Erase rate: %lu sector erases in %lu s since boot, lifetime not projected\n",
+                      journal_wear_erases, uptime / 1000);
+    }
+    else
+    {
+        /*扇区轮流擦除，剩余寿命 = 磨损最重扇区的剩余次数 x 扇区数 / 每天的擦除次数*/
+        uint64_t per_day = (uint64_t)journal_wear_erases * 86400000UL / uptime;
+        uint64_t days = (uint64_t)(JOURNAL_ENDURANCE - max) * JOURNAL_SECTOR_COUNT * uptime /
+                        ((uint64_t)journal_wear_erases * 86400000UL);
+
+        Serial_Printf("[FLASH] Erase rate: %lu sector erases in %lu s since boot (%lu per day)\n",
+                      journal_wear_erases, uptime / 1000, (uint32_t)per_day);
+        Serial_Printf("[FLASH] Projected lifetime: %lu days (%lu years)\n",
+                      (uint32_t)(days > 0xFFFFFFFF ? 0xFFFFFFFF : days), (uint32_t)(days / 365 > 0xFFFFFFFF ? 0xFFFFFFFF : days / 365));
+    }
+}
+
+/**
+  * @brief  清除写入统计
+  * @param  None
+  * @retval None
+  */
+void Journal_ResetStats(void)
+{
+    journal_append_count = 0;
+    journal_erase_count = 0;
+    journal_open_count = 0;
+    journal_open_ready = 0;
+    journal_erase_waits = 0;
+    journal_program_count = 0;
+    journal_program_bytes = 0;
+    journal_flush_full = 0;
+    journal_flush_timer = 0;
+    journal_flush_sync = 0;
+    journal_buffer_waits = 0;
+    journal_search_count = 0;
+    journal_search_reads = 0;
+}
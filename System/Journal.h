@@ -0,0 +1,248 @@
+#ifndef __JOURNAL_H
+#define __JOURNAL_H
+
+#include "stm32f10x.h"
+#include "W25Q64.h"
+
+/**
+  * W25Q64上的只追加记录日志
+  *
+  * 日志区由连续的扇区组成，按物理顺序循环使用。每个扇区以扇区头开始，之后是
+  * JOURNAL_ENTRIES_PER_SECTOR个16字节的记录槽，最后是扇区摘要：
+  *     扇区头：magic、扇区序号（每启用一个扇区加1）、本扇区第一条记录的序号、
+  *             本扇区的擦除次数、CRC
+  *     记录：  记录序号、DataRecord_t、CRC
+  *     摘要：  第一条和最后一条记录的时间戳、有效记录数、温湿度最小/最大值、
+  *             红外检测到人体的记录数、CRC，和最后一个记录槽在同一页中编程
+  * 记录槽按顺序写入，记录序号 = 扇区第一条记录的序号 + 槽号，16字节对齐不跨页。
+  * 扇区头和记录先写入内存中的256字节页缓冲，写满一页（16条记录）才编程一次；
+  * 未写满的页超过JOURNAL_FLUSH_MS、执行Journal_Sync或电源电压下降（PVD）时写入。
+  * 写满一个扇区后擦除下一个扇区并写入扇区头，日志区写满后覆盖最早的扇区。
+  * 擦除和编程加入W25Q64操作队列后即返回，在后台完成，尚未写入的最近记录从页缓冲读取。
+  * 写入扇区之后的若干扇区在空闲时预先擦除，启用扇区时只需写入扇区头，追加的记录
+  * 不必排在约45ms的扇区擦除之后；日志区已循环时保留的记录相应少几个扇区。
+  * 写入位置不单独保存：上电时二分查找序号最大的扇区头，其中第一个空槽即为写入位置；
+  * 写入扇区之后的扇区（跳过预擦除的扇区和可能写了一半的扇区头）若序号更小，即为最早的扇区。
+  * 恢复只读取约20个扇区头和记录槽（建立时间索引另需读取写入扇区的记录和约64个扇区摘要），
+  * 不需要擦除，历史记录在重启后保留。
+  * 掉电时写了一半的记录CRC不符，读出时报告为无效，其记录序号不再使用。
+  * 上电时读取每JOURNAL_INDEX_STRIDE个扇区的摘要，在内存中保存这些扇区的起始时间；
+  * 按时间查找记录时先在内存索引中二分查找，再读取约log2(JOURNAL_INDEX_STRIDE)个扇区
+  * 摘要和扇区内的记录槽二分查找，假定记录时间戳随序号不减（RTC被调回时结果偏早）。
+  */
+
+/* 日志区：前一半扇区（4MB，约26万条记录），之后为温湿度采样区（Series.h），
+   最后两个扇区保留给配置存储（Config.h）和SPI链路自检页（W25Q64_TEST_ADDR） */
+#define JOURNAL_FIRST_SECTOR        0
+#define JOURNAL_SECTOR_COUNT        (W25Q64_NUM_SECTORS / 2)
+
+#define JOURNAL_MAGIC               0x4C4E524A      /* "JRNL" */
+#define JOURNAL_VERSION             3
+
+/* 写入扇区之后预先擦除的扇区数，可由Journal_SetEraseAhead修改 */
+#define JOURNAL_ERASE_AHEAD         2
+#define JOURNAL_ERASE_AHEAD_MAX     8
+
+/* 页缓冲中未写入的数据最多保留的时间（ms） */
+#define JOURNAL_FLUSH_MS            1000
+
+/* W25Q64每个扇区的擦写寿命（次） */
+#define JOURNAL_ENDURANCE           100000
+
+/* 内存时间索引：每隔多少个扇区保存一个扇区的起始时间 */
+#define JOURNAL_INDEX_STRIDE        32
+#define JOURNAL_INDEX_SIZE          ((JOURNAL_SECTOR_COUNT + JOURNAL_INDEX_STRIDE - 1) / JOURNAL_INDEX_STRIDE)
+
+#define JOURNAL_HEADER_SIZE         32
+#define JOURNAL_ENTRY_SIZE          16
+#define JOURNAL_FOOTER_SIZE         16
+#define JOURNAL_ENTRIES_PER_SECTOR  \
+    ((W25Q64_SECTOR_SIZE - JOURNAL_HEADER_SIZE - JOURNAL_FOOTER_SIZE) / JOURNAL_ENTRY_SIZE)
+
+#pragma pack(1)
+/**
+  * @brief  扇区头
+  */
+typedef struct {
+    uint32_t magic;         /* JOURNAL_MAGIC */
+    uint32_t seq;           /* 扇区序号，从1开始 */
+    uint32_t first_record;  /* 本扇区第一条记录的序号 */
+    uint32_t erase_count;   /* 本扇区的擦除次数，包括启用前的这一次 */
+    uint8_t version;        /* JOURNAL_VERSION */
+    uint8_t reserved[13];
+    uint16_t crc;           /* 以上字段的CRC16 */
+} Journal_Header_t;
+
+/**
+  * @brief  记录槽
+  */
+typedef struct {
+    uint32_t seq;           /* 记录序号 */
+    DataRecord_t record;    /* 记录内容，record.crc为记录字段的CRC16 */
+    uint16_t crc;           /* seq和record的CRC16 */
+} Journal_Entry_t;
+
+/**
+  * @brief  扇区摘要，写满扇区时写在扇区末尾
+  */
+typedef struct {
+    uint32_t first_time;    /* 第一条有效记录的时间戳 */
+    uint32_t last_time;     /* 最后一条有效记录的时间戳 */
+    uint8_t count;          /* 有效记录数 */
+    uint8_t temp_min;       /* 温度最小/最大值（°C） */
+    uint8_t temp_max;
+    uint8_t humi_min;       /* 湿度最小/最大值（%） */
+    uint8_t humi_max;
+    uint8_t motion;         /* 红外检测到人体的记录数 */
+    uint16_t crc;           /* 以上字段的CRC16 */
+} Journal_Footer_t;
+#pragma pack()
+
+/**
+  * @brief  从Flash内容恢复写入位置和最早的记录，在W25Q64_Init之后调用
+  * @param  None
+  * @retval 0: 日志为空或最后一条记录有效，1: 最后一条记录CRC错误（写入时掉电）
+  */
+uint8_t Journal_Init(void);
+
+/**
+  * @brief  追加一条记录
+  * @param  record: 记录，CRC由日志计算
+  * @retval 追加的记录序号
+  */
+uint32_t Journal_Append(const DataRecord_t *record);
+
+/**
+  * @brief  把页缓冲中未写入的数据加入编程，不等待编程完成
+  * @param  None
+  * @retval None
+  */
+void Journal_Sync(void);
+
+/**
+  * @brief  页缓冲中的数据超过JOURNAL_FLUSH_MS未写入时加入编程（bulk线程调用）
+  * @param  None
+  * @retval None
+  */
+void Journal_Poll(void);
+
+/**
+  * @brief  获取到下一次超时写入页缓冲的时间
+  * @param  None
+  * @retval 时间（ms），页缓冲中没有未写入的数据时为KERNEL_WAIT_FOREVER
+  */
+uint32_t Journal_GetFlushDelay(void);
+
+/**
+  * @brief  电源电压下降时立即写入页缓冲，之后每条记录追加后立即编程
+  * @param  enable: 1: 电压低于PVD阈值，0: 电压恢复，重新按页合并写入
+  * @retval None
+  */
+void Journal_SetWriteThrough(uint8_t enable);
+
+/**
+  * @brief  在空闲时预先擦除写入扇区之后的扇区（bulk线程写完记录后调用）
+  * @param  None
+  * @retval None
+  */
+void Journal_Prepare(void);
+
+/**
+  * @brief  设置预擦除的扇区数
+  * @param  count: 扇区数，超过JOURNAL_ERASE_AHEAD_MAX时取最大值
+  * @retval None
+  */
+void Journal_SetEraseAhead(uint8_t count);
+
+/**
+  * @brief  获取预擦除的扇区数
+  * @param  None
+  * @retval 扇区数
+  */
+uint8_t Journal_GetEraseAhead(void);
+
+/**
+  * @brief  按序号读取记录
+  * @param  seq: 记录序号，范围为[Journal_GetFirst(), Journal_GetNext())
+  * @param  record: 用于存放记录的指针
+  * @retval 0: 成功，1: CRC错误或记录无效，2: 序号不在日志中
+  */
+uint8_t Journal_Read(uint32_t seq, DataRecord_t *record);
+
+/**
+  * @brief  按时间查找记录
+  * @param  timestamp: 时间戳（RTC秒数）
+  * @retval 第一条时间戳不早于timestamp的记录序号，没有时为Journal_GetNext()
+  * @note   结果之前的记录都早于timestamp；结果之后可能还有早于timestamp的记录或无效记录，
+  *         由调用者按序读取时跳过
+  */
+uint32_t Journal_FindTime(uint32_t timestamp);
+
+/**
+  * @brief  读取写满的扇区的摘要
+  * @param  seq: 扇区第一条记录的序号
+  * @param  summary: 用于存放摘要的指针
+  * @retval 0: 成功，1: seq不是扇区第一条记录、扇区未写满或摘要尚未写入Flash
+  * @note   摘要只统计有效记录，与逐条Journal_Read跳过无效记录的结果相同
+  */
+uint8_t Journal_ReadSummary(uint32_t seq, Journal_Footer_t *summary);
+
+/**
+  * @brief  获取最早保留的记录序号
+  * @param  None
+  * @retval 记录序号
+  */
+uint32_t Journal_GetFirst(void);
+
+/**
+  * @brief  获取下一条追加记录的序号
+  * @param  None
+  * @retval 记录序号
+  */
+uint32_t Journal_GetNext(void);
+
+/**
+  * @brief  获取已编程完成的记录末尾
+  * @param  None
+  * @retval 记录序号，小于它的记录都已写入Flash，之后的还在页缓冲或操作队列中
+  */
+uint32_t Journal_GetDurable(void);
+
+/**
+  * @brief  设置记录编程完成的钩子
+  * @param  hook: 钩子函数，参数为Journal_GetDurable()的新值，0表示不调用
+  * @retval None
+  * @note   钩子在轮询W25Q64操作队列的线程中运行（持有Flash总线），不能阻塞或访问W25Q64
+  */
+void Journal_SetDurableHook(void (*hook)(uint32_t next));
+
+/**
+  * @brief  擦除日志区，清空全部记录（系统配置保留）
+  * @param  None
+  * @retval None
+  * @note   擦除1024个扇区（64个64KB块），耗时约10秒
+  */
+void Journal_Clear(void);
+
+/**
+  * @brief  通过串口输出日志位置和写入统计
+  * @param  None
+  * @retval None
+  */
+void Journal_ReportStats(void);
+
+/**
+  * @brief  读取全部扇区头，通过串口输出擦除次数统计和估算寿命
+  * @param  None
+  * @retval None
+  */
+void Journal_ReportWear(void);
+
+/**
+  * @brief  清除写入统计
+  * @param  None
+  * @retval None
+  */
+void Journal_ResetStats(void);
+
+#endif /* __JOURNAL_H */
@@ -0,0 +1,631 @@
+#include "Kernel.h"
+#include "Scheduler.h"
+#include "Serial.h"
+#include "Delay.h"
+#include "Trace.h"
+
+/* 临界区，保存并恢复PRIMASK，允许嵌套 */
+#define KERNEL_ENTER_CRITICAL() uint32_t primask = __get_PRIMASK(); __disable_irq()
+#define KERNEL_EXIT_CRITICAL()  __set_PRIMASK(primask)
+
+/* 线程表 */
+static Kernel_Thread_t *kernel_threads[KERNEL_MAX_THREADS];
+static uint8_t kernel_thread_count = 0;
+static uint8_t kernel_current_index = 0;
+static volatile uint8_t kernel_running = 0;
+static uint8_t kernel_sched_lock = 0;       /* 调度锁嵌套计数，非0时不切换线程 */
+static uint8_t kernel_sched_pending = 0;    /* 锁定期间有线程需要抢占，解锁时补做调度 */
+
+/* 当前运行线程，PendSV汇编直接访问 */
+Kernel_Thread_t *volatile Kernel_Current = 0;
+
+/* 上下文切换开销统计，PendSV入口和出口分别记录周期计数 */
+volatile uint32_t Kernel_SwitchBegin = 0;
+volatile uint32_t Kernel_SwitchEnd = 0;
+static uint8_t kernel_switch_valid = 0;
+static uint32_t kernel_switch_count = 0;
+static uint32_t kernel_switch_min = 0xFFFFFFFF;
+static uint32_t kernel_switch_max = 0;
+static uint32_t kernel_switch_total = 0;
+
+/* 空闲线程，空闲钩子（低功耗处理）在此栈上运行 */
+static Kernel_Thread_t kernel_idle_thread;
+static uint32_t kernel_idle_stack[128];
+static void (*volatile kernel_idle_hook)(void) = 0;
+
+/**
+  * @brief  空闲线程，无事可做时调用空闲钩子，未设置钩子时休眠等待中断
+  * @param  None
+  * @retval None
+  */
+static void Kernel_IdleThread(void)
+{
+    while (1)
+    {
+        if (kernel_idle_hook)
+        {
+            kernel_idle_hook();
+        }
+        else
+        {
+            __WFI();
+        }
+    }
+}
+
+/**
+  * @brief  线程函数返回后进入此函数，线程转为休眠态
+  * @param  None
+  * @retval None
+  */
+static void Kernel_ThreadExit(void)
+{
+    KERNEL_ENTER_CRITICAL();
+    Kernel_Current->state = KERNEL_STATE_DORMANT;
+    SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+    KERNEL_EXIT_CRITICAL();
+
+    while (1);
+}
+
+/**
+  * @brief  查找等待指定对象的最高优先级线程
+  * @param  obj: 信号量或互斥锁
+  * @retval 线程指针，无等待线程时返回0
+  */
+static Kernel_Thread_t *Kernel_FindWaiter(void *obj)
+{
+    Kernel_Thread_t *waiter = 0;
+    uint8_t i;
+
+    for (i = 0; i < kernel_thread_count; i++)
+    {
+        Kernel_Thread_t *t = kernel_threads[i];
+        if (t->state == KERNEL_STATE_BLOCKED && t->wait_obj == obj &&
+            (waiter == 0 || t->priority > waiter->priority))
+        {
+            waiter = t;
+        }
+    }
+    return waiter;
+}
+
+/**
+  * @brief  使等待中的线程就绪
+  * @param  thread: 线程
+  * @param  result: 等待结果，0: 获得资源，1: 超时
+  * @retval None
+  */
+static void Kernel_MakeReady(Kernel_Thread_t *thread, uint8_t result)
+{
+    thread->state = KERNEL_STATE_READY;
+    thread->wait_result = result;
+    thread->wait_obj = 0;
+    thread->timed = 0;
+}
+
+/**
+  * @brief  如有更高优先级的就绪线程或当前线程不再就绪，则挂起PendSV进行切换
+  * @param  None
+  * @retval None
+  * @note   调用者需处于临界区
+  */
+static void Kernel_Schedule(void)
+{
+    uint8_t i;
+
+    if (!kernel_running)
+    {
+        return;
+    }
+
+    if (Kernel_Current->state != KERNEL_STATE_READY)
+    {
+        SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+        return;
+    }
+
+    for (i = 0; i < kernel_thread_count; i++)
+    {
+        if (kernel_threads[i]->state == KERNEL_STATE_READY &&
+            kernel_threads[i]->priority > Kernel_Current->priority)
+        {
+            if (kernel_sched_lock)
+            {
+                kernel_sched_pending = 1;
+                return;
+            }
+            SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+            return;
+        }
+    }
+}
+
+/**
+  * @brief  内核初始化，创建空闲线程
+  * @param  None
+  * @retval None
+  */
+void Kernel_Init(void)
+{
+    kernel_thread_count = 0;
+    kernel_running = 0;
+
+    /* 上下文切换开销由DWT周期计数器测量 */
+    if (!(DWT_CTRL & DWT_CTRL_CYCCNTENA))
+    {
+        Delay_Init();
+    }
+
+    Kernel_CreateThread(&kernel_idle_thread, "idle", Kernel_IdleThread,
+                        kernel_idle_stack, sizeof(kernel_idle_stack) / 4, KERNEL_PRIO_IDLE);
+}
+
+/**
+  * @brief  设置空闲钩子，空闲线程每次循环调用一次
+  * @param  hook: 钩子函数，0表示恢复为直接WFI
+  * @retval None
+  * @note   钩子在空闲线程中运行，不能阻塞
+  */
+void Kernel_SetIdleHook(void (*hook)(void))
+{
+    kernel_idle_hook = hook;
+}
+
+/**
+  * @brief  查询最早的线程定时唤醒时刻（延时到期或等待超时）
+  * @param  tick: 输出最早的唤醒时刻（ms）
+  * @retval 1: 有定时等待的线程，0: 没有
+  * @note   应在关中断时调用，结果在开中断前有效
+  */
+uint8_t Kernel_GetNextWake(uint32_t *tick)
+{
+    uint32_t now = Scheduler_GetTick();
+    uint8_t found = 0;
+    uint8_t i;
+
+    for (i = 0; i < kernel_thread_count; i++)
+    {
+        Kernel_Thread_t *t = kernel_threads[i];
+        if (t->state != KERNEL_STATE_READY && t->timed &&
+            (!found || (int32_t)(t->wake_tick - *tick) < 0))
+        {
+            *tick = t->wake_tick;
+            found = 1;
+        }
+    }
+
+    /* 已经到期的按当前时刻返回 */
+    if (found && (int32_t)(*tick - now) < 0)
+    {
+        *tick = now;
+    }
+    return found;
+}
+
+/**
+  * @brief  创建线程
+  * @param  thread: 线程控制块
+  * @param  name: 线程名称
+  * @param  entry: 线程函数
+  * @param  stack: 静态栈数组
+  * @param  stack_words: 栈大小（字）
+  * @param  priority: 优先级
+  * @retval 0: 成功，1: 线程表已满
+  */
+uint8_t Kernel_CreateThread(Kernel_Thread_t *thread, const char *name, void (*entry)(void),
+                            uint32_t *stack, uint32_t stack_words, uint8_t priority)
+{
+    uint32_t i;
+
+    if (kernel_thread_count >= KERNEL_MAX_THREADS)
+    {
+        return 1;
+    }
+
+    /* 填充栈，用于统计高水位 */
+    for (i = 0; i < stack_words; i++)
+    {
+        stack[i] = KERNEL_STACK_FILL;
+    }
+
+    thread->stack = stack;
+    thread->stack_words = stack_words;
+    thread->sp = Kernel_PortInitStack(stack + stack_words, entry, Kernel_ThreadExit);
+    thread->name = name;
+    thread->priority = priority;
+    thread->base_priority = priority;
+    thread->state = KERNEL_STATE_READY;
+    thread->wait_result = 0;
+    thread->timed = 0;
+    thread->mutex_count = 0;
+    thread->wait_obj = 0;
+    thread->wake_tick = 0;
+    thread->switch_count = 0;
+
+    kernel_threads[kernel_thread_count++] = thread;
+    return 0;
+}
+
+/**
+  * @brief  启动内核，切换到最高优先级线程，不再返回
+  * @param  None
+  * @retval None
+  */
+void Kernel_Start(void)
+{
+    /* PendSV设为最低优先级，保证只在所有中断处理完后才切换上下文 */
+    NVIC_SetPriority(PendSV_IRQn, 0xFF);
+
+    kernel_current_index = 0;
+    Kernel_Current = kernel_threads[0];
+    kernel_running = 1;
+
+    Kernel_PortStart();
+}
+
+/**
+  * @brief  查询当前是否在线程上下文中运行（内核已启动且不在中断中）
+  * @param  None
+  * @retval 1: 是，0: 否
+  */
+uint8_t Kernel_InThread(void)
+{
+    return kernel_running && (SCB->ICSR & SCB_ICSR_VECTACTIVE_Msk) == 0;
+}
+
+/**
+  * @brief  当前线程延时
+  * @param  ms: 延时时长（ms）
+  * @retval None
+  */
+void Kernel_Sleep(uint32_t ms)
+{
+    Kernel_SleepUntil(Scheduler_GetTick() + ms);
+}
+
+/**
+  * @brief  当前线程延时到指定时刻
+  * @param  tick: 唤醒时刻（ms），已过去则立即返回
+  * @retval None
+  */
+void Kernel_SleepUntil(uint32_t tick)
+{
+    KERNEL_ENTER_CRITICAL();
+    if ((int32_t)(tick - Scheduler_GetTick()) > 0)
+    {
+        Kernel_Current->state = KERNEL_STATE_SLEEPING;
+        Kernel_Current->wake_tick = tick;
+        Kernel_Current->timed = 1;
+        Kernel_Schedule();
+    }
+    KERNEL_EXIT_CRITICAL();
+}
+
+/**
+  * @brief  锁定调度器，当前线程不会被其他线程抢占，中断照常响应
+  * @param  None
+  * @retval None
+  * @note   可嵌套，须与Kernel_SchedUnlock成对调用；锁定期间不能阻塞或延时
+  */
+void Kernel_SchedLock(void)
+{
+    KERNEL_ENTER_CRITICAL();
+    kernel_sched_lock++;
+    KERNEL_EXIT_CRITICAL();
+}
+
+/**
+  * @brief  解锁调度器，最外层解锁时补做锁定期间被推迟的抢占
+  * @param  None
+  * @retval None
+  */
+void Kernel_SchedUnlock(void)
+{
+    KERNEL_ENTER_CRITICAL();
+    if (kernel_sched_lock > 0 && --kernel_sched_lock == 0 && kernel_sched_pending)
+    {
+        kernel_sched_pending = 0;
+        Kernel_Schedule();
+    }
+    KERNEL_EXIT_CRITICAL();
+}
+
+/**
+  * @brief  初始化信号量
+  * @param  sem: 信号量
+  * @param  count: 初始计数
+  * @retval None
+  */
+void Kernel_SemInit(Kernel_Sem_t *sem, uint16_t count)
+{
+    sem->count = count;
+}
+
+/**
+  * @brief  等待信号量
+  * @param  sem: 信号量
+  * @param  timeout: 超时（ms），KERNEL_WAIT_FOREVER表示永久等待
+  * @retval 0: 获得信号量，1: 超时
+  * @note   不能在中断或临界区中调用
+  */
+uint8_t Kernel_SemWait(Kernel_Sem_t *sem, uint32_t timeout)
+{
+    KERNEL_ENTER_CRITICAL();
+    if (sem->count > 0)
+    {
+        sem->count--;
+        KERNEL_EXIT_CRITICAL();
+        return 0;
+    }
+    if (timeout == 0)
+    {
+        KERNEL_EXIT_CRITICAL();
+        return 1;
+    }
+
+    Kernel_Current->state = KERNEL_STATE_BLOCKED;
+    Kernel_Current->wait_obj = sem;
+    Kernel_Current->timed = (timeout != KERNEL_WAIT_FOREVER);
+    Kernel_Current->wake_tick = Scheduler_GetTick() + timeout;
+    Kernel_Schedule();
+    KERNEL_EXIT_CRITICAL();
+
+    /* 退出临界区后PendSV立即切走，被唤醒后从这里继续 */
+    return Kernel_Current->wait_result;
+}
+
+/**
+  * @brief  释放信号量，可在中断中调用
+  * @param  sem: 信号量
+  * @retval None
+  */
+void Kernel_SemPost(Kernel_Sem_t *sem)
+{
+    Kernel_Thread_t *waiter;
+
+    KERNEL_ENTER_CRITICAL();
+    waiter = Kernel_FindWaiter(sem);
+    if (waiter)
+    {
+        Kernel_MakeReady(waiter, 0);
+    }
+    else if (sem->count < 0xFFFF)
+    {
+        sem->count++;
+    }
+    Kernel_Schedule();
+    KERNEL_EXIT_CRITICAL();
+}
+
+/**
+  * @brief  获取互斥锁，内核未启动时直接返回
+  * @param  mutex: 互斥锁
+  * @retval None
+  * @note   持有者优先级低于等待者时临时提升到等待者的优先级；
+  *         嵌套持有多个互斥锁时须按固定顺序获取，提升的优先级保持到全部释放
+  */
+void Kernel_MutexLock(Kernel_Mutex_t *mutex)
+{
+    if (!Kernel_InThread())
+    {
+        return;
+    }
+
+    KERNEL_ENTER_CRITICAL();
+    if (mutex->owner == 0)
+    {
+        mutex->owner = Kernel_Current;
+        Kernel_Current->mutex_count++;
+        KERNEL_EXIT_CRITICAL();
+        return;
+    }
+
+    /* 优先级继承 */
+    if (mutex->owner->priority < Kernel_Current->priority)
+    {
+        mutex->owner->priority = Kernel_Current->priority;
+    }
+
+    Kernel_Current->state = KERNEL_STATE_BLOCKED;
+    Kernel_Current->wait_obj = mutex;
+    Kernel_Current->timed = 0;
+    Kernel_Schedule();
+    KERNEL_EXIT_CRITICAL();
+
+    /* 被唤醒时互斥锁已由释放者移交给本线程 */
+}
+
+/**
+  * @brief  尝试获取互斥锁，不等待，内核未启动时直接返回0
+  * @param  mutex: 互斥锁
+  * @retval 0: 获得互斥锁，1: 已被其他线程持有
+  */
+uint8_t Kernel_MutexTryLock(Kernel_Mutex_t *mutex)
+{
+    uint8_t busy = 1;
+
+    if (!Kernel_InThread())
+    {
+        return 0;
+    }
+
+    KERNEL_ENTER_CRITICAL();
+    if (mutex->owner == 0)
+    {
+        mutex->owner = Kernel_Current;
+        Kernel_Current->mutex_count++;
+        busy = 0;
+    }
+    KERNEL_EXIT_CRITICAL();
+    return busy;
+}
+
+/**
+  * @brief  释放互斥锁，内核未启动时直接返回
+  * @param  mutex: 互斥锁
+  * @retval None
+  */
+void Kernel_MutexUnlock(Kernel_Mutex_t *mutex)
+{
+    Kernel_Thread_t *waiter;
+
+    if (!Kernel_InThread() || mutex->owner != Kernel_Current)
+    {
+        return;
+    }
+
+    KERNEL_ENTER_CRITICAL();
+    if (--Kernel_Current->mutex_count == 0)
+    {
+        Kernel_Current->priority = Kernel_Current->base_priority;
+    }
+    waiter = Kernel_FindWaiter(mutex);
+    mutex->owner = waiter;
+    if (waiter)
+    {
+        waiter->mutex_count++;
+        Kernel_MakeReady(waiter, 0);
+    }
+    Kernel_Schedule();
+    KERNEL_EXIT_CRITICAL();
+}
+
+/**
+  * @brief  时基处理，在SysTick中断中调用
+  * @param  None
+  * @retval None
+  */
+void Kernel_Tick(void)
+{
+    uint32_t now = Scheduler_GetTick();
+    uint8_t i;
+
+    if (!kernel_running)
+    {
+        return;
+    }
+
+    for (i = 0; i < kernel_thread_count; i++)
+    {
+        Kernel_Thread_t *t = kernel_threads[i];
+        if (t->timed && (int32_t)(now - t->wake_tick) >= 0)
+        {
+            /* 延时到期或等待超时 */
+            Kernel_MakeReady(t, t->state == KERNEL_STATE_BLOCKED);
+        }
+    }
+    Kernel_Schedule();
+}
+
+/**
+  * @brief  获取线程名称
+  * @param  index: 线程号，按创建顺序，0为空闲线程
+  * @retval 线程名称，线程号无效时返回0
+  */
+const char *Kernel_GetThreadName(uint8_t index)
+{
+    return (index < kernel_thread_count) ? kernel_threads[index]->name : 0;
+}
+
+/**
+  * @brief  选择下一个运行的线程，由PendSV调用
+  * @param  None
+  * @retval None
+  * @note   选择最高优先级的就绪线程，同优先级从当前线程之后轮转
+  */
+void Kernel_SelectNext(void)
+{
+    Kernel_Thread_t *next = 0;
+    uint8_t next_index = 0;
+    uint8_t i;
+
+    /* 统计上一次切换的开销（PendSV入口到出口的周期数） */
+    if (kernel_switch_valid)
+    {
+        uint32_t cycles = Kernel_SwitchEnd - Kernel_SwitchBegin;
+        kernel_switch_count++;
+        kernel_switch_total += cycles;
+        if (cycles < kernel_switch_min) kernel_switch_min = cycles;
+        if (cycles > kernel_switch_max) kernel_switch_max = cycles;
+    }
+    kernel_switch_valid = 1;
+
+    for (i = 1; i <= kernel_thread_count; i++)
+    {
+        uint8_t index = (kernel_current_index + i) % kernel_thread_count;
+        Kernel_Thread_t *t = kernel_threads[index];
+        if (t->state == KERNEL_STATE_READY && (next == 0 || t->priority > next->priority))
+        {
+            next = t;
+            next_index = index;
+        }
+    }
+
+    if (next != Kernel_Current)
+    {
+        next->switch_count++;
+        TRACE(TRACE_EV_THREAD_SWITCH, next_index);
+    }
+    Kernel_Current = next;
+    kernel_current_index = next_index;
+}
+
+/**
+  * @brief  统计线程栈使用高水位
+  * @param  thread: 线程
+  * @retval 已使用的栈字节数
+  */
+static uint32_t Kernel_StackUsed(Kernel_Thread_t *thread)
+{
+    uint32_t i = 0;
+
+    while (i < thread->stack_words && thread->stack[i] == KERNEL_STACK_FILL)
+    {
+        i++;
+    }
+    return (thread->stack_words - i) * 4;
+}
+
+/**
+  * @brief  获取线程栈使用高水位
+  * @param  index: 线程号，按创建顺序，0为空闲线程
+  * @param  used: 已使用的栈字节数
+  * @param  size: 栈大小（字节）
+  * @retval 1: 成功，0: 线程号无效
+  */
+uint8_t Kernel_GetStackUsage(uint8_t index, uint32_t *used, uint32_t *size)
+{
+    if (index >= kernel_thread_count)
+    {
+        return 0;
+    }
+    *used = Kernel_StackUsed(kernel_threads[index]);
+    *size = kernel_threads[index]->stack_words * 4;
+    return 1;
+}
+
+/**
+  * @brief  通过串口输出线程状态、栈使用高水位和上下文切换开销
+  * @param  None
+  * @retval None
+  */
+void Kernel_ReportStats(void)
+{
+    static const char *state_names[] = {"READY", "SLEEP", "BLOCK", "DORMANT"};
+    uint8_t i;
+
+    Serial_Printf("[THREADS] Name | Prio | State | Switches | Stack used/size\n");
+    for (i = 0; i < kernel_thread_count; i++)
+    {
+        Kernel_Thread_t *t = kernel_threads[i];
+        Serial_Printf("[THREADS] %s | %d | %s | %lu | %lu/%lu\n",
+                      t->name, t->priority, state_names[t->state], t->switch_count,
+                      Kernel_StackUsed(t), t->stack_words * 4);
+    }
+    Serial_Printf("[THREADS] Context switch: %lu, cycles min/avg/max: %lu/%lu/%lu\n",
+                  kernel_switch_count,
+                  kernel_switch_count ? kernel_switch_min : 0,
+                  kernel_switch_count ? kernel_switch_total / kernel_switch_count : 0,
+                  kernel_switch_max);
+}
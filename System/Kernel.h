@@ -0,0 +1,234 @@
+#ifndef __KERNEL_H
+#define __KERNEL_H
+
+#include "stm32f10x.h"
+
+/* 最大线程数（含空闲线程） */
+#define KERNEL_MAX_THREADS      5
+
+/* 线程优先级，数值越大优先级越高，0保留给空闲线程 */
+#define KERNEL_PRIO_IDLE        0
+#define KERNEL_PRIO_LOW         1
+#define KERNEL_PRIO_MID         2
+#define KERNEL_PRIO_HIGH        3
+
+/* 永久等待 */
+#define KERNEL_WAIT_FOREVER     0xFFFFFFFF
+
+/* 栈填充值，用于统计栈使用高水位 */
+#define KERNEL_STACK_FILL       0xDEADBEEF
+
+/**
+  * @brief  线程状态
+  */
+typedef enum {
+    KERNEL_STATE_READY = 0,     /* 就绪或运行 */
+    KERNEL_STATE_SLEEPING,      /* 延时等待 */
+    KERNEL_STATE_BLOCKED,       /* 等待信号量或互斥锁 */
+    KERNEL_STATE_DORMANT        /* 线程函数已返回 */
+} Kernel_State_t;
+
+/**
+  * @brief  线程控制块
+  * @note   sp必须是第一个成员，PendSV汇编直接按偏移0存取
+  */
+typedef struct {
+    uint32_t *sp;               /* 保存的进程栈指针 */
+    uint32_t *stack;            /* 栈底（低地址） */
+    uint32_t stack_words;       /* 栈大小（字） */
+    const char *name;           /* 线程名称 */
+    uint8_t priority;           /* 当前优先级（可能因优先级继承而提升） */
+    uint8_t base_priority;      /* 创建时指定的优先级 */
+    uint8_t state;              /* 线程状态，见Kernel_State_t */
+    uint8_t wait_result;        /* 等待结果，0: 获得资源，1: 超时 */
+    uint8_t timed;              /* 1: wake_tick有效，到时自动唤醒 */
+    uint8_t mutex_count;        /* 持有的互斥锁数，全部释放后才恢复base_priority */
+    void *wait_obj;             /* 正在等待的信号量或互斥锁 */
+    uint32_t wake_tick;         /* 唤醒时刻（ms） */
+    uint32_t switch_count;      /* 被切换运行的次数 */
+} Kernel_Thread_t;
+
+/**
+  * @brief  计数信号量，可在中断中释放
+  */
+typedef struct {
+    volatile uint16_t count;
+} Kernel_Sem_t;
+
+/**
+  * @brief  互斥锁，带优先级继承
+  */
+typedef struct {
+    Kernel_Thread_t *volatile owner;
+} Kernel_Mutex_t;
+
+/**
+  * @brief  内核初始化，创建空闲线程
+  * @param  None
+  * @retval None
+  */
+void Kernel_Init(void);
+
+/**
+  * @brief  设置空闲钩子，空闲线程每次循环调用一次
+  * @param  hook: 钩子函数，0表示恢复为直接WFI
+  * @retval None
+  * @note   钩子在空闲线程中运行，不能阻塞
+  */
+void Kernel_SetIdleHook(void (*hook)(void));
+
+/**
+  * @brief  查询最早的线程定时唤醒时刻（延时到期或等待超时）
+  * @param  tick: 输出最早的唤醒时刻（ms）
+  * @retval 1: 有定时等待的线程，0: 没有
+  * @note   应在关中断时调用，结果在开中断前有效
+  */
+uint8_t Kernel_GetNextWake(uint32_t *tick);
+
+/**
+  * @brief  创建线程
+  * @param  thread: 线程控制块
+  * @param  name: 线程名称
+  * @param  entry: 线程函数
+  * @param  stack: 静态栈数组
+  * @param  stack_words: 栈大小（字）
+  * @param  priority: 优先级
+  * @retval 0: 成功，1: 线程表已满
+  */
+uint8_t Kernel_CreateThread(Kernel_Thread_t *thread, const char *name, void (*entry)(void),
+                            uint32_t *stack, uint32_t stack_words, uint8_t priority);
+
+/**
+  * @brief  启动内核，切换到最高优先级线程，不再返回
+  * @param  None
+  * @retval None
+  */
+void Kernel_Start(void);
+
+/**
+  * @brief  查询当前是否在线程上下文中运行（内核已启动且不在中断中）
+  * @param  None
+  * @retval 1: 是，0: 否
+  */
+uint8_t Kernel_InThread(void);
+
+/**
+  * @brief  当前线程延时
+  * @param  ms: 延时时长（ms）
+  * @retval None
+  */
+void Kernel_Sleep(uint32_t ms);
+
+/**
+  * @brief  当前线程延时到指定时刻
+  * @param  tick: 唤醒时刻（ms），已过去则立即返回
+  * @retval None
+  */
+void Kernel_SleepUntil(uint32_t tick);
+
+/**
+  * @brief  锁定调度器，当前线程不会被其他线程抢占，中断照常响应
+  * @param  None
+  * @retval None
+  * @note   可嵌套，须与Kernel_SchedUnlock成对调用；锁定期间不能阻塞或延时
+  */
+void Kernel_SchedLock(void);
+
+/**
+  * @brief  解锁调度器，最外层解锁时补做锁定期间被推迟的抢占
+  * @param  None
+  * @retval None
+  */
+void Kernel_SchedUnlock(void);
+
+/**
+  * @brief  初始化信号量
+  * @param  sem: 信号量
+  * @param  count: 初始计数
+  * @retval None
+  */
+void Kernel_SemInit(Kernel_Sem_t *sem, uint16_t count);
+
+/**
+  * @brief  等待信号量
+  * @param  sem: 信号量
+  * @param  timeout: 超时（ms），KERNEL_WAIT_FOREVER表示永久等待
+  * @retval 0: 获得信号量，1: 超时
+  */
+uint8_t Kernel_SemWait(Kernel_Sem_t *sem, uint32_t timeout);
+
+/**
+  * @brief  释放信号量，可在中断中调用
+  * @param  sem: 信号量
+  * @retval None
+  */
+void Kernel_SemPost(Kernel_Sem_t *sem);
+
+/**
+  * @brief  获取互斥锁，内核未启动时直接返回
+  * @param  mutex: 互斥锁
+  * @retval None
+  */
+void Kernel_MutexLock(Kernel_Mutex_t *mutex);
+
+/**
+  * @brief  尝试获取互斥锁，不等待，内核未启动时直接返回0
+  * @param  mutex: 互斥锁
+  * @retval 0: 获得互斥锁，1: 已被其他线程持有
+  */
+uint8_t Kernel_MutexTryLock(Kernel_Mutex_t *mutex);
+
+/**
+  * @brief  释放互斥锁，内核未启动时直接返回
+  * @param  mutex: 互斥锁
+  * @retval None
+  */
+void Kernel_MutexUnlock(Kernel_Mutex_t *mutex);
+
+/**
+  * @brief  时基处理，在SysTick中断中调用
+  * @param  None
+  * @retval None
+  */
+void Kernel_Tick(void);
+
+/**
+  * @brief  通过串口输出线程状态、栈使用高水位和上下文切换开销
+  * @param  None
+  * @retval None
+  */
+void Kernel_ReportStats(void);
+
+/**
+  * @brief  获取线程名称
+  * @param  index: 线程号，按创建顺序，0为空闲线程
+  * @retval 线程名称，线程号无效时返回0
+  */
+const char *Kernel_GetThreadName(uint8_t index);
+
+/**
+  * @brief  获取线程栈使用高水位
+  * @param  index: 线程号，按创建顺序，0为空闲线程
+  * @param  used: 已使用的栈字节数
+  * @param  size: 栈大小（字节）
+  * @retval 1: 成功，0: 线程号无效
+  */
+uint8_t Kernel_GetStackUsage(uint8_t index, uint32_t *used, uint32_t *size);
+
+/**
+  * @brief  选择下一个运行的线程，由PendSV调用
+  * @param  None
+  * @retval None
+  */
+void Kernel_SelectNext(void);
+
+/* 移植层接口，由KernelPort.c实现 */
+uint32_t *Kernel_PortInitStack(uint32_t *stack_top, void (*entry)(void), void (*exit)(void));
+void Kernel_PortStart(void);
+
+/* 供PendSV汇编访问的全局变量 */
+extern Kernel_Thread_t *volatile Kernel_Current;
+extern volatile uint32_t Kernel_SwitchBegin;
+extern volatile uint32_t Kernel_SwitchEnd;
+
+#endif /* __KERNEL_H */
@@ -0,0 +1,99 @@
+#include "Kernel.h"
+
+/**
+  * @brief  初始化线程栈，构造一个异常返回帧，首次切换到该线程时从entry开始运行
+  * @param  stack_top: 栈顶（高地址，栈数组末尾的下一个字）
+  * @param  entry: 线程函数
+  * @param  exit: 线程函数返回后进入的函数
+  * @retval 初始栈指针
+  */
+uint32_t *Kernel_PortInitStack(uint32_t *stack_top, void (*entry)(void), void (*exit)(void))
+{
+    uint32_t *sp = (uint32_t *)((uint32_t)stack_top & ~0x07UL); /* AAPCS要求8字节对齐 */
+    uint8_t i;
+
+    /* 硬件自动出栈部分：xPSR, PC, LR, R12, R3, R2, R1, R0 */
+    *(--sp) = 0x01000000;                       /* xPSR，Thumb位 */
+    *(--sp) = (uint32_t)entry & ~0x01UL;        /* PC */
+    *(--sp) = (uint32_t)exit;                   /* LR */
+    for (i = 0; i < 5; i++)
+    {
+        *(--sp) = 0;                            /* R12, R3, R2, R1, R0 */
+    }
+
+    /* 软件保存部分：R11~R4 */
+    for (i = 0; i < 8; i++)
+    {
+        *(--sp) = 0;
+    }
+
+    return sp;
+}
+
+/**
+  * @brief  启动第一个线程
+  * @param  None
+  * @retval None
+  * @note   PSP清零作为标记，PendSV据此跳过对当前（main）上下文的保存
+  */
+void Kernel_PortStart(void)
+{
+    __set_PSP(0);
+    SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+    __enable_irq();
+    __DSB();
+    __ISB();
+
+    /* PendSV会立即切换到线程，不会执行到这里 */
+    while (1);
+}
+
+/**
+  * @brief  PendSV中断函数，完成上下文切换
+  * @param  None
+  * @retval None
+  * @note   入口和出口分别把DWT_CYCCNT记录到Kernel_SwitchBegin/Kernel_SwitchEnd，
+  *         由Kernel_SelectNext统计切换开销
+  */
+__asm void PendSV_Handler(void)
+{
+    IMPORT  Kernel_Current
+    IMPORT  Kernel_SelectNext
+    IMPORT  Kernel_SwitchBegin
+    IMPORT  Kernel_SwitchEnd
+    PRESERVE8
+
+    CPSID   I
+    LDR     r2, =0xE0001004             ; DWT_CYCCNT
+    LDR     r3, [r2]
+    LDR     r1, =Kernel_SwitchBegin
+    STR     r3, [r1]
+
+    MRS     r0, PSP
+    CBZ     r0, PendSV_NoSave           ; 首次切换，没有需要保存的线程上下文
+    STMDB   r0!, {r4-r11}               ; 保存R4~R11到线程栈
+    LDR     r1, =Kernel_Current
+    LDR     r1, [r1]
+    STR     r0, [r1]                    ; Kernel_Current->sp = r0
+
+PendSV_NoSave
+    PUSH    {r3, lr}
+    BL      Kernel_SelectNext           ; 更新Kernel_Current
+    POP     {r3, lr}
+
+    LDR     r1, =Kernel_Current
+    LDR     r1, [r1]
+    LDR     r0, [r1]                    ; r0 = Kernel_Current->sp
+    LDMIA   r0!, {r4-r11}               ; 恢复R4~R11
+    MSR     PSP, r0
+    ORR     lr, lr, #0x04               ; 返回线程模式并使用PSP
+
+    LDR     r2, =0xE0001004
+    LDR     r3, [r2]
+    LDR     r1, =Kernel_SwitchEnd
+    STR     r3, [r1]
+
+    CPSIE   I
+    BX      lr
+    ALIGN
+}
@@ -0,0 +1,265 @@
+#include "Latency.h"
+#include "Delay.h"
+#include "Serial.h"
+
+/* 临界区，保存并恢复PRIMASK，允许嵌套 */
+#define LATENCY_ENTER_CRITICAL()    uint32_t primask = __get_PRIMASK(); __disable_irq()
+#define LATENCY_EXIT_CRITICAL()     __set_PRIMASK(primask)
+
+/**
+  * @brief  单个阶段的统计
+  */
+typedef struct {
+    uint32_t count;                             /* 记录次数 */
+    uint32_t max;                               /* 最大延迟（us） */
+    uint16_t hist[LATENCY_HIST_BUCKETS];        /* 延迟直方图，饱和计数 */
+} Latency_Stats_t;
+
+static const char * const latency_stage_names[LATENCY_STAGE_COUNT] = {
+    "IR->observe", "IR->buzzer", "IR->uart", "IR->record", "IR->index"
+};
+
+static Latency_Stats_t latency_stats[LATENCY_STAGE_COUNT];
+
+/* 当前跟踪 */
+static volatile uint64_t latency_edge = 0;      /* 边沿时刻（周期数） */
+static volatile uint8_t latency_open = 0;       /* 1: 跟踪进行中 */
+static volatile uint8_t latency_marked = 0;     /* 已到达阶段的位图 */
+
+/* 跟踪计数 */
+static volatile uint32_t latency_trace_count = 0;
+static volatile uint32_t latency_incomplete_count = 0;
+static volatile uint32_t latency_ignored_count = 0;
+
+/**
+  * @brief  计算延迟所在的直方图桶
+  * @param  us: 延迟（us）
+  * @retval 桶号
+  */
+static uint8_t Latency_Bucket(uint32_t us)
+{
+    uint32_t v = us;
+    uint8_t log2 = 0;
+    uint32_t index;
+
+    if (us < 4)
+    {
+        return us;
+    }
+
+    if (v >= 0x10000) { v >>= 16; log2 += 16; }
+    if (v >= 0x100)   { v >>= 8;  log2 += 8; }
+    if (v >= 0x10)    { v >>= 4;  log2 += 4; }
+    if (v >= 0x4)     { v >>= 2;  log2 += 2; }
+    if (v >= 0x2)     { log2 += 1; }
+
+    /* 2^log2起的2倍区间分为4档，取最高位之后的两位 */
+    index = 4 * (log2 - 1) + ((us >> (log2 - 2)) & 3);
+    return (index < LATENCY_HIST_BUCKETS) ? index : LATENCY_HIST_BUCKETS - 1;
+}
+
+/**
+  * @brief  计算直方图桶的上限
+  * @param  bucket: 桶号
+  * @retval 桶内最大延迟（us）
+  */
+static uint32_t Latency_BucketUpper(uint8_t bucket)
+{
+    uint8_t shift;
+
+    if (bucket < 4)
+    {
+        return bucket;
+    }
+    shift = bucket / 4 - 1;
+    return ((uint32_t)(4 + bucket % 4) << shift) + (1UL << shift) - 1;
+}
+
+/**
+  * @brief  结束当前跟踪，调用前应关闭中断
+  * @param  None
+  * @retval None
+  */
+static void Latency_Close(void)
+{
+    if (!(latency_marked & (1 << LATENCY_INDEX)))
+    {
+        latency_incomplete_count++;
+    }
+    latency_open = 0;
+}
+
+/**
+  * @brief  红外检测边沿，开始一次跟踪，在EXTI1中断中调用
+  * @param  None
+  * @retval None
+  */
+void Latency_Edge(void)
+{
+    uint64_t now = Delay_GetCycles64();
+    uint64_t timeout = (uint64_t)LATENCY_TRACE_TIMEOUT_MS * (SystemCoreClock / 1000);
+    LATENCY_ENTER_CRITICAL();
+
+    if (latency_open)
+    {
+        if (now - latency_edge < timeout)
+        {
+            /* 上一次跟踪尚未走完，把这次边沿当作同一事件 */
+            latency_ignored_count++;
+            LATENCY_EXIT_CRITICAL();
+            return;
+        }
+        Latency_Close();
+    }
+
+    latency_edge = now;
+    latency_marked = 0;
+    latency_open = 1;
+    latency_trace_count++;
+
+    LATENCY_EXIT_CRITICAL();
+}
+
+/**
+  * @brief  记录当前跟踪到达某阶段的延迟，每次跟踪每个阶段只记录第一次
+  * @param  stage: 阶段，见Latency_Stage_t
+  * @retval 1: 记录了这次到达，0: 没有进行中的跟踪、该阶段已记录或跟踪已超时
+  * @note   到达LATENCY_INDEX后跟踪结束
+  */
+uint8_t Latency_Mark(uint8_t stage)
+{
+    uint64_t now = Delay_GetCycles64();
+    uint64_t elapsed;
+    uint32_t us;
+    Latency_Stats_t *s;
+    uint8_t bucket;
+    LATENCY_ENTER_CRITICAL();
+
+    if (!latency_open || stage >= LATENCY_STAGE_COUNT || (latency_marked & (1 << stage)))
+    {
+        LATENCY_EXIT_CRITICAL();
+        return 0;
+    }
+
+    elapsed = now - latency_edge;
+    if (elapsed >= (uint64_t)LATENCY_TRACE_TIMEOUT_MS * (SystemCoreClock / 1000))
+    {
+        /* 超时后到达的阶段不属于这次边沿 */
+        Latency_Close();
+        LATENCY_EXIT_CRITICAL();
+        return 0;
+    }
+
+    us = (uint32_t)(elapsed / (SystemCoreClock / 1000000));
+    bucket = Latency_Bucket(us);
+    s = &latency_stats[stage];
+    s->count++;
+    if (us > s->max) s->max = us;
+    if (s->hist[bucket] < 0xFFFF)
+    {
+        s->hist[bucket]++;
+    }
+
+    latency_marked |= 1 << stage;
+    if (stage == LATENCY_INDEX)
+    {
+        Latency_Close();
+    }
+
+    LATENCY_EXIT_CRITICAL();
+    return 1;
+}
+
+/**
+  * @brief  按直方图计算百分位延迟
+  * @param  s: 阶段统计
+  * @param  percent: 百分位，1~100
+  * @retval 百分位所在桶的上限（us），不超过最大值
+  */
+static uint32_t Latency_Percentile(const Latency_Stats_t *s, uint8_t percent)
+{
+    uint32_t total = 0, rank, seen = 0;
+    uint32_t upper;
+    uint8_t i;
+
+    for (i = 0; i < LATENCY_HIST_BUCKETS; i++)
+    {
+        total += s->hist[i];
+    }
+    rank = (total * percent + 99) / 100;
+    if (rank == 0)
+    {
+        rank = 1;
+    }
+
+    for (i = 0; i < LATENCY_HIST_BUCKETS - 1; i++)
+    {
+        seen += s->hist[i];
+        if (seen >= rank)
+        {
+            break;
+        }
+    }
+    upper = Latency_BucketUpper(i);
+    return (upper < s->max) ? upper : s->max;
+}
+
+/**
+  * @brief  通过串口输出各阶段延迟的p50/p99/最大值
+  * @param  None
+  * @retval None
+  * @note   百分位取所在直方图桶的上限，偏大不超过25%
+  */
+void Latency_ReportStats(void)
+{
+    Latency_Stats_t snap;
+    uint8_t i;
+
+    Serial_Printf("[LATENCY] Traces %lu, incomplete %lu, merged edges %lu, in progress %s\n",
+                  latency_trace_count, latency_incomplete_count, latency_ignored_count,
+                  latency_open ? "yes" : "no");
+    Serial_Printf("[LATENCY] Stage | Count | p50 us | p99 us | Max us\n");
+    for (i = 0; i < LATENCY_STAGE_COUNT; i++)
+    {
+        {
+            LATENCY_ENTER_CRITICAL();
+            snap = latency_stats[i];
+            LATENCY_EXIT_CRITICAL();
+        }
+
+        if (snap.count == 0)
+        {
+            Serial_Printf("[LATENCY] %s | 0 | - | - | -\n", latency_stage_names[i]);
+            continue;
+        }
+        Serial_Printf("[LATENCY] %s | %lu | %lu | %lu | %lu\n",
+                      latency_stage_names[i], snap.count,
+                      Latency_Percentile(&snap, 50), Latency_Percentile(&snap, 99), snap.max);
+    }
+}
+
+/**
+  * @brief  清除延迟统计
+  * @param  None
+  * @retval None
+  */
+void Latency_ResetStats(void)
+{
+    uint8_t i, j;
+    LATENCY_ENTER_CRITICAL();
+
+    for (i = 0; i < LATENCY_STAGE_COUNT; i++)
+    {
+        latency_stats[i].count = 0;
+        latency_stats[i].max = 0;
+        for (j = 0; j < LATENCY_HIST_BUCKETS; j++)
+        {
+            latency_stats[i].hist[j] = 0;
+        }
+    }
+    latency_trace_count = 0;
+    latency_incomplete_count = 0;
+    latency_ignored_count = 0;
+
+    LATENCY_EXIT_CRITICAL();
+}
@@ -0,0 +1,68 @@
+#ifndef __LATENCY_H
+#define __LATENCY_H
+
+#include "stm32f10x.h"
+
+/**
+  * 报警端到端延迟跟踪
+  *
+  * 红外检测边沿（EXTI1中断中按64位周期计数打时间戳）开始一次跟踪，之后各阶段
+  * 第一次到达时调用Latency_Mark，记录相对边沿的延迟：
+  *     observe: System_HandleAlarm看到红外检测状态
+  *     buzzer:  Buzzer_Pattern打开蜂鸣器（在alarm线程中直接驱动引脚）
+  *     uart:    "[ALARM]INTRUSION!"最后一个字节写入串口发送移位寄存器
+  *     record:  bulk线程用Journal_Append把记录追加到日志
+  *     index:   该记录所在的页编程完成（W25Q64操作队列回调），事件已持久保存，跟踪结束；
+  *              记录先在页缓冲中等待写满一页或JOURNAL_FLUSH_MS超时，电压下降时立即编程
+  * 跟踪进行中的边沿（传感器抖动、重复触发）不开始新的跟踪；超过LATENCY_TRACE_TIMEOUT_MS
+  * 仍未走完的跟踪计为未完成（如调试模式不报警也不记录）。
+  * 各阶段延迟累计在对数-线性直方图中（每个2倍区间分4档，误差不超过25%），复位前一直保留。
+  */
+
+/* 单次跟踪的最长时间（ms） */
+#define LATENCY_TRACE_TIMEOUT_MS    3000
+
+/* 直方图桶数：0~3us各一桶，之后每个2倍区间4桶，最后一桶为14.7s以上 */
+#define LATENCY_HIST_BUCKETS        92
+
+/**
+  * @brief  跟踪阶段
+  */
+typedef enum {
+    LATENCY_OBSERVE = 0,    /* 报警逻辑看到红外检测 */
+    LATENCY_BUZZER,         /* 蜂鸣器打开 */
+    LATENCY_UART,           /* 报警信息发送完成 */
+    LATENCY_RECORD,         /* 记录写入日志页缓冲，写满一页或超时后在后台编程 */
+    LATENCY_INDEX,          /* 记录所在的页编程完成 */
+    LATENCY_STAGE_COUNT
+} Latency_Stage_t;
+
+/**
+  * @brief  红外检测边沿，开始一次跟踪，在EXTI1中断中调用
+  * @param  None
+  * @retval None
+  */
+void Latency_Edge(void);
+
+/**
+  * @brief  记录当前跟踪到达某阶段的延迟，每次跟踪每个阶段只记录第一次
+  * @param  stage: 阶段，见Latency_Stage_t
+  * @retval 1: 记录了这次到达，0: 没有进行中的跟踪、该阶段已记录或跟踪已超时
+  */
+uint8_t Latency_Mark(uint8_t stage);
+
+/**
+  * @brief  通过串口输出各阶段延迟的p50/p99/最大值
+  * @param  None
+  * @retval None
+  */
+void Latency_ReportStats(void);
+
+/**
+  * @brief  清除延迟统计
+  * @param  None
+  * @retval None
+  */
+void Latency_ResetStats(void);
+
+#endif /* __LATENCY_H */
@@ -0,0 +1,214 @@
+#include "Mem.h"
+#include "Kernel.h"
+#include "Event.h"
+#include "Serial.h"
+
+/* 主栈填充时在当前栈指针以下保留的字节数 */
+#define MEM_MSP_GUARD           32
+
+/* 栈个数上限：主栈加全部线程 */
+#define MEM_MAX_STACKS          (KERNEL_MAX_THREADS + 1)
+
+#if defined(__CC_ARM)
+/* SRAM起止地址 */
+#define MEM_SRAM_BASE           0x20000000
+#define MEM_SRAM_SIZE           0x5000
+
+/* Project.sct中各执行区的链接器符号，符号地址即为数值 */
+extern char Image$$RW_MAIN$$RW$$Length[],   Image$$RW_MAIN$$ZI$$Length[];
+extern char Image$$RW_KERNEL$$RW$$Length[], Image$$RW_KERNEL$$ZI$$Length[];
+extern char Image$$RW_SCHED$$RW$$Length[],  Image$$RW_SCHED$$ZI$$Length[];
+extern char Image$$RW_DIAG$$RW$$Length[],   Image$$RW_DIAG$$ZI$$Length[];
+extern char Image$$RW_STORE$$RW$$Length[],  Image$$RW_STORE$$ZI$$Length[];
+extern char Image$$RW_DRIVER$$RW$$Length[], Image$$RW_DRIVER$$ZI$$Length[];
+extern char Image$$RW_IRAM1$$RW$$Length[],  Image$$RW_IRAM1$$ZI$$Length[];
+extern char Image$$RW_HEAP$$ZI$$Length[];
+extern char Image$$RW_STACK$$ZI$$Base[],    Image$$RW_STACK$$ZI$$Limit[];
+
+/**
+  * @brief  静态RAM分组
+  */
+typedef struct {
+    const char *name;
+    const char *rw;         /* RW长度（符号地址） */
+    const char *zi;         /* ZI长度（符号地址） */
+} Mem_Region_t;
+
+static const Mem_Region_t mem_regions[] = {
+    {"main",    Image$$RW_MAIN$$RW$$Length,   Image$$RW_MAIN$$ZI$$Length},
+    {"kernel",  Image$$RW_KERNEL$$RW$$Length, Image$$RW_KERNEL$$ZI$$Length},
+    {"sched",   Image$$RW_SCHED$$RW$$Length,  Image$$RW_SCHED$$ZI$$Length},
+    {"diag",    Image$$RW_DIAG$$RW$$Length,   Image$$RW_DIAG$$ZI$$Length},
+    {"store",   Image$$RW_STORE$$RW$$Length,  Image$$RW_STORE$$ZI$$Length},
+    {"driver",  Image$$RW_DRIVER$$RW$$Length, Image$$RW_DRIVER$$ZI$$Length},
+    {"lib",     Image$$RW_IRAM1$$RW$$Length,  Image$$RW_IRAM1$$ZI$$Length},
+    {"heap",    0,                            Image$$RW_HEAP$$ZI$$Length},
+};
+
+/**
+  * @brief  从栈底扫描填充值，得到已使用的字节数
+  * @param  stack: 栈底
+  * @param  words: 栈大小（字）
+  * @retval 已使用的字节数
+  */
+static uint32_t Mem_ScanStack(const uint32_t *stack, uint32_t words)
+{
+    uint32_t i = 0;
+
+    while (i < words && stack[i] == KERNEL_STACK_FILL)
+    {
+        i++;
+    }
+    return (words - i) * 4;
+}
+#endif
+
+static uint16_t mem_margin = MEM_STACK_MARGIN;
+static uint8_t mem_warned = 0;                  /* 已告警的栈，按栈号置位 */
+static uint32_t mem_warn_count = 0;
+
+/**
+  * @brief  填充主栈，在System_Init最开始调用
+  * @param  None
+  * @retval None
+  */
+void Mem_Init(void)
+{
+#if defined(__CC_ARM)
+    uint32_t *p = (uint32_t *)Image$$RW_STACK$$ZI$$Base;
+    uint32_t *top = (uint32_t *)(__get_MSP() - MEM_MSP_GUARD);
+
+    /*中断尚未打开，当前栈指针以下的主栈都未使用*/
+    while (p < top)
+    {
+        *p++ = KERNEL_STACK_FILL;
+    }
+#endif
+}
+
+/**
+  * @brief  获取栈使用情况
+  * @param  index: 栈号，见MEM_STACK_MSP
+  * @param  used: 已使用字节数（高水位）
+  * @param  size: 栈大小（字节）
+  * @retval 栈名称，栈号无效时返回0
+  */
+const char *Mem_GetStack(uint8_t index, uint32_t *used, uint32_t *size)
+{
+    if (index == MEM_STACK_MSP)
+    {
+#if defined(__CC_ARM)
+        uint32_t words = (Image$$RW_STACK$$ZI$$Limit - Image$$RW_STACK$$ZI$$Base) / 4;
+        *size = words * 4;
+        *used = Mem_ScanStack((const uint32_t *)Image$$RW_STACK$$ZI$$Base, words);
+        return "msp";
+#else
+        return 0;
+#endif
+    }
+    if (Kernel_GetStackUsage(index - 1, used, size))
+    {
+        return Kernel_GetThreadName(index - 1);
+    }
+    return 0;
+}
+
+/**
+  * @brief  更新各栈的高水位，剩余空间低于余量时投递EVENT_MEM_LOW（周期任务）
+  * @param  None
+  * @retval None
+  */
+void Mem_Check(void)
+{
+    uint8_t i;
+
+    for (i = 0; i < MEM_MAX_STACKS; i++)
+    {
+        uint32_t used, size;
+
+        if (Mem_GetStack(i, &used, &size) == 0)
+        {
+            continue;
+        }
+
+        if (size - used < mem_margin && !(mem_warned & (1 << i)))
+        {
+            /*事件队列为单生产者，在线程中投递时关中断，避免与中断同时写入*/
+            uint32_t primask = __get_PRIMASK();
+            __disable_irq();
+            if (Event_Post(EVENT_MEM_LOW, i) == 0)
+            {
+                mem_warned |= 1 << i;
+                mem_warn_count++;
+            }
+            __set_PRIMASK(primask);
+        }
+    }
+}
+
+/**
+  * @brief  设置栈余量并清除已告警标志
+  * @param  margin: 余量（字节）
+  * @retval None
+  */
+void Mem_SetMargin(uint16_t margin)
+{
+    mem_margin = margin;
+    mem_warned = 0;
+}
+
+/**
+  * @brief  获取栈余量
+  * @param  None
+  * @retval 余量（字节）
+  */
+uint16_t Mem_GetMargin(void)
+{
+    return mem_margin;
+}
+
+/**
+  * @brief  通过串口输出静态RAM分组占用、各栈高水位和余量
+  * @param  None
+  * @retval None
+  */
+void Mem_ReportStats(void)
+{
+    uint8_t i;
+
+#if defined(__CC_ARM)
+    uint32_t stack = Image$$RW_STACK$$ZI$$Limit - Image$$RW_STACK$$ZI$$Base;
+    uint32_t total = stack;
+
+    Serial_Printf("[MEM] Region | RW | ZI | Total\n");
+    for (i = 0; i < sizeof(mem_regions) / sizeof(mem_regions[0]); i++)
+    {
+        uint32_t rw = (uint32_t)mem_regions[i].rw;
+        uint32_t zi = (uint32_t)mem_regions[i].zi;
+
+        Serial_Printf("[MEM] %s | %lu | %lu | %lu\n", mem_regions[i].name, rw, zi, rw + zi);
+        total += rw + zi;
+    }
+    Serial_Printf("[MEM] msp | 0 | %lu | %lu\n", stack, stack);
+    Serial_Printf("[MEM] SRAM: %lu total, %lu static, %lu unused\n",
+                  (uint32_t)MEM_SRAM_SIZE, total,
+                  MEM_SRAM_BASE + MEM_SRAM_SIZE - (uint32_t)Image$$RW_STACK$$ZI$$Limit);
+#else
+    Serial_Printf("[MEM] Static RAM breakdown needs the Keil scatter file, not available in host build\n");
+#endif
+
+    Serial_Printf("[MEM] Stack | Size | Used | Free\n");
+    for (i = 0; i < MEM_MAX_STACKS; i++)
+    {
+        uint32_t used, size;
+        const char *name = Mem_GetStack(i, &used, &size);
+
+        if (name == 0)
+        {
+            continue;
+        }
+        Serial_Printf("[MEM] %s | %lu | %lu | %lu%s\n", name, size, used, size - used,
+                      (size - used < mem_margin) ? " LOW" : "");
+    }
+    Serial_Printf("[MEM] Margin: %u bytes, warnings: %lu\n", mem_margin, mem_warn_count);
+}
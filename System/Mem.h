@@ -0,0 +1,71 @@
+#ifndef __MEM_H
+#define __MEM_H
+
+#include "stm32f10x.h"
+
+/**
+  * RAM与栈预算监控（20KB SRAM）
+  *
+  * 静态RAM：Project.sct把RW/ZI按模块分组放入独立的执行区，按各区的链接器符号
+  * Image$$<区>$$RW$$Length/ZI$$Length统计每组的占用，剩余部分为未分配的SRAM。
+  * 栈：主栈（MSP，内核启动前和中断使用）在Mem_Init中从栈底填充到当前栈指针以下，
+  * 线程栈由Kernel_CreateThread填充，填充值均为KERNEL_STACK_FILL。Mem_Check周期性地
+  * 从栈底扫描填充值得到高水位，剩余空间低于余量时投递EVENT_MEM_LOW（arg为栈号：
+  * 0为主栈，n为线程n-1），每个栈只告警一次，修改余量后重新告警。
+  * 主机编译没有分散加载和主栈，只统计线程栈。
+  */
+
+/* 默认栈余量（字节），剩余空间低于此值时告警 */
+#define MEM_STACK_MARGIN        128
+
+/* 高水位检查周期（ms） */
+#define MEM_CHECK_PERIOD_MS     1000
+
+/* 栈号：0为主栈，之后依次为各线程 */
+#define MEM_STACK_MSP           0
+
+/**
+  * @brief  填充主栈，在System_Init最开始调用
+  * @param  None
+  * @retval None
+  */
+void Mem_Init(void);
+
+/**
+  * @brief  更新各栈的高水位，剩余空间低于余量时投递EVENT_MEM_LOW（周期任务）
+  * @param  None
+  * @retval None
+  */
+void Mem_Check(void);
+
+/**
+  * @brief  设置栈余量并清除已告警标志
+  * @param  margin: 余量（字节）
+  * @retval None
+  */
+void Mem_SetMargin(uint16_t margin);
+
+/**
+  * @brief  获取栈余量
+  * @param  None
+  * @retval 余量（字节）
+  */
+uint16_t Mem_GetMargin(void);
+
+/**
+  * @brief  获取栈使用情况
+  * @param  index: 栈号，见MEM_STACK_MSP
+  * @param  used: 已使用字节数（高水位）
+  * @param  size: 栈大小（字节）
+  * @retval 栈名称，栈号无效时返回0
+  */
+const char *Mem_GetStack(uint8_t index, uint32_t *used, uint32_t *size);
+
+/**
+  * @brief  通过串口输出静态RAM分组占用、各栈高水位和余量
+  * @param  None
+  * @retval None
+  */
+void Mem_ReportStats(void);
+
+#endif /* __MEM_H */
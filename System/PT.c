@@ -0,0 +1,118 @@
+#include "PT.h"
+#include "Kernel.h"
+
+/**
+  * @brief  协程任务的定时器回调，运行一次协程，未结束时按其唤醒时刻重新启动定时器
+  * @param  arg: 任务
+  * @retval None
+  */
+static void PT_TaskTimer(void *arg)
+{
+    PT_Task_t *task = (PT_Task_t *)arg;
+    int32_t delay;
+
+    if (!task->active)
+    {
+        return;
+    }
+
+    if (task->restart)
+    {
+        task->restart = 0;
+        PT_INIT(&task->pt);
+    }
+
+    if (!PT_SCHEDULE(task->func(&task->pt)))
+    {
+        /* 运行结束，期间被重新启动的除外 */
+        if (!task->restart)
+        {
+            task->active = 0;
+        }
+        return;
+    }
+
+    /* 按唤醒时刻重新启动定时器，在非延时的条件上等待时下一个tick再检查；
+       运行期间被重新启动或停止的，定时器已由PT_TaskStart/PT_TaskStop处理 */
+    if (task->active && !task->restart)
+    {
+        delay = (int32_t)(task->pt.wake - Scheduler_GetTick());
+        Timer_Start(&task->timer, delay > 0 ? (uint32_t)delay : 1, 0);
+    }
+}
+
+/**
+  * @brief  初始化协程任务（初始为停止状态）
+  * @param  task: 任务
+  * @param  name: 任务名称
+  * @param  func: 协程函数
+  * @retval None
+  */
+void PT_TaskInit(PT_Task_t *task, const char *name, PT_Func func)
+{
+    task->func = func;
+    task->active = 0;
+    task->restart = 0;
+    PT_INIT(&task->pt);
+    Timer_Setup(&task->timer, name, PT_TaskTimer, task);
+}
+
+/**
+  * @brief  从头启动协程任务，已在运行时重新开始，可在任意线程中调用
+  * @param  task: 任务
+  * @retval None
+  * @note   协程本身只在定时器回调中复位，避免与正在运行的协程冲突
+  */
+void PT_TaskStart(PT_Task_t *task)
+{
+    task->restart = 1;
+    task->active = 1;
+    Timer_Start(&task->timer, 0, 0);
+}
+
+/**
+  * @brief  停止协程任务
+  * @param  task: 任务
+  * @retval None
+  */
+void PT_TaskStop(PT_Task_t *task)
+{
+    task->active = 0;
+    Timer_Stop(&task->timer);
+}
+
+/**
+  * @brief  查询协程任务是否在运行
+  * @param  task: 任务
+  * @retval 1: 运行中，0: 已停止
+  */
+uint8_t PT_TaskIsActive(PT_Task_t *task)
+{
+    return task->active;
+}
+
+/**
+  * @brief  PT_RUN_BLOCKING使用，等待到协程的唤醒时刻
+  * @param  pt: 协程
+  * @retval None
+  * @note   线程中休眠让出CPU，内核启动前忙等；
+  *         协程未使用PT_DELAY时唤醒时刻已过，等待1个tick后再检查
+  */
+void PT_Sleep(PT_t *pt)
+{
+    uint32_t wake = pt->wake;
+
+    if ((int32_t)(wake - Scheduler_GetTick()) <= 0)
+    {
+        wake = Scheduler_GetTick() + 1;
+    }
+
+    if (Kernel_InThread())
+    {
+        Kernel_SleepUntil(wake);
+    }
+    else
+    {
+        while ((int32_t)(Scheduler_GetTick() - wake) < 0);
+    }
+}
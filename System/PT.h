@@ -0,0 +1,142 @@
+#ifndef __PT_H
+#define __PT_H
+
+#include "stm32f10x.h"
+#include "Scheduler.h"
+#include "Timer.h"
+
+/**
+  * 无栈协程（protothread）
+  *
+  * 协程函数在每个等待点返回，下次调用时通过switch跳回上次的位置继续执行，
+  * 不需要独立的栈，每个协程只占用一个PT_t。限制：
+  * 1. 跨越等待点的局部变量必须声明为static（或放在调用者提供的结构体中）
+  * 2. 协程函数体内不能再使用switch语句包含等待点
+  */
+
+/* 协程函数返回值 */
+#define PT_WAITING      0   /* 在等待点挂起 */
+#define PT_YIELDED      1   /* 主动让出 */
+#define PT_EXITED       2   /* 中途退出 */
+#define PT_ENDED        3   /* 运行结束 */
+
+/**
+  * @brief  协程控制块
+  */
+typedef struct {
+    uint16_t lc;            /* 恢复位置（源代码行号），0表示从头开始 */
+    uint32_t wake;          /* 希望被再次调用的时刻（ms），由PT_DELAY设置 */
+} PT_t;
+
+/* 声明协程函数 */
+#define PT_THREAD(name_args)            char name_args
+
+/* 初始化协程，下次调用时从头开始 */
+#define PT_INIT(pt)                     do { (pt)->lc = 0; (pt)->wake = Scheduler_GetTick(); } while (0)
+
+/* 协程函数体的开始和结束 */
+#define PT_BEGIN(pt)                    { char pt_yield_flag = 1; (void)pt_yield_flag; switch ((pt)->lc) { case 0:
+#define PT_END(pt)                      } pt_yield_flag = 0; PT_INIT(pt); return PT_ENDED; }
+
+/* 等待条件成立 */
+#define PT_WAIT_UNTIL(pt, condition)                    \
+    do {                                                \
+        (pt)->lc = __LINE__; case __LINE__:             \
+        if (!(condition)) { return PT_WAITING; }        \
+    } while (0)
+
+#define PT_WAIT_WHILE(pt, cond)         PT_WAIT_UNTIL((pt), !(cond))
+
+/* 延时ms毫秒，期间协程挂起 */
+#define PT_DELAY(pt, ms)                                \
+    do {                                                \
+        (pt)->wake = Scheduler_GetTick() + (ms);        \
+        PT_WAIT_UNTIL((pt), (int32_t)(Scheduler_GetTick() - (pt)->wake) >= 0); \
+    } while (0)
+
+/* 延时到指定时刻（ms），该时刻已过去时不挂起 */
+#define PT_DELAY_UNTIL(pt, tick)                        \
+    do {                                                \
+        (pt)->wake = (tick);                            \
+        PT_WAIT_UNTIL((pt), (int32_t)(Scheduler_GetTick() - (pt)->wake) >= 0); \
+    } while (0)
+
+/* 查询协程是否还在运行（未结束） */
+#define PT_SCHEDULE(f)                  ((f) < PT_EXITED)
+
+/* 启动子协程并等待其结束，子协程的唤醒时刻传递给父协程 */
+#define PT_SPAWN(pt, child, thread)                     \
+    do {                                                \
+        PT_INIT(child);                                 \
+        PT_WAIT_WHILE((pt), PT_SCHEDULE(thread) && (((pt)->wake = (child)->wake), 1)); \
+    } while (0)
+
+/* 让出一次，下一轮再继续 */
+#define PT_YIELD(pt)                                    \
+    do {                                                \
+        pt_yield_flag = 0;                              \
+        (pt)->lc = __LINE__; case __LINE__:             \
+        if (pt_yield_flag == 0) { return PT_YIELDED; }  \
+    } while (0)
+
+/* 退出协程 */
+#define PT_EXIT(pt)                     do { PT_INIT(pt); return PT_EXITED; } while (0)
+
+/* 在普通函数中运行协程直到结束，线程中等待时休眠，否则忙等 */
+#define PT_RUN_BLOCKING(pt, thread)                     \
+    do {                                                \
+        PT_INIT(pt);                                    \
+        while (PT_SCHEDULE(thread)) { PT_Sleep(pt); }   \
+    } while (0)
+
+/**
+  * @brief  协程任务，由单次定时器在协程的唤醒时刻调用，在定时器服务线程中运行
+  */
+typedef PT_THREAD((*PT_Func)(PT_t *pt));
+
+typedef struct {
+    PT_Func func;           /* 协程函数 */
+    PT_t pt;                /* 协程控制块 */
+    Timer_t timer;          /* 唤醒定时器 */
+    volatile uint8_t active;    /* 1: 运行中 */
+    volatile uint8_t restart;   /* 1: 下次调度时从头开始 */
+} PT_Task_t;
+
+/**
+  * @brief  初始化协程任务（初始为停止状态）
+  * @param  task: 任务
+  * @param  name: 任务名称
+  * @param  func: 协程函数
+  * @retval None
+  */
+void PT_TaskInit(PT_Task_t *task, const char *name, PT_Func func);
+
+/**
+  * @brief  从头启动协程任务，已在运行时重新开始，可在任意线程中调用
+  * @param  task: 任务
+  * @retval None
+  */
+void PT_TaskStart(PT_Task_t *task);
+
+/**
+  * @brief  停止协程任务
+  * @param  task: 任务
+  * @retval None
+  */
+void PT_TaskStop(PT_Task_t *task);
+
+/**
+  * @brief  查询协程任务是否在运行
+  * @param  task: 任务
+  * @retval 1: 运行中，0: 已停止
+  */
+uint8_t PT_TaskIsActive(PT_Task_t *task);
+
+/**
+  * @brief  PT_RUN_BLOCKING使用，等待到协程的唤醒时刻
+  * @param  pt: 协程
+  * @retval None
+  */
+void PT_Sleep(PT_t *pt);
+
+#endif /* __PT_H */
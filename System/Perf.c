@@ -0,0 +1,157 @@
+#include "Perf.h"
+#include "Serial.h"
+#include <stdio.h>
+
+/* 临界区，保存并恢复PRIMASK，允许嵌套 */
+#define PERF_ENTER_CRITICAL()   uint32_t primask = __get_PRIMASK(); __disable_irq()
+#define PERF_EXIT_CRITICAL()    __set_PRIMASK(primask)
+
+/* 已登记探针链表 */
+static Perf_Probe_t *perf_probes = 0;
+static Perf_Probe_t *perf_probes_tail = 0;
+
+/**
+  * @brief  计算周期数所在的直方图桶
+  * @param  cycles: 周期数
+  * @retval 桶号
+  */
+static uint8_t Perf_Bucket(uint32_t cycles)
+{
+    uint8_t log2 = 0;
+
+    if (cycles >= 0x10000) { cycles >>= 16; log2 += 16; }
+    if (cycles >= 0x100)   { cycles >>= 8;  log2 += 8; }
+    if (cycles >= 0x10)    { cycles >>= 4;  log2 += 4; }
+    if (cycles >= 0x4)     { cycles >>= 2;  log2 += 2; }
+    if (cycles >= 0x2)     { log2 += 1; }
+
+    if (log2 < PERF_HIST_MIN_SHIFT)
+    {
+        return 0;
+    }
+    log2 -= PERF_HIST_MIN_SHIFT;
+    return (log2 < PERF_HIST_BUCKETS) ? log2 : PERF_HIST_BUCKETS - 1;
+}
+
+/**
+  * @brief  记录一次测量，可在线程和中断中调用
+  * @param  probe: 探针
+  * @param  cycles: 本次经过的周期数
+  * @retval None
+  */
+void Perf_Record(Perf_Probe_t *probe, uint32_t cycles)
+{
+    uint8_t bucket = Perf_Bucket(cycles);
+    PERF_ENTER_CRITICAL();
+
+    if (!probe->registered)
+    {
+        probe->registered = 1;
+        probe->next = 0;
+        if (perf_probes_tail)
+        {
+            perf_probes_tail->next = probe;
+        }
+        else
+        {
+            perf_probes = probe;
+        }
+        perf_probes_tail = probe;
+    }
+
+    probe->count++;
+    probe->total += cycles;
+    if (cycles < probe->min) probe->min = cycles;
+    if (cycles > probe->max) probe->max = cycles;
+    if (probe->hist[bucket] < 0xFFFF)
+    {
+        probe->hist[bucket]++;
+    }
+
+    PERF_EXIT_CRITICAL();
+}
+
+/**
+  * @brief  通过串口输出各探针的次数、最短/平均/最长周期和直方图
+  * @param  None
+  * @retval None
+  * @note   输出时先在临界区内复制单个探针，避免输出过程中统计被改写
+  */
+void Perf_ReportStats(void)
+{
+#if PERF_ENABLE
+    uint32_t mhz = SystemCoreClock / 1000000;
+    Perf_Probe_t *p;
+    Perf_Probe_t snap;
+    char line[96];
+    uint8_t i, len, shift;
+
+    Serial_Printf("[PERF] Probe | Count | Min cyc | Avg cyc | Max cyc | Avg us | Max us | Total ms\n");
+    for (p = perf_probes; p; p = snap.next)
+    {
+        {
+            PERF_ENTER_CRITICAL();
+            snap = *p;
+            PERF_EXIT_CRITICAL();
+        }
+
+        if (snap.count == 0)
+        {
+            Serial_Printf("[PERF] %s | 0 | - | - | - | - | - | 0\n", snap.name);
+            continue;
+        }
+        Serial_Printf("[PERF] %s | %lu | %lu | %lu | %lu | %lu | %lu | %lu\n",
+                      snap.name, snap.count, snap.min, (uint32_t)(snap.total / snap.count), snap.max,
+                      (uint32_t)(snap.total / snap.count) / mhz, snap.max / mhz,
+                      (uint32_t)(snap.total / (mhz * 1000)));
+
+        /* 只输出非空的桶，以桶下限（周期数的2的幂）表示，首尾两桶分别为"<"和">=" */
+        len = 0;
+        for (i = 0; i < PERF_HIST_BUCKETS; i++)
+        {
+            if (snap.hist[i] == 0)
+            {
+                continue;
+            }
+            if (len > sizeof(line) - 16)
+            {
+                line[len] = '\0';
+                Serial_Printf("[PERF]   hist%s\n", line);
+                len = 0;
+            }
+            shift = i + PERF_HIST_MIN_SHIFT + (i == 0);
+            len += sprintf(line + len, " %s2^%u:%u",
+                           i == 0 ? "<" : (i == PERF_HIST_BUCKETS - 1 ? ">=" : ""), shift, snap.hist[i]);
+        }
+        line[len] = '\0';
+        Serial_Printf("[PERF]   hist%s\n", line);
+    }
+#else
+    Serial_Printf("[PERF] Probes compiled out (PERF_ENABLE = 0)\n");
+#endif
+}
+
+/**
+  * @brief  清除各探针的统计，探针保持登记
+  * @param  None
+  * @retval None
+  */
+void Perf_ResetStats(void)
+{
+    Perf_Probe_t *p;
+    uint8_t i;
+
+    for (p = perf_probes; p; p = p->next)
+    {
+        PERF_ENTER_CRITICAL();
+        p->count = 0;
+        p->min = 0xFFFFFFFF;
+        p->max = 0;
+        p->total = 0;
+        for (i = 0; i < PERF_HIST_BUCKETS; i++)
+        {
+            p->hist[i] = 0;
+        }
+        PERF_EXIT_CRITICAL();
+    }
+}
@@ -0,0 +1,78 @@
+#ifndef __PERF_H
+#define __PERF_H
+
+#include "stm32f10x.h"
+#include "Delay.h"
+
+/**
+  * 热点路径周期计数探针
+  *
+  * 用法：在源文件中定义探针（文件内静态变量），在被测代码前后加PERF_BEGIN/PERF_END
+  *     PERF_PROBE(perf_oled_clear, "OLED_Clear");
+  *     PERF_BEGIN(perf_oled_clear);
+  *     ...
+  *     PERF_END(perf_oled_clear);
+  * 探针第一次记录时自动登记，perf命令按登记顺序输出。
+  * 测量的是DWT周期数，包含被中断和被其他线程抢占的时间；内核休眠时CYCCNT停止，
+  * 被测代码阻塞期间系统空闲休眠的时间不计入。
+  * PERF_ENABLE定义为0时所有探针编译为空，没有任何开销。
+  */
+#ifndef PERF_ENABLE
+#define PERF_ENABLE             1
+#endif
+
+/* log2直方图：第i桶统计[2^(i+PERF_HIST_MIN_SHIFT), 2^(i+PERF_HIST_MIN_SHIFT+1))个周期，
+   首尾两桶分别包含更短和更长的样本；72MHz下覆盖约1us到15s */
+#define PERF_HIST_BUCKETS       24
+#define PERF_HIST_MIN_SHIFT     6
+
+/**
+  * @brief  探针
+  */
+typedef struct Perf_Probe {
+    const char *name;               /* 探针名称 */
+    struct Perf_Probe *next;        /* 已登记探针链表 */
+    uint8_t registered;             /* 1: 已登记 */
+    uint32_t count;                 /* 记录次数 */
+    uint32_t min;                   /* 最短周期数 */
+    uint32_t max;                   /* 最长周期数 */
+    uint64_t total;                 /* 累计周期数 */
+    uint16_t hist[PERF_HIST_BUCKETS];   /* log2直方图，饱和计数 */
+} Perf_Probe_t;
+
+/* 静态初始化探针 */
+#define PERF_PROBE_INIT(name)   { (name), 0, 0, 0, 0xFFFFFFFF, 0, 0, {0} }
+
+#if PERF_ENABLE
+#define PERF_PROBE(probe, name) static Perf_Probe_t probe = PERF_PROBE_INIT(name)
+#define PERF_BEGIN(probe)       uint32_t probe##_start = DWT_CYCCNT
+#define PERF_END(probe)         Perf_Record(&(probe), DWT_CYCCNT - probe##_start)
+#else
+#define PERF_PROBE(probe, name) extern Perf_Probe_t probe
+#define PERF_BEGIN(probe)       do { } while (0)
+#define PERF_END(probe)         do { } while (0)
+#endif
+
+/**
+  * @brief  记录一次测量，可在线程和中断中调用
+  * @param  probe: 探针
+  * @param  cycles: 本次经过的周期数
+  * @retval None
+  */
+void Perf_Record(Perf_Probe_t *probe, uint32_t cycles);
+
+/**
+  * @brief  通过串口输出各探针的次数、最短/平均/最长周期和直方图
+  * @param  None
+  * @retval None
+  */
+void Perf_ReportStats(void);
+
+/**
+  * @brief  清除各探针的统计，探针保持登记
+  * @param  None
+  * @retval None
+  */
+void Perf_ResetStats(void);
+
+#endif /* __PERF_H */
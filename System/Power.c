@@ -0,0 +1,493 @@
+#include "Power.h"
+#include "Kernel.h"
+#include "Scheduler.h"
+#include "Delay.h"
+#include "Serial.h"
+#include "Event.h"
+
+/* SysTick为24位递减计数器 */
+#define POWER_SYSTICK_MAX           0x00FFFFFF
+
+/* RTC时钟（LSE）频率，RTC_DIV每秒从32767递减到0 */
+#define POWER_RTC_CLOCK_HZ          32768
+
+/* 停机唤醒后内核先以HSI（8MHz）运行，直到切回PLL */
+#define POWER_HSI_MHZ               8
+
+static volatile uint8_t power_stop_enabled = 0;
+
+/* 停机时长中不足1ms、尚未补计到毫秒计数的部分（us） */
+static uint32_t power_stop_remainder_us = 0;
+
+/* 统计，只在关中断时修改 */
+static uint32_t power_stats_start;          /* 统计开始时刻（ms） */
+static uint64_t power_sleep_us;             /* 睡眠模式累计时间 */
+static uint64_t power_stop_us;              /* 停机模式累计时间 */
+static uint32_t power_sleep_count;          /* 进入睡眠模式次数 */
+static uint32_t power_stop_count;           /* 进入停机模式次数 */
+static uint32_t power_stop_alarm_wakes;     /* 其中由RTC闹钟唤醒的次数 */
+static uint32_t power_stop_denied;          /* 空闲窗口足够但因串口活动未停机的次数 */
+static uint32_t power_wake_min_us;          /* 停机唤醒到中断处理的延迟 */
+static uint32_t power_wake_max_us;
+static uint32_t power_wake_total_us;
+static uint32_t power_clock_max_us;         /* 唤醒后恢复HSE和PLL的最长时间 */
+static uint32_t power_pvd_count;            /* 电源电压低于PVD阈值的次数 */
+
+/**
+  * @brief  读取RTC计数器和分频器，保证两者属于同一秒
+  * @param  cnt: 输出秒计数
+  * @param  div: 输出分频器余数（32767~0）
+  * @retval None
+  */
+static void Power_ReadRTC(uint32_t *cnt, uint32_t *div)
+{
+    uint32_t c;
+
+    do
+    {
+        c = RTC_GetCounter();
+        *div = RTC_GetDivider();
+    } while (c != RTC_GetCounter());
+    *cnt = c;
+}
+
+/**
+  * @brief  停机唤醒后恢复系统时钟：HSE -> PLL -> SYSCLK
+  * @param  None
+  * @retval 1: 已从停机恢复，0: 系统时钟未切换过（有中断挂起时WFI立即返回，未真正停机）
+  * @note   PLL倍频和Flash等待周期配置在停机期间保持不变，只需重新打开振荡器
+  */
+static uint8_t Power_RestoreClock(void)
+{
+    if (RCC_GetSYSCLKSource() == 0x08)
+    {
+        return 0;
+    }
+
+    RCC_HSEConfig(RCC_HSE_ON);
+    if (RCC_WaitForHSEStartUp() == SUCCESS)
+    {
+        RCC_PLLCmd(ENABLE);
+        while (RCC_GetFlagStatus(RCC_FLAG_PLLRDY) == RESET);
+        RCC_SYSCLKConfig(RCC_SYSCLKSource_PLLCLK);
+        while (RCC_GetSYSCLKSource() != 0x08);
+    }
+    /* HSE起振失败时继续以HSI运行 */
+    return 1;
+}
+
+/**
+  * @brief  无SysTick中断的睡眠模式：把SysTick装载为整个空闲时长，唤醒后补计经过的毫秒数
+  * @param  idle_ms: 空闲时长（ms），至少为1
+  * @retval None
+  * @note   在关中断时调用，由SysTick唤醒时最后1ms由随后执行的SysTick中断计入
+  */
+static void Power_EnterSleep(uint32_t idle_ms)
+{
+    uint32_t per_tick = SystemCoreClock / 1000;
+    uint32_t reload, remaining, elapsed, to_boundary, complete, slept, cycles;
+
+    if (idle_ms > POWER_SYSTICK_MAX / per_tick)
+    {
+        idle_ms = POWER_SYSTICK_MAX / per_tick;
+    }
+
+    /* 暂停计数，当前1ms即将到期时交给SysTick中断处理；VAL为0时下一个时钟才重新装载，剩余整1ms */
+    SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_TICKINT_Msk;
+    remaining = SysTick->VAL ? SysTick->VAL : per_tick;
+    if ((SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) || remaining <= 1)
+    {
+        SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+        return;
+    }
+
+    /* 从当前1ms的剩余部分开始，一直计到唤醒时刻（计数周期为LOAD+1） */
+    reload = remaining - 1 + per_tick * (idle_ms - 1);
+    SysTick->LOAD = reload;
+    SysTick->VAL = 0;
+    SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+
+    cycles = DWT_CYCCNT;
+    __DSB();
+    __WFI();
+    __ISB();
+    cycles = DWT_CYCCNT - cycles;
+
+    SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_TICKINT_Msk;
+    remaining = SysTick->VAL;
+    if (SysTick->CTRL & SysTick_CTRL_COUNTFLAG_Msk)
+    {
+        /* 由SysTick唤醒，整个空闲时长已过去，VAL不为0时计数器已从reload重新开始递减 */
+        elapsed = remaining ? reload - remaining + 1 : 0;
+        slept = reload + 1 + elapsed;
+        complete = idle_ms - 1;
+        SysTick->LOAD = (elapsed < per_tick - 1) ? (per_tick - 1 - elapsed) : (per_tick - 1);
+    }
+    else
+    {
+        /* 由其他中断提前唤醒，remaining为到预定唤醒时刻的周期数，补计已经完整经过的毫秒 */
+        slept = reload + 1 - remaining;
+        complete = idle_ms - 1 - (remaining - 1) / per_tick;
+        to_boundary = remaining - (remaining - 1) / per_tick * per_tick;
+        if (to_boundary > 1)
+        {
+            SysTick->LOAD = to_boundary - 1;
+        }
+        else
+        {
+            /* 下一个时钟就是1ms边界，直接计入 */
+            SysTick->LOAD = per_tick - 1;
+            complete++;
+        }
+    }
+    SysTick->VAL = 0;
+    SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+    SysTick->LOAD = per_tick - 1;
+
+    Scheduler_StepTicks(complete);
+
+    /* 睡眠期间内核时钟停止，CYCCNT少计的部分补到时间戳上 */
+    if (slept > cycles)
+    {
+        Delay_AddCycles(slept - cycles);
+    }
+
+    power_sleep_us += slept / (SystemCoreClock / 1000000);
+    power_sleep_count++;
+}
+
+/**
+  * @brief  停机模式：用RTC闹钟在空闲窗口内最后一个秒边界唤醒，期间SysTick暂停，唤醒后按RTC补计时间
+  * @param  idle_ms: 空闲时长（ms）
+  * @retval 1: 已进入停机模式，0: 条件不满足，应改用睡眠模式
+  * @note   在关中断时调用，剩余的空闲时间由下一次Power_Idle按睡眠模式处理
+  */
+static uint8_t Power_EnterStop(uint32_t idle_ms)
+{
+    uint32_t cnt, div, cnt_wake, div_wake, alarm;
+    uint32_t boundary_ms, skip, rtc_ticks, stop_us, expected;
+    uint32_t cyc_start, cyc_wake, cyc_clock, cyc_end;
+    uint32_t clock_us, latency_us;
+    uint8_t stopped;
+
+    if (idle_ms < POWER_STOP_MIN_MS + POWER_STOP_MARGIN_MS)
+    {
+        return 0;
+    }
+
+    /* 从这里开始由RTC计时，暂停SysTick避免重复计入 */
+    SysTick->CTRL &= ~SysTick_CTRL_ENABLE_Msk;
+    cyc_start = DWT_CYCCNT;
+    Power_ReadRTC(&cnt, &div);
+
+    /* 下一个秒边界（向上取整），太近时来不及写入闹钟，改用再下一个 */
+    boundary_ms = ((div + 1) * 1000 + POWER_RTC_CLOCK_HZ - 1) / POWER_RTC_CLOCK_HZ;
+    alarm = cnt + 1;
+    if (boundary_ms < POWER_STOP_MARGIN_MS)
+    {
+        boundary_ms += 1000;
+        alarm++;
+    }
+
+    /* 取唤醒时刻减去时钟恢复余量之前的最后一个秒边界 */
+    if (boundary_ms + POWER_STOP_MARGIN_MS > idle_ms)
+    {
+        SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+        return 0;
+    }
+    skip = (idle_ms - POWER_STOP_MARGIN_MS - boundary_ms) / 1000;
+    boundary_ms += skip * 1000;
+    alarm += skip;
+    if (boundary_ms < POWER_STOP_MIN_MS)
+    {
+        SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+        return 0;
+    }
+
+    /* 停机期间USART时钟停止：正在发送的字节会被截断，接收的字节会丢失 */
+    if (!Serial_IsTxIdle() || Scheduler_GetTick() - Serial_GetLastRxTick() < POWER_SERIAL_HOLDOFF_MS)
+    {
+        power_stop_denied++;
+        SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+        return 0;
+    }
+
+    RTC_WaitForLastTask();
+    RTC_SetAlarm(alarm);
+    RTC_WaitForLastTask();
+    RTC_ClearFlag(RTC_FLAG_ALR);
+    RTC_WaitForLastTask();
+    EXTI_ClearITPendingBit(EXTI_Line17);
+
+    /* 写入闹钟期间已越过该秒边界时闹钟不会再触发 */
+    if ((int32_t)(RTC_GetCounter() - alarm) >= 0)
+    {
+        SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+        return 0;
+    }
+
+    PWR_EnterSTOPMode(PWR_Regulator_LowPower, PWR_STOPEntry_WFI);
+    cyc_wake = DWT_CYCCNT;
+    stopped = Power_RestoreClock();
+    cyc_clock = DWT_CYCCNT;
+
+    /* APB1时钟停止过，读RTC前需重新同步 */
+    RTC_WaitForSynchro();
+    Power_ReadRTC(&cnt_wake, &div_wake);
+    rtc_ticks = (cnt_wake - cnt) * POWER_RTC_CLOCK_HZ + div - div_wake;
+    stop_us = (uint32_t)((uint64_t)rtc_ticks * 1000000 / POWER_RTC_CLOCK_HZ);
+
+    /* 补计毫秒计数和CYCCNT */
+    power_stop_remainder_us += stop_us;
+    Scheduler_StepTicks(power_stop_remainder_us / 1000);
+    power_stop_remainder_us %= 1000;
+    expected = stop_us * (SystemCoreClock / 1000000);
+    if (expected > DWT_CYCCNT - cyc_start)
+    {
+        Delay_AddCycles(expected - (DWT_CYCCNT - cyc_start));
+    }
+    SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+    if (!stopped)
+    {
+        return 1;
+    }
+
+    /* 唤醒到中断处理的延迟：恢复时钟期间以HSI运行，之后以HCLK运行，返回后开中断即进入中断处理 */
+    cyc_end = DWT_CYCCNT;
+    clock_us = (cyc_clock - cyc_wake) / POWER_HSI_MHZ;
+    latency_us = clock_us + (cyc_end - cyc_clock) / (SystemCoreClock / 1000000);
+    if (latency_us < power_wake_min_us) power_wake_min_us = latency_us;
+    if (latency_us > power_wake_max_us) power_wake_max_us = latency_us;
+    if (clock_us > power_clock_max_us) power_clock_max_us = clock_us;
+    power_wake_total_us += latency_us;
+
+    power_stop_us += stop_us;
+    power_stop_count++;
+    if (RTC_GetFlagStatus(RTC_FLAG_ALR) != RESET)
+    {
+        power_stop_alarm_wakes++;
+    }
+    return 1;
+}
+
+/**
+  * @brief  低功耗初始化，配置RTC闹钟唤醒并安装空闲钩子，应在RTC_Init之后调用
+  * @param  None
+  * @retval None
+  */
+void Power_Init(void)
+{
+    /* RTC闹钟经EXTI17唤醒停机模式 */
+    EXTI_InitTypeDef EXTI_InitStructure;
+    EXTI_ClearITPendingBit(EXTI_Line17);
+    EXTI_InitStructure.EXTI_Line = EXTI_Line17;
+    EXTI_InitStructure.EXTI_Mode = EXTI_Mode_Interrupt;
+    EXTI_InitStructure.EXTI_Trigger = EXTI_Trigger_Rising;
+    EXTI_InitStructure.EXTI_LineCmd = ENABLE;
+    EXTI_Init(&EXTI_InitStructure);
+
+    RTC_WaitForLastTask();
+    RTC_ITConfig(RTC_IT_ALR, ENABLE);
+    RTC_WaitForLastTask();
+
+    NVIC_InitTypeDef NVIC_InitStructure;
+    NVIC_InitStructure.NVIC_IRQChannel = RTCAlarm_IRQn;
+    NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+    NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = 1;
+    NVIC_InitStructure.NVIC_IRQChannelSubPriority = 3;
+    NVIC_Init(&NVIC_InitStructure);
+
+    /* PVD：电源电压低于阈值时PVDO置1，经EXTI16双边沿中断通知电压下降和恢复 */
+    PWR_PVDLevelConfig(POWER_PVD_LEVEL);
+    PWR_PVDCmd(ENABLE);
+    EXTI_ClearITPendingBit(EXTI_Line16);
+    EXTI_InitStructure.EXTI_Line = EXTI_Line16;
+    EXTI_InitStructure.EXTI_Mode = EXTI_Mode_Interrupt;
+    EXTI_InitStructure.EXTI_Trigger = EXTI_Trigger_Rising_Falling;
+    EXTI_InitStructure.EXTI_LineCmd = ENABLE;
+    EXTI_Init(&EXTI_InitStructure);
+
+    /* 投递事件的中断抢占优先级相同（见Event_Post），响应优先级最高 */
+    NVIC_InitStructure.NVIC_IRQChannel = PVD_IRQn;
+    NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+    NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = 1;
+    NVIC_InitStructure.NVIC_IRQChannelSubPriority = 0;
+    NVIC_Init(&NVIC_InitStructure);
+
+    Power_ResetStats();
+    Kernel_SetIdleHook(Power_Idle);
+}
+
+/**
+  * @brief  空闲钩子，由空闲线程调用，按下一个唤醒时刻进入睡眠或停机模式
+  * @param  None
+  * @retval None
+  * @note   关中断后进入休眠，挂起的中断仍能唤醒内核，补计完时间后开中断才进入中断处理
+  */
+void Power_Idle(void)
+{
+    uint32_t now, next, idle_ms;
+
+    __disable_irq();
+    now = Scheduler_GetTick();
+    if (!Kernel_GetNextWake(&next) || next - now > POWER_MAX_IDLE_MS)
+    {
+        next = now + POWER_MAX_IDLE_MS;
+    }
+
+    /* 已到期的线程由下一个SysTick中断唤醒 */
+    idle_ms = (next - now) ? (next - now) : 1;
+
+    if (!power_stop_enabled || !Power_EnterStop(idle_ms))
+    {
+        Power_EnterSleep(idle_ms);
+    }
+    __enable_irq();
+}
+
+/**
+  * @brief  打开或关闭停机模式
+  * @param  enable: 1: 允许进入停机模式，0: 只使用睡眠模式
+  * @retval None
+  */
+void Power_SetStopEnabled(uint8_t enable)
+{
+    power_stop_enabled = enable ? 1 : 0;
+}
+
+/**
+  * @brief  查询是否允许进入停机模式
+  * @param  None
+  * @retval 1: 允许，0: 不允许
+  */
+uint8_t Power_IsStopEnabled(void)
+{
+    return power_stop_enabled;
+}
+
+/**
+  * @brief  计算千分比
+  * @param  part: 部分
+  * @param  whole: 总数
+  * @retval part占whole的千分比
+  */
+static uint32_t Power_Permille(uint32_t part, uint32_t whole)
+{
+    return whole ? (uint32_t)((uint64_t)part * 1000 / whole) : 0;
+}
+
+/**
+  * @brief  通过串口输出运行/睡眠/停机时间占比、唤醒延迟和估算平均电流
+  * @param  None
+  * @retval None
+  * @note   估算电流只包含MCU本身，按数据手册典型值计算，用于估算备用电池容量
+  */
+void Power_ReportStats(void)
+{
+    uint32_t window_ms, sleep_ms, stop_ms, run_ms;
+    uint32_t sleep_count, stop_count, alarm_wakes, denied;
+    uint32_t wake_min, wake_max, wake_total, clock_max;
+    uint32_t avg_ua;
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    window_ms = Scheduler_GetTick() - power_stats_start;
+    sleep_ms = (uint32_t)(power_sleep_us / 1000);
+    stop_ms = (uint32_t)(power_stop_us / 1000);
+    sleep_count = power_sleep_count;
+    stop_count = power_stop_count;
+    alarm_wakes = power_stop_alarm_wakes;
+    denied = power_stop_denied;
+    wake_min = power_wake_min_us;
+    wake_max = power_wake_max_us;
+    wake_total = power_wake_total_us;
+    clock_max = power_clock_max_us;
+    __set_PRIMASK(primask);
+
+    run_ms = (sleep_ms + stop_ms < window_ms) ? window_ms - sleep_ms - stop_ms : 0;
+
+    Serial_Printf("[POWER] Stop mode: %s, max idle %u ms, serial holdoff %u ms\n",
+                  power_stop_enabled ? "enabled" : "disabled", POWER_MAX_IDLE_MS, POWER_SERIAL_HOLDOFF_MS);
+
+    Serial_Printf("[POWER] Window %lu ms | Run %lu ms (%lu.%lu%%) | Sleep %lu ms (%lu.%lu%%) | Stop %lu ms (%lu.%lu%%)\n",
+                  window_ms,
+                  run_ms, Power_Permille(run_ms, window_ms) / 10, Power_Permille(run_ms, window_ms) % 10,
+                  sleep_ms, Power_Permille(sleep_ms, window_ms) / 10, Power_Permille(sleep_ms, window_ms) % 10,
+                  stop_ms, Power_Permille(stop_ms, window_ms) / 10, Power_Permille(stop_ms, window_ms) % 10);
+
+    Serial_Printf("[POWER] Sleeps %lu | Stops %lu (RTC alarm %lu, external %lu) | Stops denied by serial %lu\n",
+                  sleep_count, stop_count, alarm_wakes, stop_count - alarm_wakes, denied);
+    Serial_Printf("[POWER] Supply: %s, %lu drops below the PVD threshold\n",
+                  (PWR_GetFlagStatus(PWR_FLAG_PVDO) == SET) ? "low" : "OK", power_pvd_count);
+    if (stop_count > 0)
+    {
+        Serial_Printf("[POWER] Stop wake-to-handler: min %lu us, avg %lu us, max %lu us (clock restore max %lu us)\n",
+                      wake_min, wake_total / stop_count, wake_max, clock_max);
+    }
+
+    if (window_ms > 0)
+    {
+        avg_ua = (uint32_t)(((uint64_t)run_ms * POWER_RUN_UA + (uint64_t)sleep_ms * POWER_SLEEP_UA +
+                             (uint64_t)stop_ms * POWER_STOP_UA) / window_ms);
+        Serial_Printf("[POWER] Estimated MCU average current %lu uA, %lu h per 1000 mAh (typ. run %u uA, sleep %u uA, stop %u uA)\n",
+                      avg_ua, avg_ua ? 1000000UL / avg_ua : 0UL, POWER_RUN_UA, POWER_SLEEP_UA, POWER_STOP_UA);
+    }
+}
+
+/**
+  * @brief  清除低功耗统计，重新开始计时
+  * @param  None
+  * @retval None
+  */
+void Power_ResetStats(void)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    power_stats_start = Scheduler_GetTick();
+    power_sleep_us = 0;
+    power_stop_us = 0;
+    power_sleep_count = 0;
+    power_stop_count = 0;
+    power_stop_alarm_wakes = 0;
+    power_stop_denied = 0;
+    power_wake_min_us = 0xFFFFFFFF;
+    power_wake_max_us = 0;
+    power_wake_total_us = 0;
+    power_clock_max_us = 0;
+    power_pvd_count = 0;
+    __set_PRIMASK(primask);
+}
+
+/**
+  * @brief  RTC闹钟（EXTI17）中断函数，只用于从停机模式唤醒
+  * @param  None
+  * @retval None
+  * @note   RTC的闹钟标志由RTC_IRQHandler清除
+  */
+void RTCAlarm_IRQHandler(void)
+{
+    EXTI_ClearITPendingBit(EXTI_Line17);
+}
+
+/**
+  * @brief  PVD（EXTI16）中断函数，电源电压越过阈值时投递EVENT_POWER_LOW
+  * @param  None
+  * @retval None
+  * @note   由alarm线程立即写入记录日志的页缓冲，掉电前保存最近的记录
+  */
+void PVD_IRQHandler(void)
+{
+    uint8_t low;
+
+    if (EXTI_GetITStatus(EXTI_Line16) != RESET)
+    {
+        low = (PWR_GetFlagStatus(PWR_FLAG_PVDO) == SET) ? 1 : 0;
+        if (low)
+        {
+            power_pvd_count++;
+        }
+        Event_Post(EVENT_POWER_LOW, low);
+        EXTI_ClearITPendingBit(EXTI_Line16);
+    }
+}
@@ -0,0 +1,83 @@
+#ifndef __POWER_H
+#define __POWER_H
+
+#include "stm32f10x.h"
+
+/**
+  * 低功耗空闲（tickless idle）
+  *
+  * 空闲线程通过空闲钩子调用Power_Idle，按最早的线程唤醒时刻（定时器服务线程的
+  * 等待超时即下一个定时器到期时刻）决定休眠时长：
+  * 1. 睡眠模式：把SysTick重新装载为整个空闲时长，期间不再每1ms唤醒一次
+  * 2. 停机模式（需用Power_SetStopEnabled打开）：空闲窗口内包含RTC秒边界时，
+  *    用RTC闹钟（EXTI17）在最后一个秒边界唤醒，其余时间仍按睡眠模式处理。
+  *    F1的RTC闹钟只能以秒为单位，红外（EXTI1）和编码器按键（EXTI10）也可唤醒。
+  *    串口接收引脚PA10与按键PB10共用EXTI10，停机期间串口不能唤醒，
+  *    因此最近有串口接收或仍在发送时不进入停机模式
+  * 可编程电压监测器（PVD）在电源电压低于POWER_PVD_LEVEL时投递EVENT_POWER_LOW，
+  * 记录日志据此立即写入页缓冲
+  */
+
+/* 单次休眠的最长时间（ms），停机期间独立看门狗仍在计数，需留出喂狗余量 */
+#define POWER_MAX_IDLE_MS           800
+
+/* 停机时长不足此值（ms）时只进入睡眠模式 */
+#define POWER_STOP_MIN_MS           20
+
+/* 停机唤醒后恢复HSE和PLL所需的余量（ms），闹钟提前这么多唤醒 */
+#define POWER_STOP_MARGIN_MS        3
+
+/* 串口最近一次接收后的这段时间（ms）内不进入停机模式 */
+#define POWER_SERIAL_HOLDOFF_MS     10000
+
+/* PVD阈值：2.9V，W25Q64在2.7V以上仍可编程，电压下降到掉电之间留有写入时间 */
+#define POWER_PVD_LEVEL             PWR_PVDLevel_2V9
+
+/* 估算平均电流用的典型值（uA，STM32F103数据手册，72MHz外设全开，3.3V） */
+#define POWER_RUN_UA                36000
+#define POWER_SLEEP_UA              14400
+#define POWER_STOP_UA               14
+
+/**
+  * @brief  低功耗初始化，配置RTC闹钟唤醒并安装空闲钩子，应在RTC_Init之后调用
+  * @param  None
+  * @retval None
+  */
+void Power_Init(void);
+
+/**
+  * @brief  空闲钩子，由空闲线程调用，按下一个唤醒时刻进入睡眠或停机模式
+  * @param  None
+  * @retval None
+  */
+void Power_Idle(void);
+
+/**
+  * @brief  打开或关闭停机模式
+  * @param  enable: 1: 允许进入停机模式，0: 只使用睡眠模式
+  * @retval None
+  */
+void Power_SetStopEnabled(uint8_t enable);
+
+/**
+  * @brief  查询是否允许进入停机模式
+  * @param  None
+  * @retval 1: 允许，0: 不允许
+  */
+uint8_t Power_IsStopEnabled(void);
+
+/**
+  * @brief  通过串口输出运行/睡眠/停机时间占比、唤醒延迟和估算平均电流
+  * @param  None
+  * @retval None
+  */
+void Power_ReportStats(void);
+
+/**
+  * @brief  清除低功耗统计，重新开始计时
+  * @param  None
+  * @retval None
+  */
+void Power_ResetStats(void);
+
+#endif /* __POWER_H */
@@ -1,4 +1,6 @@
 #include "RTC.h"
+#include "Event.h"
+#include "Trace.h"
 
 /**
   * @brief  检查年份是否为闰年
@@ -87,6 +89,36 @@ void RTC_Init(void) {
         /* 写入备份寄存器，标记RTC已初始化 */
         BKP_WriteBackupRegister(BKP_DR1, 0xA5A5);
     }
+    
+    /* 使能RTC秒中断，每秒投递一次EVENT_RTC_TICK事件 */
+    RTC_ITConfig(RTC_IT_SEC, ENABLE);
+    RTC_WaitForLastTask();
+    
+    NVIC_InitTypeDef NVIC_InitStructure;
+    NVIC_InitStructure.NVIC_IRQChannel = RTC_IRQn;
+    NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+    NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = 1; /* 与其他投递事件的中断相同 */
+    NVIC_InitStructure.NVIC_IRQChannelSubPriority = 2;
+    NVIC_Init(&NVIC_InitStructure);
+}
+
+/**
+  * @brief  RTC中断函数，秒中断时投递EVENT_RTC_TICK事件
+  * @param  None
+  * @retval None
+  * @note   闹钟中断用于从停机模式唤醒（见Power.c），这里只清除标志，避免中断反复进入
+  */
+void RTC_IRQHandler(void) {
+    if (RTC_GetITStatus(RTC_IT_SEC) != RESET) {
+        TRACE(TRACE_EV_RTC_ISR, 0);
+        Event_Post(EVENT_RTC_TICK, 0);
+        RTC_ClearITPendingBit(RTC_IT_SEC);
+        RTC_WaitForLastTask();
+    }
+    if (RTC_GetITStatus(RTC_IT_ALR) != RESET) {
+        RTC_ClearITPendingBit(RTC_IT_ALR);
+        RTC_WaitForLastTask();
+    }
 }
 
 /**
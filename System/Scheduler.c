@@ -0,0 +1,222 @@
+#include "Scheduler.h"
+#include "Serial.h"
+#include "Kernel.h"
+#include "Delay.h"
+#include "Supervisor.h"
+
+/* 毫秒计数，由SysTick中断递增 */
+static volatile uint32_t scheduler_ticks = 0;
+
+/* 任务表 */
+static Scheduler_Task_t scheduler_tasks[SCHEDULER_MAX_TASKS];
+static uint8_t scheduler_task_count = 0;
+
+/**
+  * @brief  任务的周期定时器回调，释放任务
+  * @param  arg: 任务
+  * @retval None
+  * @note   上一次释放尚未运行时保留原释放时刻，超时由截止时间统计体现
+  */
+static void Scheduler_Release(void *arg)
+{
+    Scheduler_Task_t *task = (Scheduler_Task_t *)arg;
+
+    if (!task->released)
+    {
+        task->release = scheduler_ticks;
+        task->released = 1;
+    }
+}
+
+/**
+  * @brief  调度器初始化，启动SysTick作为1ms时基，并初始化定时器服务
+  * @param  None
+  * @retval None
+  */
+void Scheduler_Init(void)
+{
+    scheduler_ticks = 0;
+    scheduler_task_count = 0;
+    Timer_Init();
+
+    /* SysTick每1ms中断一次，中断优先级为最低 */
+    SysTick_Config(SystemCoreClock / 1000);
+}
+
+/**
+  * @brief  注册周期任务
+  * @param  name: 任务名称
+  * @param  func: 任务函数
+  * @param  period_ms: 周期（ms）
+  * @param  deadline_ms: 相对截止时间（ms），应不大于周期
+  * @param  critical: 1: 超期未完成时停止喂狗，0: 只记录
+  * @retval 0: 成功，1: 任务表已满
+  * @note   任务同时注册为截止时间监控作业，两次完成之间允许的最大间隔为周期加相对截止时间
+  */
+uint8_t Scheduler_AddTask(const char *name, Scheduler_TaskFunc func, uint32_t period_ms, uint32_t deadline_ms, uint8_t critical)
+{
+    Scheduler_Task_t *task;
+
+    if (scheduler_task_count >= SCHEDULER_MAX_TASKS)
+    {
+        return 1;
+    }
+
+    task = &scheduler_tasks[scheduler_task_count++];
+    task->name = name;
+    task->func = func;
+    task->period = period_ms;
+    task->deadline = deadline_ms;
+    task->released = 0;
+    task->run_count = 0;
+    task->total_us = 0;
+    task->max_us = 0;
+    task->max_latency = 0;
+    task->deadline_miss = 0;
+    task->supervisor_job = Supervisor_Register(name, period_ms + deadline_ms, critical);
+
+    /* 注册后在下一个tick释放第一次 */
+    Timer_Setup(&task->timer, name, Scheduler_Release, task);
+    Timer_Start(&task->timer, 0, period_ms);
+
+    return 0;
+}
+
+/**
+  * @brief  获取自启动以来的毫秒数（自由运行，约49.7天回绕）
+  * @param  None
+  * @retval 毫秒计数值
+  */
+uint32_t Scheduler_GetTick(void)
+{
+    return scheduler_ticks;
+}
+
+/**
+  * @brief  补计SysTick暂停或延长期间经过的毫秒数
+  * @param  ticks: 经过的毫秒数
+  * @retval None
+  * @note   由低功耗空闲处理在关中断时调用，补计的时间不超过最早的唤醒时刻，不需要处理到期事件
+  */
+void Scheduler_StepTicks(uint32_t ticks)
+{
+    scheduler_ticks += ticks;
+}
+
+/**
+  * @brief  执行所有已释放的任务，按绝对截止时间先后运行
+  * @param  None
+  * @retval None
+  * @note   任务由各自的周期定时器释放，调用前应先执行Timer_Run
+  */
+void Scheduler_Dispatch(void)
+{
+    while (1)
+    {
+        Scheduler_Task_t *task = 0;
+        uint32_t now = scheduler_ticks;
+        uint32_t start_us, elapsed_us, finish;
+        uint8_t i;
+
+        /* 在已释放的任务中选出绝对截止时间最早的一个 */
+        for (i = 0; i < scheduler_task_count; i++)
+        {
+            Scheduler_Task_t *t = &scheduler_tasks[i];
+            if (!t->released)
+            {
+                continue;
+            }
+            if (task == 0 ||
+                (int32_t)((t->release + t->deadline) - (task->release + task->deadline)) < 0)
+            {
+                task = t;
+            }
+        }
+        if (task == 0)
+        {
+            return;
+        }
+
+        if (now - task->release > task->max_latency)
+        {
+            task->max_latency = now - task->release;
+        }
+
+        start_us = Delay_Micros();
+        task->func();
+        elapsed_us = Delay_Micros() - start_us;
+        finish = scheduler_ticks;
+
+        task->run_count++;
+        task->total_us += elapsed_us;
+        if (elapsed_us > task->max_us)
+        {
+            task->max_us = elapsed_us;
+        }
+        if ((int32_t)(finish - (task->release + task->deadline)) > 0)
+        {
+            task->deadline_miss++;
+        }
+        task->released = 0;
+        Supervisor_CheckIn(task->supervisor_job);
+    }
+}
+
+/**
+  * @brief  通过串口输出各任务运行统计
+  * @param  None
+  * @retval None
+  */
+void Scheduler_ReportStats(void)
+{
+    uint8_t i;
+
+    Serial_Printf("[TASKS] Uptime: %lu ms\n", scheduler_ticks);
+    Serial_Printf("[TASKS] Name | Period | Deadline | Runs | Avg us | Max us | Max lat ms | Misses\n");
+    for (i = 0; i < scheduler_task_count; i++)
+    {
+        Scheduler_Task_t *task = &scheduler_tasks[i];
+        Serial_Printf("[TASKS] %s | %lu | %lu | %lu | %lu | %lu | %lu | %lu\n",
+                      task->name, task->period, task->deadline, task->run_count,
+                      task->run_count ? task->total_us / task->run_count : 0,
+                      task->max_us, task->max_latency, task->deadline_miss);
+    }
+}
+
+/**
+  * @brief  清除各任务运行统计
+  * @param  None
+  * @retval None
+  */
+void Scheduler_ResetStats(void)
+{
+    uint8_t i;
+
+    for (i = 0; i < scheduler_task_count; i++)
+    {
+        scheduler_tasks[i].run_count = 0;
+        scheduler_tasks[i].total_us = 0;
+        scheduler_tasks[i].max_us = 0;
+        scheduler_tasks[i].max_latency = 0;
+        scheduler_tasks[i].deadline_miss = 0;
+    }
+}
+
+/**
+  * @brief  SysTick中断函数，提供1ms时基
+  * @param  None
+  * @retval None
+  */
+void SysTick_Handler(void)
+{
+    scheduler_ticks++;
+    
+    /* 定期读取周期计数，使64位扩展能检测到CYCCNT回绕 */
+    Delay_GetCycles64();
+    
+    /* 截止时间监控，所有关键作业按时签到时喂狗 */
+    Supervisor_Tick();
+    
+    /* 唤醒延时到期的线程 */
+    Kernel_Tick();
+}
@@ -0,0 +1,90 @@
+#ifndef __SCHEDULER_H
+#define __SCHEDULER_H
+
+#include "stm32f10x.h"
+#include "Timer.h"
+
+/* 最大任务数 */
+#define SCHEDULER_MAX_TASKS     8
+
+/**
+  * @brief  任务函数类型
+  */
+typedef void (*Scheduler_TaskFunc)(void);
+
+/**
+  * @brief  任务控制块
+  */
+typedef struct {
+    const char *name;           /* 任务名称 */
+    Scheduler_TaskFunc func;    /* 任务函数 */
+    uint32_t period;            /* 周期（ms） */
+    uint32_t deadline;          /* 相对截止时间（ms，从释放时刻起算） */
+    Timer_t timer;              /* 周期定时器，到期时释放任务 */
+    uint32_t release;           /* 本次释放时刻（ms） */
+    uint8_t released;           /* 1: 已释放，等待运行 */
+    uint8_t supervisor_job;     /* 截止时间监控作业号，每次运行完成时签到 */
+    uint32_t run_count;         /* 运行次数 */
+    uint32_t total_us;          /* 累计运行时间（us） */
+    uint32_t max_us;            /* 单次最长运行时间（us） */
+    uint32_t max_latency;       /* 最大启动延迟（ms，从释放到开始运行） */
+    uint32_t deadline_miss;     /* 错过截止时间的次数 */
+} Scheduler_Task_t;
+
+/**
+  * @brief  调度器初始化，启动SysTick作为1ms时基，并初始化定时器服务
+  * @param  None
+  * @retval None
+  */
+void Scheduler_Init(void);
+
+/**
+  * @brief  注册周期任务
+  * @param  name: 任务名称
+  * @param  func: 任务函数
+  * @param  period_ms: 周期（ms）
+  * @param  deadline_ms: 相对截止时间（ms），应不大于周期
+  * @param  critical: 1: 超期未完成时停止喂狗，0: 只记录
+  * @retval 0: 成功，1: 任务表已满
+  * @note   任务同时注册为截止时间监控作业，两次完成之间允许的最大间隔为周期加相对截止时间
+  */
+uint8_t Scheduler_AddTask(const char *name, Scheduler_TaskFunc func, uint32_t period_ms, uint32_t deadline_ms, uint8_t critical);
+
+/**
+  * @brief  获取自启动以来的毫秒数（自由运行，约49.7天回绕）
+  * @param  None
+  * @retval 毫秒计数值
+  */
+uint32_t Scheduler_GetTick(void);
+
+/**
+  * @brief  补计SysTick暂停或延长期间经过的毫秒数
+  * @param  ticks: 经过的毫秒数
+  * @retval None
+  * @note   由低功耗空闲处理在关中断时调用，补计的时间不超过最早的唤醒时刻，不需要处理到期事件
+  */
+void Scheduler_StepTicks(uint32_t ticks);
+
+/**
+  * @brief  执行所有已释放的任务，按绝对截止时间先后运行
+  * @param  None
+  * @retval None
+  * @note   任务由各自的周期定时器释放，调用前应先执行Timer_Run
+  */
+void Scheduler_Dispatch(void);
+
+/**
+  * @brief  通过串口输出各任务运行统计
+  * @param  None
+  * @retval None
+  */
+void Scheduler_ReportStats(void);
+
+/**
+  * @brief  清除各任务运行统计
+  * @param  None
+  * @retval None
+  */
+void Scheduler_ResetStats(void);
+
+#endif /* __SCHEDULER_H */
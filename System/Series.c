@@ -0,0 +1,767 @@
+#include "Series.h"
+#include "Kernel.h"
+#include "Serial.h"
+#include "RTC.h"
+#include <string.h>
+
+/* 采样区的Flash地址 */
+#define SERIES_AREA_ADDR            ((uint32_t)SERIES_FIRST_SECTOR * W25Q64_SECTOR_SIZE)
+
+/* 采样区内第index页的Flash地址，第seq页的index为(seq - 1) % SERIES_PAGE_COUNT */
+#define SERIES_INDEX_ADDR(index)    (SERIES_AREA_ADDR + (uint32_t)(index) * W25Q64_PAGE_SIZE)
+#define SERIES_PAGE_ADDR(seq)       SERIES_INDEX_ADDR(((seq) - 1) % SERIES_PAGE_COUNT)
+
+/* 页头读取结果 */
+#define SERIES_PAGE_VALID           0
+#define SERIES_PAGE_ERASED          1
+#define SERIES_PAGE_INVALID         2
+
+/**
+  * @brief  页：页头和位流，整页编程
+  */
+typedef struct {
+    Series_Header_t header;
+    uint8_t data[SERIES_DATA_SIZE];
+} Series_Page_t;
+
+/* 两个页缓冲交替使用：一页编码时另一页等待编程；header.seq为0表示缓冲区未使用 */
+static Series_Page_t series_pages[2];
+static uint8_t series_open = 0;                 /* 正在编码的页缓冲 */
+static uint8_t series_page_open = 0;            /* 1: 正在编码的页缓冲中有未结束的页 */
+static uint8_t series_pending = 0;              /* 1: 另一个页缓冲中已结束的页等待加入编程 */
+static uint8_t series_enabled = 0;
+
+/* 编码状态：前一个样本 */
+static uint32_t series_last_time;
+static int32_t series_last_delta;
+static uint8_t series_last_temp;
+static uint8_t series_last_humi;
+
+/* 写入位置 */
+static uint32_t series_next_page = 1;           /* 下一页的序号 */
+static uint32_t series_first_page = 1;          /* 最早保留的页序号 */
+
+/* 读出位置，只在bulk线程中使用 */
+static Series_Page_t series_read;               /* 读出的页，header.count为0表示需要读取下一页 */
+static uint32_t series_read_page;               /* 下一个读取的页序号 */
+static uint32_t series_read_end;                /* Series_Seek时的下一页序号 */
+static uint32_t series_read_skip;               /* 开头跳过的样本数 */
+static uint32_t series_read_left;               /* 剩余的样本数 */
+static uint16_t series_read_index;              /* 下一个样本的页内序号 */
+static uint16_t series_read_bit;                /* 下一个位在位流中的位置 */
+static Series_Sample_t series_read_sample;      /* 前一个样本 */
+static int32_t series_read_delta;               /* 前一个样本的时间间隔 */
+
+/* 写入统计 */
+static uint32_t series_sample_count = 0;        /* 追加的样本数 */
+static uint32_t series_bit_count = 0;           /* 差值位流的位数（不含页头中的第一个样本） */
+static uint32_t series_page_count = 0;          /* 结束的页数 */
+static uint32_t series_sync_count = 0;          /* 未写满提前结束的页数 */
+static uint32_t series_erase_count = 0;         /* 扇区擦除次数 */
+static uint32_t series_dropped = 0;             /* 两个页缓冲都未写入时丢弃的样本数 */
+static uint32_t series_buffer_waits = 0;        /* 启用页缓冲时其中的页仍在编程的次数 */
+static uint32_t series_invalid = 0;             /* 读出时CRC错误的页数 */
+static uint32_t series_stat_first = 0;          /* 统计开始后第一个和最后一个样本的时间戳 */
+static uint32_t series_stat_last = 0;
+
+/* sensor线程追加，bulk线程写入和读出，alarm线程在电压下降时写入 */
+static Kernel_Mutex_t series_mutex;
+
+/**
+  * @brief  zig-zag映射：0, -1, 1, -2, 2...映射为0, 1, 2, 3, 4...
+  * @param  value: 有符号数
+  * @retval 无符号数
+  */
+static uint32_t Series_ZigZag(int32_t value)
+{
+    return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+/**
+  * @brief  zig-zag逆映射
+  * @param  value: 无符号数
+  * @retval 有符号数
+  */
+static int32_t Series_UnZigZag(uint32_t value)
+{
+    return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+/**
+  * @brief  计算变长编码的位数
+  * @param  value: zig-zag映射后的值
+  * @retval 位数：0为1位，非0为1位加每3位数值4位
+  */
+static uint8_t Series_CodeBits(uint32_t value)
+{
+    uint8_t bits = 1;
+
+    while (value != 0)
+    {
+        bits += 4;
+        value >>= 3;
+    }
+    return bits;
+}
+
+/**
+  * @brief  向页的位流追加若干位，高位在前（位流初始为0）
+  * @param  page: 页缓冲
+  * @param  value: 数值
+  * @param  count: 位数
+  * @retval None
+  */
+static void Series_PutBits(Series_Page_t *page, uint32_t value, uint8_t count)
+{
+    uint16_t bit = page->header.bits;
+
+    while (count-- > 0)
+    {
+        if ((value >> count) & 1)
+        {
+            page->data[bit >> 3] |= 0x80 >> (bit & 7);
+        }
+        bit++;
+    }
+    page->header.bits = bit;
+}
+
+/**
+  * @brief  向页的位流追加一个变长编码
+  * @param  page: 页缓冲
+  * @param  value: zig-zag映射后的值
+  * @retval None
+  */
+static void Series_PutCode(Series_Page_t *page, uint32_t value)
+{
+    Series_PutBits(page, value != 0, 1);
+    while (value != 0)
+    {
+        Series_PutBits(page, value & 7, 3);
+        value >>= 3;
+        Series_PutBits(page, value != 0, 1);
+    }
+}
+
+/**
+  * @brief  从读出的页中读取若干位，超出位流时读出0
+  * @param  count: 位数
+  * @retval 数值
+  */
+static uint32_t Series_GetBits(uint8_t count)
+{
+    uint32_t value = 0;
+
+    while (count-- > 0)
+    {
+        value <<= 1;
+        if (series_read_bit < series_read.header.bits &&
+            (series_read.data[series_read_bit >> 3] & (0x80 >> (series_read_bit & 7))))
+        {
+            value |= 1;
+        }
+        series_read_bit++;
+    }
+    return value;
+}
+
+/**
+  * @brief  从读出的页中读取一个变长编码
+  * @param  None
+  * @retval zig-zag映射后的值
+  */
+static uint32_t Series_GetCode(void)
+{
+    uint32_t value = 0;
+    uint8_t shift = 0;
+
+    if (Series_GetBits(1))
+    {
+        do
+        {
+            value |= Series_GetBits(3) << shift;
+            shift += 3;
+        } while (Series_GetBits(1) && shift < 32);
+    }
+    return value;
+}
+
+/**
+  * @brief  读取并检查采样区内第index页的页头（不校验CRC）
+  * @param  index: 采样区内的页号
+  * @param  header: 用于存放页头的指针
+  * @retval SERIES_PAGE_VALID/ERASED/INVALID
+  */
+static uint8_t Series_ReadHeader(uint32_t index, Series_Header_t *header)
+{
+    const uint8_t *p = (const uint8_t *)header;
+    uint8_t i;
+
+    W25Q64_ReadBytes(SERIES_INDEX_ADDR(index), (uint8_t *)header, sizeof(Series_Header_t));
+
+    for (i = 0; i < sizeof(Series_Header_t) && p[i] == 0xFF; i++)
+    {
+    }
+    if (i == sizeof(Series_Header_t))
+    {
+        return SERIES_PAGE_ERASED;
+    }
+    if (header->seq == 0 || header->seq == 0xFFFFFFFF || header->count == 0 ||
+        header->bits > SERIES_DATA_BITS || (header->seq - 1) % SERIES_PAGE_COUNT != index)
+    {
+        return SERIES_PAGE_INVALID;
+    }
+    return SERIES_PAGE_VALID;
+}
+
+/**
+  * @brief  查找仍保存着某页的页缓冲，调用时持有series_mutex
+  * @param  seq: 页序号
+  * @retval 页缓冲，不在内存中时为0
+  * @note   页结束后内容不再修改，页缓冲重新启用之前与Flash中的内容相同
+  */
+static const Series_Page_t *Series_FindBuffer(uint32_t seq)
+{
+    uint8_t i;
+
+    for (i = 0; i < 2; i++)
+    {
+        if (series_pages[i].header.seq == seq)
+        {
+            return &series_pages[i];
+        }
+    }
+    return 0;
+}
+
+/**
+  * @brief  用一个样本启用新的一页，调用时持有series_mutex
+  * @param  time: 时间戳
+  * @param  temp: 温度
+  * @param  humi: 湿度
+  * @retval None
+  */
+static void Series_Open(uint32_t time, uint8_t temp, uint8_t humi)
+{
+    Series_Page_t *page = &series_pages[series_open];
+
+    /*页缓冲中上一页的编程通常早已完成*/
+    if (W25Q64_IsQueued((const uint8_t *)page, sizeof(Series_Page_t)))
+    {
+        series_buffer_waits++;
+        W25Q64_Sync();
+    }
+
+    memset(page->data, 0, sizeof(page->data));
+    page->header.crc = 0xFFFF;
+    page->header.count = 1;
+    page->header.seq = series_next_page++;
+    page->header.time = time;
+    page->header.temp = temp;
+    page->header.humi = humi;
+    page->header.bits = 0;
+    series_page_open = 1;
+
+    series_last_time = time;
+    series_last_delta = 0;
+    series_last_temp = temp;
+    series_last_humi = humi;
+}
+
+/**
+  * @brief  结束当前页，计算CRC后交给bulk线程编程，调用时持有series_mutex且没有等待编程的页
+  * @param  None
+  * @retval None
+  */
+static void Series_Close(void)
+{
+    Series_Page_t *page = &series_pages[series_open];
+
+    page->header.crc = W25Q64_CalculateCRC16((const uint8_t *)page + sizeof(page->header.crc),
+                                             sizeof(Series_Page_t) - sizeof(page->header.crc));
+    series_page_open = 0;
+    series_pending = 1;
+    series_open ^= 1;
+    series_page_count++;
+}
+
+/**
+  * @brief  把等待编程的页加入操作队列，页位于扇区开头时先擦除该扇区，调用时持有series_mutex
+  * @param  None
+  * @retval None
+  */
+static void Series_Write(void)
+{
+    const Series_Page_t *page = &series_pages[series_open ^ 1];
+    uint32_t seq = page->header.seq;
+
+    if (!series_pending)
+    {
+        return;
+    }
+
+    if ((seq - 1) % SERIES_PAGES_PER_SECTOR == 0)
+    {
+        /*覆盖上一轮写入的扇区，之后的扇区成为最早的扇区*/
+        if (seq + SERIES_PAGES_PER_SECTOR > SERIES_PAGE_COUNT + series_first_page)
+        {
+            series_first_page = seq + SERIES_PAGES_PER_SECTOR - SERIES_PAGE_COUNT;
+        }
+        W25Q64_QueueErase(SERIES_PAGE_ADDR(seq));
+        series_erase_count++;
+    }
+    W25Q64_QueueProgram(SERIES_PAGE_ADDR(seq), (const uint8_t *)page, W25Q64_PAGE_SIZE);
+    series_pending = 0;
+}
+
+/**
+  * @brief  提前结束当前页并加入编程，调用时持有series_mutex
+  * @param  None
+  * @retval None
+  */
+static void Series_Flush(void)
+{
+    Series_Write();
+    if (series_page_open)
+    {
+        Series_Close();
+        series_sync_count++;
+        Series_Write();
+    }
+}
+
+/**
+  * @brief  从Flash内容恢复写入位置，在W25Q64_Init之后调用
+  * @param  None
+  * @retval 下一页的序号，1表示采样区为空
+  * @note   每个扇区第0页的序号为上一个扇区第0页的序号加SERIES_PAGES_PER_SECTOR，
+  *         本轮写入的扇区在前，二分查找只需读取约log2(扇区数)个页头
+  */
+uint32_t Series_Init(void)
+{
+    Series_Header_t header;
+    uint32_t base;
+    uint16_t lo, hi, mid;
+
+    series_open = 0;
+    series_page_open = 0;
+    series_pending = 0;
+    series_pages[0].header.seq = 0;
+    series_pages[1].header.seq = 0;
+    series_read.header.count = 0;
+    series_read_left = 0;
+    series_next_page = 1;
+    series_first_page = 1;
+
+    /*二分查找写入扇区：第0页序号与0号扇区连续的最后一个扇区*/
+    if (Series_ReadHeader(0, &header) == SERIES_PAGE_VALID)
+    {
+        base = header.seq;
+        lo = 0;
+        hi = SERIES_SECTOR_COUNT;
+        while (hi - lo > 1)
+        {
+            mid = (lo + hi) / 2;
+            if (Series_ReadHeader((uint32_t)mid * SERIES_PAGES_PER_SECTOR, &header) == SERIES_PAGE_VALID &&
+                header.seq == base + (uint32_t)mid * SERIES_PAGES_PER_SECTOR)
+            {
+                lo = mid;
+            }
+            else
+            {
+                hi = mid;
+            }
+        }
+    }
+    else if (Series_ReadHeader((uint32_t)(SERIES_SECTOR_COUNT - 1) * SERIES_PAGES_PER_SECTOR, &header) ==
+             SERIES_PAGE_VALID)
+    {
+        /*启用0号扇区时掉电，写入扇区为最后一个扇区*/
+        lo = SERIES_SECTOR_COUNT - 1;
+    }
+    else
+    {
+        /*采样区为空，第一页写入0号扇区*/
+        return series_next_page;
+    }
+
+    Series_ReadHeader((uint32_t)lo * SERIES_PAGES_PER_SECTOR, &header);
+    base = header.seq;
+
+    /*二分查找写入扇区中第一个空页，写了一半的页不是空页，其序号不再使用*/
+    hi = SERIES_PAGES_PER_SECTOR;
+    mid = 1;
+    while (mid < hi)
+    {
+        uint16_t page = (mid + hi) / 2;
+
+        if (Series_ReadHeader((uint32_t)lo * SERIES_PAGES_PER_SECTOR + page, &header) == SERIES_PAGE_ERASED)
+        {
+            hi = page;
+        }
+        else
+        {
+            mid = page + 1;
+        }
+    }
+    series_next_page = base + mid;
+
+    /*采样区已循环时，写入扇区之后的扇区为最早的扇区*/
+    if (base + SERIES_PAGES_PER_SECTOR > SERIES_PAGE_COUNT + 1)
+    {
+        series_first_page = base + SERIES_PAGES_PER_SECTOR - SERIES_PAGE_COUNT;
+    }
+    return series_next_page;
+}
+
+/**
+  * @brief  打开或关闭采样流，关闭时把当前页加入编程
+  * @param  enable: 1: 打开，0: 关闭
+  * @retval None
+  */
+void Series_Enable(uint8_t enable)
+{
+    Kernel_MutexLock(&series_mutex);
+    series_enabled = enable ? 1 : 0;
+    if (!series_enabled)
+    {
+        Series_Flush();
+    }
+    Kernel_MutexUnlock(&series_mutex);
+}
+
+/**
+  * @brief  获取采样流是否打开
+  * @param  None
+  * @retval 1: 打开，0: 关闭
+  */
+uint8_t Series_IsEnabled(void)
+{
+    return series_enabled;
+}
+
+/**
+  * @brief  追加一个样本（sensor线程调用），采样流关闭时忽略
+  * @param  time: 时间戳（RTC秒数）
+  * @param  temp: 温度（°C）
+  * @param  humi: 湿度（%）
+  * @retval 1: 写满一页，需要唤醒bulk线程调用Series_Poll，0: 其他
+  */
+uint8_t Series_Append(uint32_t time, uint8_t temp, uint8_t humi)
+{
+    uint8_t closed = 0;
+
+    if (!series_enabled)
+    {
+        return 0;
+    }
+
+    Kernel_MutexLock(&series_mutex);
+    if (series_page_open)
+    {
+        Series_Page_t *page = &series_pages[series_open];
+        int32_t delta = (int32_t)(time - series_last_time);
+        uint32_t dod = Series_ZigZag(delta - series_last_delta);
+        uint32_t dt = Series_ZigZag((int32_t)temp - series_last_temp);
+        uint32_t dh = Series_ZigZag((int32_t)humi - series_last_humi);
+        uint16_t bits = Series_CodeBits(dod) + Series_CodeBits(dt) + Series_CodeBits(dh);
+
+        if (page->header.bits + bits <= SERIES_DATA_BITS && page->header.count < 0xFFFF)
+        {
+            Series_PutCode(page, dod);
+            Series_PutCode(page, dt);
+            Series_PutCode(page, dh);
+            page->header.count++;
+            series_last_time = time;
+            series_last_delta = delta;
+            series_last_temp = temp;
+            series_last_humi = humi;
+            series_bit_count += bits;
+        }
+        else if (series_pending)
+        {
+            /*上一页仍未写入（bulk线程一整页的时间都没有运行），没有空闲的页缓冲*/
+            series_dropped++;
+            Kernel_MutexUnlock(&series_mutex);
+            return 0;
+        }
+        else
+        {
+            /*当前页放不下，结束当前页，样本作为新一页的第一个样本*/
+            Series_Close();
+            closed = 1;
+        }
+    }
+    if (!series_page_open)
+    {
+        Series_Open(time, temp, humi);
+    }
+
+    if (series_sample_count == 0)
+    {
+        series_stat_first = time;
+    }
+    series_stat_last = time;
+    series_sample_count++;
+    Kernel_MutexUnlock(&series_mutex);
+    return closed;
+}
+
+/**
+  * @brief  把写满的页加入编程，启用新扇区时先擦除（bulk线程调用）
+  * @param  None
+  * @retval None
+  */
+void Series_Poll(void)
+{
+    Kernel_MutexLock(&series_mutex);
+    Series_Write();
+    Kernel_MutexUnlock(&series_mutex);
+}
+
+/**
+  * @brief  提前结束当前页并加入编程，不等待编程完成
+  * @param  None
+  * @retval None
+  */
+void Series_Sync(void)
+{
+    Kernel_MutexLock(&series_mutex);
+    Series_Flush();
+    Kernel_MutexUnlock(&series_mutex);
+}
+
+/**
+  * @brief  读取页头，尚未写入或仍在页缓冲中的页从内存读取
+  * @param  seq: 页序号
+  * @param  header: 用于存放页头的指针
+  * @retval SERIES_PAGE_VALID/ERASED/INVALID
+  */
+static uint8_t Series_LoadHeader(uint32_t seq, Series_Header_t *header)
+{
+    const Series_Page_t *buffer;
+    uint8_t result;
+
+    Kernel_MutexLock(&series_mutex);
+    buffer = Series_FindBuffer(seq);
+    if (buffer)
+    {
+        *header = buffer->header;
+        result = SERIES_PAGE_VALID;
+    }
+    else
+    {
+        result = Series_ReadHeader((seq - 1) % SERIES_PAGE_COUNT, header);
+        if (result == SERIES_PAGE_VALID && header->seq != seq)
+        {
+            result = SERIES_PAGE_INVALID;
+        }
+    }
+    Kernel_MutexUnlock(&series_mutex);
+    return result;
+}
+
+/**
+  * @brief  把一页读入读出缓冲并校验，尚未写入或仍在页缓冲中的页从内存复制
+  * @param  seq: 页序号
+  * @retval 1: 有效，0: 页已被覆盖、未写入或CRC错误
+  */
+static uint8_t Series_LoadPage(uint32_t seq)
+{
+    const Series_Page_t *buffer;
+    uint8_t valid;
+
+    Kernel_MutexLock(&series_mutex);
+    buffer = Series_FindBuffer(seq);
+    if (buffer)
+    {
+        /*正在编码的页没有CRC，复制时的样本数之后的位流不再改变*/
+        series_read = *buffer;
+        valid = 1;
+    }
+    else
+    {
+        W25Q64_ReadBytes(SERIES_PAGE_ADDR(seq), (uint8_t *)&series_read, sizeof(series_read));
+        valid = series_read.header.seq == seq && series_read.header.count != 0 &&
+                series_read.header.bits <= SERIES_DATA_BITS &&
+                series_read.header.crc == W25Q64_CalculateCRC16((const uint8_t *)&series_read + sizeof(series_read.header.crc),
+                                                                sizeof(series_read) - sizeof(series_read.header.crc));
+        if (!valid && Series_ReadHeader((seq - 1) % SERIES_PAGE_COUNT, &series_read.header) != SERIES_PAGE_ERASED)
+        {
+            series_invalid++;
+        }
+    }
+    Kernel_MutexUnlock(&series_mutex);
+
+    if (!valid)
+    {
+        series_read.header.count = 0;
+    }
+    return valid;
+}
+
+/**
+  * @brief  定位到最近的count个样本，之后由Series_Next按时间顺序读出（bulk线程调用）
+  * @param  count: 样本数
+  * @retval 可读出的样本数上限（CRC错误的页读出时跳过）
+  * @note   从最后一页向前读取页头累计样本数，只读取需要的页头
+  */
+uint32_t Series_Seek(uint32_t count)
+{
+    Series_Header_t header;
+    uint32_t page = series_next_page;
+    uint32_t total = 0;
+
+    while (page > series_first_page && total < count)
+    {
+        page--;
+        if (Series_LoadHeader(page, &header) == SERIES_PAGE_VALID)
+        {
+            total += header.count;
+        }
+    }
+
+    series_read_page = page;
+    series_read_end = series_next_page;
+    series_read_skip = (total > count) ? total - count : 0;
+    series_read_left = total - series_read_skip;
+    series_read.header.count = 0;
+    series_read_index = 0;
+    return series_read_left;
+}
+
+/**
+  * @brief  读出下一个样本
+  * @param  sample: 用于存放样本的指针
+  * @retval 0: 成功，1: 已读到Series_Seek时的最后一个样本
+  */
+uint8_t Series_Next(Series_Sample_t *sample)
+{
+    while (series_read_left > 0)
+    {
+        if (series_read_index >= series_read.header.count)
+        {
+            /*读取下一页，跳过无效的页*/
+            if (series_read_page >= series_read_end)
+            {
+                break;
+            }
+            if (!Series_LoadPage(series_read_page++))
+            {
+                continue;
+            }
+            series_read_index = 0;
+            series_read_bit = 0;
+            series_read_delta = 0;
+            series_read_sample.time = series_read.header.time;
+            series_read_sample.temp = series_read.header.temp;
+            series_read_sample.humi = series_read.header.humi;
+        }
+        else
+        {
+            /*按差值还原下一个样本*/
+            series_read_delta += Series_UnZigZag(Series_GetCode());
+            series_read_sample.time += series_read_delta;
+            series_read_sample.temp += Series_UnZigZag(Series_GetCode());
+            series_read_sample.humi += Series_UnZigZag(Series_GetCode());
+        }
+        series_read_index++;
+
+        if (series_read_skip > 0)
+        {
+            series_read_skip--;
+            continue;
+        }
+        series_read_left--;
+        *sample = series_read_sample;
+        return 0;
+    }
+    series_read_left = 0;
+    return 1;
+}
+
+/**
+  * @brief  通过串口输出采样区位置、压缩率（字节/样本）和按当前压缩率估算的保存时长
+  * @param  None
+  * @retval None
+  * @note   占用的字节数按整页计算已结束的页（包括提前结束时未用的空间），
+  *         正在编码的页按页头和已用的位流计算
+  */
+void Series_ReportStats(void)
+{
+    Series_Header_t header;
+    RTC_TimeTypeDef first_time;
+    uint32_t page, bytes, per_sample, area, open_count = 0;
+
+    Kernel_MutexLock(&series_mutex);
+    if (series_page_open)
+    {
+        open_count = series_pages[series_open].header.count;
+    }
+    bytes = series_page_count * W25Q64_PAGE_SIZE +
+            (series_page_open ? SERIES_HEADER_SIZE + (series_pages[series_open].header.bits + 7) / 8 : 0);
+    Kernel_MutexUnlock(&series_mutex);
+
+    Serial_Printf("[SERIES] Stream %s, sectors %u-%u, pages %lu..%lu retained, %lu samples in the open page\n",
+                  series_enabled ? "on" : "off", SERIES_FIRST_SECTOR, SERIES_FIRST_SECTOR + SERIES_SECTOR_COUNT - 1,
+                  series_first_page, series_next_page - 1, open_count);
+
+    /*最早的一页可能正在擦除或写入时掉电，向后找第一个有效的页*/
+    for (page = series_first_page; page < series_next_page && page < series_first_page + SERIES_PAGES_PER_SECTOR; page++)
+    {
+        if (Series_LoadHeader(page, &header) == SERIES_PAGE_VALID)
+        {
+            RTC_ConvertFromSeconds(header.time, &first_time);
+            Serial_Printf("[SERIES] Oldest sample 20%02d-%02d-%02d %02d:%02d:%02d in page %lu\n",
+                          first_time.year, first_time.month, first_time.day,
+                          first_time.hour, first_time.minute, first_time.second, page);
+            break;
+        }
+    }
+
+    if (series_sample_count == 0)
+    {
+        Serial_Printf("[SERIES] No samples since reset\n");
+        return;
+    }
+
+    per_sample = (uint32_t)((uint64_t)bytes * 100 / series_sample_count);
+    Serial_Printf("[SERIES] Since reset: %lu samples in %lu bytes, %lu.%02lu bytes/sample (deltas %lu.%02lu bits/sample)\n",
+                  series_sample_count, bytes, per_sample / 100, per_sample % 100,
+                  series_bit_count / series_sample_count, series_bit_count * 100 / series_sample_count % 100);
+    Serial_Printf("[SERIES] Pages: %lu written (%lu closed early), %lu sector erases, %lu buffer waits\n",
+                  series_page_count, series_sync_count, series_erase_count, series_buffer_waits);
+    Serial_Printf("[SERIES] Errors: %lu samples dropped, %lu invalid pages read\n", series_dropped, series_invalid);
+
+    /*按统计期间的字节数和时间跨度估算整个采样区能保存的时长*/
+    area = SERIES_PAGE_COUNT * W25Q64_PAGE_SIZE;
+    if (series_stat_last > series_stat_first)
+    {
+        uint32_t span = series_stat_last - series_stat_first;
+
+        Serial_Printf("[SERIES] Capacity %lu bytes: %lu samples, about %lu days at this rate\n",
+                      area, (uint32_t)((uint64_t)area * series_sample_count / bytes),
+                      (uint32_t)((uint64_t)area * span / bytes / 86400));
+        Serial_Printf("[SERIES] As %u-byte journal entries: %lu days\n", JOURNAL_ENTRY_SIZE,
+                      (uint32_t)((uint64_t)area / JOURNAL_ENTRY_SIZE * span / series_sample_count / 86400));
+    }
+}
+
+/**
+  * @brief  清除写入统计
+  * @param  None
+  * @retval None
+  */
+void Series_ResetStats(void)
+{
+    Kernel_MutexLock(&series_mutex);
+    series_sample_count = 0;
+    series_bit_count = 0;
+    series_page_count = 0;
+    series_sync_count = 0;
+    series_erase_count = 0;
+    series_dropped = 0;
+    series_buffer_waits = 0;
+    series_invalid = 0;
+    Kernel_MutexUnlock(&series_mutex);
+}
@@ -0,0 +1,136 @@
+#ifndef __SERIES_H
+#define __SERIES_H
+
+#include "stm32f10x.h"
+#include "W25Q64.h"
+#include "Journal.h"
+
+/**
+  * W25Q64上的温湿度连续采样流（压缩时间序列）
+  *
+  * 打开后每次温湿度采集都追加一个样本（时间戳、温度、湿度），不经过记录日志。
+  * 样本按页压缩：每页以页头开始，保存页序号和第一个样本的原始值，之后的样本
+  * 以位流保存相对前一个样本的差值：
+  *     时间戳：二阶差分（本次间隔 - 上次间隔），固定周期采样时为0
+  *     温度、湿度：与上一个样本的差值
+  * 差值经zig-zag映射为无符号数后按位变长编码：0编码为1位"0"；非0编码为"1"后跟
+  * 若干组"3位数值 + 1位后续标志"，低位组在前。温湿度不变、采样间隔不变时每个样本
+  * 只占3位，一页（240字节位流）约可保存640个样本，即约53分钟的5秒采样。
+  * 每页独立解码，掉电时写了一半的页CRC不符，读出时整页跳过。
+  * 页在内存中编码，写满时才整页编程一次，不修改已写入的页；Series_Sync（sync命令、
+  * 电源电压下降）提前结束当前页，页内剩余空间不再使用。未写满的页只在内存中，
+  * 异常复位时最多丢失一页的样本。
+  * 页序号从1开始连续递增，第n页位于采样区内第(n-1) % SERIES_PAGE_COUNT页；启用
+  * 每个扇区的第0页时先擦除该扇区，采样区写满后覆盖最早的扇区。
+  * 写入位置不单独保存：上电时二分查找第0页序号连续的最后一个扇区，其中第一个
+  * 空页即为写入位置。
+  */
+
+/* 采样区：日志区之后到配置区之前的扇区 */
+#define SERIES_FIRST_SECTOR         (JOURNAL_FIRST_SECTOR + JOURNAL_SECTOR_COUNT)
+#define SERIES_SECTOR_COUNT         (W25Q64_NUM_SECTORS - 2 - SERIES_FIRST_SECTOR)
+
+#define SERIES_PAGES_PER_SECTOR     (W25Q64_SECTOR_SIZE / W25Q64_PAGE_SIZE)
+#define SERIES_PAGE_COUNT           ((uint32_t)SERIES_SECTOR_COUNT * SERIES_PAGES_PER_SECTOR)
+
+#define SERIES_HEADER_SIZE          16
+#define SERIES_DATA_SIZE            (W25Q64_PAGE_SIZE - SERIES_HEADER_SIZE)
+#define SERIES_DATA_BITS            (SERIES_DATA_SIZE * 8)
+
+#pragma pack(1)
+/**
+  * @brief  页头，CRC在最前面，校验页内其余的全部字节
+  */
+typedef struct {
+    uint16_t crc;           /* 页内crc之后全部字节的CRC16 */
+    uint16_t count;         /* 样本数，包括页头中的第一个样本 */
+    uint32_t seq;           /* 页序号，从1开始 */
+    uint32_t time;          /* 第一个样本的时间戳（RTC秒数） */
+    uint8_t temp;           /* 第一个样本的温度（°C） */
+    uint8_t humi;           /* 第一个样本的湿度（%） */
+    uint16_t bits;          /* 位流的有效位数 */
+} Series_Header_t;
+#pragma pack()
+
+/**
+  * @brief  样本
+  */
+typedef struct {
+    uint32_t time;          /* 时间戳（RTC秒数） */
+    uint8_t temp;           /* 温度（°C） */
+    uint8_t humi;           /* 湿度（%） */
+} Series_Sample_t;
+
+/**
+  * @brief  从Flash内容恢复写入位置，在W25Q64_Init之后调用
+  * @param  None
+  * @retval 下一页的序号，1表示采样区为空
+  */
+uint32_t Series_Init(void);
+
+/**
+  * @brief  打开或关闭采样流，关闭时把当前页加入编程
+  * @param  enable: 1: 打开，0: 关闭
+  * @retval None
+  */
+void Series_Enable(uint8_t enable);
+
+/**
+  * @brief  获取采样流是否打开
+  * @param  None
+  * @retval 1: 打开，0: 关闭
+  */
+uint8_t Series_IsEnabled(void);
+
+/**
+  * @brief  追加一个样本（sensor线程调用），采样流关闭时忽略
+  * @param  time: 时间戳（RTC秒数）
+  * @param  temp: 温度（°C）
+  * @param  humi: 湿度（%）
+  * @retval 1: 写满一页，需要唤醒bulk线程调用Series_Poll，0: 其他
+  */
+uint8_t Series_Append(uint32_t time, uint8_t temp, uint8_t humi);
+
+/**
+  * @brief  把写满的页加入编程，启用新扇区时先擦除（bulk线程调用）
+  * @param  None
+  * @retval None
+  */
+void Series_Poll(void);
+
+/**
+  * @brief  提前结束当前页并加入编程，不等待编程完成
+  * @param  None
+  * @retval None
+  */
+void Series_Sync(void);
+
+/**
+  * @brief  定位到最近的count个样本，之后由Series_Next按时间顺序读出（bulk线程调用）
+  * @param  count: 样本数
+  * @retval 可读出的样本数上限（CRC错误的页读出时跳过）
+  */
+uint32_t Series_Seek(uint32_t count);
+
+/**
+  * @brief  读出下一个样本
+  * @param  sample: 用于存放样本的指针
+  * @retval 0: 成功，1: 已读到Series_Seek时的最后一个样本
+  */
+uint8_t Series_Next(Series_Sample_t *sample);
+
+/**
+  * @brief  通过串口输出采样区位置、压缩率（字节/样本）和按当前压缩率估算的保存时长
+  * @param  None
+  * @retval None
+  */
+void Series_ReportStats(void);
+
+/**
+  * @brief  清除写入统计
+  * @param  None
+  * @retval None
+  */
+void Series_ResetStats(void);
+
+#endif /* __SERIES_H */
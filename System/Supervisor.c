@@ -0,0 +1,240 @@
+#include "Supervisor.h"
+#include "Scheduler.h"
+#include "Serial.h"
+
+/* IWDG时钟：LSI 40kHz经64分频为625Hz */
+#define SUPERVISOR_IWDG_CLOCK_HZ    625
+
+/* 停止喂狗时把超期作业号写入BKP_DR2，看门狗复位后据此报告，高字节为有效标志 */
+#define SUPERVISOR_BKP_REG          BKP_DR2
+#define SUPERVISOR_BKP_MAGIC        0x5A00
+
+/* 作业表 */
+static Supervisor_Job_t supervisor_jobs[SUPERVISOR_MAX_JOBS];
+static uint8_t supervisor_job_count = 0;
+
+/* 监控状态 */
+static volatile uint8_t supervisor_running = 0;
+static uint32_t supervisor_last_check = 0;
+static volatile uint32_t supervisor_feed_count = 0;
+static volatile uint32_t supervisor_last_feed = 0;
+static volatile uint32_t supervisor_starve_count = 0;
+
+/**
+  * @brief  注册监控作业，应在Supervisor_Start之前调用
+  * @param  name: 作业名称
+  * @param  max_period_ms: 两次签到之间允许的最大间隔（ms）
+  * @param  critical: 1: 超期时停止喂狗使系统复位，0: 只记录
+  * @retval 作业号，作业表已满时返回SUPERVISOR_INVALID_JOB
+  */
+uint8_t Supervisor_Register(const char *name, uint32_t max_period_ms, uint8_t critical)
+{
+    Supervisor_Job_t *job;
+
+    if (supervisor_job_count >= SUPERVISOR_MAX_JOBS)
+    {
+        return SUPERVISOR_INVALID_JOB;
+    }
+
+    job = &supervisor_jobs[supervisor_job_count];
+    job->name = name;
+    job->max_period = max_period_ms;
+    job->critical = critical;
+    job->overdue = 0;
+    job->last_checkin = Scheduler_GetTick();
+    job->checkin_count = 0;
+    job->max_gap = 0;
+    job->max_late = 0;
+    job->overrun_count = 0;
+
+    return supervisor_job_count++;
+}
+
+/**
+  * @brief  作业签到，超期签到时记录并输出超期时间
+  * @param  job: 作业号
+  * @retval None
+  * @note   在作业所在的线程中调用
+  */
+void Supervisor_CheckIn(uint8_t job)
+{
+    Supervisor_Job_t *j;
+    uint32_t now, gap;
+
+    if (job >= supervisor_job_count)
+    {
+        return;
+    }
+
+    j = &supervisor_jobs[job];
+    now = Scheduler_GetTick();
+    gap = now - j->last_checkin;
+    j->last_checkin = now;
+    j->overdue = 0;
+    j->checkin_count++;
+
+    if (!supervisor_running)
+    {
+        return;
+    }
+
+    if (gap > j->max_gap)
+    {
+        j->max_gap = gap;
+    }
+    if (gap > j->max_period)
+    {
+        uint32_t late = gap - j->max_period;
+
+        j->overrun_count++;
+        if (late > j->max_late)
+        {
+            j->max_late = late;
+        }
+        Serial_Printf("[DEADLINE] %s overrun: %lu ms late (gap %lu ms, max %lu ms)\n",
+                      j->name, late, gap, j->max_period);
+    }
+}
+
+/**
+  * @brief  开始监控并启动独立看门狗，启动后无法停止
+  * @param  None
+  * @retval None
+  * @note   如上次复位由看门狗引起，输出超期的作业名称
+  */
+void Supervisor_Start(void)
+{
+    uint8_t i;
+
+    /* 报告上次的看门狗复位 */
+    if (RCC_GetFlagStatus(RCC_FLAG_IWDGRST) != RESET)
+    {
+        uint16_t stalled = BKP_ReadBackupRegister(SUPERVISOR_BKP_REG);
+
+        if ((stalled & 0xFF00) == SUPERVISOR_BKP_MAGIC && (stalled & 0xFF) < supervisor_job_count)
+        {
+            Serial_Printf("[WARN] Watchdog reset: job '%s' missed its deadline\n",
+                          supervisor_jobs[stalled & 0xFF].name);
+        }
+        else
+        {
+            Serial_Printf("[WARN] Watchdog reset\n");
+        }
+        RCC_ClearFlag();
+    }
+    BKP_WriteBackupRegister(SUPERVISOR_BKP_REG, 0);
+
+    /* 从现在开始计算各作业的签到间隔 */
+    for (i = 0; i < supervisor_job_count; i++)
+    {
+        supervisor_jobs[i].last_checkin = Scheduler_GetTick();
+        supervisor_jobs[i].overdue = 0;
+    }
+
+    /* 调试器暂停内核时看门狗同时暂停 */
+    DBGMCU_Config(DBGMCU_IWDG_STOP, ENABLE);
+
+    /* 启动独立看门狗 */
+    IWDG_WriteAccessCmd(IWDG_WriteAccess_Enable);
+    IWDG_SetPrescaler(IWDG_Prescaler_64);
+    IWDG_SetReload(SUPERVISOR_IWDG_TIMEOUT_MS * SUPERVISOR_IWDG_CLOCK_HZ / 1000);
+    IWDG_ReloadCounter();
+    IWDG_Enable();
+
+    supervisor_last_feed = Scheduler_GetTick();
+    supervisor_last_check = supervisor_last_feed;
+    supervisor_running = 1;
+}
+
+/**
+  * @brief  监控检查，由SysTick中断调用，每SUPERVISOR_CHECK_MS检查一次，所有关键作业按时签到时才喂狗
+  * @param  None
+  * @retval None
+  * @note   按经过的时间而不是调用次数判断检查周期，低功耗空闲期间SysTick中断间隔会被拉长
+  */
+void Supervisor_Tick(void)
+{
+    uint32_t now = Scheduler_GetTick();
+    uint8_t healthy = 1;
+    uint8_t i;
+
+    if (!supervisor_running || now - supervisor_last_check < SUPERVISOR_CHECK_MS)
+    {
+        return;
+    }
+    supervisor_last_check = now;
+
+    for (i = 0; i < supervisor_job_count; i++)
+    {
+        Supervisor_Job_t *j = &supervisor_jobs[i];
+
+        if (now - j->last_checkin > j->max_period)
+        {
+            if (j->critical && healthy)
+            {
+                healthy = 0;
+
+                /* 记录第一个超期的关键作业，看门狗复位后报告 */
+                if (!j->overdue)
+                {
+                    BKP_WriteBackupRegister(SUPERVISOR_BKP_REG, SUPERVISOR_BKP_MAGIC | i);
+                }
+            }
+            j->overdue = 1;
+        }
+    }
+
+    if (healthy)
+    {
+        IWDG_ReloadCounter();
+        supervisor_feed_count++;
+        supervisor_last_feed = now;
+    }
+    else
+    {
+        supervisor_starve_count++;
+    }
+}
+
+/**
+  * @brief  通过串口输出各作业的签到和超期统计
+  * @param  None
+  * @retval None
+  */
+void Supervisor_ReportStats(void)
+{
+    uint32_t now = Scheduler_GetTick();
+    uint8_t i;
+
+    Serial_Printf("[DEADLINES] Watchdog: %s, timeout %u ms, feeds %lu, starved checks %lu, last feed %lu ms ago\n",
+                  supervisor_running ? "running" : "stopped", SUPERVISOR_IWDG_TIMEOUT_MS,
+                  supervisor_feed_count, supervisor_starve_count, now - supervisor_last_feed);
+    Serial_Printf("[DEADLINES] Name | Max period | Critical | Check-ins | Max gap ms | Worst late ms | Overruns | Since last ms\n");
+    for (i = 0; i < supervisor_job_count; i++)
+    {
+        Supervisor_Job_t *j = &supervisor_jobs[i];
+        Serial_Printf("[DEADLINES] %s | %lu | %s | %lu | %lu | %lu | %lu | %lu\n",
+                      j->name, j->max_period, j->critical ? "yes" : "no", j->checkin_count,
+                      j->max_gap, j->max_late, j->overrun_count, now - j->last_checkin);
+    }
+}
+
+/**
+  * @brief  清除各作业的签到和超期统计
+  * @param  None
+  * @retval None
+  */
+void Supervisor_ResetStats(void)
+{
+    uint8_t i;
+
+    for (i = 0; i < supervisor_job_count; i++)
+    {
+        supervisor_jobs[i].checkin_count = 0;
+        supervisor_jobs[i].max_gap = 0;
+        supervisor_jobs[i].max_late = 0;
+        supervisor_jobs[i].overrun_count = 0;
+    }
+    supervisor_feed_count = 0;
+    supervisor_starve_count = 0;
+}
@@ -0,0 +1,80 @@
+#ifndef __SUPERVISOR_H
+#define __SUPERVISOR_H
+
+#include "stm32f10x.h"
+
+/* 最大监控作业数 */
+#define SUPERVISOR_MAX_JOBS         8
+
+/* 注册失败时返回的作业号 */
+#define SUPERVISOR_INVALID_JOB      0xFF
+
+/* 检查周期（ms），在SysTick中断中按此周期检查各作业并喂狗 */
+#define SUPERVISOR_CHECK_MS         100
+
+/* 独立看门狗超时（ms），按LSI标称40kHz计算，实际为2/3~4/3倍 */
+#define SUPERVISOR_IWDG_TIMEOUT_MS  2000
+
+/**
+  * @brief  监控作业
+  */
+typedef struct {
+    const char *name;           /* 作业名称 */
+    uint32_t max_period;        /* 两次签到之间允许的最大间隔（ms） */
+    uint8_t critical;           /* 1: 超期时停止喂狗 */
+    volatile uint8_t overdue;   /* 1: 当前已超期未签到 */
+    volatile uint32_t last_checkin; /* 上次签到时刻（ms） */
+    uint32_t checkin_count;     /* 签到次数 */
+    uint32_t max_gap;           /* 最大签到间隔（ms） */
+    uint32_t max_late;          /* 最大超期时间（ms，签到间隔减去最大间隔） */
+    uint32_t overrun_count;     /* 超期次数 */
+} Supervisor_Job_t;
+
+/**
+  * @brief  注册监控作业，应在Supervisor_Start之前调用
+  * @param  name: 作业名称
+  * @param  max_period_ms: 两次签到之间允许的最大间隔（ms）
+  * @param  critical: 1: 超期时停止喂狗使系统复位，0: 只记录
+  * @retval 作业号，作业表已满时返回SUPERVISOR_INVALID_JOB
+  */
+uint8_t Supervisor_Register(const char *name, uint32_t max_period_ms, uint8_t critical);
+
+/**
+  * @brief  作业签到，超期签到时记录并输出超期时间
+  * @param  job: 作业号
+  * @retval None
+  * @note   在作业所在的线程中调用
+  */
+void Supervisor_CheckIn(uint8_t job);
+
+/**
+  * @brief  开始监控并启动独立看门狗，启动后无法停止
+  * @param  None
+  * @retval None
+  * @note   如上次复位由看门狗引起，输出超期的作业名称
+  */
+void Supervisor_Start(void);
+
+/**
+  * @brief  监控检查，由SysTick中断调用，每SUPERVISOR_CHECK_MS检查一次，所有关键作业按时签到时才喂狗
+  * @param  None
+  * @retval None
+  * @note   按经过的时间而不是调用次数判断检查周期，低功耗空闲期间SysTick中断间隔会被拉长
+  */
+void Supervisor_Tick(void);
+
+/**
+  * @brief  通过串口输出各作业的签到和超期统计
+  * @param  None
+  * @retval None
+  */
+void Supervisor_ReportStats(void);
+
+/**
+  * @brief  清除各作业的签到和超期统计
+  * @param  None
+  * @retval None
+  */
+void Supervisor_ResetStats(void);
+
+#endif /* __SUPERVISOR_H */
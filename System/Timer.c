@@ -0,0 +1,449 @@
+#include "Timer.h"
+#include "Scheduler.h"
+#include "Kernel.h"
+#include "Serial.h"
+
+/* 临界区，保存并恢复PRIMASK，允许嵌套 */
+#define TIMER_ENTER_CRITICAL()  uint32_t primask = __get_PRIMASK(); __disable_irq()
+#define TIMER_EXIT_CRITICAL()   __set_PRIMASK(primask)
+
+/* 时间轮，每个槽是一个单向链表头 */
+static Timer_t *timer_wheel[TIMER_LEVELS][TIMER_SLOTS];
+
+/* 下一个待处理的tick，时间轮已推进到它之前 */
+static uint32_t timer_jiffies = 0;
+
+/* 服务线程等待状态，用于判断新启动的定时器是否需要提前唤醒它 */
+static Kernel_Sem_t timer_sem;
+static volatile uint8_t timer_waiting = 0;
+static volatile uint32_t timer_wait_until = 0;
+
+/* timers命令最多列出的定时器数 */
+#define TIMER_REPORT_MAX        16
+
+/* 统计 */
+static uint32_t timer_armed_count = 0;
+static uint32_t timer_fire_count = 0;
+static uint32_t timer_late_total = 0;
+static uint32_t timer_late_max = 0;
+
+/**
+  * @brief  将定时器挂入链表头部
+  * @param  head: 链表头
+  * @param  timer: 定时器
+  * @retval None
+  */
+static void Timer_ListAdd(Timer_t **head, Timer_t *timer)
+{
+    timer->next = *head;
+    if (*head)
+    {
+        (*head)->pprev = &timer->next;
+    }
+    *head = timer;
+    timer->pprev = head;
+}
+
+/**
+  * @brief  将定时器从所在链表中摘除
+  * @param  timer: 定时器
+  * @retval None
+  */
+static void Timer_ListDel(Timer_t *timer)
+{
+    *timer->pprev = timer->next;
+    if (timer->next)
+    {
+        timer->next->pprev = timer->pprev;
+    }
+    timer->next = 0;
+    timer->pprev = 0;
+}
+
+/**
+  * @brief  按到期时刻把定时器挂入对应的级和槽，O(1)
+  * @param  timer: 定时器
+  * @retval None
+  * @note   调用者需处于临界区
+  */
+static void Timer_Insert(Timer_t *timer)
+{
+    uint32_t expires = timer->expires;
+    uint32_t delta = expires - timer_jiffies;
+    uint8_t level;
+
+    if ((int32_t)delta < 0)
+    {
+        /* 已过期，在下一个待处理的tick触发 */
+        timer->expires = timer_jiffies;
+        expires = timer_jiffies;
+        delta = 0;
+    }
+    else if (delta > TIMER_MAX_DELTA)
+    {
+        /* 超出时间轮范围，先挂在最远的槽，降级时重新计算 */
+        expires = timer_jiffies + TIMER_MAX_DELTA;
+        delta = TIMER_MAX_DELTA;
+    }
+
+    for (level = 0; level < TIMER_LEVELS - 1; level++)
+    {
+        if (delta < (1UL << ((level + 1) * TIMER_SLOT_BITS)))
+        {
+            break;
+        }
+    }
+
+    Timer_ListAdd(&timer_wheel[level][(expires >> (level * TIMER_SLOT_BITS)) & TIMER_SLOT_MASK], timer);
+    timer_armed_count++;
+}
+
+/**
+  * @brief  把高一级的一个槽中的定时器重新挂入，使其降到更低的级
+  * @param  level: 级
+  * @param  slot: 槽
+  * @retval None
+  * @note   调用者需处于临界区
+  */
+static void Timer_Cascade(uint8_t level, uint8_t slot)
+{
+    Timer_t *list = timer_wheel[level][slot];
+
+    timer_wheel[level][slot] = 0;
+    while (list)
+    {
+        Timer_t *timer = list;
+        list = timer->next;
+        timer->next = 0;
+        timer->pprev = 0;
+        timer_armed_count--;
+        Timer_Insert(timer);
+    }
+}
+
+/**
+  * @brief  定时器服务初始化，由Scheduler_Init调用
+  * @param  None
+  * @retval None
+  */
+void Timer_Init(void)
+{
+    uint8_t level, slot;
+
+    for (level = 0; level < TIMER_LEVELS; level++)
+    {
+        for (slot = 0; slot < TIMER_SLOTS; slot++)
+        {
+            timer_wheel[level][slot] = 0;
+        }
+    }
+    timer_jiffies = Scheduler_GetTick();
+    timer_armed_count = 0;
+    Kernel_SemInit(&timer_sem, 0);
+    Timer_ResetStats();
+}
+
+/**
+  * @brief  设置定时器的回调（定时器初始为未启动）
+  * @param  timer: 定时器
+  * @param  name: 名称
+  * @param  func: 回调函数
+  * @param  arg: 回调参数
+  * @retval None
+  */
+void Timer_Setup(Timer_t *timer, const char *name, Timer_Func func, void *arg)
+{
+    timer->next = 0;
+    timer->pprev = 0;
+    timer->name = name;
+    timer->func = func;
+    timer->arg = arg;
+    timer->expires = 0;
+    timer->period = 0;
+    timer->fire_count = 0;
+    timer->max_late = 0;
+}
+
+/**
+  * @brief  启动定时器，已启动时重新开始计时，可在任意线程中调用
+  * @param  timer: 定时器
+  * @param  delay_ms: 首次到期的延时（ms），0表示下一个tick
+  * @param  period_ms: 之后的周期（ms），0表示单次定时器
+  * @retval None
+  */
+void Timer_Start(Timer_t *timer, uint32_t delay_ms, uint32_t period_ms)
+{
+    uint8_t wake;
+    TIMER_ENTER_CRITICAL();
+
+    if (timer->pprev)
+    {
+        Timer_ListDel(timer);
+        timer_armed_count--;
+    }
+    timer->expires = Scheduler_GetTick() + delay_ms;
+    timer->period = period_ms;
+    Timer_Insert(timer);
+
+    /* 比服务线程当前的等待截止时刻更早，需要唤醒它重新计算 */
+    wake = timer_waiting && (int32_t)(timer->expires - timer_wait_until) < 0;
+    if (wake)
+    {
+        timer_waiting = 0;
+    }
+    TIMER_EXIT_CRITICAL();
+
+    if (wake)
+    {
+        Kernel_SemPost(&timer_sem);
+    }
+}
+
+/**
+  * @brief  停止定时器，可在任意线程（包括回调）中调用
+  * @param  timer: 定时器
+  * @retval None
+  */
+void Timer_Stop(Timer_t *timer)
+{
+    TIMER_ENTER_CRITICAL();
+    if (timer->pprev)
+    {
+        Timer_ListDel(timer);
+        timer_armed_count--;
+    }
+    timer->period = 0;
+    TIMER_EXIT_CRITICAL();
+}
+
+/**
+  * @brief  查询定时器是否已启动
+  * @param  timer: 定时器
+  * @retval 1: 已启动，0: 未启动
+  */
+uint8_t Timer_IsArmed(Timer_t *timer)
+{
+    return timer->pprev != 0;
+}
+
+/**
+  * @brief  推进时间轮到当前时刻并执行所有到期定时器的回调（定时器服务线程调用）
+  * @param  None
+  * @retval None
+  * @note   每推进一个tick为O(1)，最低一级转完一圈时把高一级的一个槽降级
+  */
+void Timer_Run(void)
+{
+    uint32_t now = Scheduler_GetTick();
+
+    while ((int32_t)(now - timer_jiffies) >= 0)
+    {
+        uint8_t slot = timer_jiffies & TIMER_SLOT_MASK;
+        Timer_t *list;
+
+        {
+            TIMER_ENTER_CRITICAL();
+
+            if (slot == 0)
+            {
+                uint8_t level;
+                for (level = 1; level < TIMER_LEVELS; level++)
+                {
+                    uint8_t index = (timer_jiffies >> (level * TIMER_SLOT_BITS)) & TIMER_SLOT_MASK;
+                    Timer_Cascade(level, index);
+                    if (index != 0)
+                    {
+                        break;
+                    }
+                }
+            }
+
+            /* 取出到期槽，链表头换成局部变量，回调中停止其他到期定时器时仍能正确摘除 */
+            list = timer_wheel[0][slot];
+            timer_wheel[0][slot] = 0;
+            if (list)
+            {
+                list->pprev = &list;
+            }
+            timer_jiffies++;
+            TIMER_EXIT_CRITICAL();
+        }
+
+        while (list)
+        {
+            Timer_t *timer;
+            uint32_t late;
+
+            {
+                TIMER_ENTER_CRITICAL();
+                timer = list;
+                if (timer == 0)
+                {
+                    TIMER_EXIT_CRITICAL();
+                    break;
+                }
+                Timer_ListDel(timer);
+                timer_armed_count--;
+
+                late = Scheduler_GetTick() - timer->expires;
+                timer->fire_count++;
+                if (late > timer->max_late)
+                {
+                    timer->max_late = late;
+                }
+                timer_fire_count++;
+                timer_late_total += late;
+                if (late > timer_late_max)
+                {
+                    timer_late_max = late;
+                }
+
+                /* 周期定时器先重新挂入，落后超过一个周期时不补触发，直接与当前时间对齐 */
+                if (timer->period)
+                {
+                    timer->expires += timer->period;
+                    if ((int32_t)(Scheduler_GetTick() - timer->expires) >= 0)
+                    {
+                        timer->expires = Scheduler_GetTick() + timer->period;
+                    }
+                    Timer_Insert(timer);
+                }
+                TIMER_EXIT_CRITICAL();
+            }
+
+            timer->func(timer->arg);
+        }
+    }
+}
+
+/**
+  * @brief  获取时间轮下一次需要推进的时刻
+  * @param  None
+  * @retval 时刻（ms），不晚于最早的到期时刻；无定时器时返回当前时刻之后1秒
+  * @note   最低一级返回精确的到期时刻，高一级返回非空槽的降级时刻，最多检查每级32个槽
+  */
+uint32_t Timer_GetNextExpiry(void)
+{
+    uint32_t next = Scheduler_GetTick() + 1000;
+    uint8_t level, i;
+    TIMER_ENTER_CRITICAL();
+
+    for (i = 0; i < TIMER_SLOTS; i++)
+    {
+        if (timer_wheel[0][(timer_jiffies + i) & TIMER_SLOT_MASK])
+        {
+            if ((int32_t)(timer_jiffies + i - next) < 0)
+            {
+                next = timer_jiffies + i;
+            }
+            break;
+        }
+    }
+
+    for (level = 1; level < TIMER_LEVELS; level++)
+    {
+        uint8_t shift = level * TIMER_SLOT_BITS;
+        uint32_t mask = (1UL << shift) - 1;
+
+        /* 从不早于timer_jiffies的第一个降级时刻开始，依次对应本级的32个槽 */
+        uint32_t base = (timer_jiffies >> shift) + ((timer_jiffies & mask) != 0);
+
+        for (i = 0; i < TIMER_SLOTS; i++)
+        {
+            if (timer_wheel[level][(base + i) & TIMER_SLOT_MASK])
+            {
+                uint32_t cascade = (base + i) << shift;
+                if ((int32_t)(cascade - next) < 0)
+                {
+                    next = cascade;
+                }
+                break;
+            }
+        }
+    }
+
+    TIMER_EXIT_CRITICAL();
+    return next;
+}
+
+/**
+  * @brief  等待到指定时刻，有更早到期的定时器被启动时提前返回（定时器服务线程调用）
+  * @param  tick: 等待的截止时刻（ms）
+  * @retval None
+  */
+void Timer_Wait(uint32_t tick)
+{
+    int32_t remain;
+
+    {
+        TIMER_ENTER_CRITICAL();
+        remain = (int32_t)(tick - Scheduler_GetTick());
+        timer_wait_until = tick;
+        timer_waiting = (remain > 0);
+        TIMER_EXIT_CRITICAL();
+    }
+
+    if (remain > 0)
+    {
+        Kernel_SemWait(&timer_sem, (uint32_t)remain);
+        timer_waiting = 0;
+    }
+}
+
+/**
+  * @brief  通过串口输出定时器统计和已启动的定时器
+  * @param  None
+  * @retval None
+  */
+void Timer_ReportStats(void)
+{
+    Timer_t *armed[TIMER_REPORT_MAX];
+    int32_t due[TIMER_REPORT_MAX];
+    uint8_t count = 0, level, slot, i;
+
+    Serial_Printf("[TIMERS] Armed: %lu | Fired: %lu | Avg late: %lu.%02lu ms | Max late: %lu ms\n",
+                  timer_armed_count, timer_fire_count,
+                  timer_fire_count ? timer_late_total / timer_fire_count : 0,
+                  timer_fire_count ? (timer_late_total * 100 / timer_fire_count) % 100 : 0,
+                  timer_late_max);
+
+    /* 在临界区内取快照，输出期间定时器可能到期重排 */
+    {
+        uint32_t now = Scheduler_GetTick();
+        TIMER_ENTER_CRITICAL();
+        for (level = 0; level < TIMER_LEVELS; level++)
+        {
+            for (slot = 0; slot < TIMER_SLOTS; slot++)
+            {
+                Timer_t *timer;
+                for (timer = timer_wheel[level][slot]; timer != 0 && count < TIMER_REPORT_MAX; timer = timer->next)
+                {
+                    armed[count] = timer;
+                    due[count] = (int32_t)(timer->expires - now);
+                    count++;
+                }
+            }
+        }
+        TIMER_EXIT_CRITICAL();
+    }
+
+    Serial_Printf("[TIMERS] Name | Due in ms | Period | Fires | Max late ms\n");
+    for (i = 0; i < count; i++)
+    {
+        Serial_Printf("[TIMERS] %s | %ld | %lu | %lu | %lu\n",
+                      armed[i]->name, due[i], armed[i]->period,
+                      armed[i]->fire_count, armed[i]->max_late);
+    }
+}
+
+/**
+  * @brief  清除定时器统计
+  * @param  None
+  * @retval None
+  */
+void Timer_ResetStats(void)
+{
+    timer_fire_count = 0;
+    timer_late_total = 0;
+    timer_late_max = 0;
+}
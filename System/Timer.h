@@ -0,0 +1,109 @@
+#ifndef __TIMER_H
+#define __TIMER_H
+
+#include "stm32f10x.h"
+
+/* 时间轮：4级，每级32个槽，最低一级精度1ms，可直接表示的最长延时为2^20ms（约17.5分钟），
+   更长的延时在最高一级中逐轮重新挂入 */
+#define TIMER_LEVELS            4
+#define TIMER_SLOT_BITS         5
+#define TIMER_SLOTS             (1 << TIMER_SLOT_BITS)
+#define TIMER_SLOT_MASK         (TIMER_SLOTS - 1)
+#define TIMER_MAX_DELTA         ((1UL << (TIMER_LEVELS * TIMER_SLOT_BITS)) - 1)
+
+/**
+  * @brief  定时器回调函数类型，在定时器服务线程（sensor线程）中执行
+  */
+typedef void (*Timer_Func)(void *arg);
+
+/**
+  * @brief  定时器
+  */
+typedef struct Timer {
+    struct Timer *next;         /* 槽内链表 */
+    struct Timer **pprev;       /* 指向前一个节点的next（或槽头），为0表示未启动 */
+    const char *name;           /* 名称 */
+    Timer_Func func;            /* 回调函数 */
+    void *arg;                  /* 回调参数 */
+    uint32_t expires;           /* 到期时刻（ms） */
+    uint32_t period;            /* 周期（ms），0表示单次 */
+    uint32_t fire_count;        /* 触发次数 */
+    uint32_t max_late;          /* 最大触发延迟（ms，从到期到回调开始） */
+} Timer_t;
+
+/**
+  * @brief  定时器服务初始化，由Scheduler_Init调用
+  * @param  None
+  * @retval None
+  */
+void Timer_Init(void);
+
+/**
+  * @brief  设置定时器的回调（定时器初始为未启动）
+  * @param  timer: 定时器
+  * @param  name: 名称
+  * @param  func: 回调函数
+  * @param  arg: 回调参数
+  * @retval None
+  */
+void Timer_Setup(Timer_t *timer, const char *name, Timer_Func func, void *arg);
+
+/**
+  * @brief  启动定时器，已启动时重新开始计时，可在任意线程中调用
+  * @param  timer: 定时器
+  * @param  delay_ms: 首次到期的延时（ms），0表示下一个tick
+  * @param  period_ms: 之后的周期（ms），0表示单次定时器
+  * @retval None
+  */
+void Timer_Start(Timer_t *timer, uint32_t delay_ms, uint32_t period_ms);
+
+/**
+  * @brief  停止定时器，可在任意线程（包括回调）中调用
+  * @param  timer: 定时器
+  * @retval None
+  */
+void Timer_Stop(Timer_t *timer);
+
+/**
+  * @brief  查询定时器是否已启动
+  * @param  timer: 定时器
+  * @retval 1: 已启动，0: 未启动
+  */
+uint8_t Timer_IsArmed(Timer_t *timer);
+
+/**
+  * @brief  推进时间轮到当前时刻并执行所有到期定时器的回调（定时器服务线程调用）
+  * @param  None
+  * @retval None
+  */
+void Timer_Run(void);
+
+/**
+  * @brief  获取时间轮下一次需要推进的时刻
+  * @param  None
+  * @retval 时刻（ms），不晚于最早的到期时刻；无定时器时返回当前时刻之后1秒
+  */
+uint32_t Timer_GetNextExpiry(void);
+
+/**
+  * @brief  等待到指定时刻，有更早到期的定时器被启动时提前返回（定时器服务线程调用）
+  * @param  tick: 等待的截止时刻（ms）
+  * @retval None
+  */
+void Timer_Wait(uint32_t tick);
+
+/**
+  * @brief  通过串口输出定时器统计和已启动的定时器
+  * @param  None
+  * @retval None
+  */
+void Timer_ReportStats(void);
+
+/**
+  * @brief  清除定时器统计
+  * @param  None
+  * @retval None
+  */
+void Timer_ResetStats(void);
+
+#endif /* __TIMER_H */
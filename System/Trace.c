@@ -0,0 +1,142 @@
+#include "Trace.h"
+#include "Delay.h"
+#include "Kernel.h"
+#include "Serial.h"
+#include <stdio.h>
+
+/* 每行输出的记录数，每条14个十六进制字符：周期计数8位、事件号2位、参数4位 */
+#define TRACE_DUMP_PER_LINE     8
+
+/**
+  * @brief  跟踪记录
+  */
+typedef struct {
+    uint32_t cycles;            /* DWT_CYCCNT */
+    volatile uint8_t event;     /* 事件号，0表示槽位尚未写完 */
+    uint8_t reserved;
+    uint16_t arg;               /* 参数 */
+} Trace_Record_t;
+
+static Trace_Record_t trace_buffer[TRACE_BUFFER_SIZE];
+
+/* 已占用的记录总数，低位即下一个写入槽位，只通过LDREX/STREX修改 */
+static volatile uint32_t trace_head = 0;
+
+static volatile uint8_t trace_enabled = 1;
+
+/**
+  * @brief  写入一条跟踪记录，可在中断和线程中调用
+  * @param  event: 事件号，见Trace_Event_t
+  * @param  arg: 16位参数
+  * @retval None
+  * @note   先用LDREX/STREX占用槽位，被抢占时STREX失败并重试；事件号最后写入，
+  *         输出时跳过尚未写完的槽位
+  */
+void Trace_Event(uint8_t event, uint16_t arg)
+{
+    Trace_Record_t *r;
+    uint32_t head;
+
+    if (!trace_enabled)
+    {
+        return;
+    }
+
+    do
+    {
+        head = __LDREXW((uint32_t *)&trace_head);
+    } while (__STREXW(head + 1, (uint32_t *)&trace_head));
+
+    r = &trace_buffer[head & (TRACE_BUFFER_SIZE - 1)];
+    r->event = TRACE_EV_NONE;
+    r->cycles = DWT_CYCCNT;
+    r->arg = arg;
+    r->event = event;
+}
+
+/**
+  * @brief  开始或暂停记录
+  * @param  enable: 1: 记录，0: 暂停
+  * @retval None
+  */
+void Trace_SetEnabled(uint8_t enable)
+{
+    trace_enabled = enable ? 1 : 0;
+}
+
+/**
+  * @brief  查询是否正在记录
+  * @param  None
+  * @retval 1: 正在记录，0: 已暂停
+  */
+uint8_t Trace_IsEnabled(void)
+{
+    return trace_enabled;
+}
+
+/**
+  * @brief  清空缓冲区
+  * @param  None
+  * @retval None
+  */
+void Trace_Clear(void)
+{
+    uint8_t enabled = trace_enabled;
+
+    trace_enabled = 0;
+    trace_head = 0;
+    trace_enabled = enabled;
+}
+
+/**
+  * @brief  暂停记录，以十六进制行通过串口输出缓冲区中的全部记录，然后恢复原来的状态
+  * @param  None
+  * @retval None
+  * @note   输出格式（主机工具按[TRACE]前缀从串口日志中提取）：
+  *         [TRACE] BEGIN <时钟Hz> <记录数> <被覆盖数>
+  *         [TRACE] THREAD <线程号> <线程名>
+  *         [TRACE] D <每条14个十六进制字符>...
+  *         [TRACE] END
+  *         暂停期间的事件不记录，输出本身不会出现在跟踪中
+  */
+void Trace_Dump(void)
+{
+    uint8_t enabled = trace_enabled;
+    uint32_t head, start, i;
+    const char *name;
+    char line[TRACE_DUMP_PER_LINE * 14 + 1];
+    uint8_t n = 0;
+
+    trace_enabled = 0;
+    head = trace_head;
+    start = (head > TRACE_BUFFER_SIZE) ? head - TRACE_BUFFER_SIZE : 0;
+
+    Serial_Printf("[TRACE] BEGIN %lu %lu %lu\n", SystemCoreClock, head - start, start);
+    for (i = 0; (name = Kernel_GetThreadName(i)) != 0; i++)
+    {
+        Serial_Printf("[TRACE] THREAD %lu %s\n", i, name);
+    }
+
+    for (i = start; i != head; i++)
+    {
+        Trace_Record_t *r = &trace_buffer[i & (TRACE_BUFFER_SIZE - 1)];
+
+        if (r->event == TRACE_EV_NONE)
+        {
+            continue;
+        }
+        sprintf(line + n * 14, "%08lX%02X%04X", (unsigned long)r->cycles, r->event, r->arg);
+        if (++n == TRACE_DUMP_PER_LINE)
+        {
+            Serial_Printf("[TRACE] D %s\n", line);
+            n = 0;
+        }
+    }
+    if (n)
+    {
+        Serial_Printf("[TRACE] D %s\n", line);
+    }
+    Serial_Printf("[TRACE] END\n");
+
+    trace_enabled = enabled;
+}
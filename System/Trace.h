@@ -0,0 +1,98 @@
+#ifndef __TRACE_H
+#define __TRACE_H
+
+#include "stm32f10x.h"
+
+/**
+  * 二进制事件跟踪
+  *
+  * RAM中的环形缓冲区，每条记录8字节：{DWT周期计数, 事件号, 16位参数}。
+  * 写入端用LDREX/STREX原子地占用槽位，中断和线程都可直接调用，不关中断也不加锁；
+  * 缓冲区写满后覆盖最旧的记录。trace命令暂停记录并以十六进制行通过USART1输出，
+  * 由主机工具Tools/trace2chrome.c转换为Chrome trace_event JSON，
+  * 可在chrome://tracing或Perfetto中按时间线查看。
+  * 内核休眠期间CYCCNT停止，Delay_AddCycles补偿周期时写入TRACE_EV_CLOCK_SKIP，
+  * 主机工具据此恢复实际时间。
+  * TRACE_ENABLE定义为0时所有跟踪点编译为空。
+  */
+#ifndef TRACE_ENABLE
+#define TRACE_ENABLE            1
+#endif
+
+/* 环形缓冲区条数，必须为2的幂，每条8字节 */
+#define TRACE_BUFFER_SIZE       256
+
+/**
+  * @brief  事件号，修改时同步修改Tools/trace2chrome.c中的事件表
+  * @note   _BEGIN/_END成对出现，0保留表示槽位尚未写完
+  */
+typedef enum {
+    TRACE_EV_NONE = 0,
+    TRACE_EV_THREAD_SWITCH,     /* 线程切换，arg为线程号 */
+    TRACE_EV_CLOCK_SKIP,        /* 内核休眠补偿，arg为补偿时间（单位16us） */
+    TRACE_EV_IR_ISR,            /* 红外中断，arg为电平 */
+    TRACE_EV_KEY_ISR,           /* 编码器按键中断 */
+    TRACE_EV_UART_RX_ISR,       /* 串口接收中断，arg为收到的字节 */
+    TRACE_EV_RTC_ISR,           /* RTC秒中断 */
+    TRACE_EV_DHT11_BEGIN,       /* DHT11读取 */
+    TRACE_EV_DHT11_END,         /* arg为读取结果，0成功 */
+    TRACE_EV_OLED_BEGIN,        /* OLED刷新（System_Display） */
+    TRACE_EV_OLED_END,
+    TRACE_EV_FLASH_WRITE_BEGIN, /* 写入记录，arg为记录号 */
+    TRACE_EV_FLASH_WRITE_END,
+    TRACE_EV_FLASH_ERASE_BEGIN, /* 擦除，arg为起始扇区号 */
+    TRACE_EV_FLASH_ERASE_END,
+    TRACE_EV_UART_TX_BEGIN,     /* Serial_Printf发送，arg为字节数 */
+    TRACE_EV_UART_TX_END,
+    TRACE_EV_COMMAND_BEGIN,     /* 串口命令处理 */
+    TRACE_EV_COMMAND_END,
+    TRACE_EV_FLASH_DMA_BEGIN,   /* W25Q64 DMA传输，arg为字节数 */
+    TRACE_EV_FLASH_DMA_END,     /* arg为传输结果，0成功 */
+    TRACE_EV_FLASH_SUSPEND,     /* 为读取暂停擦除，arg为擦除的扇区号 */
+    TRACE_EV_FLASH_RESUME,      /* 恢复擦除 */
+    TRACE_EV_COUNT
+} Trace_Event_t;
+
+#if TRACE_ENABLE
+#define TRACE(event, arg)       Trace_Event((event), (arg))
+#else
+#define TRACE(event, arg)       do { } while (0)
+#endif
+
+/**
+  * @brief  写入一条跟踪记录，可在中断和线程中调用
+  * @param  event: 事件号，见Trace_Event_t
+  * @param  arg: 16位参数
+  * @retval None
+  */
+void Trace_Event(uint8_t event, uint16_t arg);
+
+/**
+  * @brief  开始或暂停记录
+  * @param  enable: 1: 记录，0: 暂停
+  * @retval None
+  */
+void Trace_SetEnabled(uint8_t enable);
+
+/**
+  * @brief  查询是否正在记录
+  * @param  None
+  * @retval 1: 正在记录，0: 已暂停
+  */
+uint8_t Trace_IsEnabled(void);
+
+/**
+  * @brief  清空缓冲区
+  * @param  None
+  * @retval None
+  */
+void Trace_Clear(void);
+
+/**
+  * @brief  暂停记录，以十六进制行通过串口输出缓冲区中的全部记录，然后恢复原来的状态
+  * @param  None
+  * @retval None
+  */
+void Trace_Dump(void);
+
+#endif /* __TRACE_H */
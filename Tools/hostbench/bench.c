@@ -0,0 +1,299 @@
+/**
+  * 主机微基准测试
+  *
+  * 测量可在主机上运行的纯C热点路径：CRC16、RTC时间换算、串口命令解析，
+  * 以及基于内存W25Q64替身的记录日志追加和读取/校验。固件源文件原样编译，
+  * 外设访问由shim目录下的替身完成。
+  *
+  * 用法：hostbench [-t 毫秒] [-v] [名称过滤...]
+  *   -t  每项基准的最短运行时间，默认200ms
+  *   -v  命令解析基准把串口输出回显到标准输出
+  *   只运行名称包含任一过滤字符串的基准
+  */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "stm32f10x.h"
+#include "host.h"
+#include "W25Q64.h"
+#include "Journal.h"
+#include "RTC.h"
+
+/* 固件main.c中的函数和变量 */
+void System_Init(void);
+void System_ParseCommand(char *command);
+void System_QueueRecord(DataRecord_t *record);
+void System_FlushRecords(void);
+
+/* 记录读取基准预先写入的记录数：16个扇区 */
+#define BENCH_RECORD_COUNT      (16 * JOURNAL_ENTRIES_PER_SECTOR)
+
+typedef struct {
+    const char *name;
+    uint32_t bytes_per_op;                  /* 每次操作处理的字节数，用于计算吞吐量 */
+    void (*setup)(void);
+    void (*run)(uint64_t iterations);
+    const char *command;                    /* 命令解析基准的命令 */
+} Bench_t;
+
+static volatile uint32_t bench_sink;
+static uint8_t bench_buffer[4096];
+static RTC_TimeTypeDef bench_times[64];
+static const char *bench_command;
+
+/* CRC16 */
+static void Bench_SetupBuffer(void)
+{
+    uint32_t i, x = 12345;
+
+    for (i = 0; i < sizeof(bench_buffer); i++)
+    {
+        x = x * 1103515245 + 12345;
+        bench_buffer[i] = (uint8_t)(x >> 16);
+    }
+}
+
+static void Bench_Crc256(uint64_t n)
+{
+    uint64_t i;
+    for (i = 0; i < n; i++)
+    {
+        bench_sink += W25Q64_CalculateCRC16(bench_buffer + (i & 15) * 256, 256);
+    }
+}
+
+static void Bench_CrcRecord(uint64_t n)
+{
+    uint64_t i;
+    for (i = 0; i < n; i++)
+    {
+        bench_sink += W25Q64_CalculateCRC16(bench_buffer + (i & 255) * 8, sizeof(DataRecord_t) - 2);
+    }
+}
+
+/* RTC时间换算 */
+static void Bench_RtcFromSeconds(uint64_t n)
+{
+    RTC_TimeTypeDef t;
+    uint32_t seconds = 0;
+    uint64_t i;
+
+    for (i = 0; i < n; i++)
+    {
+        seconds += 86413;   /* 每次跨过约一天，覆盖闰年和月末 */
+        if (seconds > 3155760000UL)
+        {
+            seconds -= 3155760000UL;
+        }
+        RTC_ConvertFromSeconds(seconds, &t);
+        bench_sink += t.day;
+    }
+}
+
+static void Bench_SetupTimes(void)
+{
+    uint32_t i;
+
+    for (i = 0; i < 64; i++)
+    {
+        RTC_ConvertFromSeconds(i * 49380013UL, &bench_times[i]);
+    }
+}
+
+static void Bench_RtcToSeconds(uint64_t n)
+{
+    uint64_t i;
+    for (i = 0; i < n; i++)
+    {
+        bench_sink += RTC_ConvertToSeconds(&bench_times[i & 63]);
+    }
+}
+
+/* 串口命令解析，命令缓冲区每次重新复制，与固件中每条命令都是新收到的一致 */
+static void Bench_SetupCommand(void)
+{
+    DataRecord_t record;
+    uint32_t i;
+
+    /* 准备history命令要读取的记录 */
+    if (Journal_GetNext() - Journal_GetFirst() < 32)
+    {
+        memset(&record, 0, sizeof(record));
+        for (i = 0; i < 32; i++)
+        {
+            record.timestamp = 1000 + i * 60;
+            record.temperature = 20 + i % 10;
+            record.humidity = 40 + i % 20;
+            System_QueueRecord(&record);
+            System_FlushRecords();
+        }
+    }
+}
+
+static void Bench_Command(uint64_t n)
+{
+    char command[64];
+    uint64_t i;
+
+    for (i = 0; i < n; i++)
+    {
+        strcpy(command, bench_command);
+        System_ParseCommand(command);
+    }
+}
+
+/* 记录追加：计算CRC并页编程，写满一个扇区时擦除下一个扇区（擦除在替身中为memset） */
+static void Bench_SetupRecords(void)
+{
+    Journal_Clear();
+}
+
+static void Bench_RecordWrite(uint64_t n)
+{
+    DataRecord_t record;
+    uint64_t i;
+
+    memset(&record, 0, sizeof(record));
+    for (i = 0; i < n; i++)
+    {
+        record.timestamp = (uint32_t)i;
+        record.temperature = (uint8_t)i;
+        Journal_Append(&record);
+    }
+}
+
+static void Bench_SetupReadRecords(void)
+{
+    Bench_SetupRecords();
+    Bench_RecordWrite(BENCH_RECORD_COUNT);
+}
+
+static void Bench_RecordRead(uint64_t n)
+{
+    DataRecord_t record;
+    uint64_t i;
+    uint32_t invalid = 0;
+
+    for (i = 0; i < n; i++)
+    {
+        invalid += Journal_Read(Journal_GetFirst() + (uint32_t)(i % BENCH_RECORD_COUNT), &record);
+        bench_sink += record.timestamp;
+    }
+    if (invalid)
+    {
+        fprintf(stderr, "record/read: %u records failed CRC\n", invalid);
+    }
+}
+
+static const Bench_t benches[] = {
+    { "crc16/256B",            256,                        Bench_SetupBuffer,      Bench_Crc256,         0 },
+    { "crc16/record",          sizeof(DataRecord_t) - 2,   Bench_SetupBuffer,      Bench_CrcRecord,      0 },
+    { "rtc/from_seconds",      sizeof(uint32_t),           0,                      Bench_RtcFromSeconds, 0 },
+    { "rtc/to_seconds",        sizeof(RTC_TimeTypeDef),    Bench_SetupTimes,       Bench_RtcToSeconds,   0 },
+    { "parse/help",            0,                          Bench_SetupCommand,     Bench_Command,        "help" },
+    { "parse/status",          0,                          Bench_SetupCommand,     Bench_Command,        "status" },
+    { "parse/time",            0,                          Bench_SetupCommand,     Bench_Command,        "time" },
+    { "parse/history",         0,                          Bench_SetupCommand,     Bench_Command,        "history 10" },
+    { "parse/threshold",       0,                          Bench_SetupCommand,     Bench_Command,        "threshold temp 10 30" },
+    { "parse/unknown",         0,                          Bench_SetupCommand,     Bench_Command,        "bogus" },
+    { "record/write",          sizeof(DataRecord_t),       Bench_SetupRecords,     Bench_RecordWrite,    0 },
+    { "record/read",           sizeof(DataRecord_t),       Bench_SetupReadRecords, Bench_RecordRead,     0 },
+};
+
+static int Bench_Selected(const char *name, int argc, char **argv, int first)
+{
+    int i;
+
+    if (first >= argc)
+    {
+        return 1;
+    }
+    for (i = first; i < argc; i++)
+    {
+        if (strstr(name, argv[i]))
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    uint64_t min_ns = 200000000ULL;
+    int first = 1;
+    size_t b;
+
+    while (first < argc && argv[first][0] == '-')
+    {
+        if (strcmp(argv[first], "-t") == 0 && first + 1 < argc)
+        {
+            min_ns = strtoull(argv[first + 1], NULL, 10) * 1000000ULL;
+            first += 2;
+        }
+        else if (strcmp(argv[first], "-v") == 0)
+        {
+            Host_SerialEcho = 1;
+            first++;
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [-t ms] [-v] [filter...]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    /* 固件初始化：W25Q64、RTC、配置和记录日志都在替身上完成 */
+    {
+        uint8_t echo = Host_SerialEcho;
+        Host_SerialEcho = 0;
+        FlashSim_Reset();
+        System_Init();
+        Host_SerialEcho = echo;
+    }
+
+    printf("%-20s %12s %12s %12s %14s\n", "benchmark", "ops", "ns/op", "MB/s", "serial B/op");
+    for (b = 0; b < sizeof(benches) / sizeof(benches[0]); b++)
+    {
+        const Bench_t *bench = &benches[b];
+        uint64_t n = 1, start, elapsed, serial_start;
+        uint32_t bytes = bench->bytes_per_op;
+        double ns_per_op;
+
+        if (!Bench_Selected(bench->name, argc, argv, first))
+        {
+            continue;
+        }
+        if (bench->setup)
+        {
+            bench->setup();
+        }
+        bench_command = bench->command;
+        if (bench->command)
+        {
+            bytes = (uint32_t)strlen(bench->command);
+        }
+
+        /* 预热一次，然后把次数翻倍直到运行时间达到下限 */
+        bench->run(1);
+        for (;;)
+        {
+            serial_start = Host_SerialBytes;
+            start = Host_Nanos();
+            bench->run(n);
+            elapsed = Host_Nanos() - start;
+            if (elapsed >= min_ns || n >= (1ULL << 40))
+            {
+                break;
+            }
+            n *= (elapsed < min_ns / 16) ? 8 : 2;
+        }
+
+        ns_per_op = (double)elapsed / (double)n;
+        printf("%-20s %12llu %12.1f %12.2f %14.1f\n", bench->name, (unsigned long long)n, ns_per_op,
+               bytes ? (double)bytes * 1e3 / ns_per_op : 0.0,
+               (double)(Host_SerialBytes - serial_start) / (double)n);
+    }
+
+    return 0;
+}
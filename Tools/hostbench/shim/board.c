@@ -0,0 +1,166 @@
+/**
+  * 板级替身：不参与基准测试的驱动和内核的最小主机实现
+  *
+  * 内核按单线程处理：Kernel_Sleep通过调用SysTick_Handler推进模拟时间，立即返回；
+  * 信号量和互斥锁不阻塞。Serial_Printf只格式化并计数，可选回显到标准输出。
+  */
+#include <stdio.h>
+#include <stdarg.h>
+#include "stm32f10x.h"
+#include "host.h"
+#include "OLED.h"
+#include "Serial.h"
+#include "DHT11.h"
+#include "IR.h"
+#include "Buzzer.h"
+#include "Encoder.h"
+#include "Kernel.h"
+#include "Scheduler.h"
+#include "Power.h"
+#include "Supervisor.h"
+
+void SysTick_Handler(void);
+
+uint8_t Host_SerialEcho = 0;
+uint64_t Host_SerialBytes = 0;
+
+/* OLED */
+void OLED_Init(void) { }
+void OLED_Clear(void) { }
+void OLED_ShowChar(uint8_t Line, uint8_t Column, char Char) { (void)Line; (void)Column; (void)Char; }
+void OLED_ShowString(uint8_t Line, uint8_t Column, char *String) { (void)Line; (void)Column; (void)String; }
+void OLED_ShowNum(uint8_t Line, uint8_t Column, uint32_t Number, uint8_t Length) { (void)Line; (void)Column; (void)Number; (void)Length; }
+
+/* 串口 */
+void Serial_Init(void) { }
+
+void Serial_Printf(char *format, ...)
+{
+    char String[128];
+    va_list arg;
+    int length;
+
+    va_start(arg, format);
+    length = vsnprintf(String, sizeof(String), format, arg);
+    va_end(arg);
+
+    if (length > 0)
+    {
+        Host_SerialBytes += (uint32_t)length;
+        if (Host_SerialEcho)
+        {
+            fputs(String, stdout);
+        }
+    }
+}
+
+uint32_t Serial_GetLastRxTick(void) { return 0; }
+uint8_t Serial_IsTxIdle(void) { return 1; }
+
+/* 传感器和执行器 */
+uint8_t DHT11_Init(void) { return 0; }
+
+PT_THREAD(DHT11_ReadPT(PT_t *pt, uint8_t *humi, uint8_t *temp, uint8_t mode, uint8_t *result))
+{
+    (void)pt;
+    (void)mode;
+    *humi = 50;
+    *temp = 25;
+    *result = 0;
+    return PT_ENDED;
+}
+
+void IR_Init(void) { }
+uint8_t IR_GetStatus(void) { return 1; }
+void Buzzer_Init(void) { }
+void Buzzer_Control(uint8_t status) { (void)status; }
+void Buzzer_Beep(uint16_t duration) { (void)duration; }
+void Buzzer_Pattern(uint16_t on_ms, uint16_t off_ms, uint8_t repeat) { (void)on_ms; (void)off_ms; (void)repeat; }
+void Encoder_Init(void) { }
+int16_t Encoder_GetCount(void) { return 0; }
+void Encoder_Update(void) { }
+
+/* 内核 */
+void Kernel_Init(void) { }
+void Kernel_SetIdleHook(void (*hook)(void)) { (void)hook; }
+uint8_t Kernel_GetNextWake(uint32_t *tick) { (void)tick; return 0; }
+
+uint8_t Kernel_CreateThread(Kernel_Thread_t *thread, const char *name, void (*entry)(void),
+                            uint32_t *stack, uint32_t stack_words, uint8_t priority)
+{
+    (void)thread; (void)name; (void)entry; (void)stack; (void)stack_words; (void)priority;
+    return 0;
+}
+
+void Kernel_Start(void) { }
+uint8_t Kernel_InThread(void) { return 1; }
+
+void Kernel_SleepUntil(uint32_t tick)
+{
+    while ((int32_t)(tick - Scheduler_GetTick()) > 0)
+    {
+        SysTick_Handler();
+    }
+}
+
+void Kernel_Sleep(uint32_t ms)
+{
+    Kernel_SleepUntil(Scheduler_GetTick() + ms);
+}
+
+void Kernel_SemInit(Kernel_Sem_t *sem, uint16_t count)
+{
+    sem->count = count;
+}
+
+uint8_t Kernel_SemWait(Kernel_Sem_t *sem, uint32_t timeout)
+{
+    if (sem->count)
+    {
+        sem->count--;
+        return 0;
+    }
+    if (timeout != KERNEL_WAIT_FOREVER)
+    {
+        Kernel_Sleep(timeout);
+    }
+    return 1;
+}
+
+void Kernel_SemPost(Kernel_Sem_t *sem)
+{
+    if (sem->count < 0xFFFF)
+    {
+        sem->count++;
+    }
+}
+
+void Kernel_SchedLock(void) { }
+void Kernel_SchedUnlock(void) { }
+void Kernel_MutexLock(Kernel_Mutex_t *mutex) { (void)mutex; }
+uint8_t Kernel_MutexTryLock(Kernel_Mutex_t *mutex) { (void)mutex; return 0; }
+void Kernel_MutexUnlock(Kernel_Mutex_t *mutex) { (void)mutex; }
+void Kernel_Tick(void) { }
+void Kernel_ReportStats(void) { Serial_Printf("[THREADS] host build, no threads\n"); }
+const char *Kernel_GetThreadName(uint8_t index) { (void)index; return 0; }
+uint8_t Kernel_GetStackUsage(uint8_t index, uint32_t *used, uint32_t *size) { (void)index; (void)used; (void)size; return 0; }
+
+/* 低功耗和看门狗 */
+void Power_Init(void) { }
+void Power_Idle(void) { }
+void Power_SetStopEnabled(uint8_t enable) { (void)enable; }
+uint8_t Power_IsStopEnabled(void) { return 0; }
+void Power_ReportStats(void) { Serial_Printf("[POWER] host build\n"); }
+void Power_ResetStats(void) { }
+
+uint8_t Supervisor_Register(const char *name, uint32_t max_period_ms, uint8_t critical)
+{
+    (void)name; (void)max_period_ms; (void)critical;
+    return 0;
+}
+
+void Supervisor_CheckIn(uint8_t job) { (void)job; }
+void Supervisor_Start(void) { }
+void Supervisor_Tick(void) { }
+void Supervisor_ReportStats(void) { Serial_Printf("[DEADLINES] host build\n"); }
+void Supervisor_ResetStats(void) { }
@@ -0,0 +1,2 @@
+/* Keil在Windows上不区分文件名大小写，DHT11.h写作"delay.h"，主机上转到Delay.h */
+#include "Delay.h"
@@ -0,0 +1,2 @@
+/* Keil在Windows上不区分文件名大小写，DHT11.c写作"dht11.h"，主机上转到DHT11.h */
+#include "DHT11.h"
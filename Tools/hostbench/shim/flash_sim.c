@@ -0,0 +1,291 @@
+/**
+  * W25Q64替身：在SPI字节层面解析W25Q64命令，数据保存在8MB内存中
+  */
+#include <stdlib.h>
+#include <string.h>
+#include "host.h"
+#include "W25Q64.h"
+
+static uint8_t *flash_mem;
+static FlashSim_Stats_t flash_stats;
+
+/* 当前命令的状态 */
+static uint8_t flash_selected;
+static uint8_t flash_cmd;
+static uint32_t flash_phase;        /* 本次片选内已传输的字节数 */
+static uint32_t flash_addr;
+static uint8_t flash_wel;
+static uint8_t flash_ignored;       /* 本次片选的命令在忙期间收到，被忽略 */
+
+/* 忙状态计时，未设置时钟时擦除和编程立即完成 */
+static uint64_t (*flash_now_ns)(void);
+static uint64_t flash_busy_until;
+static uint8_t flash_busy_erase;    /* 正在进行的是扇区或块擦除，可以暂停 */
+static uint8_t flash_suspended;     /* 擦除已暂停（SR2的SUS位） */
+static uint64_t flash_suspend_left; /* 暂停时擦除剩余的时间 */
+
+static void FlashSim_Alloc(void)
+{
+    if (!flash_mem)
+    {
+        flash_mem = malloc(W25Q64_TOTAL_SIZE);
+        memset(flash_mem, 0xFF, W25Q64_TOTAL_SIZE);
+    }
+}
+
+void FlashSim_Reset(void)
+{
+    FlashSim_Alloc();
+    memset(flash_mem, 0xFF, W25Q64_TOTAL_SIZE);
+    memset(&flash_stats, 0, sizeof(flash_stats));
+    flash_selected = 0;
+    flash_wel = 0;
+    flash_busy_until = 0;
+    flash_busy_erase = 0;
+    flash_suspended = 0;
+}
+
+void FlashSim_SetClock(uint64_t (*now_ns)(void))
+{
+    flash_now_ns = now_ns;
+    flash_busy_until = 0;
+    flash_busy_erase = 0;
+    flash_suspended = 0;
+}
+
+static uint8_t FlashSim_IsBusy(void)
+{
+    return flash_now_ns && flash_now_ns() < flash_busy_until;
+}
+
+/* 开始一次持续duration_ns的编程或擦除 */
+static void FlashSim_StartBusy(uint64_t duration_ns)
+{
+    if (flash_now_ns)
+    {
+        flash_busy_until = flash_now_ns() + duration_ns;
+    }
+    flash_busy_erase = 0;
+}
+
+/* 擦除暂停：tSUS后BUSY清零、SUS置位，记录剩余时间；芯片擦除和编程不能暂停 */
+static void FlashSim_Suspend(void)
+{
+    uint64_t now;
+
+    if (!FlashSim_IsBusy() || !flash_busy_erase || flash_suspended)
+    {
+        return;
+    }
+    now = flash_now_ns();
+    flash_suspend_left = flash_busy_until - now;
+    flash_busy_until = now + FLASH_SIM_SUSPEND_NS;
+    flash_suspended = 1;
+    flash_stats.suspends++;
+}
+
+/* 擦除恢复：按剩余时间继续保持BUSY */
+static void FlashSim_Resume(void)
+{
+    if (!flash_suspended || FlashSim_IsBusy())
+    {
+        return;
+    }
+    flash_suspended = 0;
+    FlashSim_StartBusy(flash_suspend_left);
+    flash_busy_erase = 1;
+}
+
+uint8_t *FlashSim_Memory(void)
+{
+    FlashSim_Alloc();
+    return flash_mem;
+}
+
+void FlashSim_GetStats(FlashSim_Stats_t *stats)
+{
+    *stats = flash_stats;
+}
+
+/* 执行擦除，addr按擦除大小对齐 */
+static void FlashSim_Erase(uint32_t size)
+{
+    uint32_t base = (flash_addr & (W25Q64_TOTAL_SIZE - 1)) & ~(size - 1);
+
+    memset(flash_mem + base, 0xFF, size);
+    flash_stats.sector_erases += size / W25Q64_SECTOR_SIZE;
+}
+
+void FlashSim_Select(uint8_t selected)
+{
+    FlashSim_Alloc();
+
+    if (selected == flash_selected)
+    {
+        return;
+    }
+    flash_selected = selected;
+
+    if (selected)
+    {
+        flash_phase = 0;
+        flash_addr = 0;
+        flash_ignored = 0;
+        return;
+    }
+
+    /* 擦除暂停和恢复在片选释放时生效 */
+    if (!flash_ignored && flash_phase >= 1)
+    {
+        if (flash_cmd == W25Q64_CMD_ERASE_SUSPEND)
+        {
+            FlashSim_Suspend();
+        }
+        else if (flash_cmd == W25Q64_CMD_ERASE_RESUME)
+        {
+            FlashSim_Resume();
+        }
+    }
+
+    /* 片选释放时执行擦除，编程和擦除完成后清除WEL；擦除暂停期间不接受新的编程和擦除 */
+    if (flash_wel && !flash_ignored && !flash_suspended)
+    {
+        switch (flash_cmd)
+        {
+            case W25Q64_CMD_SECTOR_ERASE_4KB:
+                if (flash_phase >= 4) FlashSim_Erase(W25Q64_SECTOR_SIZE);
+                FlashSim_StartBusy(FLASH_SIM_SECTOR_ERASE_NS);
+                flash_busy_erase = 1;
+                flash_wel = 0;
+                break;
+            case W25Q64_CMD_BLOCK_ERASE_32KB:
+                if (flash_phase >= 4) FlashSim_Erase(W25Q64_BLOCK_32KB_SIZE);
+                FlashSim_StartBusy(FLASH_SIM_BLOCK32_ERASE_NS);
+                flash_busy_erase = 1;
+                flash_wel = 0;
+                break;
+            case W25Q64_CMD_BLOCK_ERASE_64KB:
+                if (flash_phase >= 4) FlashSim_Erase(W25Q64_BLOCK_64KB_SIZE);
+                FlashSim_StartBusy(FLASH_SIM_BLOCK64_ERASE_NS);
+                flash_busy_erase = 1;
+                flash_wel = 0;
+                break;
+            case W25Q64_CMD_CHIP_ERASE:
+                flash_addr = 0;
+                FlashSim_Erase(W25Q64_TOTAL_SIZE);
+                FlashSim_StartBusy(FLASH_SIM_CHIP_ERASE_NS);
+                flash_wel = 0;
+                break;
+            case W25Q64_CMD_PAGE_PROGRAM:
+                if (flash_phase > 4)
+                {
+                    flash_stats.page_programs++;
+                    FlashSim_StartBusy(FLASH_SIM_PAGE_PROGRAM_NS);
+                }
+                flash_wel = 0;
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+uint8_t FlashSim_Transfer(uint8_t out)
+{
+    uint32_t phase = flash_phase++;
+    uint8_t in = 0xFF;
+
+    flash_stats.transfers++;
+    if (!flash_selected)
+    {
+        return in;
+    }
+
+    if (phase == 0)
+    {
+        flash_cmd = out;
+
+        /* 忙期间只响应读状态寄存器和擦除暂停 */
+        if (out != W25Q64_CMD_READ_STATUS_REG1 && out != W25Q64_CMD_READ_STATUS_REG2 &&
+            out != W25Q64_CMD_ERASE_SUSPEND && FlashSim_IsBusy())
+        {
+            flash_ignored = 1;
+            flash_stats.busy_violations++;
+            return in;
+        }
+        switch (out)
+        {
+            case W25Q64_CMD_WRITE_ENABLE:  flash_wel = 1; break;
+            case W25Q64_CMD_WRITE_DISABLE: flash_wel = 0; break;
+            default: break;
+        }
+        return in;
+    }
+
+    if (flash_ignored)
+    {
+        return in;
+    }
+
+    /* 带24位地址的命令先收地址 */
+    switch (flash_cmd)
+    {
+        case W25Q64_CMD_READ_DATA:
+        case W25Q64_CMD_FAST_READ:
+        case W25Q64_CMD_PAGE_PROGRAM:
+        case W25Q64_CMD_SECTOR_ERASE_4KB:
+        case W25Q64_CMD_BLOCK_ERASE_32KB:
+        case W25Q64_CMD_BLOCK_ERASE_64KB:
+        case W25Q64_CMD_MANUFACTURER_DEVICE_ID:
+            if (phase <= 3)
+            {
+                flash_addr = (flash_addr << 8) | out;
+                return in;
+            }
+            break;
+        default:
+            break;
+    }
+
+    switch (flash_cmd)
+    {
+        case W25Q64_CMD_READ_STATUS_REG1:
+            in = (flash_wel ? W25Q64_SR1_WEL : 0) | (FlashSim_IsBusy() ? W25Q64_SR1_BUSY : 0);
+            break;
+        case W25Q64_CMD_READ_STATUS_REG2:
+            in = flash_suspended ? W25Q64_SR2_SUS : 0;
+            break;
+        case W25Q64_CMD_JEDEC_ID:
+            in = (phase == 1) ? 0xEF : (phase == 2) ? 0x40 : 0x17;
+            break;
+        case W25Q64_CMD_MANUFACTURER_DEVICE_ID:
+            in = ((phase - 4) & 1) ? 0x16 : 0xEF;
+            break;
+        case W25Q64_CMD_RELEASE_POWER_DOWN:
+            in = (phase >= 4) ? 0x16 : 0xFF;
+            break;
+        case W25Q64_CMD_FAST_READ:
+            if (phase == 4)
+            {
+                break;          /* 空周期 */
+            }
+            /* fall through */
+        case W25Q64_CMD_READ_DATA:
+            in = flash_mem[flash_addr & (W25Q64_TOTAL_SIZE - 1)];
+            flash_addr++;
+            flash_stats.bytes_read++;
+            break;
+        case W25Q64_CMD_PAGE_PROGRAM:
+            if (flash_wel)
+            {
+                uint32_t page = flash_addr & ~(uint32_t)(W25Q64_PAGE_SIZE - 1);
+                uint32_t offset = (flash_addr + (phase - 4)) & (W25Q64_PAGE_SIZE - 1);
+                flash_mem[(page + offset) & (W25Q64_TOTAL_SIZE - 1)] &= out;
+                flash_stats.bytes_programmed++;
+            }
+            break;
+        default:
+            break;
+    }
+    return in;
+}
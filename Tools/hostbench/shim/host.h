@@ -0,0 +1,47 @@
+/**
+  * 主机替身的控制接口，供基准程序使用
+  */
+#ifndef __HOST_H
+#define __HOST_H
+
+#include <stdint.h>
+
+/* 串口输出：Serial_Printf只格式化并计数，Host_SerialEcho非0时同时写到标准输出 */
+extern uint8_t Host_SerialEcho;
+extern uint64_t Host_SerialBytes;
+
+/* 主机单调时钟（ns） */
+uint64_t Host_Nanos(void);
+
+/**
+  * W25Q64替身：8MB内存，按NOR Flash语义工作（擦除置0xFF，编程只能把1写成0，
+  * 页编程在256字节页内回绕）。默认擦除和编程立即完成，BUSY始终为0；
+  * 用FlashSim_SetClock设置时钟后按数据手册典型时间保持BUSY，忙期间除读状态寄存器外的命令被忽略；
+  * 扇区和块擦除可以暂停（0x75，tSUS后BUSY清零、SR2的SUS置位，期间可以读取）和恢复（0x7A）
+  */
+typedef struct {
+    uint64_t transfers;         /* SPI传输字节数 */
+    uint64_t bytes_read;        /* 读出的数据字节数 */
+    uint64_t bytes_programmed;  /* 编程的数据字节数 */
+    uint32_t sector_erases;     /* 擦除次数（按4KB扇区计） */
+    uint32_t page_programs;     /* 页编程命令数 */
+    uint32_t busy_violations;   /* 忙期间收到并被忽略的命令数 */
+    uint32_t suspends;          /* 擦除暂停次数 */
+} FlashSim_Stats_t;
+
+/* 典型编程和擦除时间（ns），W25Q64JV数据手册 */
+#define FLASH_SIM_PAGE_PROGRAM_NS       700000ULL
+#define FLASH_SIM_SECTOR_ERASE_NS       45000000ULL
+#define FLASH_SIM_BLOCK32_ERASE_NS      120000000ULL
+#define FLASH_SIM_BLOCK64_ERASE_NS      150000000ULL
+#define FLASH_SIM_CHIP_ERASE_NS         20000000000ULL
+#define FLASH_SIM_SUSPEND_NS            20000ULL        /* tSUS */
+
+void FlashSim_Reset(void);
+void FlashSim_SetClock(uint64_t (*now_ns)(void));
+void FlashSim_Select(uint8_t selected);
+uint8_t FlashSim_Transfer(uint8_t out);
+uint8_t *FlashSim_Memory(void);
+void FlashSim_GetStats(FlashSim_Stats_t *stats);
+
+#endif /* __HOST_H */
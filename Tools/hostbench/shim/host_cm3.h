@@ -0,0 +1,111 @@
+/**
+  * 主机构建用的Cortex-M3内核替身，由Makefile通过-include在每个源文件之前包含
+  *
+  * 先定义core_cm3.h的包含保护宏，使Start/stm32f10x.h中的#include "core_cm3.h"被跳过，
+  * 再提供固件用到的内核寄存器、CMSIS函数和内联指令的主机版本：
+  * 内核寄存器指向普通内存，DWT_CYCCNT由Host_DWT_CYCCNT提供，PRIMASK写入和WFI
+  * 转给Host_SetPrimask/Host_WaitForInterrupt，LDREX/STREX在单线程主机上总是成功。
+  * 这些函数在基准测试中由host_core.c实现（主机单调时钟，开中断不做任何事情），
+  * 在Tools/hostsim中由仿真器实现（虚拟时钟，开中断时投递挂起的中断）。
+  * 外设寄存器指针（GPIOA等）仍按原头文件定义，只作为参数传给shim中的库函数，不会被解引用；
+  * DMA存储器地址由DMA替身登记（Host_DmaAddress），在stdperiph.c和Tools/hostsim/sim_periph.c中实现。
+  */
+#ifndef __HOST_CM3_H
+#define __HOST_CM3_H
+
+#define __CM3_CORE_H__
+
+#include <stdint.h>
+
+#define __I     volatile const
+#define __O     volatile
+#define __IO    volatile
+
+#define __CM3_CMSIS_VERSION_MAIN    (0x01)
+#define __CM3_CMSIS_VERSION_SUB     (0x30)
+#define __CORTEX_M                  (0x03)
+
+/* 内核寄存器，只保留固件用到的成员 */
+typedef struct {
+    __I  uint32_t CPUID;
+    __IO uint32_t ICSR;
+    __IO uint32_t VTOR;
+    __IO uint32_t AIRCR;
+    __IO uint32_t SCR;
+    __IO uint32_t CCR;
+    __IO uint8_t  SHP[12];
+    __IO uint32_t SHCSR;
+} SCB_Type;
+
+typedef struct {
+    __IO uint32_t CTRL;
+    __IO uint32_t LOAD;
+    __IO uint32_t VAL;
+    __I  uint32_t CALIB;
+} SysTick_Type;
+
+typedef struct {
+    __IO uint32_t DHCSR;
+    __O  uint32_t DCRSR;
+    __IO uint32_t DCRDR;
+    __IO uint32_t DEMCR;
+} CoreDebug_Type;
+
+extern SCB_Type Host_SCB;
+extern SysTick_Type Host_SysTick;
+extern CoreDebug_Type Host_CoreDebug;
+
+#define SCB                 (&Host_SCB)
+#define SysTick             (&Host_SysTick)
+#define CoreDebug           (&Host_CoreDebug)
+
+#define SysTick_CTRL_COUNTFLAG_Msk          (1UL << 16)
+#define SysTick_CTRL_CLKSOURCE_Msk          (1UL << 2)
+#define SysTick_CTRL_TICKINT_Msk            (1UL << 1)
+#define SysTick_CTRL_ENABLE_Msk             (1UL << 0)
+#define SysTick_LOAD_RELOAD_Msk             (0xFFFFFFUL)
+#define CoreDebug_DEMCR_TRCENA_Msk          (1UL << 24)
+#define SCB_ICSR_PENDSVSET_Msk              (1UL << 28)
+#define SCB_ICSR_PENDSTSET_Msk              (1UL << 26)
+#define SCB_ICSR_VECTACTIVE_Msk             (0x1FFUL)
+
+/* DWT寄存器，Delay.h在未定义DWT_CYCCNT时才使用固定地址 */
+extern volatile uint32_t Host_DWT_CTRL;
+volatile uint32_t *Host_DWT_CYCCNT(void);
+#define DWT_CTRL            Host_DWT_CTRL
+#define DWT_CYCCNT          (*Host_DWT_CYCCNT())
+
+/* DMA存储器地址：主机指针为64位，放不进DMA_InitTypeDef的32位地址字段。W25Q64.c在未定义
+   DMA_MEMORY_ADDR时直接转换；主机版本登记指针并返回编号，DMA替身用Host_DmaPointer取回 */
+uint32_t Host_DmaAddress(const volatile void *pointer);
+void *Host_DmaPointer(uint32_t address);
+#define DMA_MEMORY_ADDR(p)  Host_DmaAddress(p)
+
+/* CMSIS函数 */
+extern volatile uint32_t Host_PRIMASK;
+void Host_SetPrimask(uint32_t priMask);
+void Host_WaitForInterrupt(void);
+
+static inline uint32_t __get_PRIMASK(void)          { return Host_PRIMASK; }
+static inline void __set_PRIMASK(uint32_t priMask)  { Host_SetPrimask(priMask); }
+static inline void __disable_irq(void)              { Host_PRIMASK = 1; }
+static inline void __enable_irq(void)               { Host_SetPrimask(0); }
+static inline void __NOP(void)                      { }
+static inline void __WFI(void)                      { Host_WaitForInterrupt(); }
+static inline void __WFE(void)                      { }
+static inline void __SEV(void)                      { }
+static inline void __ISB(void)                      { }
+static inline void __DSB(void)                      { }
+static inline void __DMB(void)                      { }
+static inline uint32_t __LDREXW(uint32_t *addr)     { return *addr; }
+static inline uint32_t __STREXW(uint32_t value, uint32_t *addr) { *addr = value; return 0; }
+
+#define NVIC_SetPriority(IRQn, priority)    ((void)(IRQn), (void)(priority))
+#define NVIC_EnableIRQ(IRQn)                ((void)(IRQn))
+#define NVIC_DisableIRQ(IRQn)               ((void)(IRQn))
+#define NVIC_ClearPendingIRQ(IRQn)          ((void)(IRQn))
+
+uint32_t SysTick_Config(uint32_t ticks);
+void NVIC_SystemReset(void);
+
+#endif /* __HOST_CM3_H */
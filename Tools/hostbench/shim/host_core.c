@@ -0,0 +1,65 @@
+/**
+  * 内核寄存器和CMSIS函数的主机实现，见host_cm3.h
+  */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "stm32f10x.h"
+#include "host.h"
+
+SCB_Type Host_SCB;
+SysTick_Type Host_SysTick;
+CoreDebug_Type Host_CoreDebug;
+volatile uint32_t Host_DWT_CTRL;
+volatile uint32_t Host_PRIMASK;
+
+uint32_t SystemCoreClock = 72000000;
+
+uint64_t Host_Nanos(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/**
+  * DWT_CYCCNT：每次读取时按主机时钟换算为SystemCoreClock下的周期数，
+  * 写入（Delay_Init清零）在下一次读取时被覆盖
+  */
+volatile uint32_t *Host_DWT_CYCCNT(void)
+{
+    static uint64_t start;
+    static volatile uint32_t cyccnt;
+    uint64_t now = Host_Nanos();
+
+    if (start == 0)
+    {
+        start = now;
+    }
+    cyccnt = (uint32_t)((now - start) * (SystemCoreClock / 1000000) / 1000);
+    return &cyccnt;
+}
+
+void Host_SetPrimask(uint32_t priMask)
+{
+    Host_PRIMASK = priMask;
+}
+
+void Host_WaitForInterrupt(void)
+{
+}
+
+uint32_t SysTick_Config(uint32_t ticks)
+{
+    Host_SysTick.LOAD = ticks - 1;
+    Host_SysTick.VAL = 0;
+    Host_SysTick.CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_TICKINT_Msk | SysTick_CTRL_ENABLE_Msk;
+    return 0;
+}
+
+void NVIC_SystemReset(void)
+{
+    fprintf(stderr, "host: NVIC_SystemReset called\n");
+    exit(3);
+}
@@ -0,0 +1,290 @@
+/**
+  * 标准外设库函数的主机实现，只覆盖原样编译的固件文件用到的函数
+  *
+  * GPIO只跟踪W25Q64片选，SPI传输转给W25Q64替身；SPI1的DMA传输在使能请求时立即完成，
+  * 并直接调用DMA1通道2的中断处理函数；RTC计数器、备份寄存器保存在内存中；
+  * 时钟和中断配置不做任何事情
+  */
+#include "stm32f10x.h"
+#include "W25Q64.h"
+#include "host.h"
+
+static uint16_t host_bkp[64];
+static uint32_t host_rtc_counter;
+static uint8_t host_lse_on;
+static uint16_t host_spi_rx;
+
+/* DMA1通道2（SPI1_RX）和通道3（SPI1_TX） */
+typedef struct {
+    uint8_t *memory;
+    uint8_t increment;
+    uint16_t count;
+    uint8_t enabled;
+    uint16_t it;
+} Host_DmaChannel_t;
+
+#define HOST_DMA_SLOTS      4
+static const volatile void *host_dma_slots[HOST_DMA_SLOTS];
+static uint32_t host_dma_next;
+static Host_DmaChannel_t host_dma[2];
+static uint32_t host_dma_flags;
+
+void DMA1_Channel2_IRQHandler(void);
+
+/* GPIO */
+void GPIO_Init(GPIO_TypeDef* GPIOx, GPIO_InitTypeDef* GPIO_InitStruct)
+{
+    (void)GPIOx;
+    (void)GPIO_InitStruct;
+}
+
+void GPIO_ResetBits(GPIO_TypeDef* GPIOx, uint16_t GPIO_Pin)
+{
+    if (GPIOx == W25Q64_CS_GPIO_PORT && (GPIO_Pin & W25Q64_CS_PIN))
+    {
+        FlashSim_Select(1);
+    }
+}
+
+void GPIO_SetBits(GPIO_TypeDef* GPIOx, uint16_t GPIO_Pin)
+{
+    if (GPIOx == W25Q64_CS_GPIO_PORT && (GPIO_Pin & W25Q64_CS_PIN))
+    {
+        FlashSim_Select(0);
+    }
+}
+
+/* SPI */
+void SPI_Init(SPI_TypeDef* SPIx, SPI_InitTypeDef* SPI_InitStruct)
+{
+    (void)SPIx;
+    (void)SPI_InitStruct;
+}
+
+void SPI_Cmd(SPI_TypeDef* SPIx, FunctionalState NewState)
+{
+    (void)SPIx;
+    (void)NewState;
+}
+
+FlagStatus SPI_I2S_GetFlagStatus(SPI_TypeDef* SPIx, uint16_t SPI_I2S_FLAG)
+{
+    (void)SPIx;
+    return (SPI_I2S_FLAG == SPI_I2S_FLAG_BSY) ? RESET : SET;
+}
+
+void SPI_I2S_SendData(SPI_TypeDef* SPIx, uint16_t Data)
+{
+    (void)SPIx;
+    host_spi_rx = FlashSim_Transfer((uint8_t)Data);
+}
+
+uint16_t SPI_I2S_ReceiveData(SPI_TypeDef* SPIx)
+{
+    (void)SPIx;
+    return host_spi_rx;
+}
+
+void SPI_I2S_DMACmd(SPI_TypeDef* SPIx, uint16_t SPI_I2S_DMAReq, FunctionalState NewState)
+{
+    Host_DmaChannel_t *rx = &host_dma[0];
+    Host_DmaChannel_t *tx = &host_dma[1];
+    uint16_t i;
+
+    (void)SPIx;
+    (void)SPI_I2S_DMAReq;
+    if (NewState != ENABLE || !rx->enabled || !tx->enabled)
+    {
+        return;
+    }
+
+    /* 两个通道同时搬运，传输立即完成 */
+    for (i = 0; i < rx->count; i++)
+    {
+        uint8_t in = FlashSim_Transfer(tx->memory[tx->increment ? i : 0]);
+
+        rx->memory[rx->increment ? i : 0] = in;
+    }
+    host_dma_flags |= DMA1_IT_GL2 | DMA1_IT_TC2 | DMA1_IT_GL3 | DMA1_IT_TC3;
+    if (rx->it & DMA_IT_TC)
+    {
+        DMA1_Channel2_IRQHandler();
+    }
+}
+
+/* DMA，存储器地址经Host_DmaAddress登记 */
+uint32_t Host_DmaAddress(const volatile void *pointer)
+{
+    uint32_t slot = host_dma_next++ % HOST_DMA_SLOTS;
+
+    host_dma_slots[slot] = pointer;
+    return slot + 1;
+}
+
+void *Host_DmaPointer(uint32_t address)
+{
+    return (void *)host_dma_slots[(address - 1) % HOST_DMA_SLOTS];
+}
+
+static Host_DmaChannel_t *Host_DmaChannel(DMA_Channel_TypeDef* DMAy_Channelx)
+{
+    return (DMAy_Channelx == DMA1_Channel2) ? &host_dma[0] : &host_dma[1];
+}
+
+void DMA_Init(DMA_Channel_TypeDef* DMAy_Channelx, DMA_InitTypeDef* DMA_InitStruct)
+{
+    Host_DmaChannel_t *channel = Host_DmaChannel(DMAy_Channelx);
+
+    channel->memory = Host_DmaPointer(DMA_InitStruct->DMA_MemoryBaseAddr);
+    channel->increment = (DMA_InitStruct->DMA_MemoryInc == DMA_MemoryInc_Enable);
+    channel->count = (uint16_t)DMA_InitStruct->DMA_BufferSize;
+}
+
+void DMA_Cmd(DMA_Channel_TypeDef* DMAy_Channelx, FunctionalState NewState)
+{
+    Host_DmaChannel(DMAy_Channelx)->enabled = (NewState == ENABLE);
+}
+
+void DMA_ITConfig(DMA_Channel_TypeDef* DMAy_Channelx, uint32_t DMA_IT, FunctionalState NewState)
+{
+    Host_DmaChannel_t *channel = Host_DmaChannel(DMAy_Channelx);
+
+    if (NewState == ENABLE)
+    {
+        channel->it |= (uint16_t)DMA_IT;
+    }
+    else
+    {
+        channel->it &= (uint16_t)~DMA_IT;
+    }
+}
+
+ITStatus DMA_GetITStatus(uint32_t DMAy_IT)
+{
+    return (host_dma_flags & DMAy_IT) ? SET : RESET;
+}
+
+void DMA_ClearITPendingBit(uint32_t DMAy_IT)
+{
+    uint8_t n;
+
+    /* 清除全局标志同时清除该通道的全部标志 */
+    for (n = 0; n < 7; n++)
+    {
+        if (DMAy_IT & (DMA1_IT_GL1 << (4 * n)))
+        {
+            DMAy_IT |= 0xFUL << (4 * n);
+        }
+    }
+    host_dma_flags &= ~DMAy_IT;
+}
+
+/* NVIC、RCC、PWR */
+void NVIC_PriorityGroupConfig(uint32_t NVIC_PriorityGroup)
+{
+    (void)NVIC_PriorityGroup;
+}
+
+void NVIC_Init(NVIC_InitTypeDef* NVIC_InitStruct)
+{
+    (void)NVIC_InitStruct;
+}
+
+void RCC_APB1PeriphClockCmd(uint32_t RCC_APB1Periph, FunctionalState NewState)
+{
+    (void)RCC_APB1Periph;
+    (void)NewState;
+}
+
+void RCC_APB2PeriphClockCmd(uint32_t RCC_APB2Periph, FunctionalState NewState)
+{
+    (void)RCC_APB2Periph;
+    (void)NewState;
+}
+
+void RCC_AHBPeriphClockCmd(uint32_t RCC_AHBPeriph, FunctionalState NewState)
+{
+    (void)RCC_AHBPeriph;
+    (void)NewState;
+}
+
+FlagStatus RCC_GetFlagStatus(uint8_t RCC_FLAG)
+{
+    if (RCC_FLAG == RCC_FLAG_LSERDY)
+    {
+        return host_lse_on ? SET : RESET;
+    }
+    return RESET;
+}
+
+void RCC_LSEConfig(uint8_t RCC_LSE)
+{
+    host_lse_on = (RCC_LSE != RCC_LSE_OFF);
+}
+
+void RCC_RTCCLKCmd(FunctionalState NewState)
+{
+    (void)NewState;
+}
+
+void RCC_RTCCLKConfig(uint32_t RCC_RTCCLKSource)
+{
+    (void)RCC_RTCCLKSource;
+}
+
+void PWR_BackupAccessCmd(FunctionalState NewState)
+{
+    (void)NewState;
+}
+
+/* BKP */
+uint16_t BKP_ReadBackupRegister(uint16_t BKP_DR)
+{
+    return host_bkp[(BKP_DR >> 2) & 63];
+}
+
+void BKP_WriteBackupRegister(uint16_t BKP_DR, uint16_t Data)
+{
+    host_bkp[(BKP_DR >> 2) & 63] = Data;
+}
+
+/* RTC */
+uint32_t RTC_GetCounter(void)
+{
+    return host_rtc_counter;
+}
+
+void RTC_SetCounter(uint32_t CounterValue)
+{
+    host_rtc_counter = CounterValue;
+}
+
+void RTC_SetPrescaler(uint32_t PrescalerValue)
+{
+    (void)PrescalerValue;
+}
+
+ITStatus RTC_GetITStatus(uint16_t RTC_IT)
+{
+    (void)RTC_IT;
+    return RESET;
+}
+
+void RTC_ClearITPendingBit(uint16_t RTC_IT)
+{
+    (void)RTC_IT;
+}
+
+void RTC_ITConfig(uint16_t RTC_IT, FunctionalState NewState)
+{
+    (void)RTC_IT;
+    (void)NewState;
+}
+
+void RTC_WaitForLastTask(void)
+{
+}
+
+void RTC_WaitForSynchro(void)
+{
+}
@@ -0,0 +1,112 @@
+/**
+  * 主机仿真器内部接口：虚拟时钟、中断、外设和板级器件模型之间的调用
+  *
+  * 虚拟时间以72MHz内核周期为单位，只在以下地方前进：读DWT_CYCCNT、调用外设库函数、
+  * 跨文件调用Scheduler_GetTick、等待外设标志（串口、SPI按波特率计时）和WFI（跳到下一个事件）；
+  * SPI的DMA传输按字节数计时，完成时挂起DMA中断。
+  * 纯计算不计时间，所以仿真结果反映的是等待和I/O时间，而不是指令周期数。
+  */
+#ifndef __SIM_H
+#define __SIM_H
+
+#include <stdint.h>
+
+/* 内核时钟和APB2时钟（USART1、SPI1） */
+#define SIM_CORE_HZ             72000000ULL
+#define SIM_PCLK2_HZ            72000000ULL
+
+/* 固定开销（周期） */
+#define SIM_CYCCNT_CYCLES       6       /* 读一次DWT_CYCCNT，约等于Delay_us一次循环 */
+#define SIM_ACCESS_CYCLES       12      /* 调用一次外设库函数（函数调用加APB访问） */
+#define SIM_CALL_CYCLES         10      /* 跨文件调用一次Scheduler_GetTick */
+#define SIM_SWITCH_CYCLES       60      /* 一次PendSV上下文切换 */
+
+/* 毫秒、微秒与周期换算 */
+#define SIM_MS(ms)              ((uint64_t)(ms) * (SIM_CORE_HZ / 1000))
+#define SIM_US(us)              ((uint64_t)(us) * (SIM_CORE_HZ / 1000000))
+
+/* 中断源，按数值从小到大的顺序投递（同一抢占优先级下按响应优先级） */
+typedef enum {
+    SIM_IRQ_PVD = 0,            /* 电源电压监测 */
+    SIM_IRQ_EXTI1,              /* 红外 */
+    SIM_IRQ_EXTI15_10,          /* 编码器按键 */
+    SIM_IRQ_USART1,             /* 串口接收 */
+    SIM_IRQ_RTC,                /* RTC秒中断 */
+    SIM_IRQ_DMA1_CH2,           /* W25Q64 DMA传输完成（SPI1_RX） */
+    SIM_IRQ_SYSTICK,            /* 1ms时基，优先级最低 */
+    SIM_IRQ_COUNT
+} Sim_Irq_t;
+
+/* 虚拟时钟 */
+uint64_t Sim_Now(void);
+uint64_t Sim_Nanos(void);
+void Sim_Advance(uint64_t cycles);
+void Sim_AdvanceTo(uint64_t cycles);
+
+/* 中断 */
+void Sim_PendIrq(Sim_Irq_t irq);
+void Sim_Deliver(void);
+
+/* 定时事件，按时刻先后执行，时刻相同时按加入顺序 */
+typedef void (*Sim_EventFunc)(void *arg, uint32_t value);
+void Sim_Schedule(uint64_t when, Sim_EventFunc func, void *arg, uint32_t value);
+
+/* 仿真结束：输出统计并退出进程 */
+void Sim_SetEnd(uint64_t when);
+void Sim_Finish(const char *reason, int code);
+
+/* 外设（sim_periph.c） */
+void Periph_Init(void);
+uint64_t Periph_NextEvent(void);
+void Periph_RunEvents(void);
+void Periph_SetInput(uint8_t port, uint8_t pin, uint8_t level);
+uint8_t Periph_GetOutput(uint8_t port, uint8_t pin);
+uint8_t Periph_IsOutput(uint8_t port, uint8_t pin);
+void Periph_UartReceive(uint8_t byte);
+uint64_t Periph_UartByteCycles(void);
+void Periph_EncoderAdd(int32_t counts);
+void Periph_SetSpiLimit(uint64_t hz);
+void Periph_ReportStats(void);
+
+/* 板级器件（sim_board.c），由外设模型回调 */
+#define SIM_PORT_A              0
+#define SIM_PORT_B              1
+#define SIM_PORT_C              2
+void Board_PinWrite(uint8_t port, uint8_t pin, uint8_t level);
+void Board_PinMode(uint8_t port, uint8_t pin, uint8_t output);
+uint8_t Board_PinRead(uint8_t port, uint8_t pin, uint8_t *level);
+void Board_UartTx(uint8_t byte, uint64_t done);
+
+/* 板级器件，由场景脚本调用 */
+void Board_SetPir(uint8_t motion);
+void Board_PressKey(void);
+void Board_SetDht(int temperature, int humidity, uint8_t present);
+void Board_SendLine(const char *text);
+void Board_DumpScreen(void);
+
+/* 低功耗模块替身（sim_power.c），由场景脚本调用 */
+void Power_SetSupplyLow(uint8_t low);
+
+/* 虚拟时间延迟统计（sim_main.c） */
+typedef struct {
+    const char *name;
+    uint32_t count;
+    uint64_t min;
+    uint64_t max;
+    uint64_t total;
+} Sim_Stat_t;
+
+void Sim_StatAdd(Sim_Stat_t *stat, uint64_t cycles);
+void Sim_StatPrint(const Sim_Stat_t *stat);
+
+/* 内核移植层（sim_port.c） */
+const char *Port_CurrentThreadName(void);
+
+/* 启动和运行统计 */
+extern uint8_t Sim_Quiet;
+extern uint64_t Sim_IdleCycles;
+extern uint64_t Sim_SwitchCount;
+void Board_OnThreadSwitch(const char *name);
+void Board_ReportStats(void);
+
+#endif /* __SIM_H */
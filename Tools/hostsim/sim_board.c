@@ -0,0 +1,432 @@
+/**
+  * 板级器件模型：人体红外、编码器按键、蜂鸣器、DHT11、SSD1306和串口终端
+  *
+  * 器件只通过引脚电平和串口字节与固件交互，由sim_periph.c在引脚写入、读取和串口发送时回调；
+  * 场景脚本通过Board_Set*等函数注入输入。端到端延迟在这里按虚拟时间测量：
+  *   IR->buzzer      红外引脚下降沿到蜂鸣器引脚拉低
+  *   IR->alarm line  红外引脚下降沿到"[ALARM]INTRUSION"一行发送完毕
+  *   cmd->ack        命令最后一个字节（换行）收到到"Received command"一行发送完毕
+  *   cmd->reply      同上，到命令的第一行回复（跳过周期数据）发送完毕
+  *   boot->armed     上电到"[MODE]ARMED"一行发送完毕
+  *   boot->kernel    上电到第一次切换到alarm线程
+  */
+#include <stdio.h>
+#include <string.h>
+#include "host.h"
+#include "sim.h"
+
+/* 引脚 */
+#define BOARD_PIN_DHT11         0       /* PA0 */
+#define BOARD_PIN_IR            1       /* PA1，检测到人体时输出低电平 */
+#define BOARD_PIN_FLASH_CS      4       /* PA4 */
+#define BOARD_PIN_BUZZER        8       /* PA8，低电平鸣叫 */
+#define BOARD_PIN_OLED_SCL      8       /* PB8 */
+#define BOARD_PIN_OLED_SDA      9       /* PB9 */
+#define BOARD_PIN_KEY           10      /* PB10，按下为低电平 */
+
+/* 按键按下保持时间 */
+#define BOARD_KEY_HOLD_MS       80
+
+#define BOARD_NONE              UINT64_MAX
+
+/* 延迟统计 */
+static Sim_Stat_t board_ir_buzzer = { "IR->buzzer" };
+static Sim_Stat_t board_ir_alarm = { "IR->alarm line" };
+static Sim_Stat_t board_cmd_ack = { "cmd->ack" };
+static Sim_Stat_t board_cmd_reply = { "cmd->reply" };
+static Sim_Stat_t board_boot_armed = { "boot->armed" };
+static Sim_Stat_t board_boot_kernel = { "boot->kernel" };
+
+/* 红外和蜂鸣器 */
+static uint64_t board_ir_edge = BOARD_NONE;
+static uint8_t board_wait_buzzer;
+static uint8_t board_wait_alarm_line;
+static uint32_t board_buzzer_on;
+
+/* 串口终端 */
+static char board_line[256];
+static uint16_t board_line_length;
+static uint64_t board_cmd_end = BOARD_NONE;
+static uint8_t board_wait_ack;
+static uint8_t board_wait_reply;
+static uint8_t board_booted;
+
+/* DHT11 */
+static int board_dht_temperature = 25;
+static int board_dht_humidity = 50;
+static uint8_t board_dht_present = 1;
+static uint64_t board_dht_low_since = BOARD_NONE;
+static uint64_t board_dht_start = BOARD_NONE;
+static uint8_t board_dht_frame[5];
+static uint32_t board_dht_reads;
+
+/* SSD1306 */
+static uint8_t board_scl = 1;
+static uint8_t board_sda = 1;
+static uint8_t board_i2c_active;
+static uint8_t board_i2c_bits;
+static uint8_t board_i2c_shift;
+static uint8_t board_i2c_index;
+static uint8_t board_i2c_data;          /* 控制字节为0x40时后续字节为显示数据 */
+static uint8_t board_oled_args;         /* 当前命令剩余的参数字节数 */
+static uint8_t board_oled_on;
+static uint8_t board_oled_page;
+static uint8_t board_oled_column;
+static uint8_t board_oled_ram[8][128];
+static uint32_t board_oled_bytes;
+
+static double Board_Ms(uint64_t cycles)
+{
+    return (double)cycles * 1000.0 / (double)SIM_CORE_HZ;
+}
+
+/* 红外 */
+void Board_SetPir(uint8_t motion)
+{
+    /* 只测量本次检测到人体期间的响应，未报警（非布防模式）时不计入 */
+    board_ir_edge = Sim_Now();
+    board_wait_buzzer = motion;
+    board_wait_alarm_line = motion;
+    Periph_SetInput(SIM_PORT_A, BOARD_PIN_IR, motion ? 0 : 1);
+}
+
+/* 编码器按键 */
+static void Board_ReleaseKey(void *arg, uint32_t value)
+{
+    (void)arg;
+    (void)value;
+    Periph_SetInput(SIM_PORT_B, BOARD_PIN_KEY, 1);
+}
+
+void Board_PressKey(void)
+{
+    Periph_SetInput(SIM_PORT_B, BOARD_PIN_KEY, 0);
+    Sim_Schedule(Sim_Now() + SIM_MS(BOARD_KEY_HOLD_MS), Board_ReleaseKey, 0, 0);
+}
+
+/* 串口终端发送一行，按波特率逐字节送入接收寄存器 */
+static void Board_UartByte(void *arg, uint32_t value)
+{
+    (void)arg;
+    Periph_UartReceive((uint8_t)value);
+    if (value == '\n')
+    {
+        board_cmd_end = Sim_Now();
+        board_wait_ack = 1;
+        board_wait_reply = 0;
+    }
+}
+
+void Board_SendLine(const char *text)
+{
+    uint64_t when = Sim_Now();
+    size_t i;
+
+    for (i = 0; text[i] != '\0'; i++)
+    {
+        when += Periph_UartByteCycles();
+        Sim_Schedule(when, Board_UartByte, 0, (uint8_t)text[i]);
+    }
+    when += Periph_UartByteCycles();
+    Sim_Schedule(when, Board_UartByte, 0, '\n');
+}
+
+/* 串口终端接收到完整的一行 */
+static void Board_UartLine(const char *line, uint64_t done)
+{
+    if (!Sim_Quiet)
+    {
+        printf("[%10.3f] %s\n", Board_Ms(done), line);
+    }
+
+    if (!board_booted && strncmp(line, "[MODE]ARMED", 11) == 0)
+    {
+        board_booted = 1;
+        Sim_StatAdd(&board_boot_armed, done);
+    }
+    if (board_wait_alarm_line && strncmp(line, "[ALARM]INTRUSION", 16) == 0)
+    {
+        board_wait_alarm_line = 0;
+        Sim_StatAdd(&board_ir_alarm, done - board_ir_edge);
+    }
+    if (board_wait_ack && strstr(line, "Received command") != 0)
+    {
+        board_wait_ack = 0;
+        board_wait_reply = 1;
+        Sim_StatAdd(&board_cmd_ack, done - board_cmd_end);
+    }
+    else if (board_wait_reply && strncmp(line, "[DATA]", 6) != 0)
+    {
+        board_wait_reply = 0;
+        Sim_StatAdd(&board_cmd_reply, done - board_cmd_end);
+    }
+}
+
+void Board_UartTx(uint8_t byte, uint64_t done)
+{
+    if (byte == '\r')
+    {
+        return;
+    }
+    if (byte == '\n')
+    {
+        board_line[board_line_length] = '\0';
+        Board_UartLine(board_line, done);
+        board_line_length = 0;
+        return;
+    }
+    if (board_line_length < sizeof(board_line) - 1)
+    {
+        board_line[board_line_length++] = (char)byte;
+    }
+}
+
+/* DHT11 */
+void Board_SetDht(int temperature, int humidity, uint8_t present)
+{
+    board_dht_temperature = temperature;
+    board_dht_humidity = humidity;
+    board_dht_present = present;
+}
+
+/* 主机拉低至少18ms后释放，传感器开始应答，帧内容在此时确定 */
+static void Board_DhtStart(void)
+{
+    board_dht_frame[0] = (uint8_t)board_dht_humidity;
+    board_dht_frame[1] = 0;
+    board_dht_frame[2] = (uint8_t)board_dht_temperature;
+    board_dht_frame[3] = 0;
+    board_dht_frame[4] = (uint8_t)(board_dht_frame[0] + board_dht_frame[2]);
+    board_dht_start = Sim_Now();
+    board_dht_reads++;
+}
+
+/**
+  * 应答和数据波形：释放后约30us高电平，80us低、80us高，
+  * 每位50us低电平加27us（0）或70us（1）高电平，最后50us低电平后释放
+  */
+static uint8_t Board_DhtLevel(uint8_t *level)
+{
+    uint64_t t = Sim_Now() - board_dht_start;
+    uint8_t i;
+
+    if (t < SIM_US(30)) { *level = 1; return 1; }
+    t -= SIM_US(30);
+    if (t < SIM_US(80)) { *level = 0; return 1; }
+    t -= SIM_US(80);
+    if (t < SIM_US(80)) { *level = 1; return 1; }
+    t -= SIM_US(80);
+
+    for (i = 0; i < 40; i++)
+    {
+        uint8_t bit = (board_dht_frame[i / 8] >> (7 - i % 8)) & 1;
+        uint64_t high = bit ? SIM_US(70) : SIM_US(27);
+
+        if (t < SIM_US(50)) { *level = 0; return 1; }
+        t -= SIM_US(50);
+        if (t < high) { *level = 1; return 1; }
+        t -= high;
+    }
+    if (t < SIM_US(50)) { *level = 0; return 1; }
+
+    board_dht_start = BOARD_NONE;
+    return 0;
+}
+
+/* SSD1306，每个命令字节各自一次I2C传输，带参数的命令按参数个数跳过后续字节 */
+static void Board_OledCommand(uint8_t cmd)
+{
+    if (board_oled_args)
+    {
+        board_oled_args--;
+        return;
+    }
+    if ((cmd & 0xF8) == 0xB0)
+    {
+        board_oled_page = cmd & 0x07;
+    }
+    else if ((cmd & 0xF0) == 0x10)
+    {
+        board_oled_column = (uint8_t)((board_oled_column & 0x0F) | ((cmd & 0x07) << 4));
+    }
+    else if ((cmd & 0xF0) == 0x00)
+    {
+        board_oled_column = (uint8_t)((board_oled_column & 0x70) | (cmd & 0x0F));
+    }
+    else if (cmd == 0xAE || cmd == 0xAF)
+    {
+        board_oled_on = cmd & 1;
+    }
+    else if (cmd == 0x21 || cmd == 0x22)
+    {
+        board_oled_args = 2;
+    }
+    else if (cmd == 0x20 || cmd == 0x81 || cmd == 0x8D || cmd == 0xA8 || cmd == 0xD3 ||
+             cmd == 0xD5 || cmd == 0xD9 || cmd == 0xDA || cmd == 0xDB)
+    {
+        board_oled_args = 1;
+    }
+}
+
+static void Board_OledByte(uint8_t byte)
+{
+    switch (board_i2c_index++)
+    {
+        case 0:                 /* 从机地址 */
+            break;
+        case 1:                 /* 控制字节 */
+            board_i2c_data = (byte == 0x40);
+            break;
+        default:
+            if (board_i2c_data)
+            {
+                board_oled_ram[board_oled_page][board_oled_column] = byte;
+                board_oled_column = (board_oled_column + 1) & 0x7F;
+                board_oled_bytes++;
+            }
+            else
+            {
+                Board_OledCommand(byte);
+            }
+            break;
+    }
+}
+
+static void Board_I2cWrite(uint8_t pin, uint8_t level)
+{
+    if (pin == BOARD_PIN_OLED_SDA)
+    {
+        if (board_scl && board_sda && !level)
+        {
+            board_i2c_active = 1;       /* START */
+            board_i2c_bits = 0;
+            board_i2c_index = 0;
+        }
+        else if (board_scl && !board_sda && level)
+        {
+            board_i2c_active = 0;       /* STOP */
+        }
+        board_sda = level;
+        return;
+    }
+
+    if (level && !board_scl && board_i2c_active)
+    {
+        /* 上升沿采样，第9位为应答位 */
+        if (board_i2c_bits < 8)
+        {
+            board_i2c_shift = (uint8_t)((board_i2c_shift << 1) | board_sda);
+        }
+        if (++board_i2c_bits == 9)
+        {
+            board_i2c_bits = 0;
+            Board_OledByte(board_i2c_shift);
+        }
+    }
+    board_scl = level;
+}
+
+void Board_DumpScreen(void)
+{
+    uint8_t row, col;
+
+    printf("[%10.3f] screen%s\n", Board_Ms(Sim_Now()), board_oled_on ? "" : " (display off)");
+    printf("+--------------------------------------------------------------------------------------------------------------------------------+\n");
+    for (row = 0; row < 64; row += 2)
+    {
+        putchar('|');
+        for (col = 0; col < 128; col++)
+        {
+            uint8_t top = (board_oled_ram[row / 8][col] >> (row % 8)) & 1;
+            uint8_t bottom = (board_oled_ram[row / 8][col] >> (row % 8 + 1)) & 1;
+
+            putchar(top ? (bottom ? ':' : '\'') : (bottom ? '.' : ' '));
+        }
+        printf("|\n");
+    }
+    printf("+--------------------------------------------------------------------------------------------------------------------------------+\n");
+}
+
+/* 引脚回调 */
+void Board_PinWrite(uint8_t port, uint8_t pin, uint8_t level)
+{
+    if (port == SIM_PORT_A)
+    {
+        switch (pin)
+        {
+            case BOARD_PIN_FLASH_CS:
+                FlashSim_Select(!level);
+                break;
+            case BOARD_PIN_BUZZER:
+                if (!level)
+                {
+                    board_buzzer_on++;
+                    if (board_wait_buzzer)
+                    {
+                        board_wait_buzzer = 0;
+                        Sim_StatAdd(&board_ir_buzzer, Sim_Now() - board_ir_edge);
+                    }
+                }
+                break;
+            case BOARD_PIN_DHT11:
+                if (!level)
+                {
+                    board_dht_low_since = Sim_Now();
+                    board_dht_start = BOARD_NONE;
+                }
+                else
+                {
+                    if (board_dht_low_since != BOARD_NONE && board_dht_present &&
+                        Sim_Now() - board_dht_low_since >= SIM_MS(18))
+                    {
+                        Board_DhtStart();
+                    }
+                    board_dht_low_since = BOARD_NONE;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    else if (port == SIM_PORT_B && (pin == BOARD_PIN_OLED_SCL || pin == BOARD_PIN_OLED_SDA))
+    {
+        Board_I2cWrite(pin, level);
+    }
+}
+
+void Board_PinMode(uint8_t port, uint8_t pin, uint8_t output)
+{
+    (void)port;
+    (void)pin;
+    (void)output;
+}
+
+uint8_t Board_PinRead(uint8_t port, uint8_t pin, uint8_t *level)
+{
+    if (port == SIM_PORT_A && pin == BOARD_PIN_DHT11 && board_dht_start != BOARD_NONE)
+    {
+        return Board_DhtLevel(level);
+    }
+    return 0;
+}
+
+void Board_OnThreadSwitch(const char *name)
+{
+    if (board_boot_kernel.count == 0 && strcmp(name, "alarm") == 0)
+    {
+        Sim_StatAdd(&board_boot_kernel, Sim_Now());
+    }
+}
+
+void Board_ReportStats(void)
+{
+    Sim_StatPrint(&board_boot_armed);
+    Sim_StatPrint(&board_boot_kernel);
+    Sim_StatPrint(&board_ir_buzzer);
+    Sim_StatPrint(&board_ir_alarm);
+    Sim_StatPrint(&board_cmd_ack);
+    Sim_StatPrint(&board_cmd_reply);
+    printf("[SIM] devices: %lu DHT11 frames, %lu buzzer on, %lu OLED data bytes\n",
+           (unsigned long)board_dht_reads, (unsigned long)board_buzzer_on,
+           (unsigned long)board_oled_bytes);
+}
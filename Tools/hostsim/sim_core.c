@@ -0,0 +1,308 @@
+/**
+  * 虚拟时钟、定时事件和中断投递
+  *
+  * 固件在单个主机线程中运行，线程切换由sim_port.c用ucontext完成。中断在虚拟时间前进、
+  * 开中断（PRIMASK清零）和WFI时投递：挂起的中断按Sim_Irq_t顺序依次在当前栈上调用处理函数，
+  * 处理函数中不再投递（同一抢占优先级，不嵌套），最后处理PendSV。
+  */
+#include <stdio.h>
+#include "stm32f10x.h"
+#include "sim.h"
+
+void PVD_IRQHandler(void);
+void EXTI1_IRQHandler(void);
+void EXTI15_10_IRQHandler(void);
+void USART1_IRQHandler(void);
+void RTC_IRQHandler(void);
+void DMA1_Channel2_IRQHandler(void);
+void SysTick_Handler(void);
+void PendSV_Handler(void);
+
+/* 内核寄存器，见host_cm3.h */
+SCB_Type Host_SCB;
+SysTick_Type Host_SysTick;
+CoreDebug_Type Host_CoreDebug;
+volatile uint32_t Host_DWT_CTRL;
+volatile uint32_t Host_PRIMASK;
+
+uint32_t SystemCoreClock = (uint32_t)SIM_CORE_HZ;
+
+/* 虚拟时钟（周期） */
+static uint64_t sim_now;
+static uint64_t sim_end = UINT64_MAX;
+static uint64_t sim_systick_next = UINT64_MAX;
+uint64_t Sim_IdleCycles;
+
+/* 中断 */
+static uint32_t sim_pending;
+static uint8_t sim_in_isr;
+
+static void (*const sim_handlers[SIM_IRQ_COUNT])(void) = {
+    PVD_IRQHandler,
+    EXTI1_IRQHandler,
+    EXTI15_10_IRQHandler,
+    USART1_IRQHandler,
+    RTC_IRQHandler,
+    DMA1_Channel2_IRQHandler,
+    SysTick_Handler,
+};
+
+/* 向量号，ISR运行期间写入ICSR.VECTACTIVE，Kernel_InThread据此判断 */
+static const uint16_t sim_vectors[SIM_IRQ_COUNT] = {
+    16 + PVD_IRQn,
+    16 + EXTI1_IRQn,
+    16 + EXTI15_10_IRQn,
+    16 + USART1_IRQn,
+    16 + RTC_IRQn,
+    16 + DMA1_Channel2_IRQn,
+    15,
+};
+
+/* 定时事件，按时刻排序 */
+#define SIM_MAX_EVENTS          256
+
+typedef struct {
+    uint64_t when;
+    Sim_EventFunc func;
+    void *arg;
+    uint32_t value;
+} Sim_Event_t;
+
+static Sim_Event_t sim_events[SIM_MAX_EVENTS];
+static uint32_t sim_event_count;
+
+uint64_t Sim_Now(void)
+{
+    return sim_now;
+}
+
+uint64_t Sim_Nanos(void)
+{
+    return sim_now * 1000 / (SIM_CORE_HZ / 1000000);
+}
+
+void Sim_Schedule(uint64_t when, Sim_EventFunc func, void *arg, uint32_t value)
+{
+    uint32_t i;
+
+    if (sim_event_count >= SIM_MAX_EVENTS)
+    {
+        fprintf(stderr, "hostsim: event queue full\n");
+        return;
+    }
+
+    /* 插到同一时刻已有事件之后 */
+    i = sim_event_count++;
+    while (i > 0 && sim_events[i - 1].when > when)
+    {
+        sim_events[i] = sim_events[i - 1];
+        i--;
+    }
+    sim_events[i].when = when;
+    sim_events[i].func = func;
+    sim_events[i].arg = arg;
+    sim_events[i].value = value;
+}
+
+void Sim_SetEnd(uint64_t when)
+{
+    sim_end = when;
+}
+
+static uint64_t Sim_NextEvent(void)
+{
+    uint64_t next = sim_end;
+    uint64_t periph = Periph_NextEvent();
+
+    if (sim_event_count && sim_events[0].when < next)
+    {
+        next = sim_events[0].when;
+    }
+    if (sim_systick_next < next)
+    {
+        next = sim_systick_next;
+    }
+    if (periph < next)
+    {
+        next = periph;
+    }
+    return next;
+}
+
+/* 执行所有已到期的事件 */
+static void Sim_RunDue(void)
+{
+    uint64_t period = (uint64_t)(Host_SysTick.LOAD & SysTick_LOAD_RELOAD_Msk) + 1;
+
+    if (sim_now >= sim_end)
+    {
+        Sim_Finish("end of scenario", 0);
+    }
+
+    if (!(Host_SysTick.CTRL & SysTick_CTRL_ENABLE_Msk))
+    {
+        sim_systick_next = UINT64_MAX;
+    }
+    while (sim_systick_next <= sim_now)
+    {
+        sim_systick_next += period;
+        Host_SysTick.CTRL |= SysTick_CTRL_COUNTFLAG_Msk;
+        if (Host_SysTick.CTRL & SysTick_CTRL_TICKINT_Msk)
+        {
+            Sim_PendIrq(SIM_IRQ_SYSTICK);
+        }
+    }
+
+    Periph_RunEvents();
+
+    while (sim_event_count && sim_events[0].when <= sim_now)
+    {
+        Sim_Event_t event = sim_events[0];
+        uint32_t i;
+
+        for (i = 1; i < sim_event_count; i++)
+        {
+            sim_events[i - 1] = sim_events[i];
+        }
+        sim_event_count--;
+        event.func(event.arg, event.value);
+    }
+}
+
+void Sim_AdvanceTo(uint64_t target)
+{
+    while (1)
+    {
+        uint64_t next = Sim_NextEvent();
+
+        if (next > target)
+        {
+            break;
+        }
+        if (next > sim_now)
+        {
+            sim_now = next;
+        }
+        Sim_RunDue();
+        Sim_Deliver();
+    }
+
+    /* 投递的中断可能切换过线程，回到这里时虚拟时间可能已越过target */
+    if (sim_now < target)
+    {
+        sim_now = target;
+    }
+}
+
+void Sim_Advance(uint64_t cycles)
+{
+    Sim_AdvanceTo(sim_now + cycles);
+}
+
+void Sim_PendIrq(Sim_Irq_t irq)
+{
+    sim_pending |= 1UL << irq;
+}
+
+void Sim_Deliver(void)
+{
+    if (sim_in_isr || Host_PRIMASK)
+    {
+        return;
+    }
+
+    while (1)
+    {
+        if (sim_pending)
+        {
+            uint8_t irq = (uint8_t)__builtin_ctz(sim_pending);
+
+            sim_pending &= ~(1UL << irq);
+            sim_in_isr = 1;
+            Host_SCB.ICSR = (Host_SCB.ICSR & ~SCB_ICSR_VECTACTIVE_Msk) | sim_vectors[irq];
+            Sim_Advance(SIM_ACCESS_CYCLES);     /* 异常进入和返回 */
+            sim_handlers[irq]();
+            Host_SCB.ICSR &= ~SCB_ICSR_VECTACTIVE_Msk;
+            sim_in_isr = 0;
+            continue;
+        }
+        if (Host_SCB.ICSR & SCB_ICSR_PENDSVSET_Msk)
+        {
+            Host_SCB.ICSR &= ~SCB_ICSR_PENDSVSET_Msk;
+            PendSV_Handler();
+            continue;
+        }
+        break;
+    }
+}
+
+/* CMSIS钩子，见host_cm3.h */
+void Host_SetPrimask(uint32_t priMask)
+{
+    Host_PRIMASK = priMask;
+    if (!priMask)
+    {
+        Sim_Deliver();
+    }
+}
+
+/* WFI：没有挂起的中断时跳到下一个事件，跳过的时间计为空闲 */
+void Host_WaitForInterrupt(void)
+{
+    uint64_t next;
+
+    if (sim_pending || (Host_SCB.ICSR & SCB_ICSR_PENDSVSET_Msk))
+    {
+        Sim_Deliver();
+        return;
+    }
+
+    next = Sim_NextEvent();
+    if (next > sim_now)
+    {
+        Sim_IdleCycles += next - sim_now;
+    }
+    Sim_AdvanceTo(next);
+}
+
+/**
+  * DWT_CYCCNT：每次读取前进SIM_CYCCNT_CYCLES，读数为自上次写入以来的虚拟周期数。
+  * 固件写入（Delay_Init清零）时变量与上次返回的值不同，据此重新确定起点
+  */
+volatile uint32_t *Host_DWT_CYCCNT(void)
+{
+    static volatile uint32_t cyccnt;
+    static uint32_t last;
+    static uint64_t base;
+
+    if (cyccnt != last)
+    {
+        base = sim_now - cyccnt;
+    }
+    Sim_Advance(SIM_CYCCNT_CYCLES);
+    cyccnt = last = (uint32_t)(sim_now - base);
+    return &cyccnt;
+}
+
+uint32_t SysTick_Config(uint32_t ticks)
+{
+    Host_SysTick.LOAD = ticks - 1;
+    Host_SysTick.VAL = 0;
+    Host_SysTick.CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_TICKINT_Msk | SysTick_CTRL_ENABLE_Msk;
+    sim_systick_next = sim_now + ticks;
+    return 0;
+}
+
+void NVIC_SystemReset(void)
+{
+    Sim_Finish("NVIC_SystemReset", 3);
+}
+
+/* 跨文件调用Scheduler_GetTick的开销，使内核启动前忙等毫秒计数的循环（PT_Sleep）能推进时间 */
+uint32_t __real_Scheduler_GetTick(void);
+
+uint32_t __wrap_Scheduler_GetTick(void)
+{
+    Sim_Advance(SIM_CALL_CYCLES);
+    return __real_Scheduler_GetTick();
+}
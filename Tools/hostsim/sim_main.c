@@ -0,0 +1,336 @@
+/**
+  * 主机仿真器入口：读取场景脚本，在虚拟时间下运行未经修改的User/main.c
+  *
+  *   hostsim [-q] [-F flash.img] [-t end_ms] scenario.txt
+  *
+  *   -q          不回显固件的串口输出，只输出场景中的screen和最终统计
+  *   -F file     W25Q64内容从文件载入（文件存在时），结束时写回，用于模拟断电重启
+  *   -t ms       仿真结束时刻，覆盖场景中的end
+  *
+  * 场景脚本每行一条：<时刻ms|+间隔ms> <命令>，#开始注释。命令：
+  *   pir on|off          人体红外检测到/未检测到
+  *   key                 按一下编码器按键
+  *   rotate <n>          编码器转动n个计数（负数反转）
+  *   send <text>         串口终端发送一行命令
+  *   dht <temp> <humi>   设置DHT11读数
+  *   dht fail            DHT11不应答
+  *   screen              输出当前OLED画面
+  *   power low|ok        电源电压降到PVD阈值以下/恢复（之后end相当于掉电）
+  *   end                 结束仿真
+  *
+  * 同一输入序列的输出逐字节相同，可直接用diff比较两个版本的固件。
+  */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "host.h"
+#include "W25Q64.h"
+#include "sim.h"
+
+int firmware_main(void);
+
+uint8_t Sim_Quiet;
+static const char *sim_flash_file;
+
+/* 场景命令 */
+typedef enum {
+    SCENE_PIR,
+    SCENE_KEY,
+    SCENE_ROTATE,
+    SCENE_SEND,
+    SCENE_DHT,
+    SCENE_SCREEN,
+    SCENE_POWER
+} Scene_Op_t;
+
+typedef struct {
+    Scene_Op_t op;
+    int a;
+    int b;
+    char text[64];
+} Scene_Cmd_t;
+
+void Sim_StatAdd(Sim_Stat_t *stat, uint64_t cycles)
+{
+    if (stat->count == 0 || cycles < stat->min)
+    {
+        stat->min = cycles;
+    }
+    if (cycles > stat->max)
+    {
+        stat->max = cycles;
+    }
+    stat->total += cycles;
+    stat->count++;
+}
+
+void Sim_StatPrint(const Sim_Stat_t *stat)
+{
+    double scale = 1000000.0 / (double)SIM_CORE_HZ;
+
+    if (stat->count == 0)
+    {
+        printf("[SIM] %-16s no samples\n", stat->name);
+        return;
+    }
+    printf("[SIM] %-16s n=%-4lu min %12.1f us  avg %12.1f us  max %12.1f us\n",
+           stat->name, (unsigned long)stat->count,
+           stat->min * scale, (double)stat->total / stat->count * scale, stat->max * scale);
+}
+
+void Sim_Finish(const char *reason, int code)
+{
+    uint64_t now = Sim_Now();
+
+    printf("[SIM] stopped at %.3f ms: %s\n", (double)now * 1000.0 / SIM_CORE_HZ, reason);
+    Board_ReportStats();
+    Periph_ReportStats();
+    printf("[SIM] cpu: %.1f%% idle, %llu context switches\n",
+           now ? 100.0 * (double)Sim_IdleCycles / (double)now : 0.0,
+           (unsigned long long)Sim_SwitchCount);
+
+    if (sim_flash_file)
+    {
+        FILE *f = fopen(sim_flash_file, "wb");
+
+        if (f == 0 || fwrite(FlashSim_Memory(), 1, W25Q64_TOTAL_SIZE, f) != W25Q64_TOTAL_SIZE)
+        {
+            fprintf(stderr, "hostsim: cannot write %s\n", sim_flash_file);
+            code = 1;
+        }
+        if (f)
+        {
+            fclose(f);
+        }
+    }
+
+    fflush(stdout);
+    exit(code);
+}
+
+static void Scene_Run(void *arg, uint32_t value)
+{
+    Scene_Cmd_t *cmd = arg;
+
+    (void)value;
+    switch (cmd->op)
+    {
+        case SCENE_PIR:    Board_SetPir((uint8_t)cmd->a); break;
+        case SCENE_KEY:    Board_PressKey(); break;
+        case SCENE_ROTATE: Periph_EncoderAdd(cmd->a); break;
+        case SCENE_SEND:   Board_SendLine(cmd->text); break;
+        case SCENE_DHT:    Board_SetDht(cmd->a, cmd->b, cmd->a != -1000); break;
+        case SCENE_SCREEN: Board_DumpScreen(); break;
+        case SCENE_POWER:  Power_SetSupplyLow((uint8_t)cmd->a); break;
+    }
+}
+
+/* 解析一行场景命令，返回0表示成功 */
+static int Scene_Parse(char *text, Scene_Cmd_t *cmd)
+{
+    char word[16];
+    int used = 0;
+
+    if (sscanf(text, "%15s %n", word, &used) != 1)
+    {
+        return 1;
+    }
+    text += used;
+
+    if (strcmp(word, "pir") == 0)
+    {
+        cmd->op = SCENE_PIR;
+        if (strncmp(text, "on", 2) == 0) cmd->a = 1;
+        else if (strncmp(text, "off", 3) == 0) cmd->a = 0;
+        else return 1;
+    }
+    else if (strcmp(word, "key") == 0)
+    {
+        cmd->op = SCENE_KEY;
+    }
+    else if (strcmp(word, "rotate") == 0)
+    {
+        cmd->op = SCENE_ROTATE;
+        return sscanf(text, "%d", &cmd->a) != 1;
+    }
+    else if (strcmp(word, "send") == 0)
+    {
+        cmd->op = SCENE_SEND;
+        snprintf(cmd->text, sizeof(cmd->text), "%s", text);
+    }
+    else if (strcmp(word, "dht") == 0)
+    {
+        cmd->op = SCENE_DHT;
+        if (strncmp(text, "fail", 4) == 0)
+        {
+            cmd->a = -1000;
+            return 0;
+        }
+        return sscanf(text, "%d %d", &cmd->a, &cmd->b) != 2;
+    }
+    else if (strcmp(word, "screen") == 0)
+    {
+        cmd->op = SCENE_SCREEN;
+    }
+    else if (strcmp(word, "power") == 0)
+    {
+        cmd->op = SCENE_POWER;
+        if (strncmp(text, "low", 3) == 0) cmd->a = 1;
+        else if (strncmp(text, "ok", 2) == 0) cmd->a = 0;
+        else return 1;
+    }
+    else
+    {
+        return 1;
+    }
+    return 0;
+}
+
+/* 读取场景脚本，把每条命令加入定时事件，返回最后一条命令的时刻（ms） */
+static uint64_t Scene_Load(const char *path, uint64_t *end_ms)
+{
+    FILE *f = fopen(path, "r");
+    char line[256];
+    uint64_t at = 0;
+    unsigned lineno = 0;
+
+    if (f == 0)
+    {
+        fprintf(stderr, "hostsim: cannot open %s\n", path);
+        exit(1);
+    }
+
+    while (fgets(line, sizeof(line), f))
+    {
+        char *p = line;
+        char *hash = strchr(line, '#');
+        Scene_Cmd_t *cmd;
+        char *rest;
+        unsigned long long t;
+
+        lineno++;
+        if (hash)
+        {
+            *hash = '\0';
+        }
+        line[strcspn(line, "\r\n")] = '\0';
+        for (rest = line + strlen(line); rest > line && (rest[-1] == ' ' || rest[-1] == '\t'); rest--)
+        {
+            rest[-1] = '\0';
+        }
+        while (*p == ' ' || *p == '\t')
+        {
+            p++;
+        }
+        if (*p == '\0')
+        {
+            continue;
+        }
+
+        t = strtoull(*p == '+' ? p + 1 : p, &rest, 10);
+        if (rest == p || rest == p + 1)
+        {
+            fprintf(stderr, "%s:%u: missing time\n", path, lineno);
+            exit(1);
+        }
+        at = (*p == '+') ? at + t : t;
+
+        while (*rest == ' ' || *rest == '\t')
+        {
+            rest++;
+        }
+        if (strncmp(rest, "end", 3) == 0)
+        {
+            *end_ms = at;
+            continue;
+        }
+
+        cmd = calloc(1, sizeof(Scene_Cmd_t));
+        if (Scene_Parse(rest, cmd) != 0)
+        {
+            fprintf(stderr, "%s:%u: bad command '%s'\n", path, lineno, rest);
+            exit(1);
+        }
+        Sim_Schedule(SIM_MS(at), Scene_Run, cmd, 0);
+    }
+
+    fclose(f);
+    return at;
+}
+
+static void Sim_LoadFlash(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+
+    if (f == 0)
+    {
+        return;     /* 第一次运行，从空白Flash开始 */
+    }
+    if (fread(FlashSim_Memory(), 1, W25Q64_TOTAL_SIZE, f) != W25Q64_TOTAL_SIZE)
+    {
+        fprintf(stderr, "hostsim: %s is not a %u byte flash image\n", path, (unsigned)W25Q64_TOTAL_SIZE);
+        exit(1);
+    }
+    fclose(f);
+}
+
+int main(int argc, char **argv)
+{
+    uint64_t end_ms = 0;
+    uint64_t override_ms = 0;
+    uint64_t last_ms;
+    int i;
+
+    for (i = 1; i < argc && argv[i][0] == '-'; i++)
+    {
+        if (strcmp(argv[i], "-q") == 0)
+        {
+            Sim_Quiet = 1;
+        }
+        else if (strcmp(argv[i], "-F") == 0 && i + 1 < argc)
+        {
+            sim_flash_file = argv[++i];
+        }
+        else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+        {
+            override_ms = strtoull(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "-L") == 0 && i + 1 < argc)
+        {
+            Periph_SetSpiLimit(strtoull(argv[++i], NULL, 10) * 1000);
+        }
+        else
+        {
+            break;
+        }
+    }
+    if (i != argc - 1)
+    {
+        fprintf(stderr, "usage: %s [-q] [-F flash.img] [-t end_ms] [-L spi_khz] scenario.txt\n", argv[0]);
+        return 2;
+    }
+
+    FlashSim_Reset();
+    if (sim_flash_file)
+    {
+        Sim_LoadFlash(sim_flash_file);
+    }
+    Periph_Init();
+
+    last_ms = Scene_Load(argv[i], &end_ms);
+    if (override_ms)
+    {
+        end_ms = override_ms;
+    }
+    else if (end_ms == 0)
+    {
+        end_ms = last_ms + 5000;
+    }
+    Sim_SetEnd(SIM_MS(end_ms));
+
+    firmware_main();
+
+    /* 固件的main在Kernel_Start后不会返回 */
+    Sim_Finish("firmware main returned", 1);
+    return 1;
+}
@@ -0,0 +1,871 @@
+/**
+  * 标准外设库函数的仿真实现，只覆盖原样编译的固件文件用到的函数
+  *
+  * 每次调用先前进SIM_ACCESS_CYCLES。GPIO按端口保存输出锁存和方向，输入电平由板级器件
+  * 驱动或取外部电平（默认上拉为高），外部电平变化按EXTI配置挂起中断；USART1和SPI1按
+  * 波特率和预分频计时，等待标志时直接跳到标志置位的时刻；SPI1的DMA传输在使能请求时
+  * 一次搬运全部数据，按字节数计时后置位完成标志并挂起DMA1通道2中断；RTC每秒计数一次并产生秒中断；
+  * 独立看门狗超时后结束仿真。
+  */
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include "stm32f10x.h"
+#include "host.h"
+#include "sim.h"
+
+/* GPIO */
+typedef struct {
+    uint16_t latch;             /* 输出锁存（ODR） */
+    uint16_t output;            /* 1: 输出或复用输出 */
+    uint16_t external;          /* 外部输入电平，由场景脚本设置 */
+} Periph_Port_t;
+
+static Periph_Port_t periph_ports[3];
+
+/* EXTI */
+static uint8_t periph_exti_port[16];
+static uint32_t periph_exti_enabled;
+static uint32_t periph_exti_rising;
+static uint32_t periph_exti_falling;
+static uint32_t periph_exti_pending;
+
+/* USART1 */
+static uint64_t periph_uart_byte_cycles = 10 * SIM_PCLK2_HZ / 115200;
+static uint64_t periph_uart_dr_empty;   /* 数据寄存器转入移位寄存器的时刻 */
+static uint64_t periph_uart_tx_end;     /* 最后一个字节移出的时刻 */
+static uint8_t periph_uart_rxneie;
+static uint8_t periph_uart_rx_full;
+static uint8_t periph_uart_rx_data;
+static uint64_t periph_uart_tx_bytes;
+static uint64_t periph_uart_rx_bytes;
+static uint32_t periph_uart_overruns;
+
+/* SPI1 */
+static uint64_t periph_spi_byte_cycles = 8 * 16;
+static uint64_t periph_spi_hz = SIM_PCLK2_HZ / 16;
+static uint64_t periph_spi_limit_hz;    /* 超过此频率时读回的数据晚一位采样，0为不限制 */
+static uint64_t periph_spi_done;
+static uint8_t periph_spi_rx;
+
+/* DMA1通道2（SPI1_RX）和通道3（SPI1_TX），存储器地址经Host_DmaAddress登记 */
+typedef struct {
+    uint8_t *memory;
+    uint8_t increment;
+    uint16_t count;
+    uint8_t enabled;
+    uint16_t it;
+} Periph_DmaChannel_t;
+
+#define PERIPH_DMA_SLOTS        4
+static const volatile void *periph_dma_slots[PERIPH_DMA_SLOTS];
+static uint32_t periph_dma_next;
+static Periph_DmaChannel_t periph_dma[2];
+static uint32_t periph_dma_flags;
+static uint64_t periph_dma_transfers;
+static uint64_t periph_dma_bytes;
+
+/* TIM3编码器计数 */
+static uint16_t periph_tim3_counter;
+
+/* RTC，LSE经32768分频后每秒计数一次 */
+static uint32_t periph_rtc_counter;
+static uint32_t periph_rtc_alarm;
+static uint16_t periph_rtc_ie;
+static uint16_t periph_rtc_flags;
+static uint64_t periph_rtc_next;
+static uint8_t periph_lse_on;
+static uint16_t periph_bkp[64];
+
+/* 独立看门狗，LSI 40kHz */
+#define PERIPH_LSI_HZ           40000ULL
+static uint8_t periph_iwdg_prescaler;
+static uint16_t periph_iwdg_reload = 0x0FFF;
+static uint8_t periph_iwdg_enabled;
+static uint64_t periph_iwdg_deadline = UINT64_MAX;
+
+static uint8_t Periph_PortIndex(GPIO_TypeDef *GPIOx)
+{
+    if (GPIOx == GPIOA) return SIM_PORT_A;
+    if (GPIOx == GPIOB) return SIM_PORT_B;
+    return SIM_PORT_C;
+}
+
+void Periph_Init(void)
+{
+    uint8_t i;
+
+    for (i = 0; i < 3; i++)
+    {
+        periph_ports[i].external = 0xFFFF;
+    }
+    periph_rtc_next = SIM_MS(1000);
+    FlashSim_SetClock(Sim_Nanos);
+}
+
+uint64_t Periph_NextEvent(void)
+{
+    return (periph_rtc_next < periph_iwdg_deadline) ? periph_rtc_next : periph_iwdg_deadline;
+}
+
+void Periph_RunEvents(void)
+{
+    while (periph_rtc_next <= Sim_Now())
+    {
+        periph_rtc_next += SIM_MS(1000);
+        periph_rtc_counter++;
+        periph_rtc_flags |= RTC_IT_SEC;
+        if (periph_rtc_counter == periph_rtc_alarm)
+        {
+            periph_rtc_flags |= RTC_IT_ALR;
+        }
+        if (periph_rtc_ie & periph_rtc_flags)
+        {
+            Sim_PendIrq(SIM_IRQ_RTC);
+        }
+    }
+
+    if (periph_iwdg_deadline <= Sim_Now())
+    {
+        Sim_Finish("independent watchdog reset", 4);
+    }
+}
+
+/* 外部电平变化，按EXTI配置挂起中断 */
+void Periph_SetInput(uint8_t port, uint8_t pin, uint8_t level)
+{
+    Periph_Port_t *p = &periph_ports[port];
+    uint16_t mask = 1U << pin;
+    uint8_t old = (p->external & mask) != 0;
+    uint32_t line = 1UL << pin;
+
+    if (level)
+    {
+        p->external |= mask;
+    }
+    else
+    {
+        p->external &= ~mask;
+    }
+
+    if (old == level || periph_exti_port[pin] != port || !(periph_exti_enabled & line))
+    {
+        return;
+    }
+    if ((level && (periph_exti_rising & line)) || (!level && (periph_exti_falling & line)))
+    {
+        periph_exti_pending |= line;
+        if (pin == 1)
+        {
+            Sim_PendIrq(SIM_IRQ_EXTI1);
+        }
+        else if (pin >= 10)
+        {
+            Sim_PendIrq(SIM_IRQ_EXTI15_10);
+        }
+    }
+}
+
+uint8_t Periph_GetOutput(uint8_t port, uint8_t pin)
+{
+    return (periph_ports[port].latch >> pin) & 1;
+}
+
+uint8_t Periph_IsOutput(uint8_t port, uint8_t pin)
+{
+    return (periph_ports[port].output >> pin) & 1;
+}
+
+/* 串口接收一个字节，上一个字节未读走时记为溢出并丢弃 */
+void Periph_UartReceive(uint8_t byte)
+{
+    periph_uart_rx_bytes++;
+    if (periph_uart_rx_full)
+    {
+        periph_uart_overruns++;
+        return;
+    }
+    periph_uart_rx_data = byte;
+    periph_uart_rx_full = 1;
+    if (periph_uart_rxneie)
+    {
+        Sim_PendIrq(SIM_IRQ_USART1);
+    }
+}
+
+uint64_t Periph_UartByteCycles(void)
+{
+    return periph_uart_byte_cycles;
+}
+
+void Periph_EncoderAdd(int32_t counts)
+{
+    periph_tim3_counter = (uint16_t)(periph_tim3_counter + counts);
+}
+
+void Periph_SetSpiLimit(uint64_t hz)
+{
+    periph_spi_limit_hz = hz;
+}
+
+/* 链路超过可靠频率时MISO晚一位采样 */
+static uint8_t Periph_SpiReceive(uint8_t in)
+{
+    if (periph_spi_limit_hz && periph_spi_hz > periph_spi_limit_hz)
+    {
+        return (uint8_t)((in >> 1) | 0x80);
+    }
+    return in;
+}
+
+void Periph_ReportStats(void)
+{
+    FlashSim_Stats_t flash;
+
+    FlashSim_GetStats(&flash);
+    printf("[SIM] uart: %llu bytes sent, %llu bytes received, %lu overruns\n",
+           (unsigned long long)periph_uart_tx_bytes, (unsigned long long)periph_uart_rx_bytes,
+           (unsigned long)periph_uart_overruns);
+    printf("[SIM] flash: %llu SPI bytes, %llu read, %llu programmed, %lu page programs, %lu sector erases, %lu suspends, %lu busy violations\n",
+           (unsigned long long)flash.transfers, (unsigned long long)flash.bytes_read,
+           (unsigned long long)flash.bytes_programmed, (unsigned long)flash.page_programs,
+           (unsigned long)flash.sector_erases, (unsigned long)flash.suspends, (unsigned long)flash.busy_violations);
+    printf("[SIM] spi dma: %llu transfers, %llu bytes\n",
+           (unsigned long long)periph_dma_transfers, (unsigned long long)periph_dma_bytes);
+}
+
+/* GPIO */
+void GPIO_Init(GPIO_TypeDef* GPIOx, GPIO_InitTypeDef* GPIO_InitStruct)
+{
+    Periph_Port_t *p = &periph_ports[Periph_PortIndex(GPIOx)];
+    uint8_t output = (GPIO_InitStruct->GPIO_Mode & 0x10) != 0;
+    uint8_t pin;
+
+    Sim_Advance(SIM_ACCESS_CYCLES);
+    for (pin = 0; pin < 16; pin++)
+    {
+        uint16_t mask = 1U << pin;
+
+        if (!(GPIO_InitStruct->GPIO_Pin & mask))
+        {
+            continue;
+        }
+        if (output)
+        {
+            p->output |= mask;
+        }
+        else
+        {
+            p->output &= ~mask;
+            /* 上拉、下拉通过ODR选择 */
+            if (GPIO_InitStruct->GPIO_Mode == GPIO_Mode_IPU)
+            {
+                p->latch |= mask;
+            }
+            else if (GPIO_InitStruct->GPIO_Mode == GPIO_Mode_IPD)
+            {
+                p->latch &= ~mask;
+            }
+        }
+        Board_PinMode(Periph_PortIndex(GPIOx), pin, output);
+    }
+}
+
+static void Periph_GpioWrite(GPIO_TypeDef* GPIOx, uint16_t GPIO_Pin, uint8_t level)
+{
+    uint8_t port = Periph_PortIndex(GPIOx);
+    Periph_Port_t *p = &periph_ports[port];
+    uint8_t pin;
+
+    for (pin = 0; pin < 16; pin++)
+    {
+        uint16_t mask = 1U << pin;
+
+        if (!(GPIO_Pin & mask) || ((p->latch & mask) != 0) == level)
+        {
+            continue;
+        }
+        if (level)
+        {
+            p->latch |= mask;
+        }
+        else
+        {
+            p->latch &= ~mask;
+        }
+        Board_PinWrite(port, pin, level);
+    }
+    Sim_Advance(SIM_ACCESS_CYCLES);
+}
+
+void GPIO_SetBits(GPIO_TypeDef* GPIOx, uint16_t GPIO_Pin)
+{
+    Periph_GpioWrite(GPIOx, GPIO_Pin, 1);
+}
+
+void GPIO_ResetBits(GPIO_TypeDef* GPIOx, uint16_t GPIO_Pin)
+{
+    Periph_GpioWrite(GPIOx, GPIO_Pin, 0);
+}
+
+void GPIO_WriteBit(GPIO_TypeDef* GPIOx, uint16_t GPIO_Pin, BitAction BitVal)
+{
+    Periph_GpioWrite(GPIOx, GPIO_Pin, BitVal != Bit_RESET);
+}
+
+uint8_t GPIO_ReadInputDataBit(GPIO_TypeDef* GPIOx, uint16_t GPIO_Pin)
+{
+    uint8_t port = Periph_PortIndex(GPIOx);
+    Periph_Port_t *p = &periph_ports[port];
+    uint8_t pin = (uint8_t)__builtin_ctz(GPIO_Pin);
+    uint8_t level;
+
+    Sim_Advance(SIM_ACCESS_CYCLES);
+    if (p->output & GPIO_Pin)
+    {
+        return (p->latch & GPIO_Pin) ? Bit_SET : Bit_RESET;
+    }
+    if (Board_PinRead(port, pin, &level))
+    {
+        return level ? Bit_SET : Bit_RESET;
+    }
+    return (p->external & GPIO_Pin) ? Bit_SET : Bit_RESET;
+}
+
+void GPIO_EXTILineConfig(uint8_t GPIO_PortSource, uint8_t GPIO_PinSource)
+{
+    periph_exti_port[GPIO_PinSource & 0x0F] = GPIO_PortSource;
+}
+
+/* EXTI */
+void EXTI_Init(EXTI_InitTypeDef* EXTI_InitStruct)
+{
+    uint32_t line = EXTI_InitStruct->EXTI_Line;
+
+    if (EXTI_InitStruct->EXTI_LineCmd == DISABLE)
+    {
+        periph_exti_enabled &= ~line;
+        return;
+    }
+    periph_exti_enabled |= line;
+    periph_exti_rising &= ~line;
+    periph_exti_falling &= ~line;
+    if (EXTI_InitStruct->EXTI_Trigger != EXTI_Trigger_Falling)
+    {
+        periph_exti_rising |= line;
+    }
+    if (EXTI_InitStruct->EXTI_Trigger != EXTI_Trigger_Rising)
+    {
+        periph_exti_falling |= line;
+    }
+}
+
+ITStatus EXTI_GetITStatus(uint32_t EXTI_Line)
+{
+    Sim_Advance(SIM_ACCESS_CYCLES);
+    return (periph_exti_pending & EXTI_Line) ? SET : RESET;
+}
+
+void EXTI_ClearITPendingBit(uint32_t EXTI_Line)
+{
+    periph_exti_pending &= ~EXTI_Line;
+}
+
+/* USART1 */
+void USART_Init(USART_TypeDef* USARTx, USART_InitTypeDef* USART_InitStruct)
+{
+    (void)USARTx;
+    periph_uart_byte_cycles = 10 * SIM_PCLK2_HZ / USART_InitStruct->USART_BaudRate;
+}
+
+void USART_Cmd(USART_TypeDef* USARTx, FunctionalState NewState)
+{
+    (void)USARTx;
+    (void)NewState;
+}
+
+void USART_ITConfig(USART_TypeDef* USARTx, uint16_t USART_IT, FunctionalState NewState)
+{
+    (void)USARTx;
+    if (USART_IT == USART_IT_RXNE)
+    {
+        periph_uart_rxneie = (NewState != DISABLE);
+    }
+}
+
+/* 写数据寄存器：移位寄存器空闲时立即开始发送，否则排在当前字节之后 */
+void USART_SendData(USART_TypeDef* USARTx, uint16_t Data)
+{
+    uint64_t now = Sim_Now();
+
+    (void)USARTx;
+    if (periph_uart_tx_end <= now)
+    {
+        periph_uart_dr_empty = now;
+        periph_uart_tx_end = now + periph_uart_byte_cycles;
+    }
+    else
+    {
+        periph_uart_dr_empty = periph_uart_tx_end;
+        periph_uart_tx_end += periph_uart_byte_cycles;
+    }
+    periph_uart_tx_bytes++;
+    Board_UartTx((uint8_t)Data, periph_uart_tx_end);
+    Sim_Advance(SIM_ACCESS_CYCLES);
+}
+
+uint16_t USART_ReceiveData(USART_TypeDef* USARTx)
+{
+    (void)USARTx;
+    Sim_Advance(SIM_ACCESS_CYCLES);
+    periph_uart_rx_full = 0;
+    return periph_uart_rx_data;
+}
+
+FlagStatus USART_GetFlagStatus(USART_TypeDef* USARTx, uint16_t USART_FLAG)
+{
+    (void)USARTx;
+    Sim_Advance(SIM_ACCESS_CYCLES);
+    switch (USART_FLAG)
+    {
+        case USART_FLAG_TXE:
+            /* 轮询等待直接跳到数据寄存器变空的时刻 */
+            if (Sim_Now() < periph_uart_dr_empty)
+            {
+                Sim_AdvanceTo(periph_uart_dr_empty);
+            }
+            return SET;
+        case USART_FLAG_TC:
+            return (Sim_Now() >= periph_uart_tx_end) ? SET : RESET;
+        case USART_FLAG_RXNE:
+            return periph_uart_rx_full ? SET : RESET;
+        default:
+            return RESET;
+    }
+}
+
+ITStatus USART_GetITStatus(USART_TypeDef* USARTx, uint16_t USART_IT)
+{
+    (void)USARTx;
+    Sim_Advance(SIM_ACCESS_CYCLES);
+    return (USART_IT == USART_IT_RXNE && periph_uart_rxneie && periph_uart_rx_full) ? SET : RESET;
+}
+
+void USART_ClearITPendingBit(USART_TypeDef* USARTx, uint16_t USART_IT)
+{
+    (void)USARTx;
+    if (USART_IT == USART_IT_RXNE)
+    {
+        periph_uart_rx_full = 0;
+    }
+}
+
+/* Keil的printf经fputc（Serial.c）发送到串口，主机上固件的printf改名为Sim_Printf走同样的路径 */
+int Serial_fputc(int ch, FILE *f);
+
+int Sim_Printf(const char *format, ...)
+{
+    char text[128];
+    va_list arg;
+    int length, i;
+
+    va_start(arg, format);
+    length = vsnprintf(text, sizeof(text), format, arg);
+    va_end(arg);
+    for (i = 0; text[i] != '\0'; i++)
+    {
+        Serial_fputc(text[i], stdout);
+    }
+    return length;
+}
+
+/* SPI1 */
+void SPI_Init(SPI_TypeDef* SPIx, SPI_InitTypeDef* SPI_InitStruct)
+{
+    (void)SPIx;
+    periph_spi_byte_cycles = 8 * (2U << (SPI_InitStruct->SPI_BaudRatePrescaler >> 3));
+    periph_spi_hz = SIM_PCLK2_HZ / (2U << (SPI_InitStruct->SPI_BaudRatePrescaler >> 3));
+}
+
+void SPI_Cmd(SPI_TypeDef* SPIx, FunctionalState NewState)
+{
+    (void)SPIx;
+    (void)NewState;
+}
+
+FlagStatus SPI_I2S_GetFlagStatus(SPI_TypeDef* SPIx, uint16_t SPI_I2S_FLAG)
+{
+    (void)SPIx;
+    Sim_Advance(SIM_ACCESS_CYCLES);
+    switch (SPI_I2S_FLAG)
+    {
+        case SPI_I2S_FLAG_RXNE:
+            if (Sim_Now() < periph_spi_done)
+            {
+                Sim_AdvanceTo(periph_spi_done);
+            }
+            return SET;
+        case SPI_I2S_FLAG_BSY:
+            return (Sim_Now() < periph_spi_done) ? SET : RESET;
+        default:
+            return SET;
+    }
+}
+
+void SPI_I2S_SendData(SPI_TypeDef* SPIx, uint16_t Data)
+{
+    (void)SPIx;
+    periph_spi_rx = Periph_SpiReceive(FlashSim_Transfer((uint8_t)Data));
+    periph_spi_done = Sim_Now() + periph_spi_byte_cycles;
+    Sim_Advance(SIM_ACCESS_CYCLES);
+}
+
+uint16_t SPI_I2S_ReceiveData(SPI_TypeDef* SPIx)
+{
+    (void)SPIx;
+    Sim_Advance(SIM_ACCESS_CYCLES);
+    return periph_spi_rx;
+}
+
+/* DMA传输结束：置位两个通道的完成标志 */
+static void Periph_DmaComplete(void *arg, uint32_t value)
+{
+    (void)arg;
+    (void)value;
+    periph_dma_flags |= DMA1_IT_GL2 | DMA1_IT_TC2 | DMA1_IT_GL3 | DMA1_IT_TC3;
+    if (periph_dma[0].it & DMA_IT_TC)
+    {
+        Sim_PendIrq(SIM_IRQ_DMA1_CH2);
+    }
+}
+
+void SPI_I2S_DMACmd(SPI_TypeDef* SPIx, uint16_t SPI_I2S_DMAReq, FunctionalState NewState)
+{
+    Periph_DmaChannel_t *rx = &periph_dma[0];
+    Periph_DmaChannel_t *tx = &periph_dma[1];
+    uint16_t i;
+
+    (void)SPIx;
+    (void)SPI_I2S_DMAReq;
+    Sim_Advance(SIM_ACCESS_CYCLES);
+    if (NewState != ENABLE || !rx->enabled || !tx->enabled)
+    {
+        return;
+    }
+
+    /* 片选在整个传输期间保持，数据一次搬运，字节连续发送 */
+    for (i = 0; i < rx->count; i++)
+    {
+        uint8_t in = Periph_SpiReceive(FlashSim_Transfer(tx->memory[tx->increment ? i : 0]));
+
+        rx->memory[rx->increment ? i : 0] = in;
+    }
+    periph_dma_transfers++;
+    periph_dma_bytes += rx->count;
+    periph_spi_done = Sim_Now() + rx->count * periph_spi_byte_cycles;
+    Sim_Schedule(periph_spi_done, Periph_DmaComplete, 0, 0);
+}
+
+/* DMA1 */
+uint32_t Host_DmaAddress(const volatile void *pointer)
+{
+    uint32_t slot = periph_dma_next++ % PERIPH_DMA_SLOTS;
+
+    periph_dma_slots[slot] = pointer;
+    return slot + 1;
+}
+
+void *Host_DmaPointer(uint32_t address)
+{
+    return (void *)periph_dma_slots[(address - 1) % PERIPH_DMA_SLOTS];
+}
+
+static Periph_DmaChannel_t *Periph_DmaChannel(DMA_Channel_TypeDef* DMAy_Channelx)
+{
+    return (DMAy_Channelx == DMA1_Channel2) ? &periph_dma[0] : &periph_dma[1];
+}
+
+void DMA_Init(DMA_Channel_TypeDef* DMAy_Channelx, DMA_InitTypeDef* DMA_InitStruct)
+{
+    Periph_DmaChannel_t *channel = Periph_DmaChannel(DMAy_Channelx);
+
+    Sim_Advance(SIM_ACCESS_CYCLES);
+    channel->memory = Host_DmaPointer(DMA_InitStruct->DMA_MemoryBaseAddr);
+    channel->increment = (DMA_InitStruct->DMA_MemoryInc == DMA_MemoryInc_Enable);
+    channel->count = (uint16_t)DMA_InitStruct->DMA_BufferSize;
+}
+
+void DMA_Cmd(DMA_Channel_TypeDef* DMAy_Channelx, FunctionalState NewState)
+{
+    Sim_Advance(SIM_ACCESS_CYCLES);
+    Periph_DmaChannel(DMAy_Channelx)->enabled = (NewState == ENABLE);
+}
+
+void DMA_ITConfig(DMA_Channel_TypeDef* DMAy_Channelx, uint32_t DMA_IT, FunctionalState NewState)
+{
+    Periph_DmaChannel_t *channel = Periph_DmaChannel(DMAy_Channelx);
+
+    Sim_Advance(SIM_ACCESS_CYCLES);
+    if (NewState == ENABLE)
+    {
+        channel->it |= (uint16_t)DMA_IT;
+    }
+    else
+    {
+        channel->it &= (uint16_t)~DMA_IT;
+    }
+}
+
+ITStatus DMA_GetITStatus(uint32_t DMAy_IT)
+{
+    Sim_Advance(SIM_ACCESS_CYCLES);
+    return (periph_dma_flags & DMAy_IT) ? SET : RESET;
+}
+
+void DMA_ClearITPendingBit(uint32_t DMAy_IT)
+{
+    uint8_t n;
+
+    Sim_Advance(SIM_ACCESS_CYCLES);
+    /* 清除全局标志同时清除该通道的全部标志 */
+    for (n = 0; n < 7; n++)
+    {
+        if (DMAy_IT & (DMA1_IT_GL1 << (4 * n)))
+        {
+            DMAy_IT |= 0xFUL << (4 * n);
+        }
+    }
+    periph_dma_flags &= ~DMAy_IT;
+}
+
+/* TIM3 */
+void TIM_TimeBaseInit(TIM_TypeDef* TIMx, TIM_TimeBaseInitTypeDef* TIM_TimeBaseInitStruct)
+{
+    (void)TIMx;
+    (void)TIM_TimeBaseInitStruct;
+}
+
+void TIM_EncoderInterfaceConfig(TIM_TypeDef* TIMx, uint16_t TIM_EncoderMode,
+                                uint16_t TIM_IC1Polarity, uint16_t TIM_IC2Polarity)
+{
+    (void)TIMx;
+    (void)TIM_EncoderMode;
+    (void)TIM_IC1Polarity;
+    (void)TIM_IC2Polarity;
+}
+
+void TIM_ICStructInit(TIM_ICInitTypeDef* TIM_ICInitStruct)
+{
+    memset(TIM_ICInitStruct, 0, sizeof(*TIM_ICInitStruct));
+}
+
+void TIM_ICInit(TIM_TypeDef* TIMx, TIM_ICInitTypeDef* TIM_ICInitStruct)
+{
+    (void)TIMx;
+    (void)TIM_ICInitStruct;
+}
+
+void TIM_Cmd(TIM_TypeDef* TIMx, FunctionalState NewState)
+{
+    (void)TIMx;
+    (void)NewState;
+}
+
+void TIM_SetCounter(TIM_TypeDef* TIMx, uint16_t Counter)
+{
+    (void)TIMx;
+    periph_tim3_counter = Counter;
+}
+
+uint16_t TIM_GetCounter(TIM_TypeDef* TIMx)
+{
+    (void)TIMx;
+    Sim_Advance(SIM_ACCESS_CYCLES);
+    return periph_tim3_counter;
+}
+
+ITStatus TIM_GetITStatus(TIM_TypeDef* TIMx, uint16_t TIM_IT)
+{
+    (void)TIMx;
+    (void)TIM_IT;
+    return RESET;
+}
+
+void TIM_ClearITPendingBit(TIM_TypeDef* TIMx, uint16_t TIM_IT)
+{
+    (void)TIMx;
+    (void)TIM_IT;
+}
+
+/* RTC */
+uint32_t RTC_GetCounter(void)
+{
+    Sim_Advance(SIM_ACCESS_CYCLES);
+    return periph_rtc_counter;
+}
+
+void RTC_SetCounter(uint32_t CounterValue)
+{
+    periph_rtc_counter = CounterValue;
+}
+
+void RTC_SetPrescaler(uint32_t PrescalerValue)
+{
+    (void)PrescalerValue;
+}
+
+void RTC_SetAlarm(uint32_t AlarmValue)
+{
+    periph_rtc_alarm = AlarmValue;
+}
+
+void RTC_ITConfig(uint16_t RTC_IT, FunctionalState NewState)
+{
+    if (NewState != DISABLE)
+    {
+        periph_rtc_ie |= RTC_IT;
+    }
+    else
+    {
+        periph_rtc_ie &= ~RTC_IT;
+    }
+}
+
+ITStatus RTC_GetITStatus(uint16_t RTC_IT)
+{
+    Sim_Advance(SIM_ACCESS_CYCLES);
+    return (periph_rtc_ie & periph_rtc_flags & RTC_IT) ? SET : RESET;
+}
+
+void RTC_ClearITPendingBit(uint16_t RTC_IT)
+{
+    periph_rtc_flags &= ~RTC_IT;
+}
+
+void RTC_WaitForLastTask(void)
+{
+    Sim_Advance(SIM_ACCESS_CYCLES);
+}
+
+void RTC_WaitForSynchro(void)
+{
+    Sim_Advance(SIM_ACCESS_CYCLES);
+}
+
+/* BKP */
+uint16_t BKP_ReadBackupRegister(uint16_t BKP_DR)
+{
+    return periph_bkp[(BKP_DR >> 2) & 63];
+}
+
+void BKP_WriteBackupRegister(uint16_t BKP_DR, uint16_t Data)
+{
+    periph_bkp[(BKP_DR >> 2) & 63] = Data;
+}
+
+/* 独立看门狗 */
+static void Periph_IwdgReload(void)
+{
+    if (periph_iwdg_enabled)
+    {
+        uint64_t ticks = (uint64_t)(periph_iwdg_reload + 1) * (4U << periph_iwdg_prescaler);
+
+        periph_iwdg_deadline = Sim_Now() + ticks * SIM_CORE_HZ / PERIPH_LSI_HZ;
+    }
+}
+
+void IWDG_WriteAccessCmd(uint16_t IWDG_WriteAccess)
+{
+    (void)IWDG_WriteAccess;
+}
+
+void IWDG_SetPrescaler(uint8_t IWDG_Prescaler)
+{
+    periph_iwdg_prescaler = IWDG_Prescaler;
+}
+
+void IWDG_SetReload(uint16_t Reload)
+{
+    periph_iwdg_reload = Reload;
+}
+
+void IWDG_ReloadCounter(void)
+{
+    Sim_Advance(SIM_ACCESS_CYCLES);
+    Periph_IwdgReload();
+}
+
+void IWDG_Enable(void)
+{
+    periph_iwdg_enabled = 1;
+    Periph_IwdgReload();
+}
+
+void DBGMCU_Config(uint32_t DBGMCU_Periph, FunctionalState NewState)
+{
+    (void)DBGMCU_Periph;
+    (void)NewState;
+}
+
+/* NVIC、RCC、PWR */
+void NVIC_PriorityGroupConfig(uint32_t NVIC_PriorityGroup)
+{
+    (void)NVIC_PriorityGroup;
+}
+
+void NVIC_Init(NVIC_InitTypeDef* NVIC_InitStruct)
+{
+    (void)NVIC_InitStruct;
+}
+
+void RCC_APB1PeriphClockCmd(uint32_t RCC_APB1Periph, FunctionalState NewState)
+{
+    (void)RCC_APB1Periph;
+    (void)NewState;
+}
+
+void RCC_AHBPeriphClockCmd(uint32_t RCC_AHBPeriph, FunctionalState NewState)
+{
+    (void)RCC_AHBPeriph;
+    (void)NewState;
+}
+
+void RCC_APB2PeriphClockCmd(uint32_t RCC_APB2Periph, FunctionalState NewState)
+{
+    (void)RCC_APB2Periph;
+    (void)NewState;
+}
+
+FlagStatus RCC_GetFlagStatus(uint8_t RCC_FLAG)
+{
+    Sim_Advance(SIM_ACCESS_CYCLES);
+    if (RCC_FLAG == RCC_FLAG_LSERDY)
+    {
+        return periph_lse_on ? SET : RESET;
+    }
+    return RESET;
+}
+
+void RCC_ClearFlag(void)
+{
+}
+
+void RCC_LSEConfig(uint8_t RCC_LSE)
+{
+    periph_lse_on = (RCC_LSE != RCC_LSE_OFF);
+}
+
+void RCC_RTCCLKCmd(FunctionalState NewState)
+{
+    (void)NewState;
+}
+
+void RCC_RTCCLKConfig(uint32_t RCC_RTCCLKSource)
+{
+    (void)RCC_RTCCLKSource;
+}
+
+void PWR_BackupAccessCmd(FunctionalState NewState)
+{
+    (void)NewState;
+}
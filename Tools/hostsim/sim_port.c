@@ -0,0 +1,94 @@
+/**
+  * 内核移植层的主机实现，替代System/KernelPort.c
+  *
+  * 每个线程一个ucontext和独立的主机栈（固件的栈数组仍被填充但不使用，栈高水位统计无意义），
+  * Kernel_Thread_t.sp保存SimThread指针。PendSV与硬件版本的顺序相同：关中断、记录
+  * Kernel_SwitchBegin、Kernel_SelectNext、记录Kernel_SwitchEnd、开中断后切换到新线程。
+  */
+#include <stdio.h>
+#include <stdlib.h>
+#include <ucontext.h>
+#include "Kernel.h"
+#include "Delay.h"
+#include "sim.h"
+
+/* 主机栈大小，线程中会调用vsnprintf等库函数 */
+#define SIM_THREAD_STACK        (256 * 1024)
+
+typedef struct {
+    ucontext_t context;
+    void (*entry)(void);
+    void (*exit)(void);
+} SimThread;
+
+static ucontext_t port_boot_context;
+static SimThread *port_current;
+uint64_t Sim_SwitchCount;
+
+static void Port_Trampoline(void)
+{
+    SimThread *thread = port_current;
+
+    thread->entry();
+    thread->exit();
+}
+
+uint32_t *Kernel_PortInitStack(uint32_t *stack_top, void (*entry)(void), void (*thread_exit)(void))
+{
+    SimThread *thread = calloc(1, sizeof(SimThread));
+
+    (void)stack_top;
+    if (thread == 0 || getcontext(&thread->context) != 0)
+    {
+        fprintf(stderr, "hostsim: cannot create thread context\n");
+        exit(1);
+    }
+    thread->entry = entry;
+    thread->exit = thread_exit;
+    thread->context.uc_stack.ss_sp = malloc(SIM_THREAD_STACK);
+    thread->context.uc_stack.ss_size = SIM_THREAD_STACK;
+    thread->context.uc_link = 0;
+    makecontext(&thread->context, Port_Trampoline, 0);
+
+    return (uint32_t *)thread;
+}
+
+void Kernel_PortStart(void)
+{
+    SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+    __enable_irq();
+
+    /* PendSV会立即切换到线程，不会执行到这里 */
+    fprintf(stderr, "hostsim: kernel did not start\n");
+    exit(1);
+}
+
+void PendSV_Handler(void)
+{
+    SimThread *prev = port_current;
+    SimThread *next;
+
+    Host_PRIMASK = 1;
+    Kernel_SwitchBegin = DWT_CYCCNT;
+    Kernel_SelectNext();
+    Sim_Advance(SIM_SWITCH_CYCLES);
+    Kernel_SwitchEnd = DWT_CYCCNT;
+
+    next = (SimThread *)Kernel_Current->sp;
+    if (next == prev)
+    {
+        Host_PRIMASK = 0;
+        return;
+    }
+
+    Sim_SwitchCount++;
+    Board_OnThreadSwitch(Kernel_Current->name);
+    port_current = next;
+    Host_PRIMASK = 0;
+    swapcontext(prev ? &prev->context : &port_boot_context, &next->context);
+}
+
+const char *Port_CurrentThreadName(void)
+{
+    return (port_current && Kernel_Current) ? Kernel_Current->name : "main";
+}
@@ -0,0 +1,64 @@
+/**
+  * 低功耗模块的仿真替身，替代System/Power.c
+  *
+  * 不安装空闲钩子，空闲线程直接WFI，仿真器据此跳到下一个事件。Power.c按空闲时长
+  * 重装SysTick和设置RTC闹钟的逻辑依赖寄存器级时序，不在仿真范围内。
+  * PVD由场景脚本的power命令触发，中断函数与Power.c相同，投递EVENT_POWER_LOW。
+  */
+#include "Power.h"
+#include "Serial.h"
+#include "Event.h"
+#include "sim.h"
+
+static uint8_t power_stop_enabled = 0;
+static uint8_t power_supply_low = 0;
+static uint32_t power_pvd_count = 0;
+
+void Power_SetSupplyLow(uint8_t low)
+{
+    if (low != power_supply_low)
+    {
+        power_supply_low = low;
+        Sim_PendIrq(SIM_IRQ_PVD);
+    }
+}
+
+void PVD_IRQHandler(void)
+{
+    if (power_supply_low)
+    {
+        power_pvd_count++;
+    }
+    Event_Post(EVENT_POWER_LOW, power_supply_low);
+}
+
+void Power_Init(void)
+{
+}
+
+void Power_Idle(void)
+{
+    __WFI();
+}
+
+void Power_SetStopEnabled(uint8_t enable)
+{
+    power_stop_enabled = enable;
+}
+
+uint8_t Power_IsStopEnabled(void)
+{
+    return power_stop_enabled;
+}
+
+void Power_ReportStats(void)
+{
+    Serial_Printf("[POWER] Host simulation: idle thread waits with WFI, Stop mode %s but not simulated\n",
+                  power_stop_enabled ? "enabled" : "disabled");
+    Serial_Printf("[POWER] Supply: %s, %lu drops below the PVD threshold\n",
+                  power_supply_low ? "low" : "OK", power_pvd_count);
+}
+
+void Power_ResetStats(void)
+{
+}
@@ -0,0 +1,285 @@
+/**
+  * trace2chrome - 把trace命令输出的二进制事件跟踪转换为Chrome trace_event JSON
+  *
+  * 编译：cc -std=c99 -O2 -o trace2chrome Tools/trace2chrome.c
+  * 用法：trace2chrome [串口日志文件] > trace.json
+  *       不指定文件时从标准输入读取。日志中可以混有其他输出，只处理带[TRACE]前缀的行；
+  *       包含多次输出时转换最后一次。结果在chrome://tracing或ui.perfetto.dev中打开。
+  *
+  * 时间换算：记录中是32位DWT_CYCCNT，按相邻记录的有符号差值累加（允许中断抢占造成的
+  * 少量乱序），因此相邻两条记录的间隔不能超过2^31个周期（72MHz下约29.8秒）。
+  * TRACE_EV_CLOCK_SKIP表示内核休眠期间CYCCNT停止的时间，之后的记录顺延这段时间。
+  */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+/* 每条记录的十六进制字符数：周期计数8位、事件号2位、参数4位 */
+#define RECORD_CHARS    14
+
+#define MAX_RECORDS     4096
+#define MAX_THREADS     16
+#define MAX_LINE        1024
+
+/* 时间线上的轨道 */
+enum {
+    TID_THREADS = 1,
+    TID_ISR,
+    TID_SLEEP,
+    TID_DHT11,
+    TID_OLED,
+    TID_FLASH,
+    TID_UART,
+    TID_COMMAND
+};
+
+static const char *track_names[] = {
+    "", "Threads", "ISR", "Sleep", "DHT11", "OLED", "Flash", "UART TX", "Command"
+};
+
+/* 事件表，与System/Trace.h中的Trace_Event_t顺序一致
+   phase: 'B'/'E'开始/结束，'i'瞬时事件，'S'线程切换，'K'休眠补偿 */
+typedef struct {
+    const char *name;
+    char phase;
+    int tid;
+} EventInfo;
+
+static const EventInfo events[] = {
+    { "none",           0,   0 },
+    { "thread switch",  'S', TID_THREADS },
+    { "sleep",          'K', TID_SLEEP },
+    { "IR ISR",         'i', TID_ISR },
+    { "key ISR",        'i', TID_ISR },
+    { "UART RX ISR",    'i', TID_ISR },
+    { "RTC ISR",        'i', TID_ISR },
+    { "DHT11 read",     'B', TID_DHT11 },
+    { "DHT11 read",     'E', TID_DHT11 },
+    { "OLED refresh",   'B', TID_OLED },
+    { "OLED refresh",   'E', TID_OLED },
+    { "flash write",    'B', TID_FLASH },
+    { "flash write",    'E', TID_FLASH },
+    { "flash erase",    'B', TID_FLASH },
+    { "flash erase",    'E', TID_FLASH },
+    { "Serial_Printf",  'B', TID_UART },
+    { "Serial_Printf",  'E', TID_UART },
+    { "command",        'B', TID_COMMAND },
+    { "command",        'E', TID_COMMAND },
+    { "flash DMA",      'B', TID_FLASH },
+    { "flash DMA",      'E', TID_FLASH },
+    { "erase suspended", 'B', TID_FLASH },
+    { "erase suspended", 'E', TID_FLASH },
+};
+
+#define EVENT_COUNT     (sizeof(events) / sizeof(events[0]))
+
+typedef struct {
+    uint32_t cycles;
+    uint8_t event;
+    uint16_t arg;
+} Record;
+
+static Record records[MAX_RECORDS];
+static size_t record_count;
+static char thread_names[MAX_THREADS][32];
+static unsigned long clock_hz = 72000000;
+static unsigned long lost_count;
+
+/* 解析一个十六进制字段 */
+static int parse_hex(const char *s, int digits, uint32_t *value)
+{
+    uint32_t v = 0;
+    int i;
+
+    for (i = 0; i < digits; i++)
+    {
+        char c = s[i];
+        v <<= 4;
+        if (c >= '0' && c <= '9')      v |= (uint32_t)(c - '0');
+        else if (c >= 'A' && c <= 'F') v |= (uint32_t)(c - 'A' + 10);
+        else if (c >= 'a' && c <= 'f') v |= (uint32_t)(c - 'a' + 10);
+        else return -1;
+    }
+    *value = v;
+    return 0;
+}
+
+/* 处理一行[TRACE]输出，p指向前缀之后的内容 */
+static void parse_line(const char *p)
+{
+    if (strncmp(p, "BEGIN", 5) == 0)
+    {
+        unsigned long count = 0;
+
+        /* 新的一次输出，丢弃之前的内容 */
+        record_count = 0;
+        lost_count = 0;
+        memset(thread_names, 0, sizeof(thread_names));
+        sscanf(p + 5, "%lu %lu %lu", &clock_hz, &count, &lost_count);
+        if (clock_hz == 0)
+        {
+            clock_hz = 72000000;
+        }
+    }
+    else if (strncmp(p, "THREAD", 6) == 0)
+    {
+        unsigned index;
+        char name[32];
+
+        if (sscanf(p + 6, "%u %31s", &index, name) == 2 && index < MAX_THREADS)
+        {
+            strcpy(thread_names[index], name);
+        }
+    }
+    else if (p[0] == 'D' && p[1] == ' ')
+    {
+        p += 2;
+        while (record_count < MAX_RECORDS)
+        {
+            uint32_t cycles, event, arg;
+
+            if (parse_hex(p, 8, &cycles) || parse_hex(p + 8, 2, &event) || parse_hex(p + 10, 4, &arg))
+            {
+                break;
+            }
+            records[record_count].cycles = cycles;
+            records[record_count].event = (uint8_t)event;
+            records[record_count].arg = (uint16_t)arg;
+            record_count++;
+            p += RECORD_CHARS;
+        }
+    }
+}
+
+/* 输出一个JSON事件，first用于处理逗号 */
+static void emit(int *first, const char *name, char phase, int tid, double ts, double dur, long arg)
+{
+    printf("%s\n{\"name\":\"%s\",\"ph\":\"%c\",\"pid\":1,\"tid\":%d,\"ts\":%.3f",
+           *first ? "" : ",", name, phase, tid, ts);
+    if (phase == 'X')
+    {
+        printf(",\"dur\":%.3f", dur);
+    }
+    if (phase == 'i')
+    {
+        printf(",\"s\":\"t\"");
+    }
+    if (arg >= 0)
+    {
+        printf(",\"args\":{\"arg\":%ld}", arg);
+    }
+    printf("}");
+    *first = 0;
+}
+
+int main(int argc, char **argv)
+{
+    FILE *in = stdin;
+    char line[MAX_LINE];
+    int64_t t = 0;              /* 累计周期数 */
+    double offset_us = 0;       /* 累计的休眠补偿 */
+    int current_thread = -1;
+    char thread_label[48];
+    int first = 1;
+    size_t i;
+    int tid;
+
+    if (argc > 2 || (argc == 2 && strcmp(argv[1], "-h") == 0))
+    {
+        fprintf(stderr, "usage: %s [capture.log] > trace.json\n", argv[0]);
+        return 2;
+    }
+    if (argc == 2 && (in = fopen(argv[1], "r")) == NULL)
+    {
+        perror(argv[1]);
+        return 1;
+    }
+
+    while (fgets(line, sizeof(line), in))
+    {
+        const char *p = strstr(line, "[TRACE] ");
+        if (p)
+        {
+            parse_line(p + 8);
+        }
+    }
+    if (in != stdin)
+    {
+        fclose(in);
+    }
+
+    if (record_count == 0)
+    {
+        fprintf(stderr, "no [TRACE] records found\n");
+        return 1;
+    }
+    if (lost_count)
+    {
+        fprintf(stderr, "note: %lu older records were overwritten on the target\n", lost_count);
+    }
+
+    printf("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+
+    /* 轨道名称 */
+    for (tid = TID_THREADS; tid <= TID_COMMAND; tid++)
+    {
+        printf("%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+               first ? "" : ",", tid, track_names[tid]);
+        first = 0;
+    }
+
+    for (i = 0; i < record_count; i++)
+    {
+        const Record *r = &records[i];
+        const EventInfo *e;
+        double ts;
+
+        if (i > 0)
+        {
+            t += (int32_t)(r->cycles - records[i - 1].cycles);
+        }
+        ts = (double)t * 1e6 / (double)clock_hz + offset_us;
+
+        if (r->event == 0 || r->event >= EVENT_COUNT)
+        {
+            fprintf(stderr, "skipping unknown event %u\n", r->event);
+            continue;
+        }
+        e = &events[r->event];
+
+        switch (e->phase)
+        {
+            case 'S':
+                /* 结束上一个线程的运行区间，开始新线程的区间 */
+                if (current_thread >= 0)
+                {
+                    emit(&first, thread_label, 'E', e->tid, ts, 0, -1);
+                }
+                current_thread = r->arg;
+                if (r->arg < MAX_THREADS && thread_names[r->arg][0])
+                {
+                    snprintf(thread_label, sizeof(thread_label), "%s", thread_names[r->arg]);
+                }
+                else
+                {
+                    snprintf(thread_label, sizeof(thread_label), "thread %u", r->arg);
+                }
+                emit(&first, thread_label, 'B', e->tid, ts, 0, -1);
+                break;
+
+            case 'K':
+                /* 内核时钟停止了arg*16us，画出休眠区间并顺延之后的记录 */
+                emit(&first, e->name, 'X', e->tid, ts, r->arg * 16.0, -1);
+                offset_us += r->arg * 16.0;
+                break;
+
+            default:
+                emit(&first, e->name, e->phase, e->tid, ts, 0, r->arg);
+                break;
+        }
+    }
+
+    printf("\n]}\n");
+    return 0;
+}
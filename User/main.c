@@ -10,6 +10,20 @@
 #include "Encoder.h"
 #include "W25Q64.h"
 #include "RTC.h"
+#include "Scheduler.h"
+#include "Event.h"
+#include "Kernel.h"
+#include "PT.h"
+#include "Timer.h"
+#include "Supervisor.h"
+#include "Power.h"
+#include "Perf.h"
+#include "Latency.h"
+#include "Trace.h"
+#include "Mem.h"
+#include "Journal.h"
+#include "Config.h"
+#include "Series.h"
 
 //系统模式枚举
 typedef enum {
@@ -25,7 +39,8 @@ typedef struct {
     uint8_t humidity;            //湿度值
     uint8_t ir_status;           //红外传感器状态
     uint8_t alarm_status;        //报警状态
-    uint16_t alarm_count;        //报警计数，用于超时关闭
+    uint16_t alarm_count;        //报警持续秒数，用于超时关闭
+    uint8_t alarm_silenced;      //报警已超时自动静音
     uint8_t temp_threshold_low;  //温度下限阈值
     uint8_t temp_threshold_high; //温度上限阈值
     uint8_t humi_threshold_low;  //湿度下限阈值
@@ -37,20 +52,87 @@ SystemStatus_t system_status;
 char serial_command_buffer[64];  // 串口命令缓冲区
 uint8_t serial_command_length = 0;  // 命令长度
 uint8_t serial_command_received = 0;  // 命令接收完成标志
-uint32_t record_index = 0;  // 当前记录索引
 
-// 数据记录相关常量
-#define MAX_RECORDS           10000                   // 最大记录数（W25Q64容量大，可存储更多记录）
+// 数据记录相关常量，记录保存在W25Q64的只追加日志中（见Journal.h）
+#define FLASH_BENCH_BYTES     16384                   // flash bench读取的字节数（日志区开头4个扇区）
+#define FLASH_BENCH_CHUNK     128                     // 每次读取的字节数，缓冲区在bulk线程栈上
+#define RECORD_QUEUE_SIZE     4                       // 待写入记录队列长度
+#define HISTORY_RANGE_ROWS    100                     // history from最多逐条列出的记录数，之后只统计
+
+// 线程：alarm（高优先级）处理红外/按键事件，sensor（中优先级）运行周期任务，bulk（低优先级）处理Flash写入和串口命令
+#define RESYNC_PERIOD_MS      500                     // alarm线程电平同步兜底周期，边沿由中断上报，兜底周期放长以延长空闲休眠
+#define ALARM_MAX_PERIOD_MS   1000                    // alarm线程两次签到之间允许的最大间隔
+static Kernel_Thread_t alarm_thread, sensor_thread, bulk_thread;
+static uint32_t alarm_stack[192];
+static uint32_t sensor_stack[256];
+static uint32_t bulk_stack[384];
+static Kernel_Sem_t bulk_sem;                         // 有记录待写入或有命令待处理时释放
+static volatile uint8_t command_pending = 0;          // 有命令等待bulk线程处理
+
+// 协程任务，由sensor线程轮询，等待期间不占用CPU也不需要独立的栈
+#define SENSOR_RETRY_MAX      5                       // DHT11读取最多尝试次数
+#define SENSOR_RETRY_DELAY_MS 200                     // 重试前等待时间
+static PT_Task_t sample_task;
+
+// 入侵报警蜂鸣节奏，持续到红外恢复或超时自动静音
+#define ALARM_SIREN_ON_MS     500
+#define ALARM_SIREN_OFF_MS    500
+#define ALARM_SILENCE_MS      30000                   // 报警持续30秒后自动静音
+static Timer_t silence_timer;
+
+// 截止时间监控作业号
+static uint8_t alarm_job;
+
+// 热点路径周期计数探针，perf命令输出
+PERF_PROBE(perf_system_update, "System_Update");
+PERF_PROBE(perf_system_display, "System_Display");
+#if PERF_ENABLE
+// 命令处理耗时探针，按命令名前缀匹配，顺序与System_ParseCommand一致（timers在time之前）
+#define COMMAND_PROBE_PREFIX  4                       // 探针名称中"cmd "的长度
+static Perf_Probe_t command_probes[] = {
+    PERF_PROBE_INIT("cmd help"),      PERF_PROBE_INIT("cmd mode"),     PERF_PROBE_INIT("cmd status"),
+    PERF_PROBE_INIT("cmd reset"),     PERF_PROBE_INIT("cmd threshold"), PERF_PROBE_INIT("cmd timers"),
+    PERF_PROBE_INIT("cmd time"),      PERF_PROBE_INIT("cmd history"),  PERF_PROBE_INIT("cmd export"),
+    PERF_PROBE_INIT("cmd tasks"),     PERF_PROBE_INIT("cmd threads"),  PERF_PROBE_INIT("cmd deadlines"),
+    PERF_PROBE_INIT("cmd power"),     PERF_PROBE_INIT("cmd perf"),     PERF_PROBE_INIT("cmd latency"),
+    PERF_PROBE_INIT("cmd trace"),     PERF_PROBE_INIT("cmd mem"),      PERF_PROBE_INIT("cmd flash"),
+    PERF_PROBE_INIT("cmd sync"),      PERF_PROBE_INIT("cmd clear_history"), PERF_PROBE_INIT("cmd series"),
+};
+#endif
+
+// 待写入记录队列，alarm线程写入，bulk线程取出
+static DataRecord_t record_queue[RECORD_QUEUE_SIZE];
+static volatile uint8_t record_queue_head = 0;
+static volatile uint8_t record_queue_tail = 0;
+
+// 延迟跟踪中第一条追加记录之后的序号，该记录编程完成时到达LATENCY_INDEX，0表示没有等待的记录
+static volatile uint32_t record_latency_end = 0;
 
 //函数声明
 void System_Init(void);
 void System_Update(void);
+void System_SampleSensors(void);
+void System_CheckThresholds(void);
+void System_SaveThresholds(void);
 void System_Display(void);
 void System_SerialSend(void);
 void System_HandleAlarm(void);
 void System_SwitchMode(SystemMode_t new_mode);
 void System_HandleSerialCommand(void);
 void System_ParseCommand(char *command);
+void System_HandleEvent(Event_t *event);
+void System_QueueRecord(DataRecord_t *record);
+void System_FlushRecords(void);
+void System_RecordDurable(uint32_t next);
+void System_AlarmThread(void);
+void System_SensorThread(void);
+void System_BulkThread(void);
+PT_THREAD(System_SampleThread(PT_t *pt));
+void System_SilenceAlarm(void *arg);
+void System_ClearSilence(void);
+void System_FlashBench(void);
+uint8_t System_ParseTime(const char *text, uint32_t *seconds);
+void System_HistoryRange(uint32_t from, uint32_t to);
 
 int main(void)
 {
@@ -66,22 +148,121 @@ int main(void)
     /*串口发送启动信息*/
     Serial_Printf("[INFO] System Starting...\n");
     
+    /*注册周期任务：名称、周期(ms)、相对截止时间(ms)、是否关键，由各自的周期定时器释放，在sensor线程中运行*/
+    /*红外、按键、串口命令由中断以事件方式上报，由alarm线程处理*/
+    Scheduler_AddTask("sensor", System_SampleSensors, 5000, 1500, 1);  //启动温湿度采集协程
+    Scheduler_AddTask("threshold", System_CheckThresholds, 500, 500, 1); //温湿度阈值报警
+    Scheduler_AddTask("display", System_Display, 2000, 500, 0);        //OLED刷新
+    Scheduler_AddTask("telemetry", System_SerialSend, 2000, 500, 0);   //串口周期数据
+    Scheduler_AddTask("mem", Mem_Check, MEM_CHECK_PERIOD_MS, 500, 0);  //栈高水位检查
+    
+    /*alarm线程处理入侵报警，作为关键作业监控*/
+    alarm_job = Supervisor_Register("alarm", ALARM_MAX_PERIOD_MS, 1);
+    
+    /*注册协程任务：温湿度采集（含重试）*/
+    PT_TaskInit(&sample_task, "sample", System_SampleThread);
+    
+    /*单次定时器：报警超时自动静音*/
+    Timer_Setup(&silence_timer, "silence", System_SilenceAlarm, 0);
+    
+    /*创建线程并启动内核，无线程就绪时空闲线程按下一个唤醒时刻进入睡眠或停机模式*/
+    Kernel_SemInit(&bulk_sem, 0);
+    Kernel_Init();
+    Kernel_CreateThread(&alarm_thread, "alarm", System_AlarmThread,
+                        alarm_stack, sizeof(alarm_stack) / 4, KERNEL_PRIO_HIGH);
+    Kernel_CreateThread(&sensor_thread, "sensor", System_SensorThread,
+                        sensor_stack, sizeof(sensor_stack) / 4, KERNEL_PRIO_MID);
+    Kernel_CreateThread(&bulk_thread, "bulk", System_BulkThread,
+                        bulk_stack, sizeof(bulk_stack) / 4, KERNEL_PRIO_LOW);
+    
+    /*启动截止时间监控和独立看门狗，关键作业超期时停止喂狗使系统复位*/
+    Supervisor_Start();
+    Kernel_Start();
+}
+
+/**
+  * 函    数：alarm线程，最高优先级，处理中断投递的事件
+  * 参    数：无
+  * 返 回 值：无
+  */
+void System_AlarmThread(void)
+{
+    uint32_t last_resync = Scheduler_GetTick();
+    
     while (1)
     {
-        /*更新系统状态*/
-        System_Update();
+        Event_t event;
         
-        /*处理报警逻辑*/
-        System_HandleAlarm();
+        /*等待中断事件，最长等待一个同步周期*/
+        Event_Wait(RESYNC_PERIOD_MS);
+        Supervisor_CheckIn(alarm_job);
         
-        /*刷新OLED显示*/
-        System_Display();
+        /*处理中断投递的所有事件*/
+        while (Event_Get(&event))
+        {
+            System_HandleEvent(&event);
+        }
         
-        /*发送串口数据*/
-        System_SerialSend();
+        /*定期同步编码器和红外电平，兜底处理可能丢失的边沿事件*/
+        if (Scheduler_GetTick() - last_resync >= RESYNC_PERIOD_MS)
+        {
+            last_resync = Scheduler_GetTick();
+            System_Update();
+            System_HandleAlarm();
+        }
+    }
+}
+
+/**
+  * 函    数：sensor线程，中优先级，作为定时器服务线程运行定时器回调、协程和周期任务
+  * 参    数：无
+  * 返 回 值：无
+  */
+void System_SensorThread(void)
+{
+    while (1)
+    {
+        /*执行到期定时器的回调（释放周期任务、推进协程），然后运行已释放的任务*/
+        Timer_Run();
+        Scheduler_Dispatch();
         
-        /*延时，控制循环频率*/
-        Delay_ms(500);
+        /*休眠到下一个定时器到期，其他线程启动更早的定时器时提前唤醒*/
+        Timer_Wait(Timer_GetNextExpiry());
+    }
+}
+
+/**
+  * 函    数：bulk线程，最低优先级，处理Flash写入和串口命令等耗时操作
+  * 参    数：无
+  * 返 回 值：无
+  */
+void System_BulkThread(void)
+{
+    while (1)
+    {
+        /*日志页缓冲中有未写入的记录或配置修改后，最迟在超时后醒来写入*/
+        uint32_t delay = Journal_GetFlushDelay();
+        
+        if (Config_GetFlushDelay() < delay)
+        {
+            delay = Config_GetFlushDelay();
+        }
+        Kernel_SemWait(&bulk_sem, delay);
+        
+        /*写入待保存的记录、配置和写满的采样页，Flash空闲时预擦除后续扇区*/
+        System_FlushRecords();
+        Journal_Poll();
+        Config_Poll();
+        Series_Poll();
+        Journal_Prepare();
+        
+        /*处理串口命令，处理完成后才允许接收下一条*/
+        if (command_pending)
+        {
+            command_pending = 0;
+            System_HandleSerialCommand();
+            serial_command_received = 0;
+        }
     }
 }
 
@@ -92,6 +273,13 @@ int main(void)
   */
 void System_Init(void)
 {
+    /*填充主栈，用于统计栈使用高水位*/
+    Mem_Init();
+    
+    /*启动DWT周期计数（延时与时间戳）和1ms系统时基*/
+    Delay_Init();
+    Scheduler_Init();
+    
     /*硬件初始化*/
     OLED_Init();
     Serial_Init();
@@ -101,6 +289,7 @@ void System_Init(void)
     Encoder_Init();
     W25Q64_Init();
     RTC_Init();
+    Power_Init();
     
     /*系统状态初始化*/
     system_status.mode = MODE_ARMED;
@@ -109,6 +298,7 @@ void System_Init(void)
     system_status.ir_status = IR_GetStatus(); //初始化为实际红外传感器状态
     system_status.alarm_status = 0;
     system_status.alarm_count = 0;
+    system_status.alarm_silenced = 0;
     
     /*温湿度报警阈值初始化*/
     system_status.temp_threshold_low = 10;   //默认温度下限10°C
@@ -116,47 +306,76 @@ void System_Init(void)
     system_status.humi_threshold_low = 30;   //默认湿度下限30%
     system_status.humi_threshold_high = 80;  //默认湿度上限80%
     
-    /*从W25Q64读取系统配置*/
-    SystemConfig_t config;
-    uint8_t config_result = W25Q64_ReadConfig(&config);
-    if (config_result == 0)
-    {
-        /*配置有效，使用读取的值*/
-        system_status.temp_threshold_low = config.temp_threshold_low;
-        system_status.temp_threshold_high = config.temp_threshold_high;
-        system_status.humi_threshold_low = config.humi_threshold_low;
-        system_status.humi_threshold_high = config.humi_threshold_high;
-        Serial_Printf("[INFO] System configuration loaded from W25Q64\n");
+    /*SPI链路自检：选择能可靠读取JEDEC ID和测试图案的最高速度*/
+    {
+        uint32_t speed = W25Q64_SelfTest();
+        
+        if (speed)
+        {
+            Serial_Printf("[INFO] Flash link self-test: %lu kHz, %s\n", speed / 1000,
+                          W25Q64_IsFastRead() ? "Fast Read" : "Read Data");
+        }
+        else
+        {
+            Serial_Printf("[ERROR] Flash link self-test: no JEDEC ID response\n");
+        }
+    }
+    
+    /*从配置区读取系统配置，首次启动时迁移旧版配置*/
+    {
+        uint8_t result = Config_Init();
+        uint32_t value;
+        
+        if (Config_Get(CONFIG_KEY_TEMP_LOW, &value) == 0) system_status.temp_threshold_low = (uint8_t)value;
+        if (Config_Get(CONFIG_KEY_TEMP_HIGH, &value) == 0) system_status.temp_threshold_high = (uint8_t)value;
+        if (Config_Get(CONFIG_KEY_HUMI_LOW, &value) == 0) system_status.humi_threshold_low = (uint8_t)value;
+        if (Config_Get(CONFIG_KEY_HUMI_HIGH, &value) == 0) system_status.humi_threshold_high = (uint8_t)value;
+        
+        if (result == 2)
+        {
+            /*没有保存的配置，使用默认值并保存*/
+            Serial_Printf("[INFO] Default system configuration saved to W25Q64\n");
+        }
+        else
+        {
+            Serial_Printf(result ? "[INFO] System configuration migrated to the config store\n"
+                                 : "[INFO] System configuration loaded from W25Q64\n");
+        }
         
         /*检查是否需要更新湿度阈值（从旧的40%下限更新为新的30%下限）*/
         if (system_status.humi_threshold_low == 40)
         {
             system_status.humi_threshold_low = 30;
-            /*保存更新后的配置到W25Q64*/
-            config.humi_threshold_low = system_status.humi_threshold_low;
-            W25Q64_WriteConfig(&config);
             Serial_Printf("[INFO] Humidity threshold updated to new default: 30-80%%\n");
         }
+        
+        /*未保存的键和更新后的值由bulk线程合并写入*/
+        System_SaveThresholds();
     }
-    else
+    
+    /*由扇区头恢复记录日志的写入位置，保留历史记录*/
     {
-        /*配置无效，使用默认值并保存*/
-        config.temp_threshold_low = system_status.temp_threshold_low;
-        config.temp_threshold_high = system_status.temp_threshold_high;
-        config.humi_threshold_low = system_status.humi_threshold_low;
-        config.humi_threshold_high = system_status.humi_threshold_high;
-        W25Q64_WriteConfig(&config);
-        Serial_Printf("[INFO] Default system configuration saved to W25Q64\n");
+        uint32_t start = Delay_Micros();
+        uint8_t torn = Journal_Init();
+        uint32_t elapsed = Delay_Micros() - start;
+        
+        Serial_Printf("[INFO] Record journal recovered in %lu us: records %lu..%lu, last record %s\n",
+                      elapsed, Journal_GetFirst(), Journal_GetNext(), torn ? "torn (CRC error)" : "OK");
+        Journal_SetDurableHook(System_RecordDurable);
+        
+        /*预擦除状态不保存，上电后在后台重新擦除写入扇区之后的扇区*/
+        Journal_Prepare();
     }
     
-    /*从W25Q64读取记录索引*/
-    record_index = W25Q64_ReadRecordIndex();
-    /*强制清除所有历史记录，确保新记录使用正确格式*/
-    record_index = 0;
-    W25Q64_ClearAllRecords();
-    W25Q64_WriteRecordIndex(record_index);
-    Serial_Printf("[INFO] History cleared to ensure proper record format\n");
-    Serial_Printf("[INFO] Record index initialized: %lu\n", record_index);
+    /*恢复温湿度采样流的写入位置，按保存的配置打开*/
+    {
+        uint32_t page = Series_Init();
+        uint32_t enabled;
+        
+        Series_Enable(Config_Get(CONFIG_KEY_SERIES, &enabled) == 0 && enabled);
+        Serial_Printf("[INFO] Sample series recovered: next page %lu, stream %s\n",
+                      page, Series_IsEnabled() ? "on" : "off");
+    }
     
     /*确保蜂鸣器关闭*/
     Buzzer_Control(0);
@@ -173,72 +392,164 @@ void System_Init(void)
   */
 void System_Update(void)
 {
+    PERF_BEGIN(perf_system_update);
+    
     /*更新编码器状态*/
     Encoder_Update();
     int16_t encoder_count = Encoder_GetCount();
     
-    /*处理串口命令*/
-    if (serial_command_received)
+    /*读取红外传感器状态，兜底同步可能丢失的边沿事件*/
+    system_status.ir_status = IR_GetStatus();
+    
+    /*数据记录功能已移除定时记录，改为在红外报警时记录*/
+    
+    PERF_END(perf_system_update);
+}
+
+/**
+  * 函    数：处理中断投递的事件
+  * 参    数：event 事件指针
+  * 返 回 值：无
+  */
+void System_HandleEvent(Event_t *event)
+{
+    switch (event->type)
     {
-        serial_command_received = 0;
-        System_HandleSerialCommand();
+        case EVENT_IR_EDGE:
+            //红外电平变化，立即处理报警
+            system_status.ir_status = event->arg;
+            System_HandleAlarm();
+            break;
+            
+        case EVENT_KEY_PRESS:
+            //编码器按键，按固定顺序切换模式：MODE_ARMED → MODE_HOME → MODE_DEBUG → MODE_ARMED
+            System_SwitchMode((SystemMode_t)((system_status.mode + 1) % 3));
+            break;
+            
+        case EVENT_COMMAND:
+            //串口命令，可能耗时较长（如export），交给bulk线程处理
+            command_pending = 1;
+            Kernel_SemPost(&bulk_sem);
+            break;
+            
+        case EVENT_RTC_TICK:
+            //报警持续期间按秒计数
+            if (system_status.alarm_status == 1 && system_status.alarm_count < 0xFFFF)
+            {
+                system_status.alarm_count++;
+            }
+            break;
+            
+        case EVENT_MEM_LOW:
+            //栈剩余空间低于余量
+            {
+                uint32_t used, size;
+                const char *name = Mem_GetStack(event->arg, &used, &size);
+                if (name)
+                {
+                    Serial_Printf("[WARN] Stack '%s' free %lu bytes below margin %u (used %lu/%lu)\n",
+                                  name, size - used, Mem_GetMargin(), used, size);
+                }
+            }
+            break;
+            
+        case EVENT_POWER_LOW:
+            //电源电压低于PVD阈值：立即写入日志页缓冲，之后的记录逐条写入；电压恢复后重新按页合并
+            Journal_SetWriteThrough(event->arg);
+            if (event->arg)
+            {
+                Config_Flush();
+                Series_Sync();
+            }
+            Serial_Printf(event->arg ? "[WARN] Supply voltage low, journal, config and sample series flushed\n"
+                                     : "[INFO] Supply voltage restored\n");
+            break;
+            
+        default:
+            break;
     }
-    
-    /*处理编码器按键，按动一次切换一个模式*/
-    if (Encoder_GetKeyStatus() == 1)
+}
+
+/**
+  * 函    数：启动温湿度采集（sensor任务，每5秒运行一次）
+  * 参    数：无
+  * 返 回 值：无
+  */
+void System_SampleSensors(void)
+{
+    /*上一次采集仍在重试时不重复启动*/
+    if (!PT_TaskIsActive(&sample_task))
     {
-        //按固定顺序切换模式：MODE_ARMED → MODE_HOME → MODE_DEBUG → MODE_ARMED
-        SystemMode_t next_mode = (SystemMode_t)((system_status.mode + 1) % 3);
-        System_SwitchMode(next_mode);
+        PT_TaskStart(&sample_task);
     }
+}
+
+/**
+  * 函    数：温湿度采集协程，起始信号和重试等待期间挂起，不阻塞sensor线程
+  * 参    数：pt 协程控制块
+  * 返 回 值：协程状态
+  */
+PT_THREAD(System_SampleThread(PT_t *pt))
+{
+    // 跨越等待点的变量必须为static
+    static PT_t dht_pt;
+    static uint8_t retry;
+    static uint8_t result;
+    static uint8_t temp_read;
+    static uint8_t humi_read;
+    
+    PT_BEGIN(pt);
     
-    /*读取DHT11温湿度数据*/
-    static uint8_t dht11_count = 0;
-    if (++dht11_count >= 10) //每5秒读取一次温湿度，减少读取频率
+    temp_read = system_status.temperature;
+    humi_read = system_status.humidity;
+    
+    for (retry = 0; retry < SENSOR_RETRY_MAX; retry++)
     {
-        dht11_count = 0;
-        
-        // 添加错误处理和重试机制
-        uint8_t retry = 0;
-        uint8_t result = 1;
-        uint8_t temp_read = system_status.temperature;
-        uint8_t humi_read = system_status.humidity;
+        // 传递当前系统模式给DHT11，以便只在调试模式下打印调试信息
+        PT_SPAWN(pt, &dht_pt, DHT11_ReadPT(&dht_pt, &humi_read, &temp_read, system_status.mode, &result));
         
-        while (retry < 5) // 最多重试5次
+        // 如果读取成功，立即退出
+        if (result == 0)
         {
-            // 传递当前系统模式给DHT11_ReadData，以便只在调试模式下打印调试信息
-            result = DHT11_ReadData(&humi_read, &temp_read, system_status.mode);
-            
-            // 如果读取成功，立即更新并退出
-            if (result == 0)
-            {
-                system_status.temperature = temp_read;
-                system_status.humidity = humi_read;
-                break;
-            }
-            
-            retry++;
-            Delay_ms(200); // 重试前等待200ms
+            break;
         }
         
-        // 即使所有重试都失败，也使用最后一次读取到的数据
-        // 不再恢复为初始值，因为DHT11_ReadData已经确保了数据的有效性
-        system_status.temperature = temp_read;
-        system_status.humidity = humi_read;
-        
-
+        PT_DELAY(pt, SENSOR_RETRY_DELAY_MS); // 重试前等待，期间让出
     }
     
-    /*温湿度阈值判断*/
+    // 即使所有重试都失败，也使用最后一次读取到的数据
+    // 无响应或校验错误时DHT11不改写读数，temp_read/humi_read仍是上次的有效值
+    system_status.temperature = temp_read;
+    system_status.humidity = humi_read;
+    
+    // 采样流打开时保存每次成功的读数，写满一页后由bulk线程编程
+    if (result == 0 && Series_Append(RTC_GetCounter(), temp_read, humi_read))
+    {
+        Kernel_SemPost(&bulk_sem);
+    }
+    
+    PT_END(pt);
+}
+
+/**
+  * 函    数：温湿度阈值判断（threshold任务，每500ms运行一次）
+  * 参    数：无
+  * 返 回 值：无
+  */
+void System_CheckThresholds(void)
+{
     if (system_status.mode == MODE_ARMED) // 仅在布防模式下触发阈值报警
     {
         // 检查温度是否超出阈值
         if (system_status.temperature < system_status.temp_threshold_low || 
             system_status.temperature > system_status.temp_threshold_high)
         {
-            system_status.alarm_status = 1;
-            system_status.alarm_count = 0;
-            Buzzer_Beep(500); // 蜂鸣器响500ms
+            if (system_status.alarm_status == 0) // 入侵报警正在鸣叫或已静音时不打断
+            {
+                system_status.alarm_status = 1;
+                system_status.alarm_count = 0;
+                Buzzer_Beep(500); // 蜂鸣器响500ms
+            }
             Serial_Printf("[ALARM] Temperature out of range! Current: %d°C (Threshold: %d-%d°C)\n", 
                          system_status.temperature, 
                          system_status.temp_threshold_low, 
@@ -249,20 +560,88 @@ void System_Update(void)
         if (system_status.humidity < system_status.humi_threshold_low || 
             system_status.humidity > system_status.humi_threshold_high)
         {
-            system_status.alarm_status = 1;
-            system_status.alarm_count = 0;
-            Buzzer_Beep(500); // 蜂鸣器响500ms
+            if (system_status.alarm_status == 0) // 入侵报警正在鸣叫或已静音时不打断
+            {
+                system_status.alarm_status = 1;
+                system_status.alarm_count = 0;
+                Buzzer_Beep(500); // 蜂鸣器响500ms
+            }
             Serial_Printf("[ALARM] Humidity out of range! Current: %d%% (Threshold: %d-%d%%)\n", 
                          system_status.humidity, 
                          system_status.humi_threshold_low, 
                          system_status.humi_threshold_high);
         }
     }
+}
+
+/**
+  * 函    数：把温湿度阈值写入配置存储的内存副本，值有变化的键由bulk线程延时合并写入Flash
+  * 参    数：无
+  * 返 回 值：无
+  */
+void System_SaveThresholds(void)
+{
+    Config_Set(CONFIG_KEY_TEMP_LOW, system_status.temp_threshold_low);
+    Config_Set(CONFIG_KEY_TEMP_HIGH, system_status.temp_threshold_high);
+    Config_Set(CONFIG_KEY_HUMI_LOW, system_status.humi_threshold_low);
+    Config_Set(CONFIG_KEY_HUMI_HIGH, system_status.humi_threshold_high);
+}
+
+/**
+  * 函    数：将记录加入待写入队列（alarm线程调用）
+  * 参    数：record 记录指针
+  * 返 回 值：无
+  */
+void System_QueueRecord(DataRecord_t *record)
+{
+    uint8_t next = (record_queue_head + 1) % RECORD_QUEUE_SIZE;
     
-    /*读取红外传感器状态*/
-    system_status.ir_status = IR_GetStatus();
+    if (next == record_queue_tail)
+    {
+        Serial_Printf("[ERROR] Record queue full, record dropped\n");
+        return;
+    }
+    record_queue[record_queue_head] = *record;
+    record_queue_head = next;
+    Kernel_SemPost(&bulk_sem);
+}
+
+/**
+  * 函    数：将队列中的记录写入W25Q64（bulk线程调用）
+  * 参    数：无
+  * 返 回 值：无
+  */
+void System_FlushRecords(void)
+{
+    while (record_queue_tail != record_queue_head)
+    {
+        /*追加到日志页缓冲，写满一页后由Flash操作队列在后台编程，写入位置由日志内容推出，不再单独写索引*/
+        uint32_t seq = Journal_Append(&record_queue[record_queue_tail]);
+        
+        if (Latency_Mark(LATENCY_RECORD))
+        {
+            /*此时记录还在页缓冲中，所在的页编程完成才算持久保存；回调可能已先到达*/
+            record_latency_end = seq + 1;
+            System_RecordDurable(Journal_GetDurable());
+        }
+        record_queue_tail = (record_queue_tail + 1) % RECORD_QUEUE_SIZE;
+    }
+}
+
+/**
+  * 函    数：记录编程完成的钩子（在轮询Flash操作队列的线程中调用，不能阻塞），延迟跟踪中的记录写入Flash时到达LATENCY_INDEX
+  * 参    数：next 序号小于next的记录都已编程完成
+  * 返 回 值：无
+  */
+void System_RecordDurable(uint32_t next)
+{
+    uint32_t end = record_latency_end;
     
-    /*数据记录功能已移除定时记录，改为在红外报警时记录*/
+    if (end != 0 && next - end < 0x80000000UL)
+    {
+        record_latency_end = 0;
+        Latency_Mark(LATENCY_INDEX);
+    }
 }
 
 /**
@@ -275,6 +654,12 @@ void System_HandleAlarm(void)
     /*确保蜂鸣器默认关闭*/
     static uint8_t last_alarm_status = 0;
     
+    /*报警逻辑看到红外检测，记录距红外边沿的延迟*/
+    if (system_status.ir_status == 0)
+    {
+        Latency_Mark(LATENCY_OBSERVE);
+    }
+    
     /*根据当前模式处理报警*/
     switch (system_status.mode)
     {
@@ -286,8 +671,10 @@ void System_HandleAlarm(void)
                 {
                     system_status.alarm_status = 1;
                     system_status.alarm_count = 0;
-                    Buzzer_Beep(500); //蜂鸣器响500ms
+                    Buzzer_Pattern(ALARM_SIREN_ON_MS, ALARM_SIREN_OFF_MS, 255); //持续鸣叫，直到红外恢复或超时静音
+                    Timer_Start(&silence_timer, ALARM_SILENCE_MS, 0);
                     Serial_Printf("[ALARM]INTRUSION!\n");
+                    Latency_Mark(LATENCY_UART); //返回时最后一个字节已进入发送移位寄存器
                     
                     // 记录报警数据
                     uint32_t timestamp = RTC_GetCounter(); // 直接获取RTC计数器值作为时间戳
@@ -299,13 +686,7 @@ void System_HandleAlarm(void)
                     record.system_mode = system_status.mode;
                     record.ir_status = system_status.ir_status;
                     
-                    W25Q64_WriteRecord(&record, record_index);
-                    
-                    if (++record_index >= MAX_RECORDS)
-                    {
-                        record_index = 0;
-                    }
-                    W25Q64_WriteRecordIndex(record_index);
+                    System_QueueRecord(&record); //交给bulk线程写入W25Q64，不阻塞报警处理
                 }
             }
             else
@@ -315,6 +696,7 @@ void System_HandleAlarm(void)
                 {
                     system_status.alarm_status = 0;
                     system_status.alarm_count = 0;
+                    System_ClearSilence();
                     Buzzer_Control(0); //确保蜂鸣器关闭
                     Serial_Printf("[INFO]Alarm Stopped\n");
                 }
@@ -342,13 +724,7 @@ void System_HandleAlarm(void)
                     record.system_mode = system_status.mode;
                     record.ir_status = system_status.ir_status;
                     
-                    W25Q64_WriteRecord(&record, record_index);
-                    
-                    if (++record_index >= MAX_RECORDS)
-                    {
-                        record_index = 0;
-                    }
-                    W25Q64_WriteRecordIndex(record_index);
+                    System_QueueRecord(&record); //交给bulk线程写入W25Q64，不阻塞报警处理
                 }
             }
             else
@@ -363,6 +739,7 @@ void System_HandleAlarm(void)
             {
                 system_status.alarm_status = 0;
                 system_status.alarm_count = 0;
+                System_ClearSilence();
                 Buzzer_Control(0); //确保蜂鸣器关闭
             }
             break;
@@ -376,6 +753,182 @@ void System_HandleAlarm(void)
     last_alarm_status = system_status.alarm_status;
 }
 
+/**
+  * 函    数：报警超时自动静音（silence定时器回调，在sensor线程中运行）
+  * 参    数：arg 未使用
+  * 返 回 值：无
+  */
+void System_SilenceAlarm(void *arg)
+{
+    if (system_status.alarm_status == 1)
+    {
+        system_status.alarm_silenced = 1;
+        Buzzer_Control(0);
+        Serial_Printf("[INFO]Alarm Silenced after %u s\n", system_status.alarm_count);
+    }
+}
+
+/**
+  * 函    数：报警解除时停止静音定时器并清除静音状态
+  * 参    数：无
+  * 返 回 值：无
+  */
+void System_ClearSilence(void)
+{
+    Timer_Stop(&silence_timer);
+    system_status.alarm_silenced = 0;
+}
+
+/**
+  * 函    数：分别用轮询和DMA读取日志区开头，输出Flash批量读取吞吐量（在bulk线程中运行）
+  * 参    数：无
+  * 返 回 值：无
+  */
+void System_FlashBench(void)
+{
+    uint8_t buffer[FLASH_BENCH_CHUNK];
+    uint8_t dma_enabled = W25Q64_IsDmaEnabled();
+    uint32_t elapsed[2];
+    uint32_t addr, start;
+    uint8_t mode;
+
+    for (mode = 0; mode < 2; mode++)
+    {
+        W25Q64_SetDmaEnabled(mode);
+        start = Delay_Micros();
+        for (addr = 0; addr < FLASH_BENCH_BYTES; addr += FLASH_BENCH_CHUNK)
+        {
+            W25Q64_ReadBytes(addr, buffer, FLASH_BENCH_CHUNK);
+        }
+        elapsed[mode] = Delay_Micros() - start;
+        if (elapsed[mode] == 0)
+        {
+            elapsed[mode] = 1;
+        }
+    }
+    W25Q64_SetDmaEnabled(dma_enabled);
+
+    Serial_Printf("[FLASH] Bulk read %lu bytes in %u-byte chunks: polled %lu us (%lu KB/s), DMA %lu us (%lu KB/s)\n",
+                  (uint32_t)FLASH_BENCH_BYTES, FLASH_BENCH_CHUNK,
+                  elapsed[0], (uint32_t)((uint64_t)FLASH_BENCH_BYTES * 1000000 / 1024 / elapsed[0]),
+                  elapsed[1], (uint32_t)((uint64_t)FLASH_BENCH_BYTES * 1000000 / 1024 / elapsed[1]));
+}
+
+/**
+  * 函    数：解析时间，格式与history输出相同：YYYY-MM-DD HH:MM[:SS]（年份也可写两位）
+  * 参    数：text 时间字符串
+  * 参    数：seconds 用于存放RTC秒数（从2000年1月1日开始）
+  * 返 回 值：0 成功，1 格式错误或超出范围
+  */
+uint8_t System_ParseTime(const char *text, uint32_t *seconds)
+{
+    unsigned int year, month, day, hour, minute, second = 0;
+    RTC_TimeTypeDef time;
+    
+    if (sscanf(text, "%u-%u-%u %u:%u:%u", &year, &month, &day, &hour, &minute, &second) < 5)
+    {
+        return 1;
+    }
+    if (year >= 2000)
+    {
+        year -= 2000;
+    }
+    if (year > 99 || month < 1 || month > 12 || day < 1 || day > 31 || hour > 23 || minute > 59 || second > 59)
+    {
+        return 1;
+    }
+    
+    time.year = (uint8_t)year;
+    time.month = (uint8_t)month;
+    time.day = (uint8_t)day;
+    time.hour = (uint8_t)hour;
+    time.minute = (uint8_t)minute;
+    time.second = (uint8_t)second;
+    *seconds = RTC_ConvertToSeconds(&time);
+    return 0;
+}
+
+/**
+  * 函    数：输出时间范围内的记录（history from命令），由日志的时间索引和扇区摘要
+  *           二分查找第一条记录，只读取范围内的记录；列出HISTORY_RANGE_ROWS条之后，
+  *           整个扇区都在范围内时直接累计扇区摘要，不再逐条读取
+  * 参    数：from 起始时间（RTC秒数）
+  * 参    数：to 结束时间（RTC秒数，包含）
+  * 返 回 值：无
+  */
+void System_HistoryRange(uint32_t from, uint32_t to)
+{
+    DataRecord_t record;
+    Journal_Footer_t summary;
+    RTC_TimeTypeDef rec_time;
+    uint32_t start = Journal_FindTime(from);
+    uint32_t seq, shown = 0, listed = 0, motion = 0;
+    uint8_t temp_min = 0xFF, temp_max = 0, humi_min = 0xFF, humi_max = 0;
+    
+    Serial_Printf("[HISTORY] Time | Temp | Humi | Mode | IR\n");
+    Serial_Printf("[HISTORY] ---- | ---- | ---- | ---- | --\n");
+    
+    for (seq = start; seq != Journal_GetNext(); seq++)
+    {
+        uint8_t crc_result;
+        
+        if (listed >= HISTORY_RANGE_ROWS && Journal_ReadSummary(seq, &summary) == 0 &&
+            summary.count > 0 && summary.first_time >= from && summary.last_time <= to)
+        {
+            /*整个扇区在范围内：摘要的统计与逐条读取有效记录相同*/
+            shown += summary.count;
+            if (summary.temp_min < temp_min) temp_min = summary.temp_min;
+            if (summary.temp_max > temp_max) temp_max = summary.temp_max;
+            if (summary.humi_min < humi_min) humi_min = summary.humi_min;
+            if (summary.humi_max > humi_max) humi_max = summary.humi_max;
+            motion += summary.motion;
+            seq += JOURNAL_ENTRIES_PER_SECTOR - 1;
+            continue;
+        }
+        
+        crc_result = Journal_Read(seq, &record);
+        
+        if (crc_result == 2)
+        {
+            break; // 读取期间最早的扇区被覆盖
+        }
+        if (crc_result != 0 || record.timestamp < from)
+        {
+            continue; // 无效记录，或查找结果偏早时范围之前的记录
+        }
+        if (record.timestamp > to)
+        {
+            break;
+        }
+        
+        if (listed < HISTORY_RANGE_ROWS)
+        {
+            RTC_ConvertFromSeconds(record.timestamp, &rec_time);
+            Serial_Printf("[HISTORY] 20%02d-%02d-%02d %02d:%02d:%02d | %4d | %4d | %4d | %2d\n",
+                          rec_time.year, rec_time.month, rec_time.day, rec_time.hour, rec_time.minute, rec_time.second,
+                          record.temperature, record.humidity, record.system_mode, record.ir_status);
+            listed++;
+        }
+        
+        shown++;
+        if (record.temperature < temp_min) temp_min = record.temperature;
+        if (record.temperature > temp_max) temp_max = record.temperature;
+        if (record.humidity < humi_min) humi_min = record.humidity;
+        if (record.humidity > humi_max) humi_max = record.humidity;
+        if (record.ir_status == 0) motion++; //红外低电平表示检测到人体
+    }
+    
+    if (shown == 0)
+    {
+        Serial_Printf("[HISTORY] No records in range (searched from record %lu)\n", start);
+    }
+    else
+    {
+        Serial_Printf("[HISTORY] %lu records from record %lu (%lu listed), temp %d-%d°C, humi %d-%d%%, motion %lu\n",
+                      shown, start, listed, temp_min, temp_max, humi_min, humi_max, motion);
+    }
+}
+
 /**
   * 函    数：切换系统模式
   * 参    数：new_mode 新的系统模式
@@ -402,6 +955,7 @@ void System_SwitchMode(SystemMode_t new_mode)
         }
         
         /*模式切换时关闭蜂鸣器*/
+        System_ClearSilence();
         Buzzer_Control(0);
         
         /*蜂鸣器提示*/
@@ -421,14 +975,8 @@ void System_Display(void)
     static uint8_t last_humidity = 0xFF;
     static uint8_t last_ir_status = 0xFF;
     static uint8_t last_alarm_status = 0xFF;
-    static uint8_t display_counter = 0;
-    
-    /*降低OLED刷新频率，每2秒刷新一次*/
-    if (++display_counter < 4) // 主循环周期为500ms，4个周期即2秒
-    {
-        return;
-    }
-    display_counter = 0;
+    PERF_BEGIN(perf_system_display);
+    TRACE(TRACE_EV_OLED_BEGIN, 0);
     
     /*清屏*/
     OLED_Clear();
@@ -478,6 +1026,9 @@ void System_Display(void)
     {
         OLED_ShowString(4, 7, "OFF");
     }
+    
+    TRACE(TRACE_EV_OLED_END, 0);
+    PERF_END(perf_system_display);
 }
 
 /**
@@ -487,17 +1038,11 @@ void System_Display(void)
   */
 void System_SerialSend(void)
 {
-    /*降低发送频率，从500ms改为2秒发送一次数据*/
-    static uint8_t send_counter = 0;
-    if (++send_counter >= 4) // 每2秒发送一次
-    {
-        send_counter = 0;
-        /*发送周期数据*/
-        Serial_Printf("[DATA]Temp:%d,Humi:%d,IR:%d\n", 
-                     system_status.temperature, 
-                     system_status.humidity, 
-                     system_status.ir_status);
-    }
+    /*发送周期数据，发送频率由telemetry任务周期（2秒）决定*/
+    Serial_Printf("[DATA]Temp:%d,Humi:%d,IR:%d\n", 
+                 system_status.temperature, 
+                 system_status.humidity, 
+                 system_status.ir_status);
 }
 
 /**
@@ -507,8 +1052,37 @@ void System_SerialSend(void)
   */
 void System_HandleSerialCommand(void)
 {
+#if PERF_ENABLE
+    Perf_Probe_t *probe = 0;
+    uint32_t start;
+    uint8_t i;
+    
+    /*按命令名找到对应的耗时探针*/
+    for (i = 0; i < sizeof(command_probes) / sizeof(command_probes[0]); i++)
+    {
+        const char *name = command_probes[i].name + COMMAND_PROBE_PREFIX;
+        if (strncmp(serial_command_buffer, name, strlen(name)) == 0)
+        {
+            probe = &command_probes[i];
+            break;
+        }
+    }
+#endif
+    
     Serial_Printf("[INFO] Received command: %s\n", serial_command_buffer);
+    
+    TRACE(TRACE_EV_COMMAND_BEGIN, 0);
+#if PERF_ENABLE
+    start = DWT_CYCCNT;
     System_ParseCommand(serial_command_buffer);
+    if (probe)
+    {
+        Perf_Record(probe, DWT_CYCCNT - start);
+    }
+#else
+    System_ParseCommand(serial_command_buffer);
+#endif
+    TRACE(TRACE_EV_COMMAND_END, 0);
 }
 
 /**
@@ -534,10 +1108,29 @@ void System_ParseCommand(char *command)
         Serial_Printf("[HELP] threshold temp <low> <high> - Set temperature thresholds\n");
         Serial_Printf("[HELP] threshold humi <low> <high> - Set humidity thresholds\n");
         Serial_Printf("[HELP] history [count] - Show historical data records\n");
+        Serial_Printf("[HELP] history from <YYYY-MM-DD HH:MM> to <YYYY-MM-DD HH:MM> - Show records in a time range\n");
         Serial_Printf("[HELP] export - Export data records in CSV format\n");
         Serial_Printf("[HELP] clear_history - Clear all historical data\n");
+        Serial_Printf("[HELP] sync - Write buffered records, pending config changes and the open sample page to W25Q64 now\n");
+        Serial_Printf("[HELP] series [on|off] - Show the compressed temperature/humidity stream and bytes per sample, or turn it on/off\n");
+        Serial_Printf("[HELP] series reset|last <n> - Clear the stream statistics, or list the latest n samples\n");
         Serial_Printf("[HELP] time - Show current time\n");
         Serial_Printf("[HELP] time <YY> <MM> <DD> <HH> <mm> <SS> - Set current time\n");
+        Serial_Printf("[HELP] tasks [reset] - Show or reset scheduler task statistics\n");
+        Serial_Printf("[HELP] threads - Show thread states, stack high-water marks and context switch cost\n");
+        Serial_Printf("[HELP] timers [reset] - Show armed timers and firing lateness\n");
+        Serial_Printf("[HELP] deadlines [reset] - Show per-job check-in gaps, worst lateness and watchdog state\n");
+        Serial_Printf("[HELP] power [reset|stop on|stop off] - Show run/sleep/stop duty cycle and wake latency, or enable Stop mode\n");
+        Serial_Printf("[HELP] perf [reset] - Show cycle counts and log2 histograms of the hot-path probes\n");
+        Serial_Printf("[HELP] latency [reset] - Show p50/p99/max alarm latency from IR edge to buzzer, UART and flash\n");
+        Serial_Printf("[HELP] trace [clear|on|off] - Dump the binary event trace as hex (decode with Tools/trace2chrome)\n");
+        Serial_Printf("[HELP] mem [margin <bytes>] - Show static RAM per module and stack high-water marks, or set the low-stack warning margin\n");
+        Serial_Printf("[HELP] flash - Show the record journal position, config store, append and SPI statistics\n");
+        Serial_Printf("[HELP] flash reset - Clear the flash statistics\n");
+        Serial_Printf("[HELP] flash bench - Measure bulk read throughput, polled and DMA\n");
+        Serial_Printf("[HELP] flash wear - Show sector erase counts and projected lifetime\n");
+        Serial_Printf("[HELP] flash ahead <n> - Set the number of pre-erased sectors (0-8)\n");
+        Serial_Printf("[HELP] flash speed auto|<kHz> - Re-run the link self-test, or set the SPI link speed\n");
     }
     else if (strncmp(command, "mode", 4) == 0)
     {
@@ -562,7 +1155,8 @@ void System_ParseCommand(char *command)
         Serial_Printf("[STATUS] IR Status: %s\n", 
                      system_status.ir_status == 0 ? "DETECTED" : "CLEAR");
         Serial_Printf("[STATUS] Alarm Status: %s\n", 
-                     system_status.alarm_status == 0 ? "OFF" : "ON");
+                     system_status.alarm_status == 0 ? "OFF" : 
+                     system_status.alarm_silenced ? "ON (silenced)" : "ON");
         Serial_Printf("[STATUS] Temp Threshold: %d-%d°C\n", 
                      system_status.temp_threshold_low, 
                      system_status.temp_threshold_high);
@@ -591,13 +1185,8 @@ void System_ParseCommand(char *command)
                     system_status.temp_threshold_low = (uint8_t)low;
                     system_status.temp_threshold_high = (uint8_t)high;
                     
-                    /*保存配置到W25Q64*/
-                    SystemConfig_t config;
-                    config.temp_threshold_low = system_status.temp_threshold_low;
-                    config.temp_threshold_high = system_status.temp_threshold_high;
-                    config.humi_threshold_low = system_status.humi_threshold_low;
-                    config.humi_threshold_high = system_status.humi_threshold_high;
-                    W25Q64_WriteConfig(&config);
+                    /*保存配置，连续修改合并为一次写入*/
+                    System_SaveThresholds();
                     
                     Serial_Printf("[INFO] Temperature thresholds set to %d-%d°C\n", low, high);
                 }
@@ -622,13 +1211,8 @@ void System_ParseCommand(char *command)
                     system_status.humi_threshold_low = (uint8_t)low;
                     system_status.humi_threshold_high = (uint8_t)high;
                     
-                    /*保存配置到W25Q64*/
-                    SystemConfig_t config;
-                    config.temp_threshold_low = system_status.temp_threshold_low;
-                    config.temp_threshold_high = system_status.temp_threshold_high;
-                    config.humi_threshold_low = system_status.humi_threshold_low;
-                    config.humi_threshold_high = system_status.humi_threshold_high;
-                    W25Q64_WriteConfig(&config);
+                    /*保存配置，连续修改合并为一次写入*/
+                    System_SaveThresholds();
                     
                     Serial_Printf("[INFO] Humidity thresholds set to %d-%d%%\n", low, high);
                 }
@@ -647,6 +1231,19 @@ void System_ParseCommand(char *command)
             Serial_Printf("[ERROR] Invalid threshold type. Use 'temp' or 'humi'\n");
         }
     }
+    else if (strncmp(command, "timers", 6) == 0)
+    {
+        // 显示或清除定时器统计，需在time命令之前匹配
+        if (strncmp(command + 6, " reset", 6) == 0)
+        {
+            Timer_ResetStats();
+            Serial_Printf("[INFO] Timer statistics cleared\n");
+        }
+        else
+        {
+            Timer_ReportStats();
+        }
+    }
     else if (strncmp(command, "time", 4) == 0)
     {
         // time命令：显示当前时间
@@ -695,7 +1292,23 @@ void System_ParseCommand(char *command)
         {
             // 解析history命令，查看历史记录
             int count = 10; // 默认显示10条记录
-            if (command[7] == ' ' || command[7] == '\0')
+            if (strncmp(command + 7, " from ", 6) == 0)
+            {
+                // 按时间范围查看：history from <YYYY-MM-DD HH:MM[:SS]> to <YYYY-MM-DD HH:MM[:SS]>
+                const char *to = strstr(command, " to ");
+                uint32_t from_seconds, to_seconds;
+                
+                if (to != NULL && System_ParseTime(command + 13, &from_seconds) == 0 &&
+                    System_ParseTime(to + 4, &to_seconds) == 0 && from_seconds <= to_seconds)
+                {
+                    System_HistoryRange(from_seconds, to_seconds);
+                }
+                else
+                {
+                    Serial_Printf("[ERROR] Invalid time range. Use: history from YYYY-MM-DD HH:MM to YYYY-MM-DD HH:MM\n");
+                }
+            }
+            else if (command[7] == ' ' || command[7] == '\0')
             {
                 if (strlen(command) > 7)
                 {
@@ -704,17 +1317,13 @@ void System_ParseCommand(char *command)
                     {
                         count = 10;
                     }
-                    else if (count > MAX_RECORDS)
-                    {
-                        count = MAX_RECORDS;
-                    }
                 }
                 
-                // 读取记录
+                // 读取最近的记录
                 DataRecord_t record;
-                uint32_t total_records = (record_index > 0) ? record_index : MAX_RECORDS;
-                uint32_t start_index = (record_index >= count) ? (record_index - count) : 0;
-                uint32_t show_count = (record_index >= count) ? count : record_index;
+                uint32_t total_records = Journal_GetNext() - Journal_GetFirst();
+                uint32_t show_count = (total_records >= (uint32_t)count) ? (uint32_t)count : total_records;
+                uint32_t start_index = Journal_GetNext() - show_count;
                 
                 Serial_Printf("[HISTORY] Total records: %lu, Showing: %lu\n", total_records, show_count);
                 Serial_Printf("[HISTORY] Time | Temp | Humi | Mode | IR\n");
@@ -722,7 +1331,7 @@ void System_ParseCommand(char *command)
                 
                 for (uint32_t i = start_index; i < start_index + show_count; i++)
                 {
-                    uint8_t crc_result = W25Q64_ReadRecord(&record, i);
+                    uint8_t crc_result = Journal_Read(i, &record);
                     if (crc_result == 0) /* CRC match, record is valid */
                     {
                         RTC_TimeTypeDef rec_time;
@@ -742,21 +1351,21 @@ void System_ParseCommand(char *command)
             }
             else
             {
-                Serial_Printf("[ERROR] Invalid history command. Use: history [count]\n");
+                Serial_Printf("[ERROR] Invalid history command. Use: history [count] or history from <t1> to <t2>\n");
             }
         }
         else if (strncmp(command, "export", 6) == 0)
         {
             // 导出数据为CSV格式
             DataRecord_t record;
-            uint32_t total_records = (record_index > 0) ? record_index : MAX_RECORDS;
+            uint32_t total_records = Journal_GetNext() - Journal_GetFirst();
             
             Serial_Printf("[EXPORT] CSV format data (Records: %lu)\n", total_records);
             Serial_Printf("Timestamp,Temperature,Humidity,Mode,IR_Status\n");
             
-            for (uint32_t i = 0; i < total_records; i++)
+            for (uint32_t i = Journal_GetFirst(); i != Journal_GetNext(); i++)
             {
-                uint8_t crc_result = W25Q64_ReadRecord(&record, i);
+                uint8_t crc_result = Journal_Read(i, &record);
                 if (crc_result == 0) /* CRC match, record is valid */
                 {
                     RTC_TimeTypeDef rec_time;
@@ -776,13 +1385,224 @@ void System_ParseCommand(char *command)
             
             Serial_Printf("[EXPORT] Data export completed\n");
         }
+        else if (strncmp(command, "tasks", 5) == 0)
+        {
+            // 显示或清除调度器任务统计
+            if (strncmp(command + 5, " reset", 6) == 0)
+            {
+                Scheduler_ResetStats();
+                Serial_Printf("[INFO] Task statistics cleared\n");
+            }
+            else
+            {
+                Scheduler_ReportStats();
+                Serial_Printf("[TASKS] Dropped events: %lu\n", Event_GetDropCount());
+            }
+        }
+        else if (strncmp(command, "threads", 7) == 0)
+        {
+            // 显示线程状态、栈使用高水位和上下文切换开销
+            Kernel_ReportStats();
+        }
+        else if (strncmp(command, "deadlines", 9) == 0)
+        {
+            // 显示或清除截止时间监控统计
+            if (strncmp(command + 9, " reset", 6) == 0)
+            {
+                Supervisor_ResetStats();
+                Serial_Printf("[INFO] Deadline statistics cleared\n");
+            }
+            else
+            {
+                Supervisor_ReportStats();
+            }
+        }
+        else if (strncmp(command, "power", 5) == 0)
+        {
+            // 显示或清除低功耗统计，打开或关闭停机模式
+            if (strncmp(command + 5, " reset", 6) == 0)
+            {
+                Power_ResetStats();
+                Serial_Printf("[INFO] Power statistics cleared\n");
+            }
+            else if (strncmp(command + 5, " stop on", 8) == 0)
+            {
+                Power_SetStopEnabled(1);
+                Serial_Printf("[INFO] Stop mode enabled, serial input within %u ms keeps the MCU out of Stop\n", POWER_SERIAL_HOLDOFF_MS);
+            }
+            else if (strncmp(command + 5, " stop off", 9) == 0)
+            {
+                Power_SetStopEnabled(0);
+                Serial_Printf("[INFO] Stop mode disabled\n");
+            }
+            else
+            {
+                Power_ReportStats();
+            }
+        }
+        else if (strncmp(command, "perf", 4) == 0)
+        {
+            // 显示或清除热点路径周期计数统计
+            if (strncmp(command + 4, " reset", 6) == 0)
+            {
+                Perf_ResetStats();
+                Serial_Printf("[INFO] Perf statistics cleared\n");
+            }
+            else
+            {
+                Perf_ReportStats();
+            }
+        }
+        else if (strncmp(command, "latency", 7) == 0)
+        {
+            // 显示或清除报警端到端延迟统计
+            if (strncmp(command + 7, " reset", 6) == 0)
+            {
+                Latency_ResetStats();
+                Serial_Printf("[INFO] Latency statistics cleared\n");
+            }
+            else
+            {
+                Latency_ReportStats();
+            }
+        }
+        else if (strncmp(command, "trace", 5) == 0)
+        {
+            // 输出、清空、开始或暂停二进制事件跟踪
+            if (strncmp(command + 5, " clear", 6) == 0)
+            {
+                Trace_Clear();
+                Serial_Printf("[INFO] Trace buffer cleared\n");
+            }
+            else if (strncmp(command + 5, " on", 3) == 0)
+            {
+                Trace_SetEnabled(1);
+                Serial_Printf("[INFO] Trace recording on\n");
+            }
+            else if (strncmp(command + 5, " off", 4) == 0)
+            {
+                Trace_SetEnabled(0);
+                Serial_Printf("[INFO] Trace recording off\n");
+            }
+            else
+            {
+                Trace_Dump();
+            }
+        }
+        else if (strncmp(command, "mem", 3) == 0)
+        {
+            // 显示RAM和栈使用情况，或设置栈告警余量
+            if (strncmp(command + 3, " margin ", 8) == 0)
+            {
+                Mem_SetMargin((uint16_t)atoi(command + 11));
+                Serial_Printf("[INFO] Stack margin set to %u bytes\n", Mem_GetMargin());
+            }
+            else
+            {
+                Mem_ReportStats();
+            }
+        }
+        else if (strncmp(command, "flash", 5) == 0)
+        {
+            // 显示或清除记录日志统计
+            if (strncmp(command + 5, " reset", 6) == 0)
+            {
+                Journal_ResetStats();
+                Config_ResetStats();
+                W25Q64_ResetStats();
+                Serial_Printf("[INFO] Flash statistics cleared\n");
+            }
+            else if (strncmp(command + 5, " bench", 6) == 0)
+            {
+                System_FlashBench();
+            }
+            else if (strncmp(command + 5, " wear", 5) == 0)
+            {
+                Journal_ReportWear();
+            }
+            else if (strncmp(command + 5, " ahead ", 7) == 0)
+            {
+                Journal_SetEraseAhead((uint8_t)atoi(command + 12));
+                Journal_Prepare();
+                Serial_Printf("[INFO] Erase-ahead set to %u sectors\n", Journal_GetEraseAhead());
+            }
+            else if (strncmp(command + 5, " speed auto", 11) == 0)
+            {
+                W25Q64_SelfTest();
+                Serial_Printf("[INFO] Flash link speed %lu kHz after self-test\n", W25Q64_GetSpeedHz() / 1000);
+            }
+            else if (strncmp(command + 5, " speed ", 7) == 0)
+            {
+                // 选择不超过指定频率的最高速度，不做自检
+                uint32_t khz = (uint32_t)atol(command + 12);
+                uint16_t prescaler = SPI_BaudRatePrescaler_2;
+                
+                while (prescaler < SPI_BaudRatePrescaler_256 && W25Q64_SPI_HZ(prescaler) / 1000 > khz)
+                {
+                    prescaler += SPI_BaudRatePrescaler_4 - SPI_BaudRatePrescaler_2;
+                }
+                W25Q64_SetPrescaler(prescaler);
+                Serial_Printf("[INFO] Flash link speed %lu kHz, %s\n", W25Q64_GetSpeedHz() / 1000,
+                              W25Q64_IsFastRead() ? "Fast Read" : "Read Data");
+            }
+            else
+            {
+                Journal_ReportStats();
+                Config_ReportStats();
+                W25Q64_ReportStats();
+            }
+        }
+        else if (strncmp(command, "sync", 4) == 0)
+        {
+            // 写入日志页缓冲中的记录并等待编程完成
+            Journal_Sync();
+            Config_Flush();
+            Series_Sync();
+            W25Q64_Sync();
+            Serial_Printf("[INFO] Journal, config and sample series synced, records up to %lu on flash\n", Journal_GetNext());
+        }
+        else if (strncmp(command, "series", 6) == 0)
+        {
+            // 温湿度连续采样流：开关保存在配置存储中
+            if (strncmp(command + 6, " on", 3) == 0 || strncmp(command + 6, " off", 4) == 0)
+            {
+                uint8_t enable = (command[8] == 'n');
+                
+                Series_Enable(enable);
+                Config_Set(CONFIG_KEY_SERIES, enable);
+                Serial_Printf("[INFO] Sample series %s\n", enable ? "on, every reading is stored" : "off, open page written");
+            }
+            else if (strncmp(command + 6, " reset", 6) == 0)
+            {
+                Series_ResetStats();
+                Serial_Printf("[INFO] Sample series statistics cleared\n");
+            }
+            else if (strncmp(command + 6, " last", 5) == 0)
+            {
+                Series_Sample_t sample;
+                RTC_TimeTypeDef sample_time;
+                uint32_t count = (command[11] == ' ') ? (uint32_t)atol(command + 12) : 10;
+                
+                Serial_Printf("[SERIES] Time | Temp | Humi\n");
+                Series_Seek(count);
+                while (Series_Next(&sample) == 0)
+                {
+                    RTC_ConvertFromSeconds(sample.time, &sample_time);
+                    Serial_Printf("[SERIES] 20%02d-%02d-%02d %02d:%02d:%02d | %4d | %4d\n",
+                                  sample_time.year, sample_time.month, sample_time.day,
+                                  sample_time.hour, sample_time.minute, sample_time.second,
+                                  sample.temp, sample.humi);
+                }
+            }
+            else
+            {
+                Series_ReportStats();
+            }
+        }
         else if (strncmp(command, "clear_history", 13) == 0)
         {
             // 清空历史记录
-            W25Q64_ClearAllRecords();
-            record_index = 0; // 重置记录索引
-            /*保存重置后的索引*/
-            W25Q64_WriteRecordIndex(record_index);
+            Journal_Clear();
             Serial_Printf("[INFO] All historical data cleared\n");
         }
         else
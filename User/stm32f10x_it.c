@@ -118,23 +118,9 @@ void DebugMon_Handler(void)
 {
 }
 
-/**
-  * @brief  This function handles PendSVC exception.
-  * @param  None
-  * @retval None
-  */
-void PendSV_Handler(void)
-{
-}
+/* PendSV_Handler is implemented in System/KernelPort.c (thread context switch) */
 
-/**
-  * @brief  This function handles SysTick Handler.
-  * @param  None
-  * @retval None
-  */
-void SysTick_Handler(void)
-{
-}
+/* SysTick_Handler is implemented in System/Scheduler.c (1 ms system timebase) */
 
 /******************************************************************************/
 /*                 STM32F10x Peripherals Interrupt Handlers                   */